@@ -36,5 +36,6 @@ namespace Quartz
 		void PrintConfigs();
 
 		inline String GetAssetTypeName() const override { return "Config"; }
+		inline uSize GetSizeBytes() const override { return sizeof(Config); }
 	};
 }
\ No newline at end of file
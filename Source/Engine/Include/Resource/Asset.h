@@ -28,5 +28,6 @@ namespace Quartz
 		inline String		GetPath() const { return mpSourceFile->GetPath(); }
 
 		virtual String		GetAssetTypeName() const = 0;
+		virtual uSize		GetSizeBytes() const = 0; // Resident memory, for the AssetManager's budget
 	};
 }
\ No newline at end of file
@@ -0,0 +1,104 @@
+#pragma once
+
+#include "Asset.h"
+
+#include <atomic>
+
+namespace Quartz
+{
+	enum AssetLoadState
+	{
+		ASSET_LOAD_PENDING,	// Queued or being loaded on a loader thread
+		ASSET_LOAD_READY,
+		ASSET_LOAD_FAILED	// Also the state of unloaded and evicted assets
+	};
+
+	/* One per asset path, owned by the AssetManager and reused if the asset is loaded again */
+	struct AssetLoadRequest
+	{
+		File*						pFile;
+		Asset*						pAsset;
+		std::atomic<AssetLoadState>	state;
+		std::atomic<uSize>			refCount;	// Live handles, referenced assets are never evicted
+		bool						pinned;		// Returned as a raw pointer, only unloaded explicitly
+		uSize						sizeBytes;
+		uInt64						lastUse;	// AssetManager tick of the last request, for LRU eviction
+
+		inline AssetLoadRequest(File* pFile) :
+			pFile(pFile), pAsset(nullptr), state(ASSET_LOAD_PENDING), refCount(0),
+			pinned(false), sizeBytes(0), lastUse(0) {}
+	};
+
+	/*
+		Reference counted result of an asynchronous load, the asset is only available once
+		the handle is ready and stays resident while any handle to it is alive.
+	*/
+	template<typename AssetType>
+	class AssetHandle
+	{
+	public:
+		friend class AssetManager;
+
+	private:
+		AssetLoadRequest* mpRequest;
+
+	private:
+		/* Adopts a reference the AssetManager has already added */
+		explicit AssetHandle(AssetLoadRequest* pRequest) : mpRequest(pRequest) {}
+
+	public:
+		AssetHandle() : mpRequest(nullptr) {}
+
+		AssetHandle(const AssetHandle& handle) : mpRequest(handle.mpRequest)
+		{
+			if (mpRequest)
+			{
+				mpRequest->refCount.fetch_add(1, std::memory_order_relaxed);
+			}
+		}
+
+		AssetHandle(AssetHandle&& rHandle) noexcept : mpRequest(rHandle.mpRequest)
+		{
+			rHandle.mpRequest = nullptr;
+		}
+
+		~AssetHandle()
+		{
+			Release();
+		}
+
+		AssetHandle& operator=(AssetHandle handle)
+		{
+			AssetLoadRequest* pRequest = mpRequest;
+			mpRequest = handle.mpRequest;
+			handle.mpRequest = pRequest;
+			return *this;
+		}
+
+		/* Drops this handle's reference, the asset may be evicted once none remain */
+		inline void Release()
+		{
+			if (mpRequest)
+			{
+				mpRequest->refCount.fetch_sub(1, std::memory_order_release);
+				mpRequest = nullptr;
+			}
+		}
+
+		inline AssetLoadState GetState() const
+		{
+			return mpRequest ? mpRequest->state.load(std::memory_order_acquire) : ASSET_LOAD_FAILED;
+		}
+
+		inline bool IsValid() const { return mpRequest != nullptr; }
+		inline bool IsReady() const { return GetState() == ASSET_LOAD_READY; }
+		inline bool IsPending() const { return GetState() == ASSET_LOAD_PENDING; }
+		inline bool IsFailed() const { return GetState() == ASSET_LOAD_FAILED; }
+
+		/* Null until the load completes */
+		inline AssetType* Get() const
+		{
+			return IsReady() ? static_cast<AssetType*>(mpRequest->pAsset) : nullptr;
+		}
+	};
+}
\ No newline at end of file
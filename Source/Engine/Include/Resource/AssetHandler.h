@@ -3,10 +3,18 @@
 #include "Asset.h"
 #include "Types/String.h"
 
+#include <mutex>
+
 namespace Quartz
 {
 	class QUARTZ_ENGINE_API AssetHandler
 	{
+	public:
+		friend class AssetManager;
+
+	private:
+		std::mutex mLoadMutex; // Handlers are not thread safe, the AssetManager serializes calls into each one
+
 	public:
 		virtual bool LoadAsset(File& assetFile, Asset*& pOutAsset) = 0;
 		virtual bool UnloadAsset(Asset* pInAsset) = 0;
@@ -1,78 +1,105 @@
 #pragma once
 
 #include "AssetHandler.h"
+#include "AssetHandle.h"
 #include "Filesystem/Filesystem.h"
 #include "Engine.h"
 #include "Log.h"
 #include "Types/Map.h"
+#include "Types/Array.h"
 #include "Runtime/Timer.h"
 
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#define ASSET_MANAGER_LOADER_THREADS 2
+
 namespace Quartz
 {
 	class QUARTZ_ENGINE_API AssetManager
 	{
 	private:
-		Map<String, AssetHandler*>	mHandlers;
-		Map<String, Asset*>			mAssets;
-		AssetID						mNextAssetID; // @TODO: find a better system
+		Map<String, AssetHandler*>		mHandlers;
+		Map<String, AssetLoadRequest*>	mAssets;		// Every requested asset, loaded or not
+		AssetID							mNextAssetID;	// @TODO: find a better system
+		uInt64							mTick;			// Counts requests, orders assets for eviction
+
+		/* Memory accounting */
+
+		Map<String, uSize>				mTypeBytes;		// Resident bytes per asset type name
+		uSize							mResidentBytes;
+		uSize							mBudgetBytes;	// 0 for no budget
+
+		/* Asynchronous loading */
+
+		Array<AssetLoadRequest*>		mQueue;
+		uSize							mQueueHead;
+		uSize							mPendingCount;	// Claimed loads that have not completed
+		Array<std::thread*>				mLoaderThreads;
+		bool							mStopLoaders;
+		std::mutex						mMutex;
+		std::condition_variable			mQueueCondition;
+		std::condition_variable			mDoneCondition;
+
+	private:
+		AssetHandler* FindHandler(File& assetFile);
+		bool LoadWithHandler(File& assetFile, Asset*& pOutAsset);
+
+		/* Finds or creates the request for a file, true if the caller must load it */
+		bool ClaimRequest(File& assetFile, AssetLoadRequest*& pOutRequest);
+		void CompleteRequest(AssetLoadRequest* pRequest);
+
+		/* Takes a loaded asset out of its request and the accounting, the caller unloads it */
+		void ReleaseRequest(AssetLoadRequest* pRequest);
+		bool UnloadWithHandler(File& assetFile, Asset* pAsset);
+
+		void LoaderThread();
+
+		Asset* LoadAssetFile(File& assetFile);
+		AssetLoadRequest* QueueAssetFile(File& assetFile);
+		bool UnloadAssetFile(Asset* pAsset);
 
 	public:
-		AssetManager() :
-			mHandlers(128), mAssets(8196), mNextAssetID(1) {}
+		AssetManager();
+		~AssetManager();
 
 		template<typename AssetHandlerType>
 		bool RegisterAssetHandler(const String& ext, AssetHandlerType* pAssetHandler)
 		{
+			std::lock_guard<std::mutex> lock(mMutex);
 			mHandlers.Put(ext, static_cast<AssetHandler*>(pAssetHandler));
 			return true;
 		}
 
-		template<typename AssetType>
-		AssetType* GetOrLoadAsset(File& assetFile)
-		{
-			Timer loadTimer;
-			loadTimer.Start();
-
-			auto& assetIt = mAssets.Find(assetFile.GetPath());
-			if (assetIt != mAssets.End())
-			{
-				return static_cast<AssetType*>(assetIt->value);
-			}
+		/* Starts the threads that serve LoadAssetAsync. Without them asynchronous loads complete on the caller */
+		bool StartLoaders(uSize threadCount);
 
-			const String ext = assetFile.GetExtention();
-			AssetHandler* pHandler = nullptr;
-			Asset* pAsset = nullptr;
-
-			auto& loaderIt = mHandlers.Find(ext);
-			if (loaderIt != mHandlers.End())
-			{
-				pHandler = loaderIt->value;
-			}
-			else
-			{
-				LogError("Error loading asset [%s]. No registered loader is associated with the extension '%s'.", 
-					assetFile.GetPath().Str(), ext.Str());
-				return nullptr;
-			}
+		/* Joins the loader threads, queued loads that have not started are failed */
+		void StopLoaders();
 
-			if (!pHandler->LoadAsset(assetFile, pAsset))
-			{
-				// Error message in LoadAsset()
-				return nullptr;
-			}
+		/* Blocks until every queued load has completed */
+		void WaitForLoads();
 
-			// @TODO: find a better system
-			pAsset->mAssetId = mNextAssetID;
-			mNextAssetID++;
+		/* Resident bytes above which unreferenced assets are evicted, least recently requested first. 0 disables eviction */
+		void SetMemoryBudget(uSize budgetBytes);
 
-			mAssets.Put(assetFile.GetPath(), pAsset);
+		/* Evicts unreferenced assets until resident memory is within budget. Runs after every load */
+		void Trim();
 
-			double loadTime = loadTimer.Mark() / 1000000.0;
+		uSize GetResidentBytes();
+		uSize GetResidentBytes(const String& assetTypeName);
 
-			LogInfo("[Asset Manager] Loaded %s \"%s\" in %.3lf ms.",
-				pAsset->GetAssetTypeName().Str(), assetFile.GetPath().Str(), loadTime);
+		inline uSize GetMemoryBudget() const { return mBudgetBytes; }
 
-			return static_cast<AssetType*>(pAsset);
+		/*
+			Loads on the calling thread, or waits for a pending asynchronous load of the same file.
+			Assets returned as raw pointers are pinned, they are never evicted and must be unloaded
+		*/
+		template<typename AssetType>
+		AssetType* GetOrLoadAsset(File& assetFile)
+		{
+			return static_cast<AssetType*>(LoadAssetFile(assetFile));
 		}
 
 		template<typename AssetType>
@@ -89,33 +116,31 @@ namespace Quartz
 			return GetOrLoadAsset<AssetType>(*pAssetFile);
 		}
 
+		/* Queues the load on a loader thread and returns immediately. Loaded assets return a ready handle */
 		template<typename AssetType>
-		bool UnloadAsset(AssetType* pAsset)
+		AssetHandle<AssetType> LoadAssetAsync(File& assetFile)
 		{
-			if (!pAsset || !pAsset->GetSourceFile())
-			{
-				return false;
-			}
+			return AssetHandle<AssetType>(QueueAssetFile(assetFile));
+		}
 
-			const String ext = pAsset->GetSourceFile()->GetExtention();
-			AssetHandler* pHandler;
-			bool result = true;
+		template<typename AssetType>
+		AssetHandle<AssetType> LoadAssetAsync(const String& path)
+		{
+			File* pAssetFile = Engine::GetFilesystem().GetFile(path);
 
-			auto& loaderIt = mHandlers.Find(ext);
-			if (loaderIt != mHandlers.End())
-			{
-				pHandler = loaderIt->value;
-			}
-			else
+			if (!pAssetFile)
 			{
-				// No loader
-				return false;
+				LogError("Error loading asset [%s]. File does not exist.", path.Str());
+				return AssetHandle<AssetType>();
 			}
 
-			result = pHandler->UnloadAsset(pAsset);
-			mAssets.Remove(pAsset->GetSourceFile()->GetPath());
-			
-			return result;
+			return LoadAssetAsync<AssetType>(*pAssetFile);
+		}
+
+		template<typename AssetType>
+		bool UnloadAsset(AssetType* pAsset)
+		{
+			return UnloadAssetFile(static_cast<Asset*>(pAsset));
 		}
 	};
 }
\ No newline at end of file
@@ -15,5 +15,6 @@ namespace Quartz
 		ByteBuffer* pImageData;
 
 		inline String GetAssetTypeName() const override { return "Image"; }
+		inline uSize GetSizeBytes() const override { return sizeof(Image) + (pImageData ? pImageData->Size() : 0); }
 	};
 }
\ No newline at end of file
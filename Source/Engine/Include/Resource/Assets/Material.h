@@ -81,5 +81,6 @@ namespace Quartz
 		inline Material(File* pSourceFile) : Asset(pSourceFile) {};
 
 		inline String GetAssetTypeName() const override { return "Material"; }
+		inline uSize GetSizeBytes() const override { return sizeof(Material); }
 	};
 }
\ No newline at end of file
@@ -3,6 +3,7 @@
 #include "Resource/Asset.h"
 #include "Resource/Common.h"
 #include "Types/Special/ByteBuffer.h"
+#include "Math/Math.h"
 
 namespace Quartz
 {
@@ -24,36 +25,104 @@ namespace Quartz
 	{
 		uInt32					streamIdx;
 		Array<VertexElement, 8>	vertexElements;
-		ByteBuffer*				pVertexBuffer;
+		ByteBuffer*				pVertexBuffer	= nullptr;
+		const uInt8*			pMappedData		= nullptr;	// Used in place from a mapped file instead of pVertexBuffer
+		uInt64					mappedSizeBytes	= 0;
 		uInt32					strideBytes;
+
+		inline bool HasData() const { return pMappedData || pVertexBuffer; }
+
+		inline const uInt8* GetData() const
+		{
+			return pMappedData ? pMappedData : (pVertexBuffer ? (const uInt8*)pVertexBuffer->Data() : nullptr);
+		}
+
+		inline uSize GetSizeBytes() const
+		{
+			return pMappedData ? mappedSizeBytes : (pVertexBuffer ? pVertexBuffer->Size() : 0);
+		}
 	};
 
 	struct IndexStream
 	{
 		IndexElement	indexElement;
-		ByteBuffer*		pIndexBuffer;
+		ByteBuffer*		pIndexBuffer	= nullptr;
+		const uInt8*	pMappedData		= nullptr;	// Used in place from a mapped file instead of pIndexBuffer
+		uInt64			mappedSizeBytes	= 0;
 		uInt32			indexCount;
 		uInt32			maxIndex;
+
+		inline bool HasData() const { return pMappedData || pIndexBuffer; }
+
+		inline const uInt8* GetData() const
+		{
+			return pMappedData ? pMappedData : (pIndexBuffer ? (const uInt8*)pIndexBuffer->Data() : nullptr);
+		}
+
+		inline uSize GetSizeBytes() const
+		{
+			return pMappedData ? mappedSizeBytes : (pIndexBuffer ? pIndexBuffer->Size() : 0);
+		}
 	};
 
 	struct Mesh
 	{
 		String name;
 		uInt32 lod;
+		float  lodError;	// Object space distance this LOD may lie from LOD 0
 		uInt32 materialIdx;
 		uInt32 indexStart;
 		uInt32 indexCount;
 	};
 
+	struct Meshlet
+	{
+		uInt32	meshIdx;
+		uInt32	vertexStart;	// Into MeshletStream::vertices
+		uInt32	triangleStart;	// Into MeshletStream::triangles, counted in triangles
+		uInt32	vertexCount;
+		uInt32	triangleCount;
+		Vec3f	center;			// Bounding sphere
+		float	radius;
+		Vec3f	coneApex;		// Every triangle faces away from views inside the cone
+		Vec3f	coneAxis;
+		float	coneCutoff;		// Cosine of the cone half angle, above 1 if the meshlet has no cone
+	};
+
+	struct MeshletStream
+	{
+		Array<Meshlet>	meshlets;
+		Array<uInt32>	vertices;	// Model vertex indices, each meshlet's back to back
+		Array<uInt8>	triangles;	// Meshlet vertex indices, 3 per triangle
+	};
+
 	struct Model : public Asset
 	{
 		Array<VertexStream, 8>	vertexStreams;
 		IndexStream				indexStream;
 		Array<Mesh>				meshes;
+		MeshletStream			meshletStream;	// Empty unless built by BuildModelMeshlets
+		Bounds3f				bounds;			// Of every vertex, VERTEX_FORMAT_UNORM16_4 positions are relative to it
 
 		inline Model() = default;
 		inline Model(File* pSourceFile) : Asset(pSourceFile) {};
 
 		inline String GetAssetTypeName() const override { return "Model"; }
+
+		inline uSize GetSizeBytes() const override
+		{
+			uSize sizeBytes = sizeof(Model) + meshes.Size() * sizeof(Mesh);
+
+			sizeBytes += meshletStream.meshlets.Size() * sizeof(Meshlet);
+			sizeBytes += meshletStream.vertices.Size() * sizeof(uInt32);
+			sizeBytes += meshletStream.triangles.Size();
+
+			for (const VertexStream& stream : vertexStreams)
+			{
+				sizeBytes += stream.GetSizeBytes();
+			}
+
+			return sizeBytes + indexStream.GetSizeBytes();
+		}
 	}; 
 }
\ No newline at end of file
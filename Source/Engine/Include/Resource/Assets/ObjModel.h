@@ -31,8 +31,8 @@ namespace Quartz
 	{
 		uInt64 intVal = 0;
 		intVal = (value.posIdx & 0x001fffff);
-		intVal |= (value.normIdx & 0x001fffff) >> 21;
-		intVal |= value.texIdx >> 21;
+		intVal |= (uInt64)(value.normIdx & 0x001fffff) << 21;
+		intVal |= (uInt64)(value.texIdx & 0x001fffff) << 42;
 
 		uInt64 hash = 525201411107845655ull;
 
@@ -36,5 +36,17 @@ namespace Quartz
 		Shader(File* pSourceFile) : Asset(pSourceFile) {};
 
 		inline String GetAssetTypeName() const override { return "Shader"; }
+
+		inline uSize GetSizeBytes() const override
+		{
+			uSize sizeBytes = sizeof(Shader) + params.Size() * sizeof(ShaderParam);
+
+			for (const ShaderCode& code : shaderCodes)
+			{
+				sizeBytes += code.pSourceBuffer ? code.pSourceBuffer->Size() : 0;
+			}
+
+			return sizeBytes;
+		}
 	};
 }
\ No newline at end of file
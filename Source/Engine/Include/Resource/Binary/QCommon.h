@@ -7,6 +7,12 @@ namespace Quartz
 {
 	using QStringID = uInt32;
 
+	enum QCompression : uInt16
+	{
+		QCOMPRESSION_NONE	= 0,
+		QCOMPRESSION_LZ		= 1		// LZ4 block format, see QCompression.h
+	};
+
 #pragma pack(push,1)
 
 	struct QStringTable							// 256 bits
@@ -19,6 +25,13 @@ namespace Quartz
 		uInt64			nextExtOffset;			// 64 bits
 	};
 
+	/* Starts every compressed stream. Stream sizes in the tables count this header and the compressed bytes */
+	struct QCompressedBlock						// 128 bits
+	{
+		uInt64			rawSizeBytes;			// 64 bits
+		uInt64			_reserved0;				// 64 bits
+	};
+
 #pragma pack(pop)
 
 }
\ No newline at end of file
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "QCommon.h"
+#include "EngineAPI.h"
+
+#define QCOMPRESSION_HASH_BITS				12				// 16 KiB match table, kept on the stack
+#define QCOMPRESSION_PARALLEL_MIN_BYTES		(256 * 1024)	// Smaller batches are decoded on the calling thread
+#define QCOMPRESSION_MAX_THREADS			8
+
+namespace Quartz
+{
+	/* One compressed block and where its raw bytes go */
+	struct QDecompressJob
+	{
+		const uInt8*	pCompressed;
+		uSize			compressedSizeBytes;
+		uInt8*			pOutData;
+		uSize			rawSizeBytes;
+	};
+
+	/* Largest output QCompressLZ can produce for rawSizeBytes of input */
+	QUARTZ_ENGINE_API uSize QCompressBound(uSize rawSizeBytes);
+
+	/*
+		Compresses into the LZ4 block format with a single greedy pass.
+		Returns the compressed size, or 0 if the data would not shrink.
+	*/
+	QUARTZ_ENGINE_API uSize QCompressLZ(const uInt8* pData, uSize sizeBytes, uInt8* pOutData, uSize outCapacityBytes);
+
+	/* Largest QCompressedBlock, header included, QCompressBlock can write for rawSizeBytes of input */
+	QUARTZ_ENGINE_API uSize QCompressBlockBound(uSize rawSizeBytes);
+
+	/*
+		Writes a QCompressedBlock header and the compressed data to pOutBlock, which must hold
+		QCompressBlockBound(sizeBytes) bytes. Returns the block size, or 0 if the block would not
+		be smaller than the raw data, which should then be stored raw.
+	*/
+	QUARTZ_ENGINE_API uSize QCompressBlock(const uInt8* pData, uSize sizeBytes, uInt8* pOutBlock);
+
+	/*
+		Reads the header of a stored QCompressedBlock into a job, leaving pOutData for the caller
+		to allocate rawSizeBytes for. False if the block is too small or its raw size is corrupt.
+	*/
+	QUARTZ_ENGINE_API bool QPrepareDecompressJob(const uInt8* pBlock, uSize blockSizeBytes, QDecompressJob& outJob);
+
+	/* False if the block is corrupt or does not decode to exactly rawSizeBytes */
+	QUARTZ_ENGINE_API bool QDecompressLZ(const uInt8* pCompressed, uSize compressedSizeBytes, uInt8* pOutData, uSize rawSizeBytes);
+
+	/* Decodes independent blocks across threads, false if any block fails */
+	QUARTZ_ENGINE_API bool QDecompressParallel(const QDecompressJob* pJobs, uSize jobCount);
+}
\ No newline at end of file
@@ -2,8 +2,41 @@
 
 #include "QCommon.h"
 
+#define QMODEL_VERSION_MAJOR		2
+#define QMODEL_VERSION_MINOR		4
+#define QMODEL_STREAM_ALIGNMENT		4096	// Page size, so streams can be used in place from a mapped file
+
 namespace Quartz
 {
+	/*
+		Version 2 keeps the 1.4 structures but changes the layout: every table follows the
+		header back to back (meshes, vertex stream descriptors, vertex elements, the index
+		stream descriptor, then strings), and the vertex and index data follow the tables,
+		each stream starting on a QMODEL_STREAM_ALIGNMENT boundary. The stream table sizes
+		count descriptors only. All offsets are from the start of the file.
+
+		Version 2.1 adds per-stream compression. A compressed stream starts with a
+		QCompressedBlock giving its raw size, and its streamSizeBytes is the stored size.
+		Compressed streams are decoded into buffers, uncompressed ones are still used in place.
+
+		Version 2.2 stores the model bounds in a QModelBounds right after the header, found
+		through boundsOffset (0 in older files). Quantized positions decode against them.
+
+		Version 2.3 stores each mesh's lodError where the reserved 0 used to be, so older
+		files read as error free. Meshes with lodIdx above 0 follow their LOD 0 in the table.
+
+		Version 2.4 adds an optional meshlet stream. Its QModelMeshletStream descriptor follows
+		the index stream descriptor, found through streamTable.meshletStreamOffset (0 if not
+		present). The stream holds the QModelMeshlets, the uInt32 meshlet vertices and the uInt8
+		meshlet triangles back to back, and may be compressed like the other streams.
+	*/
+
+	struct QModelBounds								// 192 bits
+	{
+		float min[3];								// 96 bits
+		float max[3];								// 96 bits
+	};
+
 	struct QModelVertexElement						// 64 bits
 	{
 		VertexAttribute		attribute;				// 8 bits
@@ -18,7 +51,8 @@ namespace Quartz
 		IndexFormat			format;					// 8 bits
 		uInt8				_reserved0;				// 8 bits
 		uInt16				sizeBytes;				// 16 bits
-		uInt32				_reserved1;				// 32 bits
+		QCompression		compression;			// 16 bits, of the index stream
+		uInt16				_reserved1;				// 16 bits
 	};
 
 	struct QModelVertexElementTable					// 192 bits
@@ -32,7 +66,7 @@ namespace Quartz
 	struct QModelVertexStream						// 384 bits
 	{
 		uInt32					 streamIdx;			// 32 bits
-		uInt16					 _reserved0;		// 16 bits
+		QCompression			 compression;		// 16 bits
 		uInt16					 strideBytes;		// 16 bits
 		QModelVertexElementTable elementTable;		// 192 bits
 		uInt64					 streamOffset;		// 64 bits
@@ -48,6 +82,31 @@ namespace Quartz
 		uInt64				streamSizeBytes;		// 64 bits
 	};
 
+	struct QModelMeshlet							// 480 bits
+	{
+		uInt32		meshIdx;						// 32 bits
+		uInt32		vertexStart;					// 32 bits
+		uInt32		triangleStart;					// 32 bits
+		uInt16		vertexCount;					// 16 bits
+		uInt16		triangleCount;					// 16 bits
+		float		center[3];						// 96 bits
+		float		radius;							// 32 bits
+		float		coneApex[3];					// 96 bits
+		float		coneAxis[3];					// 96 bits
+		float		coneCutoff;						// 32 bits
+	};
+
+	struct QModelMeshletStream						// 256 bits
+	{
+		uInt32			meshletCount;				// 32 bits
+		QCompression	compression;				// 16 bits
+		uInt16			_reserved0;					// 16 bits
+		uInt32			vertexCount;				// 32 bits
+		uInt32			triangleCount;				// 32 bits
+		uInt64			streamOffset;				// 64 bits
+		uInt64			streamSizeBytes;			// 64 bits
+	};
+
 	struct QModelStreamTable						// 384 bits
 	{
 		uInt32 streamCount;							// 32 bits
@@ -56,7 +115,7 @@ namespace Quartz
 		uInt64 vertexStreamsSizeBytes;				// 64 bits
 		uInt64 indexStreamOffset;					// 64 bits
 		uInt64 indexStreamSizeBytes;				// 64 bits
-		uInt64 nextExtOffset;						// 64 bits
+		uInt64 meshletStreamOffset;					// 64 bits, 0 if not present
 	};
 
 	struct QModelMesh								// 192 bits
@@ -65,7 +124,7 @@ namespace Quartz
 		uInt32		materialIdx;					// 32 bits
 		uInt16		lodIdx;							// 16 bits
 		uInt16		_reserved0;						// 16 bits
-		uInt32		_reserved1;						// 32 bits
+		float		lodError;						// 32 bits
 		uInt32		indexStart;						// 32 bits
 		uInt32		indexCount;						// 32 bits
 	};
@@ -84,7 +143,7 @@ namespace Quartz
 		char				magic[8] = "QModel";	// 32 bits
 		uInt16				versionMajor;			// 16 bits
 		uInt16				versionMinor;			// 16 bits
-		uInt64				_reserved0;				// 64 bits
+		uInt64				boundsOffset;			// 64 bits, 0 if not present
 		QStringTable		stringTable;			// 256 bits
 		QModelMeshTable		meshTable;				// 256 bits
 		QModelStreamTable	streamTable;			// 384 bits
@@ -1,6 +1,7 @@
 #pragma once
 
 #include "QModel.h"
+#include "QCompression.h"
 #include "EngineAPI.h"
 #include "Types/Array.h"
 #include "Memory/Allocator.h"
@@ -20,15 +21,38 @@ namespace Quartz
 		PoolAllocator<Model>*		mpModelAllocator;
 		PoolAllocator<ByteBuffer>*	mpBufferAllocator;
 
+		/* Version 2 */
+
+		const uInt8*				mpTables;		// File start, mapped or read up to the end of the tables
+		Array<uInt8>				mTableData;		// Holds the tables when the file could not be mapped
+		uInt64						mTablesEnd;
+		bool						mMapped;
+
+		QCompression				mCompression;
+		Array<uInt8>				mCompressedData;	// Compressed streams waiting to be written, back to back
+		Array<uInt64>				mCompressedOffsets;	// Per written stream, into mCompressedData
+		Array<ByteBuffer*>			mCompressedBuffers;	// Compressed streams read from an unmapped file
+		Array<QDecompressJob>		mDecompressJobs;
+
+		Array<QModelMesh>			mQMeshes;
+		Array<QModelVertexStream>	mQVertexStreams;
+		Array<QModelVertexElement>	mQVertexElements;
+		QModelIndexStream			mQIndexStream;
+		QModelMeshletStream			mQMeshletStream;
+		Array<uInt8>				mMeshletData;		// Meshlet stream waiting to be written
+		ByteBuffer*					mpMeshletBuffer;	// Meshlet stream read from the file, unpacked once decoded
+		const uInt8*				mpMappedMeshlets;
+
 	private:
 		QModel		WriteBlankQModelHeader();
 		QStringID	RegisterString(const String& string);
 		bool		BeginWriting();
 		bool		EndWriting();
-		bool		WriteStrings();
-		bool		WriteMesh(const Mesh& mesh);
-		bool		WriteVertexStream(const VertexStream& stream);
-		bool		WriteIndexStream(const IndexStream& stream);
+		uInt64		CompressStream(const uInt8* pData, uInt64 sizeBytes, QCompression& outCompression);
+		void		PackMeshlets();
+		void		BuildLayout();
+		bool		WriteTables();
+		bool		WriteStreamData(const uInt8* pData, uInt64 sizeBytes, uInt64 offset, uInt64& fileOffset);
 
 		bool		BeginReading();
 		bool		EndReading();
@@ -37,6 +61,21 @@ namespace Quartz
 		bool		ReadVertexStreams();
 		bool		ReadIndexStream();
 
+		bool		ValidateHeader();
+		bool		MapTables();
+		bool		ReadStringsV2();
+		bool		ReadMeshesV2();
+		bool		ReadBoundsV2();
+		bool		ReadStreamData(uInt64 offset, uInt64 sizeBytes, QCompression compression,
+						ByteBuffer*& pOutBuffer, const uInt8*& pOutMapped);
+		bool		ReadVertexStreamsV2();
+		bool		ReadIndexStreamV2();
+		bool		ReadMeshletStreamV2();
+		bool		DecompressStreams();
+		bool		UnpackMeshletsV2();
+		void		FreeCompressedBuffers();
+		void		FreeModel();
+
 	public:
 		QModelParser(File& qModelFile,
 			PoolAllocator<Model>* pModelAllocator = nullptr,
@@ -44,7 +83,16 @@ namespace Quartz
 
 		void SetModel(const Model& model);
 
+		/* Streams that shrink are written compressed, others are stored raw. Off by default */
+		void SetCompression(QCompression compression);
+
+		/*
+			Reads 1.4 and 2.x files. Uncompressed 2.x streams point into the mapped file, which stays
+			open while the model lives. Compressed streams are decoded into buffers in parallel.
+		*/
 		bool Read();
+
+		/* Writes 2.4 */
 		bool Write();
 
 		Model* GetModel() const { return mpModel; }
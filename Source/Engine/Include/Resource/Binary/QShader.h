@@ -2,8 +2,17 @@
 
 #include "QCommon.h"
 
+#define QSHADER_VERSION_MAJOR		1
+#define QSHADER_VERSION_MINOR		1
+
 namespace Quartz
 {
+	/*
+		Version 1.1 adds per-code compression. Compressed code starts with a QCompressedBlock
+		giving its raw size, and its codeSizeBytes is the stored size. 1.0 files leave the
+		compression field unset, so it is only read from 1.1 on.
+	*/
+
 	enum QShaderStage : uInt16
 	{
 		QSHADER_STAGE_INVALID = 0,
@@ -61,7 +70,7 @@ namespace Quartz
 	{
 		QStringID			entryID;				// 32 bits
 		QShaderLang			lang;					// 16 bits
-		uInt16				_reserved0;				// 16 bits
+		QCompression		compression;			// 16 bits
 		uInt64				codeOffset;				// 64 bits
 		uInt64				codeSizeBytes;			// 64 bits
 	};
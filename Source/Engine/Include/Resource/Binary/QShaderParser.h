@@ -1,6 +1,7 @@
 #pragma once
 
 #include "QShader.h"
+#include "QCompression.h"
 #include "EngineAPI.h"
 #include "Types/Array.h"
 #include "Memory/Allocator.h"
@@ -20,6 +21,10 @@ namespace Quartz
 		PoolAllocator<Shader>*		mpShaderAllocator;
 		PoolAllocator<ByteBuffer>*	mpBufferAllocator;
 
+		QCompression				mCompression;
+		Array<ByteBuffer*>			mCompressedBuffers;	// Compressed code read from the file
+		Array<QDecompressJob>		mDecompressJobs;
+
 	private:
 		QShader		WriteBlankQShaderHeader();
 		QStringID	RegisterString(const String& string);
@@ -34,6 +39,8 @@ namespace Quartz
 		bool		ReadStrings();
 		bool		ReadShaderParams();
 		bool		ReadShaderCodes();
+		bool		ReadCompressedCode(const QShaderCode& qShaderCode, ByteBuffer*& pOutBuffer);
+		void		FreeCompressedBuffers();
 
 	public:
 		QShaderParser(File& qShaderFile,
@@ -42,6 +49,9 @@ namespace Quartz
 
 		void SetShader(const Shader& shader);
 
+		/* Code that shrinks is written compressed, other code is stored raw. Off by default */
+		void SetCompression(QCompression compression);
+
 		bool Read();
 		bool Write();
 
@@ -209,6 +209,10 @@ namespace Quartz
 		VERTEX_FORMAT_UINT_2_10_10_10,
 		VERTEX_FORMAT_FLOAT_10_11_11,
 		VERTEX_FORMAT_FLOAT_16_16_16_16,
+		VERTEX_FORMAT_FLOAT16_2,
+		VERTEX_FORMAT_UNORM16_4,
+		VERTEX_FORMAT_SNORM16_2,
+		VERTEX_FORMAT_SNORM16_4,
 		_MAX_VERTEX_FORMAT_ENUM
 	};
 
@@ -344,6 +348,10 @@ namespace Quartz
 			4,  // VERTEX_FORMAT_UINT_2_10_10_10,
 			4,  // VERTEX_FORMAT_FLOAT_10_11_11,
 			8,  // VERTEX_FORMAT_FLOAT_16_16_16_16,
+			4,  // VERTEX_FORMAT_FLOAT16_2,
+			8,  // VERTEX_FORMAT_UNORM16_4,
+			4,  // VERTEX_FORMAT_SNORM16_2,
+			8,  // VERTEX_FORMAT_SNORM16_4,
 			0   // _MAX_VERTEX_FORMAT_ENUM
 		};
 
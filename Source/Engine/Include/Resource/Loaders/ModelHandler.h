@@ -22,5 +22,8 @@ namespace Quartz
 
 		bool LoadAsset(File& assetFile, Asset*& pOutAsset) override;
 		bool UnloadAsset(Asset* pInAsset) override;
+
+		/* Buffers of loaded models, for processing that replaces them */
+		PoolAllocator<ByteBuffer>& GetBufferPool() { return mBufferPool; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "EngineAPI.h"
+#include "Resource/Assets/Model.h"
+
+#define MESH_OPTIMIZER_CACHE_SIZE			16		// FIFO entries, the smallest cache common GPUs behave like
+#define MESH_OPTIMIZER_OVERDRAW_THRESHOLD	1.05f	// Cache efficiency traded for overdraw, as a factor of ACMR
+
+namespace Quartz
+{
+	/* Post-transform cache behaviour of an index buffer under a simulated FIFO cache */
+	struct VertexCacheStats
+	{
+		uSize	triangleCount;
+		uSize	vertexCount;		// Vertices referenced by the indices
+		uSize	transformCount;		// Cache misses
+		float	acmr;				// Transforms per triangle, approaches 0.5 on large regular meshes
+		float	atvr;				// Transforms per vertex, 1.0 is ideal
+	};
+
+	struct MeshOptimizeStats
+	{
+		VertexCacheStats before;
+		VertexCacheStats after;
+	};
+
+	QUARTZ_ENGINE_API VertexCacheStats AnalyzeVertexCache(const uInt32* pIndices, uSize indexCount, uSize vertexCount, uSize cacheSize);
+
+	/* Tipsify triangle order for a FIFO cache of cacheSize entries. pOutIndices may not alias pIndices */
+	QUARTZ_ENGINE_API void OptimizeVertexCache(uInt32* pOutIndices, const uInt32* pIndices, uSize indexCount, uSize vertexCount, uSize cacheSize);
+
+	/*
+		Splits cache optimized triangles into clusters where the cache starts over, or where the
+		running ACMR stays within threshold of the cluster's, then draws outward facing clusters
+		first so they occlude the rest. Positions are float3 at positionStrideBytes apart.
+	*/
+	QUARTZ_ENGINE_API void OptimizeOverdraw(uInt32* pIndices, uSize indexCount, const uInt8* pPositions, uSize positionStrideBytes,
+		uSize vertexCount, uSize cacheSize, float threshold);
+
+	/*
+		Numbers vertices in the order the indices first use them, rewriting the indices. pOutRemap
+		receives the new index of every old vertex, unused vertices are moved to the end.
+	*/
+	QUARTZ_ENGINE_API void OptimizeVertexFetch(uInt32* pOutRemap, uInt32* pIndices, uSize indexCount, uSize vertexCount);
+
+	/*
+		Reorders the triangles of every mesh for the vertex cache and overdraw, then the model's
+		vertices for fetch locality. Streams used in place from a mapped file are not modified.
+		Meshlets are cleared, they no longer match the vertices.
+	*/
+	QUARTZ_ENGINE_API bool OptimizeModel(Model& model, MeshOptimizeStats* pOutStats = nullptr);
+}
\ No newline at end of file
@@ -0,0 +1,46 @@
+#pragma once
+
+#include "EngineAPI.h"
+#include "Types/Array.h"
+#include "Memory/PoolAllocator.h"
+#include "Resource/Assets/Model.h"
+
+#define MESH_SIMPLIFIER_MAX_LODS			8		// Levels after LOD 0
+#define MESH_SIMPLIFIER_MIN_REDUCTION		0.95f	// Levels keeping more triangles than this end the chain
+
+namespace Quartz
+{
+	struct LodChainSettings
+	{
+		uInt32	lodCount;		// Levels generated after LOD 0, at most MESH_SIMPLIFIER_MAX_LODS
+		float	reduction;		// Triangles each level keeps of the one before
+		float	maxError;		// Error a level may add to the one before, relative to the model extent
+		uInt32	minTriangles;	// Meshes this small get no further levels
+	};
+
+	struct LodChainStats
+	{
+		uInt32	levelCount;										// Levels generated for the deepest chain, including LOD 0
+		uSize	triangleCounts[MESH_SIMPLIFIER_MAX_LODS + 1];	// Over every mesh, per level
+		float	maxErrors[MESH_SIMPLIFIER_MAX_LODS + 1];		// Largest Mesh::lodError per level
+	};
+
+	/*
+		Garland and Heckbert, "Surface Simplification Using Quadric Error Metrics". Collapses edges
+		onto existing vertices, cheapest first, until targetIndexCount or maxError (an object space
+		distance) is reached, so only indices change. Borders and attribute seams collapse only along
+		themselves and collapses that would flip a triangle are skipped. pOutIndices may be pIndices.
+		Returns the simplified index count, pOutError receives the largest error of a collapse.
+	*/
+	QUARTZ_ENGINE_API uSize SimplifyMesh(uInt32* pOutIndices, const uInt32* pIndices, uSize indexCount,
+		const uInt8* pPositions, uSize positionStrideBytes, uSize vertexCount,
+		uSize targetIndexCount, float maxError, float* pOutError = nullptr);
+
+	/*
+		Replaces every mesh with a chain of levels, LOD 0 first and each simplified from the level
+		before. Levels share the model's vertices and are appended to a new index stream, and each
+		records in Mesh::lodError how far it may deviate from LOD 0. Meshlets are cleared.
+	*/
+	QUARTZ_ENGINE_API bool GenerateModelLods(Model& model, const LodChainSettings& settings,
+		PoolAllocator<ByteBuffer>& bufferAllocator, LodChainStats* pOutStats = nullptr);
+}
\ No newline at end of file
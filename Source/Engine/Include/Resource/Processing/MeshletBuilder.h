@@ -0,0 +1,39 @@
+#pragma once
+
+#include "EngineAPI.h"
+#include "Types/Array.h"
+#include "Resource/Assets/Model.h"
+
+#define MESHLET_MAX_VERTICES		64
+#define MESHLET_MAX_TRIANGLES		124		// Within common mesh shader output limits
+#define MESHLET_NO_CONE_CUTOFF		2.0f
+
+namespace Quartz
+{
+	struct MeshletStats
+	{
+		uSize	meshletCount;
+		float	averageVertices;
+		float	averageTriangles;
+		float	vertexReuse;		// Triangle corners per meshlet vertex, 3 * 124 / 64 at best
+		float	coneFraction;		// Of meshlets with a normal cone
+		float	averageConeAngle;	// Degrees the normals of a meshlet with a cone spread from its axis
+	};
+
+	/*
+		Splits every mesh into meshlets of at most MESHLET_MAX_VERTICES vertices and
+		MESHLET_MAX_TRIANGLES triangles, growing each from the triangles next to it that add the
+		fewest vertices, then the ones closest to it in position and normal. Replaces
+		model.meshletStream. Meshlets index vertices, so build them after OptimizeModel renumbers.
+	*/
+	QUARTZ_ENGINE_API bool BuildModelMeshlets(Model& model, MeshletStats* pOutStats = nullptr);
+
+	/* True if every triangle of the meshlet faces away from viewPosition, in model space */
+	inline bool IsMeshletBackfacing(const Meshlet& meshlet, const Vec3f& viewPosition)
+	{
+		const Vec3f toApex = meshlet.coneApex - viewPosition;
+		const float distance = toApex.Magnitude();
+
+		return distance > 0.0f && Dot(toApex, meshlet.coneAxis) >= meshlet.coneCutoff * distance;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,54 @@
+#pragma once
+
+#include "EngineAPI.h"
+#include "Types/Array.h"
+#include "Memory/PoolAllocator.h"
+#include "Resource/Assets/Model.h"
+
+namespace Quartz
+{
+	enum VertexQuantizeFlagBits : flags32
+	{
+		VERTEX_QUANTIZE_NONE		= 0x0 << 0,
+		VERTEX_QUANTIZE_POSITIONS	= 0x1 << 0,		// FLOAT3 to UNORM16_4 against the model bounds
+		VERTEX_QUANTIZE_DIRECTIONS	= 0x1 << 1,		// Normals, tangents and bitangents to octahedral SNORM16_2, SNORM16_4 keeps the tangent sign
+		VERTEX_QUANTIZE_TEXCOORDS	= 0x1 << 2,		// FLOAT2 to FLOAT16_2
+		VERTEX_QUANTIZE_ALL			= VERTEX_QUANTIZE_POSITIONS | VERTEX_QUANTIZE_DIRECTIONS | VERTEX_QUANTIZE_TEXCOORDS
+	};
+
+	using VertexQuantizeFlags = flags32;
+
+	/* Largest decoded difference over the vertices a mesh references */
+	struct VertexQuantizeError
+	{
+		float	maxPositionError;		// Object space distance
+		float	maxDirectionError;		// Degrees
+		float	maxTexCoordError;		// Texture space distance
+	};
+
+	struct VertexQuantizeStats
+	{
+		uSize						sizeBytesBefore;	// Of every vertex stream
+		uSize						sizeBytesAfter;
+		Array<VertexQuantizeError>	meshErrors;			// One per mesh, or one for the whole model if it has none
+	};
+
+	/* IEEE half precision, rounded to nearest even */
+	QUARTZ_ENGINE_API uInt16	FloatToHalf(float value);
+	QUARTZ_ENGINE_API float		HalfToFloat(uInt16 half);
+
+	/*
+		Cigolle et al., "A Survey of Efficient Representations for Independent Unit Vectors".
+		Folds the octahedron into the unit square, then picks the rounding that decodes closest.
+	*/
+	QUARTZ_ENGINE_API void		EncodeOctahedral(const float* pDirection, int16* pOutEncoded);
+	QUARTZ_ENGINE_API void		DecodeOctahedral(const int16* pEncoded, float* pOutDirection);
+
+	/*
+		Rewrites the vertex streams with the quantized formats flags selects and updates their
+		vertex elements and strides. Streams are copied into new buffers from bufferAllocator,
+		the old buffers are freed. model.bounds is set from the positions either way.
+	*/
+	QUARTZ_ENGINE_API bool QuantizeModel(Model& model, VertexQuantizeFlags flags,
+		PoolAllocator<ByteBuffer>& bufferAllocator, VertexQuantizeStats* pOutStats = nullptr);
+}
\ No newline at end of file
@@ -10,6 +10,8 @@
 
 #include "Banner.h"
 
+#include <cstdlib>
+
 using namespace Quartz;
 
 class EngineImpl : public Engine
@@ -156,6 +158,14 @@ int main()
 	engineImpl.mpConfig = pConfig;
 	pConfig->PrintConfigs();
 
+	String assetBudgetMB;
+	if (pConfig->GetValue("assetMemoryBudgetMB", assetBudgetMB))
+	{
+		assetManager.SetMemoryBudget((uSize)strtoull(assetBudgetMB.Str(), nullptr, 10) * 1024 * 1024);
+	}
+
+	assetManager.StartLoaders(ASSET_MANAGER_LOADER_THREADS);
+
 	/////////////////////////////////////////////////////////////////////////////////
 
 	/* Initialize Modules */
@@ -214,6 +224,7 @@ int main()
 
 	/* Shutdown */
 
+	assetManager.StopLoaders();
 	assetManager.UnloadAsset<Config>(pConfig);
 
 	moduleRegistry.UnloadAll();
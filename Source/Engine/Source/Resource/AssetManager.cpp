@@ -0,0 +1,429 @@
+#include "Resource/AssetManager.h"
+
+#include <algorithm>
+
+namespace Quartz
+{
+	AssetManager::AssetManager() :
+		mHandlers(128), mAssets(8196), mNextAssetID(1), mTick(0),
+		mTypeBytes(16), mResidentBytes(0), mBudgetBytes(0), mQueueHead(0), mPendingCount(0), mStopLoaders(false) {}
+
+	AssetManager::~AssetManager()
+	{
+		StopLoaders();
+
+		for (auto& assetPair : mAssets)
+		{
+			delete assetPair.value;
+		}
+	}
+
+	AssetHandler* AssetManager::FindHandler(File& assetFile)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		auto& loaderIt = mHandlers.Find(assetFile.GetExtention());
+		if (loaderIt != mHandlers.End())
+		{
+			return loaderIt->value;
+		}
+
+		return nullptr;
+	}
+
+	bool AssetManager::LoadWithHandler(File& assetFile, Asset*& pOutAsset)
+	{
+		Timer loadTimer;
+		loadTimer.Start();
+
+		AssetHandler* pHandler = FindHandler(assetFile);
+
+		if (!pHandler)
+		{
+			LogError("Error loading asset [%s]. No registered loader is associated with the extension '%s'.", 
+				assetFile.GetPath().Str(), assetFile.GetExtention().Str());
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> handlerLock(pHandler->mLoadMutex);
+
+			if (!pHandler->LoadAsset(assetFile, pOutAsset))
+			{
+				// Error message in LoadAsset()
+				return false;
+			}
+		}
+
+		double loadTime = loadTimer.Mark() / 1000000.0;
+
+		LogInfo("[Asset Manager] Loaded %s \"%s\" in %.3lf ms.",
+			pOutAsset->GetAssetTypeName().Str(), assetFile.GetPath().Str(), loadTime);
+
+		return true;
+	}
+
+	bool AssetManager::UnloadWithHandler(File& assetFile, Asset* pAsset)
+	{
+		AssetHandler* pHandler = FindHandler(assetFile);
+
+		if (!pHandler)
+		{
+			// No loader
+			return false;
+		}
+
+		std::lock_guard<std::mutex> handlerLock(pHandler->mLoadMutex);
+		return pHandler->UnloadAsset(pAsset);
+	}
+
+	bool AssetManager::ClaimRequest(File& assetFile, AssetLoadRequest*& pOutRequest)
+	{
+		auto& assetIt = mAssets.Find(assetFile.GetPath());
+		if (assetIt != mAssets.End())
+		{
+			pOutRequest = assetIt->value;
+			pOutRequest->lastUse = ++mTick;
+
+			// Failed and unloaded assets are tried again
+			if (pOutRequest->state.load(std::memory_order_relaxed) != ASSET_LOAD_FAILED)
+			{
+				return false;
+			}
+
+			pOutRequest->state.store(ASSET_LOAD_PENDING, std::memory_order_relaxed);
+		}
+		else
+		{
+			pOutRequest = new AssetLoadRequest(&assetFile);
+			pOutRequest->lastUse = ++mTick;
+			mAssets.Put(assetFile.GetPath(), pOutRequest);
+		}
+
+		mPendingCount++;
+
+		return true;
+	}
+
+	void AssetManager::CompleteRequest(AssetLoadRequest* pRequest)
+	{
+		Asset* pAsset = nullptr;
+		const bool loaded = LoadWithHandler(*pRequest->pFile, pAsset);
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (loaded)
+			{
+				// @TODO: find a better system
+				pAsset->mAssetId		= mNextAssetID;
+				pAsset->mpSourceFile	= pRequest->pFile;
+				pAsset->mLoaded			= true;
+				mNextAssetID++;
+
+				pRequest->pAsset	= pAsset;
+				pRequest->sizeBytes	= pAsset->GetSizeBytes();
+
+				mResidentBytes += pRequest->sizeBytes;
+
+				auto& typeIt = mTypeBytes.Find(pAsset->GetAssetTypeName());
+				if (typeIt != mTypeBytes.End())
+				{
+					typeIt->value += pRequest->sizeBytes;
+				}
+				else
+				{
+					mTypeBytes.Put(pAsset->GetAssetTypeName(), pRequest->sizeBytes);
+				}
+
+				pRequest->state.store(ASSET_LOAD_READY, std::memory_order_release);
+			}
+			else
+			{
+				pRequest->state.store(ASSET_LOAD_FAILED, std::memory_order_release);
+			}
+
+			mPendingCount--;
+			mDoneCondition.notify_all();
+		}
+
+		if (loaded)
+		{
+			Trim();
+		}
+	}
+
+	void AssetManager::ReleaseRequest(AssetLoadRequest* pRequest)
+	{
+		Asset* pAsset = pRequest->pAsset;
+
+		mResidentBytes -= pRequest->sizeBytes;
+
+		auto& typeIt = mTypeBytes.Find(pAsset->GetAssetTypeName());
+		if (typeIt != mTypeBytes.End())
+		{
+			typeIt->value -= pRequest->sizeBytes;
+		}
+
+		// The request is kept for any handles still holding it, they now read as failed
+		pRequest->state.store(ASSET_LOAD_FAILED, std::memory_order_release);
+		pRequest->pAsset	= nullptr;
+		pRequest->pinned	= false;
+		pRequest->sizeBytes	= 0;
+		pAsset->mLoaded		= false;
+	}
+
+	void AssetManager::LoaderThread()
+	{
+		while (true)
+		{
+			std::unique_lock<std::mutex> lock(mMutex);
+
+			mQueueCondition.wait(lock, [this] { return mStopLoaders || mQueueHead < mQueue.Size(); });
+
+			if (mStopLoaders)
+			{
+				return;
+			}
+
+			AssetLoadRequest* pRequest = mQueue[mQueueHead++];
+
+			if (mQueueHead == mQueue.Size())
+			{
+				mQueue.Clear();
+				mQueueHead = 0;
+			}
+
+			lock.unlock();
+
+			CompleteRequest(pRequest);
+		}
+	}
+
+	bool AssetManager::StartLoaders(uSize threadCount)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		if (mLoaderThreads.Size() > 0)
+		{
+			LogError("Failed to start asset loaders: loaders are already running.");
+			return false;
+		}
+
+		mStopLoaders = false;
+
+		for (uSize i = 0; i < threadCount; i++)
+		{
+			mLoaderThreads.PushBack(new std::thread(&AssetManager::LoaderThread, this));
+		}
+
+		return true;
+	}
+
+	void AssetManager::StopLoaders()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mStopLoaders = true;
+		}
+
+		mQueueCondition.notify_all();
+
+		for (std::thread* pThread : mLoaderThreads)
+		{
+			pThread->join();
+			delete pThread;
+		}
+
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		mLoaderThreads.Clear();
+
+		for (uSize i = mQueueHead; i < mQueue.Size(); i++)
+		{
+			LogWarning("[Asset Manager] Load of \"%s\" was cancelled.", mQueue[i]->pFile->GetPath().Str());
+			mQueue[i]->state.store(ASSET_LOAD_FAILED, std::memory_order_release);
+			mPendingCount--;
+		}
+
+		mQueue.Clear();
+		mQueueHead = 0;
+
+		mDoneCondition.notify_all();
+	}
+
+	void AssetManager::WaitForLoads()
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+		mDoneCondition.wait(lock, [this] { return mPendingCount == 0; });
+	}
+
+	void AssetManager::SetMemoryBudget(uSize budgetBytes)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+			mBudgetBytes = budgetBytes;
+		}
+
+		Trim();
+	}
+
+	void AssetManager::Trim()
+	{
+		Array<AssetLoadRequest*> evicted;
+		Array<Asset*> evictedAssets;
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			if (mBudgetBytes == 0 || mResidentBytes <= mBudgetBytes)
+			{
+				return;
+			}
+
+			// New references are only made under the lock, so an unreferenced asset stays unreferenced here
+			Array<AssetLoadRequest*> candidates;
+
+			for (auto& assetPair : mAssets)
+			{
+				AssetLoadRequest* pRequest = assetPair.value;
+
+				if (pRequest->state.load(std::memory_order_relaxed) == ASSET_LOAD_READY && !pRequest->pinned &&
+					pRequest->refCount.load(std::memory_order_acquire) == 0)
+				{
+					candidates.PushBack(pRequest);
+				}
+			}
+
+			std::sort(candidates.begin(), candidates.end(),
+				[](const AssetLoadRequest* pRequest0, const AssetLoadRequest* pRequest1)
+				{
+					return pRequest0->lastUse < pRequest1->lastUse;
+				});
+
+			for (AssetLoadRequest* pRequest : candidates)
+			{
+				if (mResidentBytes <= mBudgetBytes)
+				{
+					break;
+				}
+
+				evicted.PushBack(pRequest);
+				evictedAssets.PushBack(pRequest->pAsset);
+				ReleaseRequest(pRequest);
+			}
+		}
+
+		for (uSize i = 0; i < evicted.Size(); i++)
+		{
+			LogInfo("[Asset Manager] Evicted %s \"%s\".",
+				evictedAssets[i]->GetAssetTypeName().Str(), evicted[i]->pFile->GetPath().Str());
+
+			UnloadWithHandler(*evicted[i]->pFile, evictedAssets[i]);
+		}
+	}
+
+	uSize AssetManager::GetResidentBytes()
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+		return mResidentBytes;
+	}
+
+	uSize AssetManager::GetResidentBytes(const String& assetTypeName)
+	{
+		std::lock_guard<std::mutex> lock(mMutex);
+
+		auto& typeIt = mTypeBytes.Find(assetTypeName);
+		if (typeIt != mTypeBytes.End())
+		{
+			return typeIt->value;
+		}
+
+		return 0;
+	}
+
+	Asset* AssetManager::LoadAssetFile(File& assetFile)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		AssetLoadRequest* pRequest;
+
+		const bool claimed = ClaimRequest(assetFile, pRequest);
+
+		// Held until the asset is pinned, so the Trim after its load cannot evict it first
+		pRequest->refCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (claimed)
+		{
+			lock.unlock();
+			CompleteRequest(pRequest);
+			lock.lock();
+		}
+		else
+		{
+			mDoneCondition.wait(lock, [pRequest] { return pRequest->state.load(std::memory_order_relaxed) != ASSET_LOAD_PENDING; });
+		}
+
+		pRequest->refCount.fetch_sub(1, std::memory_order_release);
+
+		if (pRequest->state.load(std::memory_order_relaxed) != ASSET_LOAD_READY)
+		{
+			return nullptr;
+		}
+
+		pRequest->pinned = true;
+
+		return pRequest->pAsset;
+	}
+
+	AssetLoadRequest* AssetManager::QueueAssetFile(File& assetFile)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		AssetLoadRequest* pRequest;
+
+		const bool claimed = ClaimRequest(assetFile, pRequest);
+
+		// Referenced before the lock is dropped so the asset cannot be evicted under the new handle
+		pRequest->refCount.fetch_add(1, std::memory_order_relaxed);
+
+		if (!claimed)
+		{
+			return pRequest;
+		}
+
+		if (mLoaderThreads.Size() == 0)
+		{
+			lock.unlock();
+			CompleteRequest(pRequest);
+			return pRequest;
+		}
+
+		mQueue.PushBack(pRequest);
+		mQueueCondition.notify_one();
+
+		return pRequest;
+	}
+
+	bool AssetManager::UnloadAssetFile(Asset* pAsset)
+	{
+		if (!pAsset || !pAsset->GetSourceFile())
+		{
+			return false;
+		}
+
+		{
+			std::lock_guard<std::mutex> lock(mMutex);
+
+			auto& assetIt = mAssets.Find(pAsset->GetSourceFile()->GetPath());
+			if (assetIt == mAssets.End() || assetIt->value->pAsset != pAsset)
+			{
+				return false;
+			}
+
+			ReleaseRequest(assetIt->value);
+		}
+
+		return UnloadWithHandler(*pAsset->GetSourceFile(), pAsset);
+	}
+}
\ No newline at end of file
@@ -0,0 +1,374 @@
+#include "Resource/Binary/QCompression.h"
+
+#include "Memory/Memory.h"
+
+#include <atomic>
+#include <thread>
+
+/*
+	LZ4 block format. Each sequence is a token (literal length in the high nibble,
+	match length - 4 in the low nibble, 15 meaning more length bytes follow), the
+	literals, a 16 bit little endian match offset and the extra match length bytes.
+	The last sequence holds literals only, and the last 5 bytes are always literals.
+*/
+
+#define QCOMPRESSION_MIN_MATCH		4
+#define QCOMPRESSION_LAST_LITERALS	5
+#define QCOMPRESSION_MATCH_LIMIT	12		// Matches may not start in the last 12 bytes
+#define QCOMPRESSION_MAX_OFFSET		65535
+
+namespace Quartz
+{
+	static uInt32 Read32(const uInt8* pData)
+	{
+		uInt32 value;
+		MemCopy(&value, pData, 4);
+		return value;
+	}
+
+	static uInt32 HashSequence(uInt32 sequence)
+	{
+		return (sequence * 2654435761u) >> (32 - QCOMPRESSION_HASH_BITS);
+	}
+
+	static uInt8* WriteLength(uInt8* pOut, uSize length)
+	{
+		while (length >= 255)
+		{
+			*pOut++ = 255;
+			length -= 255;
+		}
+
+		*pOut++ = (uInt8)length;
+
+		return pOut;
+	}
+
+	uSize QCompressBound(uSize rawSizeBytes)
+	{
+		return rawSizeBytes + rawSizeBytes / 255 + 16;
+	}
+
+	uSize QCompressLZ(const uInt8* pData, uSize sizeBytes, uInt8* pOutData, uSize outCapacityBytes)
+	{
+		// Positions are kept as 32 bit offsets
+		if (sizeBytes == 0 || sizeBytes > 0xFFFFFFFFull || outCapacityBytes < QCompressBound(sizeBytes))
+		{
+			return 0;
+		}
+
+		uInt32 hashTable[1 << QCOMPRESSION_HASH_BITS] = {};
+
+		const uInt8* pIn		= pData;
+		const uInt8* pAnchor	= pData;
+		const uInt8* pEnd		= pData + sizeBytes;
+		uInt8* pOut				= pOutData;
+
+		if (sizeBytes > QCOMPRESSION_MATCH_LIMIT)
+		{
+			const uInt8* pMatchLimit	= pEnd - QCOMPRESSION_MATCH_LIMIT;
+			const uInt8* pMatchEnd		= pEnd - QCOMPRESSION_LAST_LITERALS;
+
+			while (pIn < pMatchLimit)
+			{
+				const uInt32 sequence	= Read32(pIn);
+				const uInt32 hash		= HashSequence(sequence);
+				const uInt8* pRef		= pData + hashTable[hash];
+
+				hashTable[hash] = (uInt32)(pIn - pData);
+
+				if (pRef >= pIn || pIn - pRef > QCOMPRESSION_MAX_OFFSET || Read32(pRef) != sequence)
+				{
+					pIn++;
+					continue;
+				}
+
+				uSize matchLength = QCOMPRESSION_MIN_MATCH;
+
+				while (pIn + matchLength < pMatchEnd && pRef[matchLength] == pIn[matchLength])
+				{
+					matchLength++;
+				}
+
+				const uSize literalLength	= pIn - pAnchor;
+				uInt8* pToken				= pOut++;
+
+				if (literalLength >= 15)
+				{
+					*pToken = 15 << 4;
+					pOut = WriteLength(pOut, literalLength - 15);
+				}
+				else
+				{
+					*pToken = (uInt8)(literalLength << 4);
+				}
+
+				MemCopy(pOut, pAnchor, literalLength);
+				pOut += literalLength;
+
+				const uInt16 offset = (uInt16)(pIn - pRef);
+				*pOut++ = (uInt8)(offset & 0xFF);
+				*pOut++ = (uInt8)(offset >> 8);
+
+				const uSize extraLength = matchLength - QCOMPRESSION_MIN_MATCH;
+
+				if (extraLength >= 15)
+				{
+					*pToken |= 15;
+					pOut = WriteLength(pOut, extraLength - 15);
+				}
+				else
+				{
+					*pToken |= (uInt8)extraLength;
+				}
+
+				pIn += matchLength;
+				pAnchor = pIn;
+			}
+		}
+
+		/* Last literals */
+
+		const uSize literalLength = pEnd - pAnchor;
+
+		if (literalLength >= 15)
+		{
+			*pOut++ = 15 << 4;
+			pOut = WriteLength(pOut, literalLength - 15);
+		}
+		else
+		{
+			*pOut++ = (uInt8)(literalLength << 4);
+		}
+
+		MemCopy(pOut, pAnchor, literalLength);
+		pOut += literalLength;
+
+		const uSize compressedSizeBytes = pOut - pOutData;
+
+		return compressedSizeBytes < sizeBytes ? compressedSizeBytes : 0;
+	}
+
+	static bool ReadLength(const uInt8*& pIn, const uInt8* pEnd, uSize& length)
+	{
+		uInt8 value;
+
+		do
+		{
+			if (pIn == pEnd)
+			{
+				return false;
+			}
+
+			value = *pIn++;
+			length += value;
+		}
+		while (value == 255);
+
+		return true;
+	}
+
+	uSize QCompressBlockBound(uSize rawSizeBytes)
+	{
+		return sizeof(QCompressedBlock) + QCompressBound(rawSizeBytes);
+	}
+
+	uSize QCompressBlock(const uInt8* pData, uSize sizeBytes, uInt8* pOutBlock)
+	{
+		const uSize compressedSizeBytes = 
+			QCompressLZ(pData, sizeBytes, pOutBlock + sizeof(QCompressedBlock), QCompressBound(sizeBytes));
+
+		// Stored raw unless the block and its header are smaller
+		if (compressedSizeBytes == 0 || compressedSizeBytes + sizeof(QCompressedBlock) >= sizeBytes)
+		{
+			return 0;
+		}
+
+		QCompressedBlock block;
+		block.rawSizeBytes	= sizeBytes;
+		block._reserved0	= 0;
+
+		MemCopy(pOutBlock, &block, sizeof(QCompressedBlock));
+
+		return sizeof(QCompressedBlock) + compressedSizeBytes;
+	}
+
+	bool QPrepareDecompressJob(const uInt8* pBlock, uSize blockSizeBytes, QDecompressJob& outJob)
+	{
+		if (blockSizeBytes < sizeof(QCompressedBlock))
+		{
+			return false;
+		}
+
+		QCompressedBlock block;
+		MemCopy(&block, pBlock, sizeof(QCompressedBlock));
+
+		const uSize compressedSizeBytes = blockSizeBytes - sizeof(QCompressedBlock);
+
+		// Blocks expand at most 255 times, larger raw sizes are corrupt
+		if (block.rawSizeBytes == 0 || block.rawSizeBytes / 255 > compressedSizeBytes)
+		{
+			return false;
+		}
+
+		outJob.pCompressed			= pBlock + sizeof(QCompressedBlock);
+		outJob.compressedSizeBytes	= compressedSizeBytes;
+		outJob.pOutData				= nullptr;
+		outJob.rawSizeBytes			= block.rawSizeBytes;
+
+		return true;
+	}
+
+	bool QDecompressLZ(const uInt8* pCompressed, uSize compressedSizeBytes, uInt8* pOutData, uSize rawSizeBytes)
+	{
+		const uInt8* pIn	= pCompressed;
+		const uInt8* pEnd	= pCompressed + compressedSizeBytes;
+		uInt8* pOut			= pOutData;
+		uInt8* pOutEnd		= pOutData + rawSizeBytes;
+
+		while (pIn < pEnd)
+		{
+			const uInt8 token = *pIn++;
+
+			uSize literalLength = token >> 4;
+
+			if (literalLength == 15 && !ReadLength(pIn, pEnd, literalLength))
+			{
+				return false;
+			}
+
+			if (literalLength > (uSize)(pEnd - pIn) || literalLength > (uSize)(pOutEnd - pOut))
+			{
+				return false;
+			}
+
+			// Short runs copy a fixed 16 bytes when both sides have room
+			if (literalLength <= 16 && pEnd - pIn >= 16 && pOutEnd - pOut >= 16)
+			{
+				MemCopy(pOut, pIn, 16);
+			}
+			else
+			{
+				MemCopy(pOut, pIn, literalLength);
+			}
+
+			pIn		+= literalLength;
+			pOut	+= literalLength;
+
+			if (pIn == pEnd)
+			{
+				break;
+			}
+
+			if (pEnd - pIn < 2)
+			{
+				return false;
+			}
+
+			const uSize offset = (uSize)pIn[0] | ((uSize)pIn[1] << 8);
+			pIn += 2;
+
+			if (offset == 0 || offset > (uSize)(pOut - pOutData))
+			{
+				return false;
+			}
+
+			uSize matchLength = token & 15;
+
+			if (matchLength == 15 && !ReadLength(pIn, pEnd, matchLength))
+			{
+				return false;
+			}
+
+			matchLength += QCOMPRESSION_MIN_MATCH;
+
+			if (matchLength > (uSize)(pOutEnd - pOut))
+			{
+				return false;
+			}
+
+			const uInt8* pMatch = pOut - offset;
+
+			if (offset >= 8 && (uSize)(pOutEnd - pOut) >= matchLength + 8)
+			{
+				// Copies 8 bytes at a time and may write past the match, which later sequences overwrite
+				uInt8* pMatchEnd = pOut + matchLength;
+
+				do
+				{
+					MemCopy(pOut, pMatch, 8);
+					pOut	+= 8;
+					pMatch	+= 8;
+				}
+				while (pOut < pMatchEnd);
+
+				pOut = pMatchEnd;
+			}
+			else if (offset >= matchLength)
+			{
+				MemCopy(pOut, pMatch, matchLength);
+				pOut += matchLength;
+			}
+			else
+			{
+				// Overlapping matches repeat the last offset bytes
+				for (uSize i = 0; i < matchLength; i++)
+				{
+					*pOut++ = *pMatch++;
+				}
+			}
+		}
+
+		return pOut == pOutEnd;
+	}
+
+	bool QDecompressParallel(const QDecompressJob* pJobs, uSize jobCount)
+	{
+		uSize totalBytes = 0;
+
+		for (uSize i = 0; i < jobCount; i++)
+		{
+			totalBytes += pJobs[i].rawSizeBytes;
+		}
+
+		uSize threadCount = jobCount < QCOMPRESSION_MAX_THREADS ? jobCount : QCOMPRESSION_MAX_THREADS;
+
+		if (totalBytes < QCOMPRESSION_PARALLEL_MIN_BYTES)
+		{
+			threadCount = 1;
+		}
+
+		std::atomic<uSize>	nextJob(0);
+		std::atomic<bool>	result(true);
+
+		auto DecodeJobs = [&]()
+		{
+			for (uSize i = nextJob++; i < jobCount; i = nextJob++)
+			{
+				const QDecompressJob& job = pJobs[i];
+
+				if (!QDecompressLZ(job.pCompressed, job.compressedSizeBytes, job.pOutData, job.rawSizeBytes))
+				{
+					result = false;
+				}
+			}
+		};
+
+		// The calling thread decodes too
+		std::thread threads[QCOMPRESSION_MAX_THREADS];
+
+		for (uSize i = 1; i < threadCount; i++)
+		{
+			threads[i] = std::thread(DecodeJobs);
+		}
+
+		DecodeJobs();
+
+		for (uSize i = 1; i < threadCount; i++)
+		{
+			threads[i].join();
+		}
+
+		return result;
+	}
+}
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "Resource/Binary/QModelParser.h"
 
 #include "Log.h"
+#include "Memory/Memory.h"
 
 namespace Quartz
 {
@@ -28,12 +29,12 @@ namespace Quartz
 		streamTable.vertexStreamsSizeBytes	= 0;
 		streamTable.indexStreamOffset		= 0;
 		streamTable.indexStreamSizeBytes	= 0;
-		streamTable.nextExtOffset			= 0;
+		streamTable.meshletStreamOffset		= 0;
 
 		QModel qModel;					// Magic assigned in header
-		qModel.versionMajor				= 1;
-		qModel.versionMinor				= 4;
-		qModel._reserved0				= 0;
+		qModel.versionMajor				= QMODEL_VERSION_MAJOR;
+		qModel.versionMinor				= QMODEL_VERSION_MINOR;
+		qModel.boundsOffset				= 0;
 		qModel.stringTable				= stringTable;
 		qModel.meshTable				= meshTable;
 		qModel.streamTable				= streamTable;
@@ -82,164 +83,308 @@ namespace Quartz
 		return true;
 	}
 
-	bool QModelParser::WriteStrings()
+	static uInt64 AlignStream(uInt64 offset)
 	{
-		mHeader.stringTable.strsOffset = mFile.GetFilePtr();
+		return (offset + QMODEL_STREAM_ALIGNMENT - 1) & ~(uInt64)(QMODEL_STREAM_ALIGNMENT - 1);
+	}
 
-		for (const String& string : mStrings)
+	static bool InFile(uInt64 offset, uInt64 sizeBytes, uInt64 fileSizeBytes)
+	{
+		return offset <= fileSizeBytes && sizeBytes <= fileSizeBytes - offset;
+	}
+
+	uInt64 QModelParser::CompressStream(const uInt8* pData, uInt64 sizeBytes, QCompression& outCompression)
+	{
+		const uInt64 offset = mCompressedData.Size();
+
+		mCompressedOffsets.PushBack(offset);
+		outCompression = QCOMPRESSION_NONE;
+
+		if (mCompression != QCOMPRESSION_LZ || sizeBytes == 0)
 		{
-			uInt16 strLength = string.Length() + 1;
+			return sizeBytes;
+		}
 
-			if (!mFile.WriteValues<uInt16>(&strLength, 1))
-			{
-				return false;
-			}
+		mCompressedData.Resize(offset + QCompressBlockBound(sizeBytes));
 
-			if (!mFile.Write((uInt8*)string.Str(), string.Length() + 1))
-			{
-				return false;
-			}
+		const uSize blockSizeBytes = QCompressBlock(pData, sizeBytes, mCompressedData.Data() + offset);
 
-			mHeader.stringTable.stringCount++;
-			mHeader.stringTable.strsSizeBytes += 2 + strLength;
+		mCompressedData.Resize(offset + blockSizeBytes);
+
+		if (blockSizeBytes == 0)
+		{
+			return sizeBytes;
 		}
 
-		return true;
+		outCompression = QCOMPRESSION_LZ;
+
+		return blockSizeBytes;
 	}
 
-	bool QModelParser::WriteMesh(const Mesh& mesh)
+	void QModelParser::PackMeshlets()
 	{
-		QModelMeshTable& meshTable = mHeader.meshTable;
+		const MeshletStream& meshletStream = mpModel->meshletStream;
 
-		uInt64 fileOffset = mFile.GetFilePtr();
+		const uInt64 meshletsSizeBytes	= meshletStream.meshlets.Size() * sizeof(QModelMeshlet);
+		const uInt64 verticesSizeBytes	= meshletStream.vertices.Size() * sizeof(uInt32);
+		const uInt64 trianglesSizeBytes	= meshletStream.triangles.Size();
 
-		if (meshTable.meshesOffset == 0)
+		mMeshletData.Resize(meshletsSizeBytes + verticesSizeBytes + trianglesSizeBytes);
+
+		for (uSize i = 0; i < meshletStream.meshlets.Size(); i++)
 		{
-			meshTable.meshesOffset = fileOffset;
+			const Meshlet& meshlet = meshletStream.meshlets[i];
+
+			QModelMeshlet qMeshlet;
+			qMeshlet.meshIdx		= meshlet.meshIdx;
+			qMeshlet.vertexStart	= meshlet.vertexStart;
+			qMeshlet.triangleStart	= meshlet.triangleStart;
+			qMeshlet.vertexCount	= meshlet.vertexCount;
+			qMeshlet.triangleCount	= meshlet.triangleCount;
+			qMeshlet.center[0]		= meshlet.center.x;
+			qMeshlet.center[1]		= meshlet.center.y;
+			qMeshlet.center[2]		= meshlet.center.z;
+			qMeshlet.radius			= meshlet.radius;
+			qMeshlet.coneApex[0]	= meshlet.coneApex.x;
+			qMeshlet.coneApex[1]	= meshlet.coneApex.y;
+			qMeshlet.coneApex[2]	= meshlet.coneApex.z;
+			qMeshlet.coneAxis[0]	= meshlet.coneAxis.x;
+			qMeshlet.coneAxis[1]	= meshlet.coneAxis.y;
+			qMeshlet.coneAxis[2]	= meshlet.coneAxis.z;
+			qMeshlet.coneCutoff		= meshlet.coneCutoff;
+
+			MemCopy(mMeshletData.Data() + i * sizeof(QModelMeshlet), &qMeshlet, sizeof(QModelMeshlet));
 		}
 
-		QModelMesh qModelMesh;
-		qModelMesh.nameID		= RegisterString(mesh.name);
-		qModelMesh.materialIdx	= mesh.materialIdx;
-		qModelMesh.lodIdx		= mesh.lod;
-		qModelMesh._reserved0	= 0;
-		qModelMesh._reserved1	= 0;
-		qModelMesh.indexStart	= mesh.indexStart;
-		qModelMesh.indexCount	= mesh.indexCount;
-
-		if (!mFile.WriteValues<QModelMesh>(&qModelMesh, 1))
+		if (verticesSizeBytes > 0)
 		{
-			return false;
+			MemCopy(mMeshletData.Data() + meshletsSizeBytes, meshletStream.vertices.Data(), verticesSizeBytes);
 		}
 
-		meshTable.meshesSizeBytes += sizeof(QModelMesh);
-		meshTable.meshCount++;
+		if (trianglesSizeBytes > 0)
+		{
+			MemCopy(mMeshletData.Data() + meshletsSizeBytes + verticesSizeBytes, meshletStream.triangles.Data(), trianglesSizeBytes);
+		}
 
-		return true;
+		mQMeshletStream.meshletCount	= meshletStream.meshlets.Size();
+		mQMeshletStream._reserved0		= 0;
+		mQMeshletStream.vertexCount		= meshletStream.vertices.Size();
+		mQMeshletStream.triangleCount	= meshletStream.triangles.Size() / 3;
+		mQMeshletStream.streamSizeBytes	= 
+			CompressStream(mMeshletData.Data(), mMeshletData.Size(), mQMeshletStream.compression);
 	}
 
-	bool QModelParser::WriteVertexStream(const VertexStream& stream)
+	void QModelParser::BuildLayout()
 	{
-		QModelStreamTable& streamTable = mHeader.streamTable;
+		QStringTable& stringTable		= mHeader.stringTable;
+		QModelMeshTable& meshTable		= mHeader.meshTable;
+		QModelStreamTable& streamTable	= mHeader.streamTable;
 
-		if (!stream.pVertexBuffer)
+		for (const Mesh& mesh : mpModel->meshes)
 		{
-			// No data for this streamIdx
-			return true;
+			QModelMesh qModelMesh;
+			qModelMesh.nameID		= RegisterString(mesh.name);
+			qModelMesh.materialIdx	= mesh.materialIdx;
+			qModelMesh.lodIdx		= mesh.lod;
+			qModelMesh._reserved0	= 0;
+			qModelMesh.lodError		= mesh.lodError;
+			qModelMesh.indexStart	= mesh.indexStart;
+			qModelMesh.indexCount	= mesh.indexCount;
+
+			mQMeshes.PushBack(qModelMesh);
 		}
 
-		uInt64 fileOffset = mFile.GetFilePtr();
-
-		if (streamTable.vertexStreamsOffset == 0)
+		for (const VertexStream& stream : mpModel->vertexStreams)
 		{
-			streamTable.vertexStreamsOffset = fileOffset;
+			if (!stream.HasData())
+			{
+				// No data for this streamIdx
+				continue;
+			}
+
+			QModelVertexStream qVertexStream;
+			qVertexStream.streamIdx						= stream.streamIdx;
+			qVertexStream.strideBytes					= stream.strideBytes;
+			qVertexStream.elementTable.elementCount		= stream.vertexElements.Size();
+			qVertexStream.elementTable._reserved0		= 0;
+			qVertexStream.streamSizeBytes				= 
+				CompressStream(stream.GetData(), stream.GetSizeBytes(), qVertexStream.compression);
+
+			for (const VertexElement& vertexElement : stream.vertexElements)
+			{
+				QModelVertexElement qVertexElement;
+				qVertexElement.attribute	= vertexElement.attribute;
+				qVertexElement.format		= vertexElement.format;
+				qVertexElement._reserved0	= 0;
+				qVertexElement.offsetBytes	= vertexElement.offsetBytes;
+				qVertexElement.sizeBytes	= vertexElement.sizeBytes;
+
+				mQVertexElements.PushBack(qVertexElement);
+			}
+
+			mQVertexStreams.PushBack(qVertexStream);
 		}
 
-		QModelVertexElementTable qVertexElementTable;
-		qVertexElementTable.elementCount		= stream.vertexElements.Size();
-		qVertexElementTable._reserved0			= 0;
-		qVertexElementTable.elementsOffset		= fileOffset + sizeof(QModelVertexStream);
-		qVertexElementTable.elementsSizeBytes	= qVertexElementTable.elementCount * sizeof(QModelVertexElement);
+		const IndexStream& indexStream = mpModel->indexStream;
 
-		QModelVertexStream qVertexStream;
-		qVertexStream.streamIdx			= stream.streamIdx;
-		qVertexStream._reserved0		= 0;
-		qVertexStream.strideBytes		= stream.strideBytes;
-		qVertexStream.elementTable		= qVertexElementTable;
-		qVertexStream.streamOffset		= qVertexElementTable.elementsOffset + qVertexElementTable.elementsSizeBytes;
- 		qVertexStream.streamSizeBytes	= stream.pVertexBuffer->Size();
+		mQIndexStream.indexElement.format		= indexStream.indexElement.format;
+		mQIndexStream.indexElement._reserved0	= 0;
+		mQIndexStream.indexElement.sizeBytes	= indexStream.indexElement.sizeBytes;
+		mQIndexStream.indexElement._reserved1	= 0;
+		mQIndexStream.indexCount				= indexStream.indexCount;
+		mQIndexStream.maxIndex					= indexStream.maxIndex;
+		mQIndexStream.streamSizeBytes			= 
+			CompressStream(indexStream.GetData(), indexStream.GetSizeBytes(), mQIndexStream.indexElement.compression);
 
-		streamTable.vertexStreamsSizeBytes += sizeof(QModelVertexStream);
+		const bool hasMeshlets = mpModel->meshletStream.meshlets.Size() > 0;
 
-		if (!mFile.WriteValues<QModelVertexStream>(&qVertexStream, 1))
+		if (hasMeshlets)
 		{
-			return false;
+			PackMeshlets();
 		}
 
-		for (const VertexElement& vertexElement : stream.vertexElements)
-		{
-			QModelVertexElement qVertexElement;
-			qVertexElement.attribute	= vertexElement.attribute;
-			qVertexElement.format		= vertexElement.format;
-			qVertexElement._reserved0	= 0;
-			qVertexElement.offsetBytes	= vertexElement.offsetBytes;
-			qVertexElement.sizeBytes	= vertexElement.sizeBytes;
+		/* Tables */
 
-			if (!mFile.WriteValues<QModelVertexElement>(&qVertexElement, 1))
-			{
-				return false;
-			}
+		uInt64 offset = sizeof(QModel);
+
+		mHeader.boundsOffset				= offset;
+		offset += sizeof(QModelBounds);
+
+		meshTable.meshCount					= mQMeshes.Size();
+		meshTable.meshesOffset				= offset;
+		meshTable.meshesSizeBytes			= mQMeshes.Size() * sizeof(QModelMesh);
+		offset += meshTable.meshesSizeBytes;
+
+		streamTable.streamCount				= mQVertexStreams.Size();
+		streamTable.vertexStreamsOffset		= offset;
+		streamTable.vertexStreamsSizeBytes	= mQVertexStreams.Size() * sizeof(QModelVertexStream);
+		offset += streamTable.vertexStreamsSizeBytes;
+
+		for (QModelVertexStream& qVertexStream : mQVertexStreams)
+		{
+			QModelVertexElementTable& elementTable = qVertexStream.elementTable;
+			elementTable.elementsOffset		= offset;
+			elementTable.elementsSizeBytes	= elementTable.elementCount * sizeof(QModelVertexElement);
+			offset += elementTable.elementsSizeBytes;
 		}
 
-		if (!mFile.Write(stream.pVertexBuffer->Data(), stream.pVertexBuffer->Size()))
+		const bool hasIndices = indexStream.HasData();
+
+		streamTable.indexStreamOffset		= hasIndices ? offset : 0;
+		streamTable.indexStreamSizeBytes	= hasIndices ? sizeof(QModelIndexStream) : 0;
+		offset += streamTable.indexStreamSizeBytes;
+
+		streamTable.meshletStreamOffset		= hasMeshlets ? offset : 0;
+		offset += hasMeshlets ? sizeof(QModelMeshletStream) : 0;
+
+		stringTable.strsOffset = offset;
+
+		for (const String& string : mStrings)
 		{
-			return false;
+			stringTable.strsSizeBytes += 2 + string.Length() + 1;
 		}
 
-		streamTable.vertexStreamsSizeBytes += stream.pVertexBuffer->Size();
+		stringTable.stringCount = mStrings.Size();
+		offset += stringTable.strsSizeBytes;
 
-		mHeader.streamTable.streamCount++;
+		/* Stream data */
 
-		return true;
+		for (QModelVertexStream& qVertexStream : mQVertexStreams)
+		{
+			offset = AlignStream(offset);
+			qVertexStream.streamOffset = offset;
+			offset += qVertexStream.streamSizeBytes;
+		}
+
+		if (hasIndices)
+		{
+			offset = AlignStream(offset);
+			mQIndexStream.streamOffset = offset;
+			offset += mQIndexStream.streamSizeBytes;
+		}
+
+		if (hasMeshlets)
+		{
+			offset = AlignStream(offset);
+			mQMeshletStream.streamOffset = offset;
+		}
 	}
 
-	bool QModelParser::WriteIndexStream(const IndexStream& stream)
+	bool QModelParser::WriteTables()
 	{
-		QModelStreamTable& streamTable = mHeader.streamTable;
+		const Bounds3f& bounds = mpModel->bounds;
 
-		uInt64 fileOffset = mFile.GetFilePtr();
+		QModelBounds qBounds;
+		qBounds.min[0] = bounds.min.x;
+		qBounds.min[1] = bounds.min.y;
+		qBounds.min[2] = bounds.min.z;
+		qBounds.max[0] = bounds.max.x;
+		qBounds.max[1] = bounds.max.y;
+		qBounds.max[2] = bounds.max.z;
 
-		if (streamTable.indexStreamOffset == 0)
+		if (!mFile.WriteValues<QModelBounds>(&qBounds, 1))
 		{
-			streamTable.indexStreamOffset = fileOffset;
+			return false;
 		}
 
-		QModelIndexElement qIndexElement;
-		qIndexElement.format		= stream.indexElement.format;
-		qIndexElement._reserved0	= 0;
-		qIndexElement.sizeBytes		= stream.indexElement.sizeBytes;
-		qIndexElement._reserved1	= 0;
+		if (mQMeshes.Size() > 0 && !mFile.WriteValues<QModelMesh>(mQMeshes.Data(), mQMeshes.Size()))
+		{
+			return false;
+		}
 
-		QModelIndexStream qIndexStream;
-		qIndexStream.indexElement		= qIndexElement;
-		qIndexStream.indexCount			= stream.indexCount;
-		qIndexStream.maxIndex			= stream.maxIndex;
-		qIndexStream.streamOffset		= fileOffset + sizeof(QModelIndexStream);
-		qIndexStream.streamSizeBytes	= stream.pIndexBuffer->Size();
+		if (mQVertexStreams.Size() > 0 && !mFile.WriteValues<QModelVertexStream>(mQVertexStreams.Data(), mQVertexStreams.Size()))
+		{
+			return false;
+		}
 
-		streamTable.indexStreamSizeBytes += sizeof(QModelIndexStream);
+		if (mQVertexElements.Size() > 0 && !mFile.WriteValues<QModelVertexElement>(mQVertexElements.Data(), mQVertexElements.Size()))
+		{
+			return false;
+		}
 
-		if (!mFile.WriteValues<QModelIndexStream>(&qIndexStream, 1))
+		if (mHeader.streamTable.indexStreamSizeBytes > 0 && !mFile.WriteValues<QModelIndexStream>(&mQIndexStream, 1))
 		{
 			return false;
 		}
 
-		if (!mFile.Write(stream.pIndexBuffer->Data(), stream.pIndexBuffer->Size()))
+		if (mHeader.streamTable.meshletStreamOffset != 0 && !mFile.WriteValues<QModelMeshletStream>(&mQMeshletStream, 1))
 		{
 			return false;
 		}
 
-		streamTable.indexStreamSizeBytes += stream.pIndexBuffer->Size();
+		for (const String& string : mStrings)
+		{
+			uInt16 strLength = string.Length() + 1;
+
+			if (!mFile.WriteValues<uInt16>(&strLength, 1))
+			{
+				return false;
+			}
+
+			if (!mFile.Write((uInt8*)string.Str(), string.Length() + 1))
+			{
+				return false;
+			}
+		}
+
+		return true;
+	}
+
+	bool QModelParser::WriteStreamData(const uInt8* pData, uInt64 sizeBytes, uInt64 offset, uInt64& fileOffset)
+	{
+		static const uInt8 padding[QMODEL_STREAM_ALIGNMENT] = {};
+
+		if (offset > fileOffset && !mFile.Write(padding, offset - fileOffset))
+		{
+			return false;
+		}
+
+		if (!mFile.Write(pData, sizeBytes))
+		{
+			return false;
+		}
+
+		fileOffset = offset + sizeBytes;
 
 		return true;
 	}
@@ -344,6 +489,7 @@ namespace Quartz
 
 			mesh.materialIdx		= qModelMesh.materialIdx;
 			mesh.lod				= qModelMesh.lodIdx;
+			mesh.lodError			= 0.0f;
 			mesh.indexStart			= qModelMesh.indexStart;
 			mesh.indexCount			= qModelMesh.indexCount;
 		}
@@ -464,54 +610,507 @@ namespace Quartz
 		if (!mFile.Read(indexStream.pIndexBuffer->Data(), qModelIndexStream.streamSizeBytes))
 		{
 			mpBufferAllocator->Free(indexStream.pIndexBuffer);
+			indexStream.pIndexBuffer = nullptr;
 			return false;
 		}
 		
 		return true;
 	}
 
-	bool QModelParser::EndReading()
+	bool QModelParser::ValidateHeader()
 	{
-		mFile.Close();
+		const uInt64 fileSizeBytes				= mFile.GetSize();
+		const QStringTable& stringTable			= mHeader.stringTable;
+		const QModelMeshTable& meshTable		= mHeader.meshTable;
+		const QModelStreamTable& streamTable	= mHeader.streamTable;
+
+		if (meshTable.meshesSizeBytes != (uInt64)meshTable.meshCount * sizeof(QModelMesh) ||
+			streamTable.vertexStreamsSizeBytes != (uInt64)streamTable.streamCount * sizeof(QModelVertexStream) ||
+			(streamTable.indexStreamSizeBytes != 0 && streamTable.indexStreamSizeBytes != sizeof(QModelIndexStream)))
+		{
+			return false;
+		}
+
+		if (!InFile(stringTable.strsOffset, stringTable.strsSizeBytes, fileSizeBytes))
+		{
+			return false;
+		}
+
+		// Strings are the last table, only [0, mTablesEnd) is read when the file cannot be mapped
+		mTablesEnd = stringTable.strsOffset + stringTable.strsSizeBytes;
+
+		if (!InFile(meshTable.meshesOffset, meshTable.meshesSizeBytes, mTablesEnd) ||
+			!InFile(streamTable.vertexStreamsOffset, streamTable.vertexStreamsSizeBytes, mTablesEnd) ||
+			!InFile(streamTable.indexStreamOffset, streamTable.indexStreamSizeBytes, mTablesEnd))
+		{
+			return false;
+		}
+
+		if (mHeader.boundsOffset != 0 && !InFile(mHeader.boundsOffset, sizeof(QModelBounds), mTablesEnd))
+		{
+			return false;
+		}
+
+		if (streamTable.meshletStreamOffset != 0 && !InFile(streamTable.meshletStreamOffset, sizeof(QModelMeshletStream), mTablesEnd))
+		{
+			return false;
+		}
 
 		return true;
 	}
 
-	QModelParser::QModelParser(File& qModelFile, 
-		PoolAllocator<Model>* pModelAllocator,
-		PoolAllocator<ByteBuffer>* pBufferAllocator) :
-		mFile(qModelFile), 
-		mHeader{},
-		mpModelAllocator(pModelAllocator),
-		mpBufferAllocator(pBufferAllocator) { }
+	bool QModelParser::MapTables()
+	{
+		uInt8* pMapData = nullptr;
 
-	void QModelParser::SetModel(const Model& model)
+		if (mFile.Map(pMapData, mFile.GetSize(), FILE_MAP_READ))
+		{
+			mpTables	= pMapData;
+			mMapped		= true;
+
+			return true;
+		}
+
+		LogWarning("QModel File [%s] could not be mapped, streams will be copied.", mFile.GetPath().Str());
+
+		// One read for every table
+		mTableData.Resize(mTablesEnd);
+		mFile.SetFilePtr(0, FILE_PTR_BEGIN);
+
+		if (!mFile.Read(mTableData.Data(), mTablesEnd))
+		{
+			return false;
+		}
+
+		mpTables	= mTableData.Data();
+		mMapped		= false;
+
+		return true;
+	}
+
+	bool QModelParser::ReadStringsV2()
 	{
-		mpModel = const_cast<Model*>(&model);
+		const uInt8* pStrs		= mpTables + mHeader.stringTable.strsOffset;
+		const uInt8* pStrsEnd	= pStrs + mHeader.stringTable.strsSizeBytes;
+
+		for (uSize i = 0; i < mHeader.stringTable.stringCount; i++)
+		{
+			uInt16 strLength = 0;
+
+			if (pStrsEnd - pStrs < 2)
+			{
+				return false;
+			}
+
+			MemCopy(&strLength, pStrs, 2);
+			pStrs += 2;
+
+			if (strLength == 0 || pStrsEnd - pStrs < strLength)
+			{
+				return false;
+			}
+
+			// Lengths count the terminator
+			String string(strLength - 1);
+			MemCopy(string.Data(), pStrs, strLength - 1);
+
+			mStrings.PushBack(string);
+			pStrs += strLength;
+		}
+
+		return true;
 	}
 
-	bool QModelParser::Read()
+	bool QModelParser::ReadMeshesV2()
 	{
-		if (!BeginReading())
+		Model* pModel = mpModelAllocator->Allocate(&mFile);
+		
+		if (!pModel)
 		{
-			mFile.Close();
+			// @TODO: error
 			return false;
 		}
 
-		if (!ReadStrings())
+		mpModel = pModel;
+
+		const QModelMesh* pQModelMeshes = (const QModelMesh*)(mpTables + mHeader.meshTable.meshesOffset);
+
+		uInt64 streamIndexCount = 0;
+
+		if (mHeader.streamTable.indexStreamSizeBytes != 0)
+		{
+			streamIndexCount = ((const QModelIndexStream*)(mpTables + mHeader.streamTable.indexStreamOffset))->indexCount;
+		}
+
+		pModel->meshes.Resize(mHeader.meshTable.meshCount);
+
+		for (uSize i = 0; i < mHeader.meshTable.meshCount; i++)
+		{
+			const QModelMesh& qModelMesh = pQModelMeshes[i];
+			Mesh& mesh = pModel->meshes[i];
+
+			if (qModelMesh.nameID >= mStrings.Size())
+			{
+				return false;
+			}
+
+			// Meshes are drawn and processed straight from these ranges
+			if ((uInt64)qModelMesh.indexStart + qModelMesh.indexCount > streamIndexCount)
+			{
+				return false;
+			}
+
+			mesh.name				= mStrings[qModelMesh.nameID];
+			mesh.materialIdx		= qModelMesh.materialIdx;
+			mesh.lod				= qModelMesh.lodIdx;
+			mesh.lodError			= qModelMesh.lodError;
+			mesh.indexStart			= qModelMesh.indexStart;
+			mesh.indexCount			= qModelMesh.indexCount;
+		}
+
+		return true;
+	}
+
+	bool QModelParser::ReadBoundsV2()
+	{
+		if (mHeader.boundsOffset == 0)
+		{
+			// Written before 2.2, positions are never quantized
+			return true;
+		}
+
+		Bounds3f& bounds = mpModel->bounds;
+
+		QModelBounds qBounds;
+		MemCopy(&qBounds, mpTables + mHeader.boundsOffset, sizeof(QModelBounds));
+
+		bounds.min.x = qBounds.min[0];
+		bounds.min.y = qBounds.min[1];
+		bounds.min.z = qBounds.min[2];
+		bounds.max.x = qBounds.max[0];
+		bounds.max.y = qBounds.max[1];
+		bounds.max.z = qBounds.max[2];
+
+		return true;
+	}
+
+	bool QModelParser::ReadStreamData(uInt64 offset, uInt64 sizeBytes, QCompression compression,
+		ByteBuffer*& pOutBuffer, const uInt8*& pOutMapped)
+	{
+		if (offset % QMODEL_STREAM_ALIGNMENT != 0 || !InFile(offset, sizeBytes, mFile.GetSize()))
 		{
-			mFile.Close();
 			return false;
 		}
 
-		if (!ReadMeshes())
+		if (compression == QCOMPRESSION_NONE)
+		{
+			if (mMapped)
+			{
+				pOutMapped = mpTables + offset;
+				return true;
+			}
+
+			pOutBuffer = mpBufferAllocator->Allocate(sizeBytes);
+
+			if (!pOutBuffer)
+			{
+				return false;
+			}
+
+			pOutBuffer->Allocate(sizeBytes);
+
+			mFile.SetFilePtr(offset, FILE_PTR_BEGIN);
+
+			return mFile.Read(pOutBuffer->Data(), sizeBytes);
+		}
+
+		if (compression != QCOMPRESSION_LZ || sizeBytes < sizeof(QCompressedBlock))
+		{
+			return false;
+		}
+
+		const uInt8* pCompressed = nullptr;
+
+		if (mMapped)
+		{
+			pCompressed = mpTables + offset;
+		}
+		else
+		{
+			ByteBuffer* pCompressedBuffer = mpBufferAllocator->Allocate(sizeBytes);
+
+			if (!pCompressedBuffer)
+			{
+				return false;
+			}
+
+			pCompressedBuffer->Allocate(sizeBytes);
+			mCompressedBuffers.PushBack(pCompressedBuffer);
+
+			mFile.SetFilePtr(offset, FILE_PTR_BEGIN);
+
+			if (!mFile.Read(pCompressedBuffer->Data(), sizeBytes))
+			{
+				return false;
+			}
+
+			pCompressed = pCompressedBuffer->Data();
+		}
+
+		QDecompressJob job;
+
+		if (!QPrepareDecompressJob(pCompressed, sizeBytes, job))
+		{
+			return false;
+		}
+
+		pOutBuffer = mpBufferAllocator->Allocate(job.rawSizeBytes);
+
+		if (!pOutBuffer)
+		{
+			return false;
+		}
+
+		pOutBuffer->Allocate(job.rawSizeBytes);
+
+		// Decoded once every stream is found, see DecompressStreams
+		job.pOutData = pOutBuffer->Data();
+		mDecompressJobs.PushBack(job);
+
+		return true;
+	}
+
+	bool QModelParser::ReadVertexStreamsV2()
+	{
+		const QModelVertexStream* pQVertexStreams = 
+			(const QModelVertexStream*)(mpTables + mHeader.streamTable.vertexStreamsOffset);
+
+		mpModel->vertexStreams.Resize(8);
+
+		uInt32 streamMask = 0;
+
+		for (uSize i = 0; i < mHeader.streamTable.streamCount; i++)
+		{
+			const QModelVertexStream& qModelVertexStream	= pQVertexStreams[i];
+			const QModelVertexElementTable& qElementTable	= qModelVertexStream.elementTable;
+
+			if (qModelVertexStream.streamIdx >= mpModel->vertexStreams.Size() || qElementTable.elementCount > 8)
+			{
+				return false;
+			}
+
+			// A second descriptor for the same streamIdx would replace the first one's buffer
+			if (streamMask & (1u << qModelVertexStream.streamIdx))
+			{
+				return false;
+			}
+
+			streamMask |= 1u << qModelVertexStream.streamIdx;
+
+			if (qElementTable.elementsSizeBytes != qElementTable.elementCount * sizeof(QModelVertexElement) ||
+				!InFile(qElementTable.elementsOffset, qElementTable.elementsSizeBytes, mTablesEnd))
+			{
+				return false;
+			}
+
+			VertexStream& vertexStream	= mpModel->vertexStreams[qModelVertexStream.streamIdx];
+			vertexStream.streamIdx		= qModelVertexStream.streamIdx;
+			vertexStream.strideBytes	= qModelVertexStream.strideBytes;
+
+			const QModelVertexElement* pQVertexElements = (const QModelVertexElement*)(mpTables + qElementTable.elementsOffset);
+
+			vertexStream.vertexElements.Resize(qElementTable.elementCount);
+
+			for (uSize j = 0; j < qElementTable.elementCount; j++)
+			{
+				VertexElement& vertexElement	= vertexStream.vertexElements[j];
+				vertexElement.attribute			= pQVertexElements[j].attribute;
+				vertexElement.offsetBytes		= pQVertexElements[j].offsetBytes;
+				vertexElement.sizeBytes			= pQVertexElements[j].sizeBytes;
+				vertexElement.format			= pQVertexElements[j].format;
+			}
+
+			if (!ReadStreamData(qModelVertexStream.streamOffset, qModelVertexStream.streamSizeBytes, 
+				qModelVertexStream.compression, vertexStream.pVertexBuffer, vertexStream.pMappedData))
+			{
+				return false;
+			}
+
+			vertexStream.mappedSizeBytes = vertexStream.pMappedData ? qModelVertexStream.streamSizeBytes : 0;
+		}
+		
+		return true;
+	}
+
+	bool QModelParser::ReadIndexStreamV2()
+	{
+		if (mHeader.streamTable.indexStreamSizeBytes == 0)
+		{
+			return true;
+		}
+
+		const QModelIndexStream& qModelIndexStream = 
+			*(const QModelIndexStream*)(mpTables + mHeader.streamTable.indexStreamOffset);
+
+		const IndexFormat format = qModelIndexStream.indexElement.format;
+
+		if ((uSize)format >= _MAX_INDEX_FORMAT_ENUM || IndexFormatSizeBytes(format) == 0 ||
+			qModelIndexStream.indexElement.sizeBytes != IndexFormatSizeBytes(format))
+		{
+			return false;
+		}
+
+		IndexStream& indexStream			= mpModel->indexStream;
+		indexStream.indexCount				= qModelIndexStream.indexCount;
+		indexStream.maxIndex				= qModelIndexStream.maxIndex;
+		indexStream.indexElement.format		= format;
+		indexStream.indexElement.sizeBytes	= qModelIndexStream.indexElement.sizeBytes;
+
+		if (!ReadStreamData(qModelIndexStream.streamOffset, qModelIndexStream.streamSizeBytes,
+			qModelIndexStream.indexElement.compression, indexStream.pIndexBuffer, indexStream.pMappedData))
 		{
-			mpModelAllocator->Free(mpModel);
-			mFile.Close();
 			return false;
 		}
 
-		if (!ReadVertexStreams())
+		indexStream.mappedSizeBytes = indexStream.pMappedData ? qModelIndexStream.streamSizeBytes : 0;
+
+		// Decoded size for compressed streams, so a short stream is caught whether or not it was mapped
+		if ((uInt64)indexStream.indexCount * indexStream.indexElement.sizeBytes > indexStream.GetSizeBytes())
+		{
+			return false;
+		}
+
+		return true;
+	}
+
+	bool QModelParser::ReadMeshletStreamV2()
+	{
+		if (mHeader.streamTable.meshletStreamOffset == 0)
+		{
+			// Written before 2.4, or without meshlets
+			return true;
+		}
+
+		MemCopy(&mQMeshletStream, mpTables + mHeader.streamTable.meshletStreamOffset, sizeof(QModelMeshletStream));
+
+		return ReadStreamData(mQMeshletStream.streamOffset, mQMeshletStream.streamSizeBytes,
+			mQMeshletStream.compression, mpMeshletBuffer, mpMappedMeshlets);
+	}
+
+	bool QModelParser::DecompressStreams()
+	{
+		const bool result = QDecompressParallel(mDecompressJobs.Data(), mDecompressJobs.Size());
+
+		FreeCompressedBuffers();
+
+		return result;
+	}
+
+	bool QModelParser::UnpackMeshletsV2()
+	{
+		if (mHeader.streamTable.meshletStreamOffset == 0)
+		{
+			return true;
+		}
+
+		const uInt8* pData		= mpMappedMeshlets ? mpMappedMeshlets : mpMeshletBuffer->Data();
+		const uInt64 sizeBytes	= mpMappedMeshlets ? mQMeshletStream.streamSizeBytes : mpMeshletBuffer->Size();
+
+		const uInt64 meshletsSizeBytes	= (uInt64)mQMeshletStream.meshletCount * sizeof(QModelMeshlet);
+		const uInt64 verticesSizeBytes	= (uInt64)mQMeshletStream.vertexCount * sizeof(uInt32);
+		const uInt64 trianglesSizeBytes	= (uInt64)mQMeshletStream.triangleCount * 3;
+
+		if (sizeBytes != meshletsSizeBytes + verticesSizeBytes + trianglesSizeBytes)
+		{
+			return false;
+		}
+
+		MeshletStream& meshletStream = mpModel->meshletStream;
+
+		meshletStream.meshlets.Resize(mQMeshletStream.meshletCount);
+		meshletStream.vertices.Resize(mQMeshletStream.vertexCount);
+		meshletStream.triangles.Resize(trianglesSizeBytes);
+
+		if (verticesSizeBytes > 0)
+		{
+			MemCopy(meshletStream.vertices.Data(), pData + meshletsSizeBytes, verticesSizeBytes);
+		}
+
+		if (trianglesSizeBytes > 0)
+		{
+			MemCopy(meshletStream.triangles.Data(), pData + meshletsSizeBytes + verticesSizeBytes, trianglesSizeBytes);
+		}
+
+		// Models without meshes are built as one
+		const uSize meshCount = mpModel->meshes.Size() > 0 ? mpModel->meshes.Size() : 1;
+
+		for (uSize i = 0; i < mQMeshletStream.meshletCount; i++)
+		{
+			QModelMeshlet qMeshlet;
+			MemCopy(&qMeshlet, pData + i * sizeof(QModelMeshlet), sizeof(QModelMeshlet));
+
+			if (qMeshlet.meshIdx >= meshCount ||
+				(uInt64)qMeshlet.vertexStart + qMeshlet.vertexCount > mQMeshletStream.vertexCount ||
+				(uInt64)qMeshlet.triangleStart + qMeshlet.triangleCount > mQMeshletStream.triangleCount)
+			{
+				return false;
+			}
+
+			for (uSize j = (uSize)qMeshlet.triangleStart * 3; j < ((uSize)qMeshlet.triangleStart + qMeshlet.triangleCount) * 3; j++)
+			{
+				if (meshletStream.triangles[j] >= qMeshlet.vertexCount)
+				{
+					return false;
+				}
+			}
+
+			Meshlet& meshlet		= meshletStream.meshlets[i];
+			meshlet.meshIdx			= qMeshlet.meshIdx;
+			meshlet.vertexStart		= qMeshlet.vertexStart;
+			meshlet.triangleStart	= qMeshlet.triangleStart;
+			meshlet.vertexCount		= qMeshlet.vertexCount;
+			meshlet.triangleCount	= qMeshlet.triangleCount;
+			meshlet.center			= Vec3f(qMeshlet.center[0], qMeshlet.center[1], qMeshlet.center[2]);
+			meshlet.radius			= qMeshlet.radius;
+			meshlet.coneApex		= Vec3f(qMeshlet.coneApex[0], qMeshlet.coneApex[1], qMeshlet.coneApex[2]);
+			meshlet.coneAxis		= Vec3f(qMeshlet.coneAxis[0], qMeshlet.coneAxis[1], qMeshlet.coneAxis[2]);
+			meshlet.coneCutoff		= qMeshlet.coneCutoff;
+		}
+
+		// Copied out, the stream is not kept
+		if (mpMeshletBuffer)
+		{
+			mpBufferAllocator->Free(mpMeshletBuffer);
+			mpMeshletBuffer = nullptr;
+		}
+
+		mpMappedMeshlets = nullptr;
+
+		return true;
+	}
+
+	void QModelParser::FreeCompressedBuffers()
+	{
+		for (ByteBuffer* pCompressedBuffer : mCompressedBuffers)
+		{
+			mpBufferAllocator->Free(pCompressedBuffer);
+		}
+
+		mCompressedBuffers.Clear();
+		mDecompressJobs.Clear();
+	}
+
+	void QModelParser::FreeModel()
+	{
+		FreeCompressedBuffers();
+
+		if (mpMeshletBuffer)
+		{
+			mpBufferAllocator->Free(mpMeshletBuffer);
+			mpMeshletBuffer = nullptr;
+		}
+
+		if (mpModel)
 		{
 			for (VertexStream& stream : mpModel->vertexStreams)
 			{
@@ -521,26 +1120,126 @@ namespace Quartz
 				}
 			}
 
+			if (mpModel->indexStream.pIndexBuffer)
+			{
+				mpBufferAllocator->Free(mpModel->indexStream.pIndexBuffer);
+			}
+
 			mpModelAllocator->Free(mpModel);
+			mpModel = nullptr;
+		}
+
+		if (mMapped)
+		{
+			mFile.Unmap();
+			mMapped = false;
+		}
+
+		mFile.Close();
+	}
+
+	bool QModelParser::EndReading()
+	{
+		bool inPlace = mpModel->indexStream.pMappedData != nullptr;
+
+		for (const VertexStream& stream : mpModel->vertexStreams)
+		{
+			inPlace |= stream.pMappedData != nullptr;
+		}
+
+		// Mapped streams are read in place, the file is closed when the model is unloaded
+		if (mMapped && inPlace)
+		{
+			return true;
+		}
+
+		// Every stream was compressed and has been decoded
+		if (mMapped)
+		{
+			mFile.Unmap();
+			mMapped = false;
+		}
+
+		mFile.Close();
+
+		return true;
+	}
+
+	QModelParser::QModelParser(File& qModelFile, 
+		PoolAllocator<Model>* pModelAllocator,
+		PoolAllocator<ByteBuffer>* pBufferAllocator) :
+		mFile(qModelFile), 
+		mHeader{},
+		mpModel(nullptr),
+		mpModelAllocator(pModelAllocator),
+		mpBufferAllocator(pBufferAllocator),
+		mpTables(nullptr),
+		mTablesEnd(0),
+		mMapped(false),
+		mCompression(QCOMPRESSION_NONE),
+		mQIndexStream{},
+		mQMeshletStream{},
+		mpMeshletBuffer(nullptr),
+		mpMappedMeshlets(nullptr) { }
+
+	void QModelParser::SetModel(const Model& model)
+	{
+		mpModel = const_cast<Model*>(&model);
+	}
+
+	void QModelParser::SetCompression(QCompression compression)
+	{
+		mCompression = compression;
+	}
+
+	bool QModelParser::Read()
+	{
+		if (!BeginReading())
+		{
 			mFile.Close();
 			return false;
 		}
 
-		if (!ReadIndexStream())
+		if (mHeader.versionMajor >= 2)
 		{
-			for (VertexStream& stream : mpModel->vertexStreams)
+			if (!ValidateHeader())
 			{
-				if (stream.pVertexBuffer)
-				{
-					mpBufferAllocator->Free(stream.pVertexBuffer);
-				}
+				LogError("Error reading QModel File [%s]. Tables lie outside the file.", mFile.GetPath().Str());
+				mFile.Close();
+				return false;
+			}
+
+			if (!MapTables() || !ReadStringsV2() || !ReadMeshesV2() || !ReadBoundsV2() ||
+				!ReadVertexStreamsV2() || !ReadIndexStreamV2() || !ReadMeshletStreamV2() ||
+				!DecompressStreams() || !UnpackMeshletsV2())
+			{
+				LogError("Error reading QModel File [%s]. File is corrupt.", mFile.GetPath().Str());
+				FreeModel();
+				return false;
 			}
 
+			return EndReading();
+		}
+
+		if (!ReadStrings())
+		{
+			mFile.Close();
+			return false;
+		}
+
+		if (!ReadMeshes())
+		{
 			mpModelAllocator->Free(mpModel);
 			mFile.Close();
 			return false;
 		}
 
+		if (!ReadVertexStreams() || !ReadIndexStream())
+		{
+			FreeModel();
+			return false;
+		}
+
 		if(!EndReading())
 		{
 			mFile.Close();
@@ -563,34 +1262,60 @@ namespace Quartz
 			return false;
 		}
 
-		for (const Mesh& mesh : mpModel->meshes)
+		BuildLayout();
+
+		if (!WriteTables())
+		{
+			mFile.Close();
+			return false;
+		}
+
+		uInt64 fileOffset = mHeader.stringTable.strsOffset + mHeader.stringTable.strsSizeBytes;
+		uSize streamIdx = 0;
+
+		for (const VertexStream& vertexStream : mpModel->vertexStreams)
 		{
-			if (!WriteMesh(mesh))
+			if (!vertexStream.HasData())
+			{
+				continue;
+			}
+
+			const QModelVertexStream& qVertexStream = mQVertexStreams[streamIdx];
+			const uInt8* pData = qVertexStream.compression != QCOMPRESSION_NONE ?
+				mCompressedData.Data() + mCompressedOffsets[streamIdx] : vertexStream.GetData();
+
+			streamIdx++;
+
+			if (!WriteStreamData(pData, qVertexStream.streamSizeBytes, qVertexStream.streamOffset, fileOffset))
 			{
 				mFile.Close();
 				return false;
 			}
 		}
 
-		for (const VertexStream& vertexStream : mpModel->vertexStreams)
+		if (mHeader.streamTable.indexStreamSizeBytes > 0)
 		{
-			if (!WriteVertexStream(vertexStream))
+			const uInt8* pData = mQIndexStream.indexElement.compression != QCOMPRESSION_NONE ?
+				mCompressedData.Data() + mCompressedOffsets[streamIdx] : mpModel->indexStream.GetData();
+
+			if (!WriteStreamData(pData, mQIndexStream.streamSizeBytes, mQIndexStream.streamOffset, fileOffset))
 			{
 				mFile.Close();
 				return false;
 			}
 		}
 
-		if (!WriteIndexStream(mpModel->indexStream))
+		if (mHeader.streamTable.meshletStreamOffset != 0)
 		{
-			mFile.Close();
-			return false;
-		}
+			// Compressed after the vertex streams and the index stream
+			const uInt8* pData = mQMeshletStream.compression != QCOMPRESSION_NONE ?
+				mCompressedData.Data() + mCompressedOffsets[mQVertexStreams.Size() + 1] : mMeshletData.Data();
 
-		if (!WriteStrings())
-		{
-			mFile.Close();
-			return false;
+			if (!WriteStreamData(pData, mQMeshletStream.streamSizeBytes, mQMeshletStream.streamOffset, fileOffset))
+			{
+				mFile.Close();
+				return false;
+			}
 		}
 
 		if (!EndWriting())
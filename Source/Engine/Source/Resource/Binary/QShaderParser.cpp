@@ -3,6 +3,7 @@
 #include "Resource/Binary/QShaderParser.h"
 
 #include "Log.h"
+#include "Memory/Memory.h"
 
 namespace Quartz
 {
@@ -31,8 +32,8 @@ namespace Quartz
 		shaderTable.nextExtOffset		= 0;
 
 		QShader qShader;			// Magic assigned in header
-		qShader.versionMajor		= 1;
-		qShader.versionMinor		= 0;
+		qShader.versionMajor		= QSHADER_VERSION_MAJOR;
+		qShader.versionMinor		= QSHADER_VERSION_MINOR;
 		qShader._reserved0			= 0;
 		qShader.stage				= QSHADER_STAGE_INVALID;
 		qShader.sourceLangs			= 0;
@@ -170,8 +171,28 @@ namespace Quartz
 
 		mHeader.sourceLangs |= qShaderCode.lang;
 
+		const uInt8* pCode		= shaderCode.pSourceBuffer->Data();
+		uInt64 codeSizeBytes	= shaderCode.pSourceBuffer->Size();
+
+		Array<uInt8> compressedCode;
+		qShaderCode.compression = QCOMPRESSION_NONE;
+
+		if (mCompression == QCOMPRESSION_LZ && codeSizeBytes > 0)
+		{
+			compressedCode.Resize(QCompressBlockBound(codeSizeBytes));
+
+			const uSize blockSizeBytes = QCompressBlock(pCode, codeSizeBytes, compressedCode.Data());
+
+			if (blockSizeBytes != 0)
+			{
+				qShaderCode.compression	= QCOMPRESSION_LZ;
+				pCode					= compressedCode.Data();
+				codeSizeBytes			= blockSizeBytes;
+			}
+		}
+
 		qShaderCode.codeOffset		= fileOffset + sizeof(QShaderCode);
-		qShaderCode.codeSizeBytes	= shaderCode.pSourceBuffer->Size();
+		qShaderCode.codeSizeBytes	= codeSizeBytes;
 
 		if (!mFile.WriteValues<QShaderCode>(&qShaderCode, 1))
 		{
@@ -180,7 +201,7 @@ namespace Quartz
 
 		shaderTable.shadersSizeBytes += sizeof(QShaderCode);
 
-		if (!mFile.Write(shaderCode.pSourceBuffer->Data(), qShaderCode.codeSizeBytes))
+		if (!mFile.Write(pCode, qShaderCode.codeSizeBytes))
 		{
 			return false;
 		}
@@ -318,6 +339,9 @@ namespace Quartz
 
 		mFile.SetFilePtr(mHeader.shaderTable.shadersOffset, FILE_PTR_BEGIN);
 
+		// 1.0 leaves the compression field unset
+		const bool hasCompression = mHeader.versionMajor > 1 || mHeader.versionMinor >= 1;
+
 		for (uSize i = 0; i < mHeader.shaderTable.shaderCount; i++)
 		{
 			QShaderCode qShaderCode;
@@ -348,6 +372,17 @@ namespace Quartz
 				default: shaderCode.lang = SHADER_LANG_INVALID;
 			}
 
+			if (hasCompression && qShaderCode.compression != QCOMPRESSION_NONE)
+			{
+				if (!ReadCompressedCode(qShaderCode, shaderCode.pSourceBuffer))
+				{
+					return false;
+				}
+
+				mpShader->shaderCodes.PushBack(shaderCode);
+				continue;
+			}
+
 			shaderCode.pSourceBuffer = mpBufferAllocator->Allocate(qShaderCode.codeSizeBytes);
 			shaderCode.pSourceBuffer->Allocate(qShaderCode.codeSizeBytes);
 
@@ -362,22 +397,90 @@ namespace Quartz
 			mpShader->shaderCodes.PushBack(shaderCode);
 		}
 
+		const bool result = QDecompressParallel(mDecompressJobs.Data(), mDecompressJobs.Size());
+
+		FreeCompressedBuffers();
+
+		return result;
+	}
+
+	bool QShaderParser::ReadCompressedCode(const QShaderCode& qShaderCode, ByteBuffer*& pOutBuffer)
+	{
+		if (qShaderCode.compression != QCOMPRESSION_LZ || qShaderCode.codeSizeBytes < sizeof(QCompressedBlock))
+		{
+			return false;
+		}
+
+		ByteBuffer* pCompressedBuffer = mpBufferAllocator->Allocate(qShaderCode.codeSizeBytes);
+
+		if (!pCompressedBuffer)
+		{
+			return false;
+		}
+
+		pCompressedBuffer->Allocate(qShaderCode.codeSizeBytes);
+		mCompressedBuffers.PushBack(pCompressedBuffer);
+
+		mFile.SetFilePtr(qShaderCode.codeOffset, FILE_PTR_BEGIN);
+
+		if (!mFile.Read(pCompressedBuffer->Data(), qShaderCode.codeSizeBytes))
+		{
+			return false;
+		}
+
+		QDecompressJob job;
+
+		if (!QPrepareDecompressJob(pCompressedBuffer->Data(), qShaderCode.codeSizeBytes, job))
+		{
+			return false;
+		}
+
+		pOutBuffer = mpBufferAllocator->Allocate(job.rawSizeBytes);
+
+		if (!pOutBuffer)
+		{
+			return false;
+		}
+
+		pOutBuffer->Allocate(job.rawSizeBytes);
+
+		// Decoded with the other codes once every code is read
+		job.pOutData = pOutBuffer->Data();
+		mDecompressJobs.PushBack(job);
+
 		return true;
 	}
 
+	void QShaderParser::FreeCompressedBuffers()
+	{
+		for (ByteBuffer* pCompressedBuffer : mCompressedBuffers)
+		{
+			mpBufferAllocator->Free(pCompressedBuffer);
+		}
+
+		mCompressedBuffers.Clear();
+		mDecompressJobs.Clear();
+	}
+
 	QShaderParser::QShaderParser(File& qShaderFile, 
 		PoolAllocator<Shader>* pShaderAllocator,
 		PoolAllocator<ByteBuffer>* pBufferAllocator) :
 		mFile(qShaderFile),
 		mHeader{},
 		mpShaderAllocator(pShaderAllocator),
-		mpBufferAllocator(pBufferAllocator) { }
+		mpBufferAllocator(pBufferAllocator),
+		mCompression(QCOMPRESSION_NONE) { }
 
 	void QShaderParser::SetShader(const Shader& shader)
 	{
 		mpShader = const_cast<Shader*>(&shader);
 	}
 
+	void QShaderParser::SetCompression(QCompression compression)
+	{
+		mCompression = compression;
+	}
+
 	bool QShaderParser::Read()
 	{
 		if (!BeginReading())
@@ -402,6 +505,8 @@ namespace Quartz
 
 		if (!ReadShaderCodes())
 		{
+			FreeCompressedBuffers();
+
 			for (ShaderCode& code : mpShader->shaderCodes)
 			{
 				mpBufferAllocator->Free(code.pSourceBuffer);
@@ -141,9 +141,28 @@ namespace Quartz
 	bool ModelHandler::UnloadAsset(Asset* pInAsset)
 	{
 		Model* pModel = static_cast<Model*>(pInAsset);
+		File* pSourceFile = pModel->GetSourceFile();
+
+		// QModel 2.0 streams are read in place from the mapped file
+		if (pSourceFile && pSourceFile->IsMapped())
+		{
+			pSourceFile->Unmap();
+			pSourceFile->Close();
+		}
+
+		for (VertexStream& stream : pModel->vertexStreams)
+		{
+			if (stream.pVertexBuffer)
+			{
+				mBufferPool.Free(stream.pVertexBuffer);
+			}
+		}
+
+		if (pModel->indexStream.pIndexBuffer)
+		{
+			mBufferPool.Free(pModel->indexStream.pIndexBuffer);
+		}
 
-		//mBufferPool.Free(pModel->vertexData.pVertexBuffer);
-		//mBufferPool.Free(pModel->vertexData.pIndexBuffer);
 		mModelPool.Free(pModel);
 
 		return true;
@@ -4,8 +4,16 @@
 #include "Resource/Assets/ObjModel.h"
 #include "Resource/Assets/Model.h"
 
-#include "Utility/StringReader.h"
 #include "Types/Map.h"
+#include "Memory/Memory.h"
+
+#include <math.h>
+#include <string.h>
+#include <thread>
+
+#define OBJ_PARSE_MIN_CHUNK_BYTES	(256 * 1024)	// Smaller files are parsed on the calling thread
+#define OBJ_PARSE_MAX_THREADS		32
+#define OBJ_INDEX_EMPTY				0xFFFFFFFF
 
 namespace Quartz
 {
@@ -33,169 +41,444 @@ namespace Quartz
 		bool flipNormals;
 	};
 
-	inline bool ParseOBJ(const String& data, ObjModel& outObjModel)
+	/* Faces following a usemtl. A chunk's first run continues the material of the chunk before it */
+	struct ObjFaceRun
 	{
-		StringReader parser(data);
+		bool			hasMaterial;
+		uSize			nameStart;		// Material name, as offsets into the file
+		uSize			nameEnd;
+		Array<OBJIndex>	indices;
+	};
 
-		// @NOTE: if objects rehashes, the loader breaks
-		Map<Substring, ObjObject> objects(1024);
-		uSize nextMaterialIdx = 0;
+	/* Everything parsed from one range of lines, merged into the model in file order */
+	struct ObjChunk
+	{
+		Array<Vec3f>		positions;
+		Array<Vec3f>		normals;
+		Array<Vec2f>		texCoords;
+		Array<ObjFaceRun>	runs;
+	};
 
-		ObjObject* pObjObject = &objects.Put(("_obj_model_"_STR).Substring(0), ObjObject());
+	inline bool IsObjSpace(char c)
+	{
+		return c == ' ' || c == '\t' || c == '\r';
+	}
 
-		while (!parser.IsEnd())
+	inline void SkipObjSpaces(const char*& pText, const char* pEnd)
+	{
+		while (pText < pEnd && IsObjSpace(*pText))
 		{
-			parser.SkipWhitespace();
+			pText++;
+		}
+	}
 
-			if (parser.Peek() == '\n' || parser.Peek() == '#')
+	inline void SkipObjLine(const char*& pText, const char* pEnd)
+	{
+		while (pText < pEnd && *pText != '\n')
+		{
+			pText++;
+		}
+	}
+
+	/* Returns false if no digits were read */
+	inline bool ParseObjInt(const char*& pText, const char* pEnd, int64& outValue)
+	{
+		bool negative = false;
+
+		if (pText < pEnd && (*pText == '-' || *pText == '+'))
+		{
+			negative = *pText == '-';
+			pText++;
+		}
+
+		const char* pDigits = pText;
+		int64 value = 0;
+
+		while (pText < pEnd && *pText >= '0' && *pText <= '9')
+		{
+			value = value * 10 + (*pText - '0');
+			pText++;
+		}
+
+		outValue = negative ? -value : value;
+
+		return pText != pDigits;
+	}
+
+	/*
+		Decimal and exponent floats without going through the C locale. Up to 19 significant
+		digits are kept in an integer and scaled once, exact powers of ten up to 1e22 keep
+		the common cases correctly rounded.
+	*/
+	inline float ParseObjFloat(const char*& pText, const char* pEnd)
+	{
+		static const double powersOfTen[] =
+		{
+			1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+			1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+		};
+
+		SkipObjSpaces(pText, pEnd);
+
+		bool negative = false;
+
+		if (pText < pEnd && (*pText == '-' || *pText == '+'))
+		{
+			negative = *pText == '-';
+			pText++;
+		}
+
+		uInt64 mantissa		= 0;
+		int64 exponent		= 0;
+		uSize digitCount	= 0;
+
+		while (pText < pEnd && *pText >= '0' && *pText <= '9')
+		{
+			if (digitCount < 19)
 			{
-				parser.ReadLine();
-				continue;
+				mantissa = mantissa * 10 + (*pText - '0');
+				digitCount += mantissa != 0;
+			}
+			else
+			{
+				exponent++;
 			}
 
-			Substring token = parser.ReadThrough(" "_WRAP);
+			pText++;
+		}
+
+		if (pText < pEnd && *pText == '.')
+		{
+			pText++;
 
-			// Comment
-			if (token.StartsWith("#"_WRAP))
+			while (pText < pEnd && *pText >= '0' && *pText <= '9')
 			{
-				parser.ReadLine();
-				continue;
+				if (digitCount < 19)
+				{
+					mantissa = mantissa * 10 + (*pText - '0');
+					digitCount += mantissa != 0;
+					exponent--;
+				}
+
+				pText++;
 			}
+		}
 
-			// Object
-			else if (token == "usemtl"_WRAP)
+		if (pText < pEnd && (*pText == 'e' || *pText == 'E'))
+		{
+			const char* pExponent = pText + 1;
+			int64 exponentValue = 0;
+
+			if (ParseObjInt(pExponent, pEnd, exponentValue))
 			{
-				parser.SkipWhitespace();
-				
-				Substring objectName = parser.ReadLine();
-				objectName = objectName.TrimWhitespaceReverse();
+				exponent += exponentValue;
+				pText = pExponent;
+			}
+		}
+
+		double value = (double)mantissa;
 
-				if (objectName.Length() > 0)
+		if (mantissa != 0)
+		{
+			if (exponent >= 0 && exponent <= 22)
+			{
+				value *= powersOfTen[exponent];
+			}
+			else if (exponent < 0 && exponent >= -22)
+			{
+				value /= powersOfTen[-exponent];
+			}
+			else
+			{
+				value *= pow(10.0, (double)exponent);
+			}
+		}
+
+		return (float)(negative ? -value : value);
+	}
+
+	inline void ParseObjFace(const char*& pText, const char* pEnd, Array<OBJIndex>& indices)
+	{
+		OBJIndex index{};
+		uInt32 indexCount = 0;
+
+		const uSize startSize = indices.Size();
+
+		while (true)
+		{
+			SkipObjSpaces(pText, pEnd);
+
+			if (pText == pEnd || *pText == '\n')
+			{
+				break;
+			}
+
+			int64 value = 0;
+
+			// Malformed faces are dropped whole
+			if (!ParseObjInt(pText, pEnd, value))
+			{
+				indices.Resize(startSize);
+				SkipObjLine(pText, pEnd);
+				break;
+			}
+
+			// Polygons are split into a fan around their first vertex
+			if (indexCount > 2)
+			{
+				OBJIndex index0 = indices[indices.Size() - 3];
+				OBJIndex index1 = indices[indices.Size() - 1];
+				indices.PushBack(Move(index0));
+				indices.PushBack(Move(index1));
+				indexCount += 2;
+			}
+
+			index.posIdx = (uInt32)(value - 1);
+
+			SkipObjSpaces(pText, pEnd);
+
+			if (pText < pEnd && *pText == '/')
+			{
+				pText++;
+
+				SkipObjSpaces(pText, pEnd);
+
+				// No texCoord
+				if (pText < pEnd && *pText == '/')
 				{
-					auto& objectIt = objects.Find(objectName);
-					if (objectIt != objects.End())
+					pText++;
+
+					if (ParseObjInt(pText, pEnd, value))
 					{
-						pObjObject = &objectIt->value;
+						index.normIdx = (uInt32)(value - 1);
 					}
-					else
-					{
-						ObjObject newObject;
-						newObject.materialName = objectName;
-						newObject.materialIdx = nextMaterialIdx++;
+				}
+				else if (ParseObjInt(pText, pEnd, value))
+				{
+					index.texIdx = (uInt32)(value - 1);
+				}
 
-						pObjObject = &objects.Put(objectName, newObject);
+				if (pText < pEnd && *pText == '/')
+				{
+					pText++;
+
+					if (ParseObjInt(pText, pEnd, value))
+					{
+						index.normIdx = (uInt32)(value - 1);
 					}
 				}
+			}
+
+			indices.PushBack(index);
+			++indexCount;
+		}
+	}
+
+	inline void ParseOBJChunk(const char* pData, uSize startIdx, uSize endIdx, ObjChunk& outChunk)
+	{
+		const char* pText	= pData + startIdx;
+		const char* pEnd	= pData + endIdx;
 
+		ObjFaceRun firstRun = {};
+		outChunk.runs.PushBack(firstRun);
+
+		while (pText < pEnd)
+		{
+			SkipObjSpaces(pText, pEnd);
+
+			if (pText == pEnd)
+			{
+				break;
+			}
+
+			if (*pText == '\n')
+			{
+				pText++;
 				continue;
 			}
 
-			// Vertex position
-			else if (token == "v"_WRAP)
+			const char* pToken = pText;
+
+			while (pText < pEnd && !IsObjSpace(*pText) && *pText != '\n')
 			{
-				parser.SkipWhitespace();
+				pText++;
+			}
 
-				float x = parser.ReadFloat();
-				float y = parser.ReadFloat();
-				float z = parser.ReadFloat();
+			const uSize tokenLength = pText - pToken;
 
-				outObjModel.positions.PushBack(Vec3f{ x, y, z });
+			// Vertex position
+			if (tokenLength == 1 && pToken[0] == 'v')
+			{
+				const float x = ParseObjFloat(pText, pEnd);
+				const float y = ParseObjFloat(pText, pEnd);
+				const float z = ParseObjFloat(pText, pEnd);
 
-				parser.ReadLine();
+				outChunk.positions.PushBack(Vec3f{ x, y, z });
 			}
 
 			// Vertex normal
-			else if (token == "vn"_WRAP)
+			else if (tokenLength == 2 && pToken[0] == 'v' && pToken[1] == 'n')
 			{
-				parser.SkipWhitespace();
+				const float x = ParseObjFloat(pText, pEnd);
+				const float y = ParseObjFloat(pText, pEnd);
+				const float z = ParseObjFloat(pText, pEnd);
 
-				float x = parser.ReadFloat();
-				float y = parser.ReadFloat();
-				float z = parser.ReadFloat();
+				outChunk.normals.PushBack(Vec3f{ x, y, z });
+			}
 
-				outObjModel.normals.PushBack(Vec3f{ x, y, z });
+			// Vertex texture coordinates
+			else if (tokenLength == 2 && pToken[0] == 'v' && pToken[1] == 't')
+			{
+				const float x = ParseObjFloat(pText, pEnd);
+				const float y = ParseObjFloat(pText, pEnd);
 
-				parser.ReadLine();
+				outChunk.texCoords.PushBack(Vec2f{ x, y });
 			}
 
-			// Vertex texture coordinates
-			else if (token == "vt"_WRAP)
+			// Face
+			else if (tokenLength == 1 && pToken[0] == 'f')
+			{
+				ParseObjFace(pText, pEnd, outChunk.runs[outChunk.runs.Size() - 1].indices);
+			}
+
+			// Object
+			else if (tokenLength == 6 && strncmp(pToken, "usemtl", 6) == 0)
 			{
-				parser.SkipWhitespace();
+				SkipObjSpaces(pText, pEnd);
+
+				const char* pName = pText;
+				SkipObjLine(pText, pEnd);
 
-				float x = parser.ReadFloat();
-				float y = parser.ReadFloat();
+				const char* pNameEnd = pText;
+
+				while (pNameEnd > pName && IsObjSpace(pNameEnd[-1]))
+				{
+					pNameEnd--;
+				}
 
-				outObjModel.texCoords.PushBack(Vec2f{ x, y });
+				if (pNameEnd > pName)
+				{
+					ObjFaceRun run = {};
+					run.hasMaterial	= true;
+					run.nameStart	= pName - pData;
+					run.nameEnd		= pNameEnd - pData;
 
-				parser.ReadLine();
+					outChunk.runs.PushBack(run);
+				}
 			}
 
-			// Face
-			else if (token == "f"_WRAP)
+			// Comments and everything else
+			SkipObjLine(pText, pEnd);
+		}
+	}
+
+	template<typename ValueType>
+	inline void AppendObjValues(Array<ValueType>& values, const Array<ValueType>& newValues)
+	{
+		if (newValues.Size() == 0)
+		{
+			return;
+		}
+
+		const uSize offset = values.Size();
+
+		values.Resize(offset + newValues.Size());
+		MemCopy(values.Data() + offset, newValues.Data(), newValues.Size() * sizeof(ValueType));
+	}
+
+	/*
+		Splits the file at line boundaries into chunks parsed on separate threads, then merges
+		the chunks in file order so the result matches a single pass. A threadCount of 0 uses
+		every hardware thread.
+	*/
+	inline bool ParseOBJ(const String& data, ObjModel& outObjModel, uSize threadCount = 0)
+	{
+		const char* pData		= data.Str();
+		const uSize dataLength	= data.Length();
+
+		if (threadCount == 0)
+		{
+			threadCount = std::thread::hardware_concurrency();
+		}
+
+		uSize chunkCount = dataLength / OBJ_PARSE_MIN_CHUNK_BYTES;
+		chunkCount = chunkCount < threadCount ? chunkCount : threadCount;
+		chunkCount = chunkCount < OBJ_PARSE_MAX_THREADS ? chunkCount : OBJ_PARSE_MAX_THREADS;
+		chunkCount = chunkCount > 0 ? chunkCount : 1;
+
+		uSize chunkBounds[OBJ_PARSE_MAX_THREADS + 1];
+		chunkBounds[0]			= 0;
+		chunkBounds[chunkCount]	= dataLength;
+
+		for (uSize i = 1; i < chunkCount; i++)
+		{
+			uSize bound = (dataLength / chunkCount) * i;
+			bound = bound > chunkBounds[i - 1] ? bound : chunkBounds[i - 1];
+
+			// Chunks start on a new line
+			while (bound < dataLength && pData[bound - 1] != '\n')
 			{
-				parser.SkipWhitespace();
+				bound++;
+			}
 
-				StringReader faceLine(parser.ReadLine());
+			chunkBounds[i] = bound;
+		}
 
-				OBJIndex index{};
-				uInt32 indexCount = 0;
+		Array<ObjChunk> chunks;
+		chunks.Resize(chunkCount);
 
-				Array<OBJIndex>& indices = pObjObject->indices;
+		/* Parse */
 
-				while (!faceLine.IsEnd())
-				{
-					if (indexCount > 2)
-					{
-						OBJIndex index0 = indices[indices.Size() - 3];
-						OBJIndex index1 = indices[indices.Size() - 1];
-						indices.PushBack(Move(index0));
-						indices.PushBack(Move(index1));
-						indexCount += 2;
-					}
+		std::thread threads[OBJ_PARSE_MAX_THREADS];
+
+		for (uSize i = 1; i < chunkCount; i++)
+		{
+			threads[i] = std::thread(ParseOBJChunk, pData, chunkBounds[i], chunkBounds[i + 1], std::ref(chunks[i]));
+		}
+
+		ParseOBJChunk(pData, chunkBounds[0], chunkBounds[1], chunks[0]);
+
+		for (uSize i = 1; i < chunkCount; i++)
+		{
+			threads[i].join();
+		}
+
+		/* Merge */
+
+		// @NOTE: if objects rehashes, the loader breaks
+		Map<Substring, ObjObject> objects(1024);
+		uSize nextMaterialIdx = 0;
 
-					faceLine.SkipWhitespace();
+		ObjObject* pObjObject = &objects.Put(("_obj_model_"_STR).Substring(0), ObjObject());
 
-					index.posIdx = faceLine.ReadInt() - 1;
+		for (const ObjChunk& chunk : chunks)
+		{
+			AppendObjValues(outObjModel.positions, chunk.positions);
+			AppendObjValues(outObjModel.normals, chunk.normals);
+			AppendObjValues(outObjModel.texCoords, chunk.texCoords);
 
-					faceLine.SkipWhitespace();
+			for (const ObjFaceRun& run : chunk.runs)
+			{
+				if (run.hasMaterial)
+				{
+					const Substring objectName = data.Substring(run.nameStart, run.nameEnd);
 
-					if (faceLine.Peek() == '/')
+					auto& objectIt = objects.Find(objectName);
+					if (objectIt != objects.End())
 					{
-						faceLine.Read();
-
-						faceLine.SkipWhitespace();
-
-						// No texCoord
-						if (faceLine.Peek() == '/')
-						{
-							faceLine.Read();
-							index.normIdx = faceLine.ReadInt() - 1;
-						}
-						else
-						{
-							index.texIdx = faceLine.ReadInt() - 1;
-						}
-
-						if (faceLine.Peek() == '/')
-						{
-							faceLine.Read();
-							index.normIdx = faceLine.ReadInt() - 1;
-						}
-
-						faceLine.SkipWhitespace();
+						pObjObject = &objectIt->value;
 					}
+					else
+					{
+						ObjObject newObject;
+						newObject.materialName = objectName;
+						newObject.materialIdx = nextMaterialIdx++;
 
-					indices.PushBack(index);
-					++indexCount;
+						pObjObject = &objects.Put(objectName, newObject);
+					}
 				}
-			}
 
-			// Everything else
-			else
-			{
-				parser.ReadLine();
-				continue;
+				AppendObjValues(pObjObject->indices, run.indices);
 			}
 		}
 
@@ -222,7 +505,11 @@ namespace Quartz
 		}
 		else
 		{
-			VertexStream vertexStream = { streamIdx, { streamElement }, nullptr, streamElement.sizeBytes };
+			VertexStream vertexStream;
+			vertexStream.streamIdx		= streamIdx;
+			vertexStream.strideBytes	= streamElement.sizeBytes;
+			vertexStream.vertexElements.PushBack(streamElement);
+
 			outVertexStreams[streamIdx] = vertexStream;
 			streamIdx++;
 		}
@@ -342,40 +629,127 @@ namespace Quartz
 		return true;
 	}
 
-	// Returns true if index was found, false otherwise
-	inline bool WriteIndex(const OBJIndex& objIndex, Map<OBJIndex, uInt32>& indexMap, 
-		uInt32& index, ByteBuffer& indices, bool is16Bit)
+	/* One slot of ObjIndexTable, value is OBJ_INDEX_EMPTY when unused */
+	struct ObjIndexSlot
+	{
+		OBJIndex	key;
+		uInt32		value;
+	};
+
+	/*
+		Open addressing map from OBJ index triples to vertex indices, probed linearly within
+		one flat allocation. Sized up front from the model's attribute counts, which are close
+		to the unique vertex count, and doubled in the rare case that estimate is exceeded.
+	*/
+	struct ObjIndexTable
 	{
-		auto& idxIt0 = indexMap.Find(objIndex);
-		if (idxIt0 != indexMap.End())
+		Array<ObjIndexSlot>	slots;
+		uSize				count;
+		uInt32				shift;
+	};
+
+	inline void InitObjIndexTable(ObjIndexTable& table, uSize expectedEntries)
+	{
+		// At most half full when the estimate holds
+		uSize capacity = 16;
+		uInt32 capacityBits = 4;
+
+		while (capacity < expectedEntries * 2)
 		{
-			if (is16Bit)
-			{
-				indices.Write<uInt16>((uInt16)idxIt0->value);
-			}
-			else
+			capacity <<= 1;
+			capacityBits++;
+		}
+
+		table.slots.Resize(capacity);
+		table.count = 0;
+		table.shift = 64 - capacityBits;
+
+		for (ObjIndexSlot& slot : table.slots)
+		{
+			slot.value = OBJ_INDEX_EMPTY;
+		}
+	}
+
+	inline ObjIndexSlot& FindObjIndexSlot(ObjIndexTable& table, const OBJIndex& objIndex)
+	{
+		const uSize mask = table.slots.Size() - 1;
+
+		// The high bits of the hash depend on all three indices
+		uSize slotIdx = (uSize)((uInt64)Hash<OBJIndex>(objIndex) >> table.shift);
+
+		while (table.slots[slotIdx].value != OBJ_INDEX_EMPTY && table.slots[slotIdx].key != objIndex)
+		{
+			slotIdx = (slotIdx + 1) & mask;
+		}
+
+		return table.slots[slotIdx];
+	}
+
+	inline void GrowObjIndexTable(ObjIndexTable& table)
+	{
+		ObjIndexTable newTable;
+		InitObjIndexTable(newTable, table.slots.Size());
+
+		for (const ObjIndexSlot& slot : table.slots)
+		{
+			if (slot.value != OBJ_INDEX_EMPTY)
 			{
-				indices.Write<uInt32>((uInt32)idxIt0->value);
+				FindObjIndexSlot(newTable, slot.key) = slot;
 			}
+		}
+
+		newTable.count = table.count;
+		table = Move(newTable);
+	}
 
+	// Returns true if the key was found, otherwise inserts newValue
+	inline bool FindOrInsertObjIndex(ObjIndexTable& table, const OBJIndex& objIndex, uInt32 newValue, uInt32& outValue)
+	{
+		ObjIndexSlot* pSlot = &FindObjIndexSlot(table, objIndex);
+
+		if (pSlot->value != OBJ_INDEX_EMPTY)
+		{
+			outValue = pSlot->value;
 			return true;
 		}
+
+		// Kept under three quarters full
+		if ((table.count + 1) * 4 > table.slots.Size() * 3)
+		{
+			GrowObjIndexTable(table);
+			pSlot = &FindObjIndexSlot(table, objIndex);
+		}
+
+		pSlot->key		= objIndex;
+		pSlot->value	= newValue;
+		outValue		= newValue;
+		table.count++;
+
+		return false;
+	}
+
+	// Returns true if index was found, false otherwise
+	inline bool WriteIndex(const OBJIndex& objIndex, ObjIndexTable& indexTable, 
+		uInt32& index, ByteBuffer& indices, bool is16Bit)
+	{
+		uInt32 vertexIndex;
+		const bool found = FindOrInsertObjIndex(indexTable, objIndex, index, vertexIndex);
+
+		if (is16Bit)
+		{
+			indices.Write<uInt16>((uInt16)vertexIndex);
+		}
 		else
 		{
-			if (is16Bit)
-			{
-				indices.Write<uInt16>((uInt16)index);
-			}
-			else
-			{
-				indices.Write<uInt32>((uInt32)index);
-			}
+			indices.Write<uInt32>((uInt32)vertexIndex);
+		}
 
-			indexMap.Put(objIndex, index);
+		if (!found)
+		{
 			index++;
-
-			return false;
 		}
+
+		return found;
 	}
 
 	inline bool WritePosition(bool shouldWrite, uInt32 objPosIdx, const Array<Vec3f>& objPositions, ByteBuffer& vertices)
@@ -501,8 +875,16 @@ namespace Quartz
 
 		ByteBuffer& indices		= *outModel.indexStream.pIndexBuffer;
 
-		Map<OBJIndex, uInt32>	indexMap;
-		uInt32					index = 0;
+		ObjIndexTable	indexTable;
+		uInt32			index = 0;
+
+		// Unique vertices rarely outnumber the largest attribute array by much
+		uSize expectedVertexCount = objModel.positions.Size();
+		expectedVertexCount = objModel.normals.Size() > expectedVertexCount ? objModel.normals.Size() : expectedVertexCount;
+		expectedVertexCount = objModel.texCoords.Size() > expectedVertexCount ? objModel.texCoords.Size() : expectedVertexCount;
+		expectedVertexCount = objModel.maxIndex < expectedVertexCount ? objModel.maxIndex : expectedVertexCount;
+
+		InitObjIndexTable(indexTable, expectedVertexCount);
 
 		for (const ObjObject& object : objModel.objects)
 		{
@@ -512,6 +894,7 @@ namespace Quartz
 
 			mesh.name			= object.materialName;
 			mesh.lod			= 0;
+			mesh.lodError		= 0.0f;
 			mesh.materialIdx	= object.materialIdx;
 			mesh.indexStart		= meshIndexStart;
 
@@ -521,7 +904,7 @@ namespace Quartz
 				const OBJIndex& objIndex1 = object.indices[i + 1];
 				const OBJIndex& objIndex2 = object.indices[i + 2];
 
-				if (!WriteIndex(objIndex0, indexMap, index, indices, is16Bit))
+				if (!WriteIndex(objIndex0, indexTable, index, indices, is16Bit))
 				{
 					WritePosition(settings.writePositions, objIndex0.posIdx, objModel.positions, positions);
 					WriteNormal(settings.writeNormals, objIndex0.normIdx, objModel.normals, normals, 
@@ -530,7 +913,7 @@ namespace Quartz
 					WriteTexCoord(settings.writeTexCoords, objIndex0.texIdx, objModel.texCoords, texCoords);
 				}
 
-				if (!WriteIndex(objIndex1, indexMap, index, indices, is16Bit))
+				if (!WriteIndex(objIndex1, indexTable, index, indices, is16Bit))
 				{
 					WritePosition(settings.writePositions, objIndex1.posIdx, objModel.positions, positions);
 					WriteNormal(settings.writeNormals, objIndex1.normIdx, objModel.normals, normals,
@@ -539,7 +922,7 @@ namespace Quartz
 					WriteTexCoord(settings.writeTexCoords, objIndex1.texIdx, objModel.texCoords, texCoords);
 				}
 
-				if (!WriteIndex(objIndex2, indexMap, index, indices, is16Bit))
+				if (!WriteIndex(objIndex2, indexTable, index, indices, is16Bit))
 				{
 					WritePosition(settings.writePositions, objIndex2.posIdx, objModel.positions, positions);
 					WriteNormal(settings.writeNormals, objIndex2.normIdx, objModel.normals, normals,
@@ -0,0 +1,625 @@
+#include "Resource/Processing/MeshOptimizer.h"
+
+#include "Log.h"
+#include "Memory/Memory.h"
+
+#include <algorithm>
+#include <math.h>
+
+#define MESH_OPTIMIZER_UNUSED 0xFFFFFFFF
+
+namespace Quartz
+{
+	/*
+		A vertex is in the FIFO cache if fewer than cacheSize vertices were transformed since it.
+		Timestamps start past cacheSize so every vertex begins as a miss.
+	*/
+	static bool TransformVertex(Array<uInt32>& cacheTime, uInt32& time, uInt32 vertex, uSize cacheSize)
+	{
+		if (time - cacheTime[vertex] > cacheSize)
+		{
+			cacheTime[vertex] = time++;
+			return true;
+		}
+
+		return false;
+	}
+
+	static void ResetCache(Array<uInt32>& cacheTime, uInt32& time, uSize vertexCount, uSize cacheSize)
+	{
+		cacheTime.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			cacheTime[i] = 0;
+		}
+
+		time = (uInt32)cacheSize + 1;
+	}
+
+	VertexCacheStats AnalyzeVertexCache(const uInt32* pIndices, uSize indexCount, uSize vertexCount, uSize cacheSize)
+	{
+		VertexCacheStats stats = {};
+		stats.triangleCount = indexCount / 3;
+
+		Array<uInt32> cacheTime;
+		uInt32 time;
+
+		ResetCache(cacheTime, time, vertexCount, cacheSize);
+
+		Array<bool> referenced;
+		referenced.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			referenced[i] = false;
+		}
+
+		for (uSize i = 0; i < stats.triangleCount * 3; i++)
+		{
+			const uInt32 vertex = pIndices[i];
+
+			stats.transformCount += TransformVertex(cacheTime, time, vertex, cacheSize);
+
+			if (!referenced[vertex])
+			{
+				referenced[vertex] = true;
+				stats.vertexCount++;
+			}
+		}
+
+		stats.acmr = stats.triangleCount ? (float)stats.transformCount / stats.triangleCount : 0.0f;
+		stats.atvr = stats.vertexCount ? (float)stats.transformCount / stats.vertexCount : 0.0f;
+
+		return stats;
+	}
+
+	/*
+		Sander, Nehab and Barczak, "Fast Triangle Reordering for Vertex Locality and Reduced
+		Overdraw". Emits every remaining triangle around a fanning vertex, then fans next around
+		the vertex emitted last that will still be cached once its remaining triangles are emitted,
+		falling back to recently emitted vertices and then to input order.
+	*/
+	void OptimizeVertexCache(uInt32* pOutIndices, const uInt32* pIndices, uSize indexCount, uSize vertexCount, uSize cacheSize)
+	{
+		const uSize triangleCount = indexCount / 3;
+
+		/* Triangles around each vertex */
+
+		Array<uInt32> liveCounts;
+		Array<uInt32> adjacencyOffsets;
+		Array<uInt32> adjacency;
+
+		liveCounts.Resize(vertexCount);
+		adjacencyOffsets.Resize(vertexCount + 1);
+		adjacency.Resize(triangleCount * 3);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			liveCounts[i] = 0;
+		}
+
+		for (uSize i = 0; i < triangleCount * 3; i++)
+		{
+			liveCounts[pIndices[i]]++;
+		}
+
+		adjacencyOffsets[0] = 0;
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			adjacencyOffsets[i + 1] = adjacencyOffsets[i] + liveCounts[i];
+		}
+
+		Array<uInt32> fillOffsets;
+		fillOffsets.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			fillOffsets[i] = adjacencyOffsets[i];
+		}
+
+		for (uSize i = 0; i < triangleCount * 3; i++)
+		{
+			adjacency[fillOffsets[pIndices[i]]++] = (uInt32)(i / 3);
+		}
+
+		/* Fan */
+
+		Array<uInt32> cacheTime;
+		uInt32 time;
+
+		ResetCache(cacheTime, time, vertexCount, cacheSize);
+
+		Array<bool> emitted;
+		emitted.Resize(triangleCount);
+
+		for (uSize i = 0; i < triangleCount; i++)
+		{
+			emitted[i] = false;
+		}
+
+		Array<uInt32> deadEnd;
+		Array<uInt32> candidates;
+		deadEnd.Reserve(triangleCount * 3);
+
+		uSize deadEndSize	= 0;
+		uSize cursor		= 0;
+		uSize outCount		= 0;
+
+		int64 fanVertex = triangleCount > 0 ? pIndices[0] : -1;
+
+		while (fanVertex >= 0)
+		{
+			candidates.Clear();
+
+			for (uInt32 i = adjacencyOffsets[fanVertex]; i < adjacencyOffsets[fanVertex + 1]; i++)
+			{
+				const uInt32 triangle = adjacency[i];
+
+				if (emitted[triangle])
+				{
+					continue;
+				}
+
+				for (uSize j = 0; j < 3; j++)
+				{
+					const uInt32 vertex = pIndices[triangle * 3 + j];
+
+					pOutIndices[outCount++] = vertex;
+
+					if (deadEndSize == deadEnd.Size())
+					{
+						deadEnd.PushBack(vertex);
+					}
+					else
+					{
+						deadEnd[deadEndSize] = vertex;
+					}
+
+					deadEndSize++;
+
+					candidates.PushBack(vertex);
+					liveCounts[vertex]--;
+
+					TransformVertex(cacheTime, time, vertex, cacheSize);
+				}
+
+				emitted[triangle] = true;
+			}
+
+			/* Next fanning vertex */
+
+			fanVertex = -1;
+			int64 bestPriority = -1;
+
+			for (uInt32 vertex : candidates)
+			{
+				if (liveCounts[vertex] == 0)
+				{
+					continue;
+				}
+
+				int64 priority = 0;
+
+				// Oldest vertex that stays cached while its triangles are emitted
+				if (time - cacheTime[vertex] + 2 * liveCounts[vertex] <= cacheSize)
+				{
+					priority = time - cacheTime[vertex];
+				}
+
+				if (priority > bestPriority)
+				{
+					bestPriority	= priority;
+					fanVertex		= vertex;
+				}
+			}
+
+			while (fanVertex < 0 && deadEndSize > 0)
+			{
+				const uInt32 vertex = deadEnd[--deadEndSize];
+
+				if (liveCounts[vertex] > 0)
+				{
+					fanVertex = vertex;
+				}
+			}
+
+			while (fanVertex < 0 && cursor < vertexCount)
+			{
+				if (liveCounts[cursor] > 0)
+				{
+					fanVertex = cursor;
+				}
+
+				cursor++;
+			}
+		}
+	}
+
+	struct OverdrawCluster
+	{
+		float	sortKey;
+		uInt32	clusterIdx;
+	};
+
+	void OptimizeOverdraw(uInt32* pIndices, uSize indexCount, const uInt8* pPositions, uSize positionStrideBytes,
+		uSize vertexCount, uSize cacheSize, float threshold)
+	{
+		const uSize triangleCount = indexCount / 3;
+
+		if (triangleCount == 0)
+		{
+			return;
+		}
+
+		Array<uInt32> cacheTime;
+		uInt32 time;
+
+		ResetCache(cacheTime, time, vertexCount, cacheSize);
+
+		auto TransformTriangle = [&](uSize triangle)
+		{
+			return (uInt32)TransformVertex(cacheTime, time, pIndices[triangle * 3 + 0], cacheSize) +
+				(uInt32)TransformVertex(cacheTime, time, pIndices[triangle * 3 + 1], cacheSize) +
+				(uInt32)TransformVertex(cacheTime, time, pIndices[triangle * 3 + 2], cacheSize);
+		};
+
+		/* Hard boundaries, where all three vertices of a triangle miss */
+
+		Array<uInt32> hardBoundaries;
+		hardBoundaries.PushBack(0);
+
+		TransformTriangle(0);
+
+		for (uSize i = 1; i < triangleCount; i++)
+		{
+			if (TransformTriangle(i) == 3)
+			{
+				hardBoundaries.PushBack((uInt32)i);
+			}
+		}
+
+		hardBoundaries.PushBack((uInt32)triangleCount);
+
+		/* Soft boundaries, where the cache has warmed up to within threshold of the cluster */
+
+		Array<uInt32> clusterStarts;
+
+		for (uSize i = 0; i + 1 < hardBoundaries.Size(); i++)
+		{
+			const uSize start	= hardBoundaries[i];
+			const uSize end		= hardBoundaries[i + 1];
+
+			time += (uInt32)cacheSize + 1;
+
+			uSize clusterMisses = 0;
+
+			for (uSize j = start; j < end; j++)
+			{
+				clusterMisses += TransformTriangle(j);
+			}
+
+			const float clusterThreshold = threshold * (float)clusterMisses / (float)(end - start);
+
+			clusterStarts.PushBack((uInt32)start);
+			time += (uInt32)cacheSize + 1;
+
+			uSize runningMisses		= 0;
+			uSize runningTriangles	= 0;
+
+			for (uSize j = start; j < end; j++)
+			{
+				runningMisses += TransformTriangle(j);
+				runningTriangles++;
+
+				if ((float)runningMisses / (float)runningTriangles <= clusterThreshold)
+				{
+					clusterStarts.PushBack((uInt32)(j + 1));
+					time += (uInt32)cacheSize + 1;
+
+					runningMisses		= 0;
+					runningTriangles	= 0;
+				}
+			}
+
+			if (clusterStarts[clusterStarts.Size() - 1] == end)
+			{
+				clusterStarts.Resize(clusterStarts.Size() - 1);
+			}
+		}
+
+		const uSize clusterCount = clusterStarts.Size();
+		clusterStarts.PushBack((uInt32)triangleCount);
+
+		/* Sort outward facing clusters first */
+
+		auto ReadPosition = [&](uInt32 vertex)
+		{
+			Vec3f position;
+			MemCopy(&position, pPositions + (uSize)vertex * positionStrideBytes, sizeof(Vec3f));
+			return position;
+		};
+
+		Vec3f meshCentroid(0.0f, 0.0f, 0.0f);
+
+		for (uSize i = 0; i < triangleCount * 3; i++)
+		{
+			meshCentroid = meshCentroid + ReadPosition(pIndices[i]);
+		}
+
+		meshCentroid = meshCentroid * (1.0f / (float)(triangleCount * 3));
+
+		Array<OverdrawCluster> clusters;
+		clusters.Resize(clusterCount);
+
+		for (uSize i = 0; i < clusterCount; i++)
+		{
+			Vec3f centroid(0.0f, 0.0f, 0.0f);
+			Vec3f normal(0.0f, 0.0f, 0.0f);
+			float area = 0.0f;
+
+			for (uSize j = clusterStarts[i]; j < clusterStarts[i + 1]; j++)
+			{
+				const Vec3f position0 = ReadPosition(pIndices[j * 3 + 0]);
+				const Vec3f position1 = ReadPosition(pIndices[j * 3 + 1]);
+				const Vec3f position2 = ReadPosition(pIndices[j * 3 + 2]);
+
+				// Twice the area, pointing along the face normal
+				const Vec3f areaNormal		= Cross(position1 - position0, position2 - position0);
+				const float triangleArea	= sqrtf(Dot(areaNormal, areaNormal));
+
+				centroid	= centroid + (position0 + position1 + position2) * (triangleArea / 3.0f);
+				normal		= normal + areaNormal;
+				area		+= triangleArea;
+			}
+
+			const float normalLength = sqrtf(Dot(normal, normal));
+
+			clusters[i].clusterIdx	= (uInt32)i;
+			clusters[i].sortKey		= 0.0f;
+
+			if (area > 0.0f && normalLength > 0.0f)
+			{
+				centroid = centroid * (1.0f / area);
+				clusters[i].sortKey = Dot(centroid - meshCentroid, normal * (1.0f / normalLength));
+			}
+		}
+
+		std::sort(clusters.Data(), clusters.Data() + clusters.Size(),
+			[](const OverdrawCluster& cluster0, const OverdrawCluster& cluster1)
+			{
+				if (cluster0.sortKey != cluster1.sortKey)
+				{
+					return cluster0.sortKey > cluster1.sortKey;
+				}
+
+				return cluster0.clusterIdx < cluster1.clusterIdx;
+			});
+
+		Array<uInt32> sortedIndices;
+		sortedIndices.Resize(triangleCount * 3);
+
+		uSize outCount = 0;
+
+		for (const OverdrawCluster& cluster : clusters)
+		{
+			const uSize startIdx	= clusterStarts[cluster.clusterIdx] * 3;
+			const uSize endIdx		= clusterStarts[cluster.clusterIdx + 1] * 3;
+
+			MemCopy(sortedIndices.Data() + outCount, pIndices + startIdx, (endIdx - startIdx) * sizeof(uInt32));
+			outCount += endIdx - startIdx;
+		}
+
+		MemCopy(pIndices, sortedIndices.Data(), triangleCount * 3 * sizeof(uInt32));
+	}
+
+	void OptimizeVertexFetch(uInt32* pOutRemap, uInt32* pIndices, uSize indexCount, uSize vertexCount)
+	{
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			pOutRemap[i] = MESH_OPTIMIZER_UNUSED;
+		}
+
+		uInt32 nextVertex = 0;
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			uInt32& remap = pOutRemap[pIndices[i]];
+
+			if (remap == MESH_OPTIMIZER_UNUSED)
+			{
+				remap = nextVertex++;
+			}
+
+			pIndices[i] = remap;
+		}
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			if (pOutRemap[i] == MESH_OPTIMIZER_UNUSED)
+			{
+				pOutRemap[i] = nextVertex++;
+			}
+		}
+	}
+
+	bool OptimizeModel(Model& model, MeshOptimizeStats* pOutStats)
+	{
+		IndexStream& indexStream = model.indexStream;
+
+		if (!indexStream.pIndexBuffer || indexStream.pMappedData)
+		{
+			LogError("Failed to optimize model. The index stream has no writable buffer.");
+			return false;
+		}
+
+		const IndexFormat indexFormat = indexStream.indexElement.format;
+
+		if (indexFormat != INDEX_FORMAT_UINT16 && indexFormat != INDEX_FORMAT_UINT32)
+		{
+			LogError("Failed to optimize model. Unsupported index format.");
+			return false;
+		}
+
+		const uSize indexSizeBytes	= IndexFormatSizeBytes(indexFormat);
+		const uSize indexCount		= indexStream.indexCount;
+
+		if (indexCount * indexSizeBytes > indexStream.pIndexBuffer->Size())
+		{
+			LogError("Failed to optimize model. The index stream is smaller than its index count.");
+			return false;
+		}
+
+		/* Widen indices */
+
+		Array<uInt32> indices;
+		indices.Resize(indexCount);
+
+		const uInt8* pIndexData = indexStream.pIndexBuffer->Data();
+		uInt32 maxIndex = 0;
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			indices[i] = indexFormat == INDEX_FORMAT_UINT16 ? ((const uInt16*)pIndexData)[i] : ((const uInt32*)pIndexData)[i];
+			maxIndex = indices[i] > maxIndex ? indices[i] : maxIndex;
+		}
+
+		/* Every stream is permuted, so each must be writable and hold every vertex */
+
+		uSize vertexCount = indexCount > 0 ? (uSize)maxIndex + 1 : 0;
+		bool hasStreams = false;
+
+		const uInt8* pPositions		= nullptr;
+		uSize positionStrideBytes	= 0;
+
+		for (VertexStream& stream : model.vertexStreams)
+		{
+			if (stream.pMappedData)
+			{
+				LogError("Failed to optimize model. Vertex stream %d is mapped read-only.", stream.streamIdx);
+				return false;
+			}
+
+			if (!stream.pVertexBuffer)
+			{
+				continue;
+			}
+
+			if (stream.strideBytes == 0 || stream.pVertexBuffer->Size() / stream.strideBytes < (uSize)maxIndex + 1)
+			{
+				LogError("Failed to optimize model. Vertex stream %d is smaller than the indices require.", stream.streamIdx);
+				return false;
+			}
+
+			const uSize streamVertexCount = stream.pVertexBuffer->Size() / stream.strideBytes;
+			vertexCount = hasStreams && vertexCount < streamVertexCount ? vertexCount : streamVertexCount;
+			hasStreams = true;
+
+			for (const VertexElement& element : stream.vertexElements)
+			{
+				if (element.attribute == VERTEX_ATTRIBUTE_POSITION && element.format == VERTEX_FORMAT_FLOAT3 && !pPositions)
+				{
+					pPositions			= stream.pVertexBuffer->Data() + element.offsetBytes;
+					positionStrideBytes	= stream.strideBytes;
+				}
+			}
+		}
+
+		if (pOutStats)
+		{
+			pOutStats->before = AnalyzeVertexCache(indices.Data(), indexCount, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+		}
+
+		/* Reorder triangles within each mesh */
+
+		Array<uInt32> meshIndices;
+
+		auto OptimizeRange = [&](uSize indexStart, uSize rangeCount)
+		{
+			rangeCount -= rangeCount % 3;
+
+			if (rangeCount == 0 || indexStart + rangeCount > indexCount)
+			{
+				return;
+			}
+
+			meshIndices.Resize(rangeCount);
+
+			OptimizeVertexCache(meshIndices.Data(), indices.Data() + indexStart, rangeCount, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+
+			if (pPositions)
+			{
+				OptimizeOverdraw(meshIndices.Data(), rangeCount, pPositions, positionStrideBytes,
+					vertexCount, MESH_OPTIMIZER_CACHE_SIZE, MESH_OPTIMIZER_OVERDRAW_THRESHOLD);
+			}
+
+			MemCopy(indices.Data() + indexStart, meshIndices.Data(), rangeCount * sizeof(uInt32));
+		};
+
+		if (model.meshes.Size() == 0)
+		{
+			OptimizeRange(0, indexCount);
+		}
+
+		for (const Mesh& mesh : model.meshes)
+		{
+			OptimizeRange(mesh.indexStart, mesh.indexCount);
+		}
+
+		/* Renumber vertices by first use */
+
+		Array<uInt32> remap;
+		remap.Resize(vertexCount);
+
+		OptimizeVertexFetch(remap.Data(), indices.Data(), indexCount, vertexCount);
+
+		Array<uInt8> vertexData;
+
+		for (VertexStream& stream : model.vertexStreams)
+		{
+			if (!stream.pVertexBuffer)
+			{
+				continue;
+			}
+
+			const uSize strideBytes = stream.strideBytes;
+			uInt8* pStreamData = stream.pVertexBuffer->Data();
+
+			vertexData.Resize(vertexCount * strideBytes);
+
+			for (uSize i = 0; i < vertexCount; i++)
+			{
+				MemCopy(vertexData.Data() + (uSize)remap[i] * strideBytes, pStreamData + i * strideBytes, strideBytes);
+			}
+
+			MemCopy(pStreamData, vertexData.Data(), vertexCount * strideBytes);
+		}
+
+		/* Narrow indices */
+
+		uInt8* pOutIndexData = indexStream.pIndexBuffer->Data();
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			if (indexFormat == INDEX_FORMAT_UINT16)
+			{
+				((uInt16*)pOutIndexData)[i] = (uInt16)indices[i];
+			}
+			else
+			{
+				((uInt32*)pOutIndexData)[i] = indices[i];
+			}
+		}
+
+		// Meshlets index the old vertex order
+		model.meshletStream = MeshletStream();
+
+		if (pOutStats)
+		{
+			pOutStats->after = AnalyzeVertexCache(indices.Data(), indexCount, vertexCount, MESH_OPTIMIZER_CACHE_SIZE);
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,1028 @@
+#include "Resource/Processing/MeshSimplifier.h"
+
+#include "Log.h"
+#include "Memory/Memory.h"
+
+#include <algorithm>
+#include <math.h>
+
+#define MESH_SIMPLIFIER_NONE			0xFFFFFFFF
+#define MESH_SIMPLIFIER_BORDER_WEIGHT	10.0	// Border edges hold their shape more than the surface does
+#define MESH_SIMPLIFIER_SEAM_WEIGHT		1.0
+#define MESH_SIMPLIFIER_MIN_FLIP_COS	0.2f	// Cosine of the largest turn a triangle may make in one collapse
+
+namespace Quartz
+{
+	enum SimplifyVertexKind : uInt8
+	{
+		SIMPLIFY_VERTEX_MANIFOLD,	// Interior, with one set of attributes
+		SIMPLIFY_VERTEX_BORDER,		// On an open edge of the surface
+		SIMPLIFY_VERTEX_SEAM,		// Interior, with two sets of attributes split along an edge loop
+		SIMPLIFY_VERTEX_LOCKED		// Anything else, never collapsed
+	};
+
+	/* Symmetric 3x3 matrix, vector and constant of the summed squared plane distances */
+	struct SimplifyQuadric
+	{
+		double a00, a11, a22;
+		double a01, a02, a12;
+		double b0, b1, b2;
+		double c;
+		double weight;
+	};
+
+	struct SimplifyCollapse
+	{
+		uInt32	from;
+		uInt32	to;
+		float	error;		// Squared distance
+	};
+
+	/* Per vertex ranges of one array, vertex i owns data[offsets[i]] to data[offsets[i + 1]] */
+	struct SimplifyAdjacency
+	{
+		Array<uInt32> offsets;
+		Array<uInt32> data;
+	};
+
+	static void AddPlaneQuadric(SimplifyQuadric& quadric, const Vec3f& normal, float distance, double weight)
+	{
+		const double x = normal.x;
+		const double y = normal.y;
+		const double z = normal.z;
+		const double d = distance;
+
+		quadric.a00		+= weight * x * x;
+		quadric.a11		+= weight * y * y;
+		quadric.a22		+= weight * z * z;
+		quadric.a01		+= weight * x * y;
+		quadric.a02		+= weight * x * z;
+		quadric.a12		+= weight * y * z;
+		quadric.b0		+= weight * x * d;
+		quadric.b1		+= weight * y * d;
+		quadric.b2		+= weight * z * d;
+		quadric.c		+= weight * d * d;
+		quadric.weight	+= weight;
+	}
+
+	static void AddQuadric(SimplifyQuadric& quadric, const SimplifyQuadric& other)
+	{
+		quadric.a00		+= other.a00;
+		quadric.a11		+= other.a11;
+		quadric.a22		+= other.a22;
+		quadric.a01		+= other.a01;
+		quadric.a02		+= other.a02;
+		quadric.a12		+= other.a12;
+		quadric.b0		+= other.b0;
+		quadric.b1		+= other.b1;
+		quadric.b2		+= other.b2;
+		quadric.c		+= other.c;
+		quadric.weight	+= other.weight;
+	}
+
+	/* Weighted mean of the squared distances to every plane in the quadric */
+	static float QuadricError(const SimplifyQuadric& quadric, const Vec3f& position)
+	{
+		const double x = position.x;
+		const double y = position.y;
+		const double z = position.z;
+
+		const double error =
+			quadric.a00 * x * x + quadric.a11 * y * y + quadric.a22 * z * z +
+			2.0 * (quadric.a01 * x * y + quadric.a02 * x * z + quadric.a12 * y * z) +
+			2.0 * (quadric.b0 * x + quadric.b1 * y + quadric.b2 * z) + quadric.c;
+
+		return quadric.weight > 0.0 ? (float)(fabs(error) / quadric.weight) : 0.0f;
+	}
+
+	static uInt32 HashPosition(const Vec3f& position)
+	{
+		uInt32 bits[3];
+		MemCopy(&bits[0], &position.x, sizeof(float));
+		MemCopy(&bits[1], &position.y, sizeof(float));
+		MemCopy(&bits[2], &position.z, sizeof(float));
+
+		uInt32 hash = (bits[0] * 73856093) ^ (bits[1] * 19349663) ^ (bits[2] * 83492791);
+		hash ^= hash >> 16;
+		hash *= 0x85EBCA6B;
+		hash ^= hash >> 13;
+
+		return hash;
+	}
+
+	/*
+		Points every vertex at the first vertex sharing its position, and links the vertices of each
+		position in a ring through outWedges so every set of attributes at a point can be found.
+	*/
+	static void BuildPositionRemap(Array<uInt32>& outRemap, Array<uInt32>& outWedges, const Array<Vec3f>& positions)
+	{
+		const uSize vertexCount = positions.Size();
+
+		uSize capacity = 16;
+
+		while (capacity < vertexCount * 2)
+		{
+			capacity *= 2;
+		}
+
+		Array<uInt32> table;
+		table.Resize(capacity);
+
+		for (uSize i = 0; i < capacity; i++)
+		{
+			table[i] = MESH_SIMPLIFIER_NONE;
+		}
+
+		outRemap.Resize(vertexCount);
+		outWedges.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			uSize slot = HashPosition(positions[i]) & (capacity - 1);
+
+			while (table[slot] != MESH_SIMPLIFIER_NONE && positions[table[slot]] != positions[i])
+			{
+				slot = (slot + 1) & (capacity - 1);
+			}
+
+			if (table[slot] == MESH_SIMPLIFIER_NONE)
+			{
+				table[slot] = (uInt32)i;
+			}
+
+			outRemap[i] = table[slot];
+			outWedges[i] = (uInt32)i;
+		}
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			const uInt32 first = outRemap[i];
+
+			if (first != i)
+			{
+				outWedges[i] = outWedges[first];
+				outWedges[first] = (uInt32)i;
+			}
+		}
+	}
+
+	/* Directed edges, each vertex to the vertices following it in its triangles */
+	static void BuildEdgeAdjacency(SimplifyAdjacency& adjacency, const uInt32* pIndices, uSize indexCount, uSize vertexCount)
+	{
+		adjacency.offsets.Resize(vertexCount + 1);
+		adjacency.data.Resize(indexCount);
+
+		for (uSize i = 0; i <= vertexCount; i++)
+		{
+			adjacency.offsets[i] = 0;
+		}
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			adjacency.offsets[pIndices[i] + 1]++;
+		}
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			adjacency.offsets[i + 1] += adjacency.offsets[i];
+		}
+
+		Array<uInt32> fill;
+		fill.Resize(vertexCount);
+		MemCopy(fill.Data(), adjacency.offsets.Data(), vertexCount * sizeof(uInt32));
+
+		for (uSize i = 0; i < indexCount; i += 3)
+		{
+			for (uSize k = 0; k < 3; k++)
+			{
+				const uInt32 vertex = pIndices[i + k];
+				adjacency.data[fill[vertex]++] = pIndices[i + (k + 1) % 3];
+			}
+		}
+	}
+
+	/* Triangles around each position */
+	static void BuildTriangleAdjacency(SimplifyAdjacency& adjacency, const uInt32* pIndices, uSize indexCount,
+		const Array<uInt32>& remap)
+	{
+		const uSize vertexCount = remap.Size();
+
+		adjacency.offsets.Resize(vertexCount + 1);
+		adjacency.data.Resize(indexCount);
+
+		for (uSize i = 0; i <= vertexCount; i++)
+		{
+			adjacency.offsets[i] = 0;
+		}
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			adjacency.offsets[remap[pIndices[i]] + 1]++;
+		}
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			adjacency.offsets[i + 1] += adjacency.offsets[i];
+		}
+
+		Array<uInt32> fill;
+		fill.Resize(vertexCount);
+		MemCopy(fill.Data(), adjacency.offsets.Data(), vertexCount * sizeof(uInt32));
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			adjacency.data[fill[remap[pIndices[i]]]++] = (uInt32)(i / 3);
+		}
+	}
+
+	static bool HasEdge(const SimplifyAdjacency& edges, uInt32 from, uInt32 to)
+	{
+		for (uInt32 i = edges.offsets[from]; i < edges.offsets[from + 1]; i++)
+		{
+			if (edges.data[i] == to)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	/* True if no wedge of to has an edge back to a wedge of from */
+	static bool IsOpenPositionEdge(const SimplifyAdjacency& edges, const Array<uInt32>& remap, const Array<uInt32>& wedges,
+		uInt32 from, uInt32 to)
+	{
+		uInt32 wedge = to;
+
+		do
+		{
+			for (uInt32 i = edges.offsets[wedge]; i < edges.offsets[wedge + 1]; i++)
+			{
+				if (remap[edges.data[i]] == remap[from])
+				{
+					return false;
+				}
+			}
+
+			wedge = wedges[wedge];
+		}
+		while (wedge != to);
+
+		return true;
+	}
+
+	/*
+		An edge is open when no triangle uses it the other way around. Open edges at a single
+		wedge are borders of the surface, while a seam vertex has two wedges whose open edges
+		mirror each other and close once positions are compared instead of vertices.
+	*/
+	static void ClassifyVertices(Array<uInt8>& outKinds, const SimplifyAdjacency& edges,
+		const Array<uInt32>& remap, const Array<uInt32>& wedges)
+	{
+		const uSize vertexCount = remap.Size();
+
+		Array<uInt32> openIn;
+		Array<uInt32> openOut;
+		Array<bool> positionOpen;
+
+		openIn.Resize(vertexCount);
+		openOut.Resize(vertexCount);
+		positionOpen.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			openIn[i]		= MESH_SIMPLIFIER_NONE;
+			openOut[i]		= MESH_SIMPLIFIER_NONE;
+			positionOpen[i]	= false;
+		}
+
+		for (uInt32 vertex = 0; vertex < vertexCount; vertex++)
+		{
+			for (uInt32 i = edges.offsets[vertex]; i < edges.offsets[vertex + 1]; i++)
+			{
+				const uInt32 target = edges.data[i];
+
+				if (HasEdge(edges, target, vertex))
+				{
+					continue;
+				}
+
+				// A vertex pointing at itself has more than one open edge
+				openOut[vertex] = openOut[vertex] == MESH_SIMPLIFIER_NONE ? target : vertex;
+				openIn[target]	= openIn[target] == MESH_SIMPLIFIER_NONE ? vertex : target;
+
+				if (IsOpenPositionEdge(edges, remap, wedges, vertex, target))
+				{
+					positionOpen[remap[vertex]] = true;
+					positionOpen[remap[target]] = true;
+				}
+			}
+		}
+
+		outKinds.Resize(vertexCount);
+
+		for (uInt32 vertex = 0; vertex < vertexCount; vertex++)
+		{
+			if (remap[vertex] != vertex)
+			{
+				continue;
+			}
+
+			const uInt32 wedge = wedges[vertex];
+			uInt8 kind = SIMPLIFY_VERTEX_LOCKED;
+
+			if (wedge == vertex)
+			{
+				if (openOut[vertex] == MESH_SIMPLIFIER_NONE && openIn[vertex] == MESH_SIMPLIFIER_NONE)
+				{
+					kind = SIMPLIFY_VERTEX_MANIFOLD;
+				}
+				else if (openOut[vertex] != MESH_SIMPLIFIER_NONE && openOut[vertex] != vertex &&
+					openIn[vertex] != MESH_SIMPLIFIER_NONE && openIn[vertex] != vertex && positionOpen[vertex])
+				{
+					kind = SIMPLIFY_VERTEX_BORDER;
+				}
+			}
+			else if (wedges[wedge] == vertex && !positionOpen[vertex])
+			{
+				const uInt32 inVertex	= openIn[vertex];
+				const uInt32 outVertex	= openOut[vertex];
+				const uInt32 inWedge	= openIn[wedge];
+				const uInt32 outWedge	= openOut[wedge];
+
+				if (inVertex != MESH_SIMPLIFIER_NONE && inVertex != vertex && outVertex != MESH_SIMPLIFIER_NONE && outVertex != vertex &&
+					inWedge != MESH_SIMPLIFIER_NONE && inWedge != wedge && outWedge != MESH_SIMPLIFIER_NONE && outWedge != wedge &&
+					remap[inVertex] == remap[outWedge] && remap[outVertex] == remap[inWedge])
+				{
+					kind = SIMPLIFY_VERTEX_SEAM;
+				}
+			}
+
+			outKinds[vertex] = kind;
+		}
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			outKinds[i] = outKinds[remap[i]];
+		}
+	}
+
+	static void FillQuadrics(Array<SimplifyQuadric>& outQuadrics, const uInt32* pIndices, uSize indexCount,
+		const Array<Vec3f>& positions, const Array<uInt32>& remap, const Array<uInt8>& kinds, const SimplifyAdjacency& edges)
+	{
+		outQuadrics.Resize(positions.Size());
+
+		for (uSize i = 0; i < positions.Size(); i++)
+		{
+			outQuadrics[i] = {};
+		}
+
+		for (uSize i = 0; i < indexCount; i += 3)
+		{
+			const uInt32 triangle[3] = { pIndices[i + 0], pIndices[i + 1], pIndices[i + 2] };
+
+			const Vec3f& p0 = positions[triangle[0]];
+			const Vec3f& p1 = positions[triangle[1]];
+			const Vec3f& p2 = positions[triangle[2]];
+
+			Vec3f normal = Cross(p1 - p0, p2 - p0);
+			const float doubleArea = normal.Magnitude();
+
+			if (doubleArea == 0.0f)
+			{
+				continue;
+			}
+
+			normal = normal / doubleArea;
+
+			for (uSize k = 0; k < 3; k++)
+			{
+				AddPlaneQuadric(outQuadrics[remap[triangle[k]]], normal, -Dot(normal, p0), doubleArea * 0.5);
+			}
+
+			// Planes through open edges, perpendicular to the triangle, keep borders and seams in place
+			for (uSize k = 0; k < 3; k++)
+			{
+				const uInt32 from	= triangle[k];
+				const uInt32 to		= triangle[(k + 1) % 3];
+
+				if ((kinds[from] != SIMPLIFY_VERTEX_BORDER && kinds[from] != SIMPLIFY_VERTEX_SEAM) || HasEdge(edges, to, from))
+				{
+					continue;
+				}
+
+				const Vec3f edge = positions[to] - positions[from];
+				const float length = edge.Magnitude();
+
+				if (length == 0.0f)
+				{
+					continue;
+				}
+
+				const Vec3f edgeNormal = Cross(edge, normal) / length;
+				const double weight = (double)length * length *
+					(kinds[from] == SIMPLIFY_VERTEX_BORDER ? MESH_SIMPLIFIER_BORDER_WEIGHT : MESH_SIMPLIFIER_SEAM_WEIGHT);
+
+				AddPlaneQuadric(outQuadrics[remap[from]], edgeNormal, -Dot(edgeNormal, positions[from]), weight);
+				AddPlaneQuadric(outQuadrics[remap[to]], edgeNormal, -Dot(edgeNormal, positions[from]), weight);
+			}
+		}
+	}
+
+	static bool CanCollapse(uInt8 fromKind, uInt8 toKind, bool openEdge)
+	{
+		switch (fromKind)
+		{
+			case SIMPLIFY_VERTEX_MANIFOLD:	return true;
+			case SIMPLIFY_VERTEX_BORDER:	return toKind == SIMPLIFY_VERTEX_BORDER && openEdge;
+			case SIMPLIFY_VERTEX_SEAM:		return toKind == SIMPLIFY_VERTEX_SEAM && openEdge;
+			default:						return false;
+		}
+	}
+
+	static void PickCollapses(Array<SimplifyCollapse>& outCollapses, const uInt32* pIndices, uSize indexCount,
+		const Array<Vec3f>& positions, const Array<uInt32>& remap, const Array<uInt8>& kinds,
+		const SimplifyAdjacency& edges, const Array<SimplifyQuadric>& quadrics)
+	{
+		outCollapses.Clear();
+
+		for (uSize i = 0; i < indexCount; i += 3)
+		{
+			for (uSize k = 0; k < 3; k++)
+			{
+				const uInt32 v0 = pIndices[i + k];
+				const uInt32 v1 = pIndices[i + (k + 1) % 3];
+
+				const bool openEdge = !HasEdge(edges, v1, v0);
+
+				// Closed edges appear in two triangles, keep one of them
+				if (remap[v0] == remap[v1] || (remap[v0] > remap[v1] && !openEdge))
+				{
+					continue;
+				}
+
+				const bool collapse01 = CanCollapse(kinds[v0], kinds[v1], openEdge);
+				const bool collapse10 = CanCollapse(kinds[v1], kinds[v0], openEdge);
+
+				if (!collapse01 && !collapse10)
+				{
+					continue;
+				}
+
+				const float error01 = collapse01 ? QuadricError(quadrics[remap[v0]], positions[v1]) : 0.0f;
+				const float error10 = collapse10 ? QuadricError(quadrics[remap[v1]], positions[v0]) : 0.0f;
+
+				SimplifyCollapse collapse;
+
+				if (collapse01 && (!collapse10 || error01 <= error10))
+				{
+					collapse.from	= v0;
+					collapse.to		= v1;
+					collapse.error	= error01;
+				}
+				else
+				{
+					collapse.from	= v1;
+					collapse.to		= v0;
+					collapse.error	= error10;
+				}
+
+				outCollapses.PushBack(collapse);
+			}
+		}
+	}
+
+	/* The vertex of to's position that the other wedge of a seam vertex shares an edge with */
+	static uInt32 FindSeamTarget(const uInt32* pIndices, const SimplifyAdjacency& triangles, const Array<uInt32>& remap,
+		uInt32 seamVertex, uInt32 to)
+	{
+		const uInt32 position = remap[seamVertex];
+
+		for (uInt32 i = triangles.offsets[position]; i < triangles.offsets[position + 1]; i++)
+		{
+			const uInt32* pTriangle = pIndices + (uSize)triangles.data[i] * 3;
+
+			if (pTriangle[0] != seamVertex && pTriangle[1] != seamVertex && pTriangle[2] != seamVertex)
+			{
+				continue;
+			}
+
+			for (uSize k = 0; k < 3; k++)
+			{
+				if (remap[pTriangle[k]] == remap[to] && pTriangle[k] != to)
+				{
+					return pTriangle[k];
+				}
+			}
+		}
+
+		return MESH_SIMPLIFIER_NONE;
+	}
+
+	/* True if moving from's position onto to turns any remaining triangle around it over */
+	static bool HasTriangleFlip(const uInt32* pIndices, const SimplifyAdjacency& triangles, const Array<uInt32>& remap,
+		const Array<uInt32>& collapseRemap, const Array<Vec3f>& positions, uInt32 from, uInt32 to)
+	{
+		const uInt32 fromPosition	= remap[from];
+		const uInt32 toPosition		= remap[to];
+		const Vec3f& target			= positions[to];
+
+		for (uInt32 i = triangles.offsets[fromPosition]; i < triangles.offsets[fromPosition + 1]; i++)
+		{
+			const uInt32* pTriangle = pIndices + (uSize)triangles.data[i] * 3;
+
+			uInt32 corners[3];
+			uSize moving = 3;
+			bool collapses = false;
+
+			for (uSize k = 0; k < 3; k++)
+			{
+				corners[k] = collapseRemap[pTriangle[k]];
+				moving = remap[corners[k]] == fromPosition ? k : moving;
+				collapses |= remap[corners[k]] == toPosition;
+			}
+
+			if (collapses || moving == 3)
+			{
+				continue;
+			}
+
+			const Vec3f& p0 = positions[corners[moving]];
+			const Vec3f& p1 = positions[corners[(moving + 1) % 3]];
+			const Vec3f& p2 = positions[corners[(moving + 2) % 3]];
+
+			const Vec3f before	= Cross(p1 - p0, p2 - p0);
+			const Vec3f after	= Cross(p1 - target, p2 - target);
+
+			if (Dot(before, after) < MESH_SIMPLIFIER_MIN_FLIP_COS * before.Magnitude() * after.Magnitude())
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	uSize SimplifyMesh(uInt32* pOutIndices, const uInt32* pIndices, uSize indexCount,
+		const uInt8* pPositions, uSize positionStrideBytes, uSize vertexCount,
+		uSize targetIndexCount, float maxError, float* pOutError)
+	{
+		indexCount -= indexCount % 3;
+
+		Array<uInt32> indices;
+		indices.Resize(indexCount);
+		MemCopy(indices.Data(), pIndices, indexCount * sizeof(uInt32));
+
+		Array<Vec3f> positions;
+		positions.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			float position[3];
+			MemCopy(position, pPositions + i * positionStrideBytes, sizeof(position));
+			positions[i] = Vec3f(position[0], position[1], position[2]);
+		}
+
+		/* Topology */
+
+		Array<uInt32> remap;
+		Array<uInt32> wedges;
+		Array<uInt8> kinds;
+		Array<SimplifyQuadric> quadrics;
+		SimplifyAdjacency edges;
+		SimplifyAdjacency triangles;
+
+		BuildPositionRemap(remap, wedges, positions);
+		BuildEdgeAdjacency(edges, indices.Data(), indexCount, vertexCount);
+		ClassifyVertices(kinds, edges, remap, wedges);
+		FillQuadrics(quadrics, indices.Data(), indexCount, positions, remap, kinds, edges);
+
+		/* Collapse in passes, each vertex moves at most once per pass */
+
+		Array<SimplifyCollapse> collapses;
+		Array<uInt32> collapseRemap;
+		Array<bool> locked;
+
+		collapseRemap.Resize(vertexCount);
+		locked.Resize(vertexCount);
+
+		const float maxErrorSquared = maxError * maxError;
+		float resultErrorSquared = 0.0f;
+		bool firstPass = true;
+
+		while (indexCount > targetIndexCount)
+		{
+			if (!firstPass)
+			{
+				BuildEdgeAdjacency(edges, indices.Data(), indexCount, vertexCount);
+			}
+
+			firstPass = false;
+
+			BuildTriangleAdjacency(triangles, indices.Data(), indexCount, remap);
+			PickCollapses(collapses, indices.Data(), indexCount, positions, remap, kinds, edges, quadrics);
+
+			std::sort(collapses.Data(), collapses.Data() + collapses.Size(),
+				[](const SimplifyCollapse& a, const SimplifyCollapse& b) { return a.error < b.error; });
+
+			for (uSize i = 0; i < vertexCount; i++)
+			{
+				collapseRemap[i]	= (uInt32)i;
+				locked[i]			= false;
+			}
+
+			const uSize triangleGoal = (indexCount - targetIndexCount) / 3;
+			uSize removedTriangles = 0;
+			uSize collapseCount = 0;
+
+			for (const SimplifyCollapse& collapse : collapses)
+			{
+				if (removedTriangles >= triangleGoal || collapse.error > maxErrorSquared)
+				{
+					break;
+				}
+
+				const uInt32 fromPosition	= remap[collapse.from];
+				const uInt32 toPosition		= remap[collapse.to];
+				const uInt8 kind			= kinds[collapse.from];
+
+				if (locked[fromPosition] || locked[toPosition])
+				{
+					continue;
+				}
+
+				uInt32 seamFrom	= MESH_SIMPLIFIER_NONE;
+				uInt32 seamTo	= MESH_SIMPLIFIER_NONE;
+
+				if (kind == SIMPLIFY_VERTEX_SEAM)
+				{
+					seamFrom	= wedges[collapse.from];
+					seamTo		= FindSeamTarget(indices.Data(), triangles, remap, seamFrom, collapse.to);
+
+					if (seamTo == MESH_SIMPLIFIER_NONE)
+					{
+						continue;
+					}
+				}
+
+				if (HasTriangleFlip(indices.Data(), triangles, remap, collapseRemap, positions, collapse.from, collapse.to))
+				{
+					continue;
+				}
+
+				if (kind == SIMPLIFY_VERTEX_SEAM)
+				{
+					collapseRemap[collapse.from]	= collapse.to;
+					collapseRemap[seamFrom]			= seamTo;
+				}
+				else
+				{
+					uInt32 wedge = collapse.from;
+
+					do
+					{
+						collapseRemap[wedge] = collapse.to;
+						wedge = wedges[wedge];
+					}
+					while (wedge != collapse.from);
+				}
+
+				AddQuadric(quadrics[toPosition], quadrics[fromPosition]);
+
+				locked[fromPosition]	= true;
+				locked[toPosition]		= true;
+
+				// An interior edge takes two triangles with it, a border edge one
+				removedTriangles += kind == SIMPLIFY_VERTEX_BORDER ? 1 : 2;
+				resultErrorSquared = collapse.error > resultErrorSquared ? collapse.error : resultErrorSquared;
+				collapseCount++;
+			}
+
+			if (collapseCount == 0)
+			{
+				break;
+			}
+
+			/* Remap indices and drop the triangles that collapsed */
+
+			uSize writeCount = 0;
+
+			for (uSize i = 0; i < indexCount; i += 3)
+			{
+				const uInt32 v0 = collapseRemap[indices[i + 0]];
+				const uInt32 v1 = collapseRemap[indices[i + 1]];
+				const uInt32 v2 = collapseRemap[indices[i + 2]];
+
+				if (remap[v0] == remap[v1] || remap[v1] == remap[v2] || remap[v2] == remap[v0])
+				{
+					continue;
+				}
+
+				indices[writeCount + 0] = v0;
+				indices[writeCount + 1] = v1;
+				indices[writeCount + 2] = v2;
+				writeCount += 3;
+			}
+
+			indexCount = writeCount;
+		}
+
+		MemCopy(pOutIndices, indices.Data(), indexCount * sizeof(uInt32));
+
+		if (pOutError)
+		{
+			*pOutError = sqrtf(resultErrorSquared);
+		}
+
+		return indexCount;
+	}
+
+	bool GenerateModelLods(Model& model, const LodChainSettings& settings,
+		PoolAllocator<ByteBuffer>& bufferAllocator, LodChainStats* pOutStats)
+	{
+		IndexStream& indexStream = model.indexStream;
+		const IndexFormat indexFormat = indexStream.indexElement.format;
+
+		if (!indexStream.HasData())
+		{
+			LogError("Failed to generate LODs. The model has no indices.");
+			return false;
+		}
+
+		if (indexFormat != INDEX_FORMAT_UINT16 && indexFormat != INDEX_FORMAT_UINT32)
+		{
+			LogError("Failed to generate LODs. Unsupported index format.");
+			return false;
+		}
+
+		const uSize indexSizeBytes	= IndexFormatSizeBytes(indexFormat);
+		const uSize indexCount		= indexStream.indexCount;
+
+		if (indexCount * indexSizeBytes > indexStream.GetSizeBytes())
+		{
+			LogError("Failed to generate LODs. The index stream is smaller than its index count.");
+			return false;
+		}
+
+		for (const Mesh& mesh : model.meshes)
+		{
+			if (mesh.lod != 0)
+			{
+				LogError("Failed to generate LODs. The model already has LODs.");
+				return false;
+			}
+		}
+
+		const uInt8* pPositions		= nullptr;
+		uSize positionStrideBytes	= 0;
+		uSize vertexCount			= 0;
+
+		for (const VertexStream& stream : model.vertexStreams)
+		{
+			for (const VertexElement& element : stream.vertexElements)
+			{
+				if (stream.HasData() && stream.strideBytes > 0 && element.attribute == VERTEX_ATTRIBUTE_POSITION &&
+					element.format == VERTEX_FORMAT_FLOAT3 && !pPositions)
+				{
+					pPositions			= stream.GetData() + element.offsetBytes;
+					positionStrideBytes	= stream.strideBytes;
+					vertexCount			= stream.GetSizeBytes() / stream.strideBytes;
+				}
+			}
+		}
+
+		if (!pPositions)
+		{
+			LogError("Failed to generate LODs. The model has no float3 positions.");
+			return false;
+		}
+
+		const uSize lodCount = settings.lodCount < MESH_SIMPLIFIER_MAX_LODS ? settings.lodCount : MESH_SIMPLIFIER_MAX_LODS;
+
+		/* Errors are relative to the largest side of the model */
+
+		float minimum[3] = {};
+		float maximum[3] = {};
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			float position[3];
+			MemCopy(position, pPositions + i * positionStrideBytes, sizeof(position));
+
+			for (uSize j = 0; j < 3; j++)
+			{
+				minimum[j] = i == 0 || position[j] < minimum[j] ? position[j] : minimum[j];
+				maximum[j] = i == 0 || position[j] > maximum[j] ? position[j] : maximum[j];
+			}
+		}
+
+		float extent = 0.0f;
+
+		for (uSize j = 0; j < 3; j++)
+		{
+			extent = maximum[j] - minimum[j] > extent ? maximum[j] - minimum[j] : extent;
+		}
+
+		const float levelMaxError = settings.maxError * extent;
+
+		/* Widen indices */
+
+		Array<uInt32> indices;
+		indices.Resize(indexCount);
+
+		const uInt8* pIndexData = indexStream.GetData();
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			indices[i] = indexFormat == INDEX_FORMAT_UINT16 ? ((const uInt16*)pIndexData)[i] : ((const uInt32*)pIndexData)[i];
+
+			if (indices[i] >= vertexCount)
+			{
+				LogError("Failed to generate LODs. Index %d is past the end of the positions.", indices[i]);
+				return false;
+			}
+		}
+
+		Array<Mesh> meshes = model.meshes;
+
+		if (meshes.Size() == 0)
+		{
+			Mesh mesh = {};
+			mesh.indexCount = indexCount;
+
+			meshes.PushBack(mesh);
+		}
+
+		if (pOutStats)
+		{
+			*pOutStats = {};
+		}
+
+		/* Chain every mesh */
+
+		Array<uInt32> lodIndices;
+		Array<Mesh> lodMeshes;
+
+		Array<uInt32> localIndices;
+		localIndices.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			localIndices[i] = MESH_SIMPLIFIER_NONE;
+		}
+
+		Array<uInt32> localVertices;
+		Array<float> localPositions;
+		Array<uInt32> levelIndices;
+		Array<uInt32> simplifiedIndices;
+
+		for (const Mesh& mesh : meshes)
+		{
+			if ((uSize)mesh.indexStart + mesh.indexCount > indexCount)
+			{
+				LogError("Failed to generate LODs. Mesh [%s] lies outside the index stream.", mesh.name.Str());
+				return false;
+			}
+
+			// Simplify a compact copy so each mesh only costs its own vertices
+			localVertices.Clear();
+			localPositions.Clear();
+			levelIndices.Resize(mesh.indexCount);
+
+			for (uSize i = 0; i < mesh.indexCount; i++)
+			{
+				const uInt32 vertex = indices[mesh.indexStart + i];
+
+				if (localIndices[vertex] == MESH_SIMPLIFIER_NONE)
+				{
+					float position[3];
+					MemCopy(position, pPositions + (uSize)vertex * positionStrideBytes, sizeof(position));
+
+					localIndices[vertex] = (uInt32)localVertices.Size();
+					localVertices.PushBack(vertex);
+					localPositions.PushBack(position[0]);
+					localPositions.PushBack(position[1]);
+					localPositions.PushBack(position[2]);
+				}
+
+				levelIndices[i] = localIndices[vertex];
+			}
+
+			for (const uInt32 vertex : localVertices)
+			{
+				localIndices[vertex] = MESH_SIMPLIFIER_NONE;
+			}
+
+			Mesh lodMesh = mesh;
+			lodMesh.lod			= 0;
+			lodMesh.lodError	= 0.0f;
+			lodMesh.indexStart	= lodIndices.Size();
+
+			for (uSize i = 0; i < mesh.indexCount; i++)
+			{
+				lodIndices.PushBack(indices[mesh.indexStart + i]);
+			}
+
+			lodMeshes.PushBack(lodMesh);
+
+			if (pOutStats)
+			{
+				pOutStats->levelCount = pOutStats->levelCount > 1 ? pOutStats->levelCount : 1;
+				pOutStats->triangleCounts[0] += mesh.indexCount / 3;
+			}
+
+			for (uSize level = 1; level <= lodCount; level++)
+			{
+				const uSize triangleCount = levelIndices.Size() / 3;
+
+				if (triangleCount <= settings.minTriangles)
+				{
+					break;
+				}
+
+				const uSize targetIndexCount = (uSize)(triangleCount * settings.reduction) * 3;
+				float levelError = 0.0f;
+
+				simplifiedIndices.Resize(levelIndices.Size());
+
+				const uSize simplifiedCount = SimplifyMesh(simplifiedIndices.Data(), levelIndices.Data(), levelIndices.Size(),
+					(const uInt8*)localPositions.Data(), 3 * sizeof(float), localVertices.Size(),
+					targetIndexCount, levelMaxError, &levelError);
+
+				if (simplifiedCount == 0 || simplifiedCount > levelIndices.Size() * MESH_SIMPLIFIER_MIN_REDUCTION)
+				{
+					// Not worth a level of its own
+					break;
+				}
+
+				simplifiedIndices.Resize(simplifiedCount);
+
+				lodMesh.lod			= (uInt32)level;
+				lodMesh.lodError	+= levelError;
+				lodMesh.indexStart	= lodIndices.Size();
+				lodMesh.indexCount	= simplifiedCount;
+
+				for (const uInt32 localIndex : simplifiedIndices)
+				{
+					lodIndices.PushBack(localVertices[localIndex]);
+				}
+
+				lodMeshes.PushBack(lodMesh);
+
+				if (pOutStats)
+				{
+					pOutStats->levelCount = pOutStats->levelCount > level + 1 ? pOutStats->levelCount : (uInt32)level + 1;
+					pOutStats->triangleCounts[level] += simplifiedCount / 3;
+					pOutStats->maxErrors[level] = lodMesh.lodError > pOutStats->maxErrors[level] ? lodMesh.lodError : pOutStats->maxErrors[level];
+				}
+
+				levelIndices = simplifiedIndices;
+			}
+		}
+
+		/* Replace the index stream */
+
+		const uSize lodIndexSizeBytes = lodIndices.Size() * indexSizeBytes;
+
+		ByteBuffer* pIndexBuffer = bufferAllocator.Allocate(lodIndexSizeBytes);
+
+		if (!pIndexBuffer)
+		{
+			LogError("Failed to generate LODs. Could not allocate the index stream.");
+			return false;
+		}
+
+		pIndexBuffer->Allocate(lodIndexSizeBytes);
+
+		uInt8* pOutIndexData = pIndexBuffer->Data();
+
+		for (uSize i = 0; i < lodIndices.Size(); i++)
+		{
+			if (indexFormat == INDEX_FORMAT_UINT16)
+			{
+				((uInt16*)pOutIndexData)[i] = (uInt16)lodIndices[i];
+			}
+			else
+			{
+				((uInt32*)pOutIndexData)[i] = lodIndices[i];
+			}
+		}
+
+		if (indexStream.pIndexBuffer)
+		{
+			bufferAllocator.Free(indexStream.pIndexBuffer);
+		}
+
+		indexStream.pIndexBuffer	= pIndexBuffer;
+		indexStream.pMappedData		= nullptr;
+		indexStream.mappedSizeBytes	= 0;
+		indexStream.indexCount		= lodIndices.Size();
+
+		model.meshes = lodMeshes;
+
+		// Meshlets index the old meshes
+		model.meshletStream = MeshletStream();
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,510 @@
+#include "Resource/Processing/MeshletBuilder.h"
+
+#include "Log.h"
+#include "Memory/Memory.h"
+
+#include <math.h>
+
+#define MESHLET_NONE				0xFFFFFFFF
+#define MESHLET_CONE_WEIGHT			1.0f	// How much a triangle facing away from the meshlet counts against it
+#define MESHLET_MIN_CONE_DOT		0.1f	// Normals spreading further than this have no useful cone
+
+namespace Quartz
+{
+	static float Component(const Vec3f& vector, uSize axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	/* Ritter's sphere, seeded from the widest pair of axis extremes */
+	static void ComputeBoundingSphere(const Array<Vec3f>& points, Vec3f& outCenter, float& outRadius)
+	{
+		uSize minIdx[3] = {};
+		uSize maxIdx[3] = {};
+
+		for (uSize i = 1; i < points.Size(); i++)
+		{
+			for (uSize axis = 0; axis < 3; axis++)
+			{
+				minIdx[axis] = Component(points[i], axis) < Component(points[minIdx[axis]], axis) ? i : minIdx[axis];
+				maxIdx[axis] = Component(points[i], axis) > Component(points[maxIdx[axis]], axis) ? i : maxIdx[axis];
+			}
+		}
+
+		uSize seedAxis = 0;
+		float seedDistance = -1.0f;
+
+		for (uSize axis = 0; axis < 3; axis++)
+		{
+			const float distance = (points[maxIdx[axis]] - points[minIdx[axis]]).Magnitude();
+
+			if (distance > seedDistance)
+			{
+				seedAxis		= axis;
+				seedDistance	= distance;
+			}
+		}
+
+		Vec3f center = (points[minIdx[seedAxis]] + points[maxIdx[seedAxis]]) * 0.5f;
+		float radius = seedDistance * 0.5f;
+
+		for (const Vec3f& point : points)
+		{
+			const float distance = (point - center).Magnitude();
+
+			if (distance > radius)
+			{
+				const float grownRadius = (radius + distance) * 0.5f;
+				center += (point - center) * ((grownRadius - radius) / distance);
+				radius = grownRadius;
+			}
+		}
+
+		outCenter = center;
+		outRadius = radius;
+	}
+
+	/*
+		The axis is the mean triangle normal. Views inside the cone at coneApex see the back of
+		every triangle, its half angle is 90 degrees less the widest normal's angle to the axis.
+	*/
+	static void ComputeCone(Meshlet& meshlet, const Array<Vec3f>& points, const uInt8* pTriangles, float& outSpreadDegrees)
+	{
+		meshlet.coneApex	= meshlet.center;
+		meshlet.coneAxis	= Vec3f(0.0f, 0.0f, 0.0f);
+		meshlet.coneCutoff	= MESHLET_NO_CONE_CUTOFF;
+		outSpreadDegrees	= 0.0f;
+
+		Vec3f normalSum(0.0f, 0.0f, 0.0f);
+
+		for (uSize i = 0; i < meshlet.triangleCount; i++)
+		{
+			const uInt8* pTriangle = pTriangles + i * 3;
+			const Vec3f normal = Cross(points[pTriangle[1]] - points[pTriangle[0]], points[pTriangle[2]] - points[pTriangle[0]]);
+			const float length = normal.Magnitude();
+
+			if (length > 0.0f)
+			{
+				normalSum += normal / length;
+			}
+		}
+
+		const float axisLength = normalSum.Magnitude();
+
+		if (axisLength == 0.0f)
+		{
+			return;
+		}
+
+		const Vec3f axis = normalSum / axisLength;
+
+		float minDot = 1.0f;
+
+		for (uSize i = 0; i < meshlet.triangleCount; i++)
+		{
+			const uInt8* pTriangle = pTriangles + i * 3;
+			const Vec3f normal = Cross(points[pTriangle[1]] - points[pTriangle[0]], points[pTriangle[2]] - points[pTriangle[0]]);
+			const float length = normal.Magnitude();
+
+			if (length > 0.0f)
+			{
+				const float dot = Dot(normal / length, axis);
+				minDot = dot < minDot ? dot : minDot;
+			}
+		}
+
+		if (minDot <= MESHLET_MIN_CONE_DOT)
+		{
+			return;
+		}
+
+		// Back the apex off until every triangle's plane has the center in front of it
+		float maxDistance = 0.0f;
+
+		for (uSize i = 0; i < meshlet.triangleCount; i++)
+		{
+			const uInt8* pTriangle = pTriangles + i * 3;
+			const Vec3f normal = Cross(points[pTriangle[1]] - points[pTriangle[0]], points[pTriangle[2]] - points[pTriangle[0]]);
+			const float length = normal.Magnitude();
+
+			if (length > 0.0f)
+			{
+				const Vec3f unitNormal = normal / length;
+				const float distance = Dot(meshlet.center - points[pTriangle[0]], unitNormal) / Dot(axis, unitNormal);
+				maxDistance = distance > maxDistance ? distance : maxDistance;
+			}
+		}
+
+		meshlet.coneApex	= meshlet.center - axis * maxDistance;
+		meshlet.coneAxis	= axis;
+		meshlet.coneCutoff	= sqrtf(1.0f - minDot * minDot);
+		outSpreadDegrees	= acosf(minDot) / ToRadians(1.0f);
+	}
+
+	bool BuildModelMeshlets(Model& model, MeshletStats* pOutStats)
+	{
+		const IndexStream& indexStream = model.indexStream;
+		const IndexFormat indexFormat = indexStream.indexElement.format;
+
+		if (!indexStream.HasData())
+		{
+			LogError("Failed to build meshlets. The model has no indices.");
+			return false;
+		}
+
+		if (indexFormat != INDEX_FORMAT_UINT16 && indexFormat != INDEX_FORMAT_UINT32)
+		{
+			LogError("Failed to build meshlets. Unsupported index format.");
+			return false;
+		}
+
+		const uSize indexSizeBytes	= IndexFormatSizeBytes(indexFormat);
+		const uSize indexCount		= indexStream.indexCount;
+
+		if (indexCount * indexSizeBytes > indexStream.GetSizeBytes())
+		{
+			LogError("Failed to build meshlets. The index stream is smaller than its index count.");
+			return false;
+		}
+
+		const uInt8* pPositions		= nullptr;
+		uSize positionStrideBytes	= 0;
+		uSize vertexCount			= 0;
+
+		for (const VertexStream& stream : model.vertexStreams)
+		{
+			for (const VertexElement& element : stream.vertexElements)
+			{
+				if (stream.HasData() && stream.strideBytes > 0 && element.attribute == VERTEX_ATTRIBUTE_POSITION &&
+					element.format == VERTEX_FORMAT_FLOAT3 && !pPositions)
+				{
+					pPositions			= stream.GetData() + element.offsetBytes;
+					positionStrideBytes	= stream.strideBytes;
+					vertexCount			= stream.GetSizeBytes() / stream.strideBytes;
+				}
+			}
+		}
+
+		if (!pPositions)
+		{
+			LogError("Failed to build meshlets. The model has no float3 positions.");
+			return false;
+		}
+
+		/* Widen indices */
+
+		Array<uInt32> indices;
+		indices.Resize(indexCount);
+
+		const uInt8* pIndexData = indexStream.GetData();
+
+		for (uSize i = 0; i < indexCount; i++)
+		{
+			indices[i] = indexFormat == INDEX_FORMAT_UINT16 ? ((const uInt16*)pIndexData)[i] : ((const uInt32*)pIndexData)[i];
+
+			if (indices[i] >= vertexCount)
+			{
+				LogError("Failed to build meshlets. Index %d is past the end of the positions.", indices[i]);
+				return false;
+			}
+		}
+
+		Array<Mesh> meshes = model.meshes;
+
+		if (meshes.Size() == 0)
+		{
+			Mesh mesh = {};
+			mesh.indexCount = indexCount;
+
+			meshes.PushBack(mesh);
+		}
+
+		MeshletStream meshletStream;
+
+		Array<uInt32> localIndices;
+		localIndices.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			localIndices[i] = MESHLET_NONE;
+		}
+
+		Array<uInt32> localVertices;
+		Array<Vec3f> localPositions;
+		Array<uInt32> meshIndices;
+		Array<Vec3f> triangleNormals;
+		Array<Vec3f> triangleCenters;
+		Array<uInt32> adjacencyOffsets;
+		Array<uInt32> adjacencyTriangles;
+		Array<bool> usedTriangles;
+		Array<uInt32> candidateStamps;
+		Array<uInt32> candidates;
+		Array<uInt32> meshletSlots;
+		Array<uInt32> meshletVertices;
+		Array<Vec3f> meshletPositions;
+
+		uSize coneCount = 0;
+		float coneSpreadSum = 0.0f;
+
+		for (uSize meshIdx = 0; meshIdx < meshes.Size(); meshIdx++)
+		{
+			const Mesh& mesh = meshes[meshIdx];
+			const uSize meshIndexCount = mesh.indexCount - mesh.indexCount % 3;
+
+			if ((uSize)mesh.indexStart + mesh.indexCount > indexCount)
+			{
+				LogError("Failed to build meshlets. Mesh [%s] lies outside the index stream.", mesh.name.Str());
+				return false;
+			}
+
+			/* Compact the mesh's vertices */
+
+			localVertices.Clear();
+			localPositions.Clear();
+			meshIndices.Resize(meshIndexCount);
+
+			for (uSize i = 0; i < meshIndexCount; i++)
+			{
+				const uInt32 vertex = indices[mesh.indexStart + i];
+
+				if (localIndices[vertex] == MESHLET_NONE)
+				{
+					float position[3];
+					MemCopy(position, pPositions + (uSize)vertex * positionStrideBytes, sizeof(position));
+
+					localIndices[vertex] = (uInt32)localVertices.Size();
+					localVertices.PushBack(vertex);
+					localPositions.PushBack(Vec3f(position[0], position[1], position[2]));
+				}
+
+				meshIndices[i] = localIndices[vertex];
+			}
+
+			for (const uInt32 vertex : localVertices)
+			{
+				localIndices[vertex] = MESHLET_NONE;
+			}
+
+			const uSize localVertexCount	= localVertices.Size();
+			const uSize triangleCount		= meshIndexCount / 3;
+
+			/* Triangles around each vertex */
+
+			adjacencyOffsets.Resize(localVertexCount + 1);
+			adjacencyTriangles.Resize(meshIndexCount);
+
+			for (uSize i = 0; i <= localVertexCount; i++)
+			{
+				adjacencyOffsets[i] = 0;
+			}
+
+			for (uSize i = 0; i < meshIndexCount; i++)
+			{
+				adjacencyOffsets[meshIndices[i] + 1]++;
+			}
+
+			for (uSize i = 0; i < localVertexCount; i++)
+			{
+				adjacencyOffsets[i + 1] += adjacencyOffsets[i];
+			}
+
+			meshletSlots.Resize(localVertexCount);
+			MemCopy(meshletSlots.Data(), adjacencyOffsets.Data(), localVertexCount * sizeof(uInt32));
+
+			for (uSize i = 0; i < meshIndexCount; i++)
+			{
+				adjacencyTriangles[meshletSlots[meshIndices[i]]++] = (uInt32)(i / 3);
+			}
+
+			for (uSize i = 0; i < localVertexCount; i++)
+			{
+				meshletSlots[i] = MESHLET_NONE;
+			}
+
+			triangleNormals.Resize(triangleCount);
+			triangleCenters.Resize(triangleCount);
+			usedTriangles.Resize(triangleCount);
+			candidateStamps.Resize(triangleCount);
+
+			for (uSize i = 0; i < triangleCount; i++)
+			{
+				const Vec3f& p0 = localPositions[meshIndices[i * 3 + 0]];
+				const Vec3f& p1 = localPositions[meshIndices[i * 3 + 1]];
+				const Vec3f& p2 = localPositions[meshIndices[i * 3 + 2]];
+
+				const Vec3f normal = Cross(p1 - p0, p2 - p0);
+				const float length = normal.Magnitude();
+
+				triangleNormals[i]	= length > 0.0f ? normal / length : Vec3f(0.0f, 0.0f, 0.0f);
+				triangleCenters[i]	= (p0 + p1 + p2) / 3.0f;
+				usedTriangles[i]	= false;
+				candidateStamps[i]	= MESHLET_NONE;
+			}
+
+			/* Grow meshlets */
+
+			uSize nextSeed = 0;
+			uSize remainingTriangles = triangleCount;
+
+			while (remainingTriangles > 0)
+			{
+				const uInt32 meshletIdx = (uInt32)meshletStream.meshlets.Size();
+
+				Meshlet meshlet = {};
+				meshlet.meshIdx			= (uInt32)meshIdx;
+				meshlet.vertexStart		= (uInt32)meshletStream.vertices.Size();
+				meshlet.triangleStart	= (uInt32)(meshletStream.triangles.Size() / 3);
+
+				meshletVertices.Clear();
+				meshletPositions.Clear();
+				candidates.Clear();
+
+				Vec3f centerSum(0.0f, 0.0f, 0.0f);
+				Vec3f normalSum(0.0f, 0.0f, 0.0f);
+
+				while (usedTriangles[nextSeed])
+				{
+					nextSeed++;
+				}
+
+				uInt32 triangle = (uInt32)nextSeed;
+
+				while (triangle != MESHLET_NONE)
+				{
+					for (uSize k = 0; k < 3; k++)
+					{
+						const uInt32 vertex = meshIndices[triangle * 3 + k];
+
+						if (meshletSlots[vertex] == MESHLET_NONE)
+						{
+							meshletSlots[vertex] = (uInt32)meshletVertices.Size();
+							meshletVertices.PushBack(vertex);
+							meshletPositions.PushBack(localPositions[vertex]);
+							meshletStream.vertices.PushBack(localVertices[vertex]);
+
+							for (uInt32 i = adjacencyOffsets[vertex]; i < adjacencyOffsets[vertex + 1]; i++)
+							{
+								const uInt32 neighbor = adjacencyTriangles[i];
+
+								if (!usedTriangles[neighbor] && candidateStamps[neighbor] != meshletIdx)
+								{
+									candidateStamps[neighbor] = meshletIdx;
+									candidates.PushBack(neighbor);
+								}
+							}
+						}
+
+						meshletStream.triangles.PushBack((uInt8)meshletSlots[vertex]);
+					}
+
+					usedTriangles[triangle] = true;
+					remainingTriangles--;
+					meshlet.triangleCount++;
+
+					centerSum += triangleCenters[triangle];
+					normalSum += triangleNormals[triangle];
+
+					if (meshlet.triangleCount == MESHLET_MAX_TRIANGLES || remainingTriangles == 0)
+					{
+						break;
+					}
+
+					/* Next triangle: fewest new vertices, then nearest and best facing */
+
+					const Vec3f center = centerSum / (float)meshlet.triangleCount;
+					const float normalLength = normalSum.Magnitude();
+					const Vec3f axis = normalLength > 0.0f ? normalSum / normalLength : Vec3f(0.0f, 0.0f, 0.0f);
+
+					uInt32 bestTriangle = MESHLET_NONE;
+					uSize bestNewVertices = 4;
+					float bestScore = 0.0f;
+
+					for (uSize i = 0; i < candidates.Size();)
+					{
+						const uInt32 candidate = candidates[i];
+
+						if (usedTriangles[candidate])
+						{
+							candidates[i] = candidates[candidates.Size() - 1];
+							candidates.Resize(candidates.Size() - 1);
+							continue;
+						}
+
+						i++;
+
+						const uSize newVertices =
+							(meshletSlots[meshIndices[candidate * 3 + 0]] == MESHLET_NONE) +
+							(meshletSlots[meshIndices[candidate * 3 + 1]] == MESHLET_NONE) +
+							(meshletSlots[meshIndices[candidate * 3 + 2]] == MESHLET_NONE);
+
+						if (meshletVertices.Size() + newVertices > MESHLET_MAX_VERTICES || newVertices > bestNewVertices)
+						{
+							continue;
+						}
+
+						const float score = (triangleCenters[candidate] - center).Magnitude() *
+							(1.0f + MESHLET_CONE_WEIGHT * (1.0f - Dot(triangleNormals[candidate], axis)));
+
+						if (newVertices < bestNewVertices || score < bestScore)
+						{
+							bestTriangle	= candidate;
+							bestNewVertices	= newVertices;
+							bestScore		= score;
+						}
+					}
+
+					// Disconnected pieces fill meshlets that would otherwise end mostly empty
+					if (bestTriangle == MESHLET_NONE && candidates.Size() == 0 &&
+						meshlet.triangleCount < MESHLET_MAX_TRIANGLES / 2 && meshletVertices.Size() + 3 <= MESHLET_MAX_VERTICES)
+					{
+						while (usedTriangles[nextSeed])
+						{
+							nextSeed++;
+						}
+
+						bestTriangle = (uInt32)nextSeed;
+					}
+
+					triangle = bestTriangle;
+				}
+
+				meshlet.vertexCount = (uInt32)meshletVertices.Size();
+
+				for (const uInt32 vertex : meshletVertices)
+				{
+					meshletSlots[vertex] = MESHLET_NONE;
+				}
+
+				float coneSpread = 0.0f;
+
+				ComputeBoundingSphere(meshletPositions, meshlet.center, meshlet.radius);
+				ComputeCone(meshlet, meshletPositions, meshletStream.triangles.Data() + (uSize)meshlet.triangleStart * 3, coneSpread);
+
+				if (meshlet.coneCutoff <= 1.0f)
+				{
+					coneCount++;
+					coneSpreadSum += coneSpread;
+				}
+
+				meshletStream.meshlets.PushBack(meshlet);
+			}
+		}
+
+		model.meshletStream = meshletStream;
+
+		if (pOutStats)
+		{
+			const uSize meshletCount = meshletStream.meshlets.Size();
+			const uSize cornerCount = meshletStream.triangles.Size();
+
+			pOutStats->meshletCount		= meshletCount;
+			pOutStats->averageVertices	= meshletCount > 0 ? (float)meshletStream.vertices.Size() / meshletCount : 0.0f;
+			pOutStats->averageTriangles	= meshletCount > 0 ? (float)cornerCount / 3 / meshletCount : 0.0f;
+			pOutStats->vertexReuse		= meshletStream.vertices.Size() > 0 ? (float)cornerCount / meshletStream.vertices.Size() : 0.0f;
+			pOutStats->coneFraction		= meshletCount > 0 ? (float)coneCount / meshletCount : 0.0f;
+			pOutStats->averageConeAngle	= coneCount > 0 ? coneSpreadSum / coneCount : 0.0f;
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
@@ -0,0 +1,583 @@
+#include "Resource/Processing/VertexQuantizer.h"
+
+#include "Log.h"
+#include "Memory/Memory.h"
+
+#include <math.h>
+
+#define VERTEX_QUANTIZER_SNORM16_MAX	32767
+#define VERTEX_QUANTIZER_UNORM16_MAX	65535
+
+namespace Quartz
+{
+	uInt16 FloatToHalf(float value)
+	{
+		uInt32 bits;
+		MemCopy(&bits, &value, sizeof(float));
+
+		const uInt32 sign		= (bits >> 16) & 0x8000;
+		const uInt32 absBits	= bits & 0x7FFFFFFF;
+
+		if (absBits >= 0x7F800000)
+		{
+			// Infinity stays infinity, NaN stays quiet NaN
+			return sign | 0x7C00 | (absBits > 0x7F800000 ? 0x0200 : 0);
+		}
+
+		if (absBits >= 0x477FF000)
+		{
+			// 65520 and up round past the largest half
+			return sign | 0x7C00;
+		}
+
+		if (absBits < 0x38800000)
+		{
+			// Below the smallest normal half, 2^-25 and under round to zero
+			if (absBits <= 0x33000000)
+			{
+				return sign;
+			}
+
+			const uInt32 exponent	= absBits >> 23;
+			const uInt32 mantissa	= (absBits & 0x007FFFFF) | 0x00800000;
+			const uInt32 shift		= 126 - exponent;
+			const uInt32 remainder	= mantissa & ((1u << shift) - 1);
+			const uInt32 halfway	= 1u << (shift - 1);
+
+			uInt32 half = mantissa >> shift;
+
+			if (remainder > halfway || (remainder == halfway && (half & 1)))
+			{
+				half++;
+			}
+
+			return sign | half;
+		}
+
+		// Rebias the exponent from 127 to 15, a mantissa carry rolls into the exponent
+		uInt32 half = (absBits - 0x38000000) >> 13;
+		const uInt32 remainder = absBits & 0x1FFF;
+
+		if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+		{
+			half++;
+		}
+
+		return sign | half;
+	}
+
+	float HalfToFloat(uInt16 half)
+	{
+		const uInt32 sign		= (uInt32)(half & 0x8000) << 16;
+		const uInt32 exponent	= (half >> 10) & 0x1F;
+		const uInt32 mantissa	= half & 0x03FF;
+
+		if (exponent == 0)
+		{
+			const float value = ldexpf((float)mantissa, -24);
+			return sign ? -value : value;
+		}
+
+		const uInt32 bits = exponent == 0x1F ?
+			sign | 0x7F800000 | (mantissa << 13) :
+			sign | ((exponent + 112) << 23) | (mantissa << 13);
+
+		float value;
+		MemCopy(&value, &bits, sizeof(float));
+
+		return value;
+	}
+
+	static float OctahedralSign(float value)
+	{
+		return value >= 0.0f ? 1.0f : -1.0f;
+	}
+
+	static float DecodeSnorm16(int16 value)
+	{
+		// As Vulkan converts SNORM, -32768 decodes to -1 as well
+		const float decoded = (float)value / VERTEX_QUANTIZER_SNORM16_MAX;
+		return decoded < -1.0f ? -1.0f : decoded;
+	}
+
+	static int16 EncodeSnorm16(float value)
+	{
+		value = value < -1.0f ? -1.0f : (value > 1.0f ? 1.0f : value);
+		return (int16)roundf(value * VERTEX_QUANTIZER_SNORM16_MAX);
+	}
+
+	void DecodeOctahedral(const int16* pEncoded, float* pOutDirection)
+	{
+		float u = DecodeSnorm16(pEncoded[0]);
+		float v = DecodeSnorm16(pEncoded[1]);
+		const float z = 1.0f - fabsf(u) - fabsf(v);
+
+		if (z < 0.0f)
+		{
+			const float foldedU = (1.0f - fabsf(v)) * OctahedralSign(u);
+			const float foldedV = (1.0f - fabsf(u)) * OctahedralSign(v);
+
+			u = foldedU;
+			v = foldedV;
+		}
+
+		const float length = sqrtf(u * u + v * v + z * z);
+
+		pOutDirection[0] = u / length;
+		pOutDirection[1] = v / length;
+		pOutDirection[2] = z / length;
+	}
+
+	void EncodeOctahedral(const float* pDirection, int16* pOutEncoded)
+	{
+		const float x = pDirection[0];
+		const float y = pDirection[1];
+		const float z = pDirection[2];
+
+		const float l1Length = fabsf(x) + fabsf(y) + fabsf(z);
+
+		if (l1Length == 0.0f)
+		{
+			pOutEncoded[0] = 0;
+			pOutEncoded[1] = 0;
+			return;
+		}
+
+		float u = x / l1Length;
+		float v = y / l1Length;
+
+		if (z < 0.0f)
+		{
+			const float foldedU = (1.0f - fabsf(v)) * OctahedralSign(u);
+			const float foldedV = (1.0f - fabsf(u)) * OctahedralSign(v);
+
+			u = foldedU;
+			v = foldedV;
+		}
+
+		// Rounding to nearest is up to twice as far off as the best of the four neighbours
+		const float scaledU = floorf(u * VERTEX_QUANTIZER_SNORM16_MAX);
+		const float scaledV = floorf(v * VERTEX_QUANTIZER_SNORM16_MAX);
+
+		float bestDot = -2.0f;
+
+		for (uSize i = 0; i < 4; i++)
+		{
+			const float candidateU = scaledU + (float)(i & 1);
+			const float candidateV = scaledV + (float)(i >> 1);
+
+			int16 candidate[2];
+			candidate[0] = (int16)(candidateU > VERTEX_QUANTIZER_SNORM16_MAX ? VERTEX_QUANTIZER_SNORM16_MAX :
+				(candidateU < -VERTEX_QUANTIZER_SNORM16_MAX ? -VERTEX_QUANTIZER_SNORM16_MAX : candidateU));
+			candidate[1] = (int16)(candidateV > VERTEX_QUANTIZER_SNORM16_MAX ? VERTEX_QUANTIZER_SNORM16_MAX :
+				(candidateV < -VERTEX_QUANTIZER_SNORM16_MAX ? -VERTEX_QUANTIZER_SNORM16_MAX : candidateV));
+
+			float decoded[3];
+			DecodeOctahedral(candidate, decoded);
+
+			const float dot = decoded[0] * x + decoded[1] * y + decoded[2] * z;
+
+			if (dot > bestDot)
+			{
+				bestDot = dot;
+				pOutEncoded[0] = candidate[0];
+				pOutEncoded[1] = candidate[1];
+			}
+		}
+	}
+
+	static float DirectionAngleDegrees(const float* pDirection, const float* pDecoded)
+	{
+		const float length = sqrtf(pDirection[0] * pDirection[0] + pDirection[1] * pDirection[1] + pDirection[2] * pDirection[2]);
+
+		if (length == 0.0f)
+		{
+			// Degenerate directions have no angle to keep
+			return 0.0f;
+		}
+
+		float cosAngle = (pDirection[0] * pDecoded[0] + pDirection[1] * pDecoded[1] + pDirection[2] * pDecoded[2]) / length;
+		cosAngle = cosAngle > 1.0f ? 1.0f : (cosAngle < -1.0f ? -1.0f : cosAngle);
+
+		return acosf(cosAngle) / ToRadians(1.0f);
+	}
+
+	static VertexFormat QuantizedFormat(const VertexElement& element, VertexQuantizeFlags flags)
+	{
+		switch (element.attribute)
+		{
+			case VERTEX_ATTRIBUTE_POSITION:
+			{
+				if ((flags & VERTEX_QUANTIZE_POSITIONS) && element.format == VERTEX_FORMAT_FLOAT3)
+				{
+					return VERTEX_FORMAT_UNORM16_4;
+				}
+
+				break;
+			}
+
+			case VERTEX_ATTRIBUTE_NORMAL:
+			case VERTEX_ATTRIBUTE_BITANGENT:
+			case VERTEX_ATTRIBUTE_TANGENT:
+			{
+				if ((flags & VERTEX_QUANTIZE_DIRECTIONS) && element.format == VERTEX_FORMAT_FLOAT3)
+				{
+					return VERTEX_FORMAT_SNORM16_2;
+				}
+
+				if ((flags & VERTEX_QUANTIZE_DIRECTIONS) && element.format == VERTEX_FORMAT_FLOAT4 &&
+					element.attribute == VERTEX_ATTRIBUTE_TANGENT)
+				{
+					return VERTEX_FORMAT_SNORM16_4;
+				}
+
+				break;
+			}
+
+			case VERTEX_ATTRIBUTE_TEXCOORD:
+			{
+				if ((flags & VERTEX_QUANTIZE_TEXCOORDS) && element.format == VERTEX_FORMAT_FLOAT2)
+				{
+					return VERTEX_FORMAT_FLOAT16_2;
+				}
+
+				break;
+			}
+
+			default:
+				break;
+		}
+
+		return element.format;
+	}
+
+	/* Per vertex errors, gathered per mesh once every stream is written */
+	struct VertexQuantizeErrors
+	{
+		Array<float> position;
+		Array<float> direction;
+		Array<float> texCoord;
+	};
+
+	static void QuantizeElement(const VertexElement& element, const VertexElement& quantizedElement, const uInt8* pSource,
+		uInt8* pDest, const Bounds3f& bounds, uSize vertexIdx, VertexQuantizeErrors& errors)
+	{
+		switch (quantizedElement.format)
+		{
+			case VERTEX_FORMAT_UNORM16_4:
+			{
+				const float minimum[3] = { bounds.min.x, bounds.min.y, bounds.min.z };
+				const float extent[3] = { bounds.max.x - bounds.min.x, bounds.max.y - bounds.min.y, bounds.max.z - bounds.min.z };
+
+				float position[3];
+				MemCopy(position, pSource, sizeof(position));
+
+				uInt16 quantized[4] = {};
+				float error = 0.0f;
+
+				for (uSize i = 0; i < 3; i++)
+				{
+					const float normalized = extent[i] > 0.0f ? (position[i] - minimum[i]) / extent[i] : 0.0f;
+					const float clamped = normalized < 0.0f ? 0.0f : (normalized > 1.0f ? 1.0f : normalized);
+
+					quantized[i] = (uInt16)roundf(clamped * VERTEX_QUANTIZER_UNORM16_MAX);
+
+					const float decoded = minimum[i] + ((float)quantized[i] / VERTEX_QUANTIZER_UNORM16_MAX) * extent[i];
+					error += (decoded - position[i]) * (decoded - position[i]);
+				}
+
+				MemCopy(pDest, quantized, sizeof(quantized));
+
+				error = sqrtf(error);
+				errors.position[vertexIdx] = error > errors.position[vertexIdx] ? error : errors.position[vertexIdx];
+
+				break;
+			}
+
+			case VERTEX_FORMAT_SNORM16_2:
+			case VERTEX_FORMAT_SNORM16_4:
+			{
+				float direction[4] = { 0.0f, 0.0f, 0.0f, 1.0f };
+				MemCopy(direction, pSource, VertexFormatSizeBytes(element.format));
+
+				int16 quantized[4] = {};
+				EncodeOctahedral(direction, quantized);
+
+				if (quantizedElement.format == VERTEX_FORMAT_SNORM16_4)
+				{
+					// Tangent handedness
+					quantized[2] = direction[3] < 0.0f ? -VERTEX_QUANTIZER_SNORM16_MAX : VERTEX_QUANTIZER_SNORM16_MAX;
+				}
+
+				MemCopy(pDest, quantized, quantizedElement.sizeBytes);
+
+				float decoded[3];
+				DecodeOctahedral(quantized, decoded);
+
+				const float error = DirectionAngleDegrees(direction, decoded);
+				errors.direction[vertexIdx] = error > errors.direction[vertexIdx] ? error : errors.direction[vertexIdx];
+
+				break;
+			}
+
+			case VERTEX_FORMAT_FLOAT16_2:
+			{
+				float texCoord[2];
+				MemCopy(texCoord, pSource, sizeof(texCoord));
+
+				const uInt16 quantized[2] = { FloatToHalf(texCoord[0]), FloatToHalf(texCoord[1]) };
+				MemCopy(pDest, quantized, sizeof(quantized));
+
+				const float errorU = HalfToFloat(quantized[0]) - texCoord[0];
+				const float errorV = HalfToFloat(quantized[1]) - texCoord[1];
+				const float error = sqrtf(errorU * errorU + errorV * errorV);
+
+				errors.texCoord[vertexIdx] = error > errors.texCoord[vertexIdx] ? error : errors.texCoord[vertexIdx];
+
+				break;
+			}
+
+			default:
+			{
+				MemCopy(pDest, pSource, quantizedElement.sizeBytes);
+				break;
+			}
+		}
+	}
+
+	static void ResetErrors(Array<float>& errors, uSize vertexCount)
+	{
+		errors.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			errors[i] = 0.0f;
+		}
+	}
+
+	static void GatherMeshError(const Model& model, uSize indexStart, uSize indexCount,
+		const VertexQuantizeErrors& errors, VertexQuantizeError& outError)
+	{
+		outError = {};
+
+		const IndexStream& indexStream = model.indexStream;
+		const IndexFormat indexFormat = indexStream.indexElement.format;
+		const uInt8* pIndexData = indexStream.GetData();
+
+		const uSize indexSizeBytes = indexFormat < _MAX_INDEX_FORMAT_ENUM ? IndexFormatSizeBytes(indexFormat) : 0;
+		const uSize vertexCount = errors.position.Size();
+
+		if (!pIndexData || indexSizeBytes == 0 || indexStart + indexCount > indexStream.GetSizeBytes() / indexSizeBytes)
+		{
+			return;
+		}
+
+		for (uSize i = indexStart; i < indexStart + indexCount; i++)
+		{
+			uInt32 index;
+
+			switch (indexFormat)
+			{
+				case INDEX_FORMAT_UINT8:	index = pIndexData[i]; break;
+				case INDEX_FORMAT_UINT16:	index = ((const uInt16*)pIndexData)[i]; break;
+				default:					index = ((const uInt32*)pIndexData)[i]; break;
+			}
+
+			if (index >= vertexCount)
+			{
+				continue;
+			}
+
+			outError.maxPositionError	= errors.position[index] > outError.maxPositionError ? errors.position[index] : outError.maxPositionError;
+			outError.maxDirectionError	= errors.direction[index] > outError.maxDirectionError ? errors.direction[index] : outError.maxDirectionError;
+			outError.maxTexCoordError	= errors.texCoord[index] > outError.maxTexCoordError ? errors.texCoord[index] : outError.maxTexCoordError;
+		}
+	}
+
+	bool QuantizeModel(Model& model, VertexQuantizeFlags flags,
+		PoolAllocator<ByteBuffer>& bufferAllocator, VertexQuantizeStats* pOutStats)
+	{
+		/* Validate every stream before any is replaced */
+
+		uSize vertexCount		= 0;
+		uSize sizeBytesBefore	= 0;
+
+		const uInt8* pPositions		= nullptr;
+		uSize positionStrideBytes	= 0;
+		uSize positionVertexCount	= 0;
+
+		for (const VertexStream& stream : model.vertexStreams)
+		{
+			if (!stream.HasData())
+			{
+				continue;
+			}
+
+			if (stream.strideBytes == 0)
+			{
+				LogError("Failed to quantize model. Vertex stream %d has no stride.", stream.streamIdx);
+				return false;
+			}
+
+			for (const VertexElement& element : stream.vertexElements)
+			{
+				if (element.format >= _MAX_VERTEX_FORMAT_ENUM ||
+					element.offsetBytes + VertexFormatSizeBytes(element.format) > stream.strideBytes)
+				{
+					LogError("Failed to quantize model. A vertex element lies outside vertex stream %d.", stream.streamIdx);
+					return false;
+				}
+
+				if (element.attribute == VERTEX_ATTRIBUTE_POSITION && element.format == VERTEX_FORMAT_FLOAT3 && !pPositions)
+				{
+					pPositions			= stream.GetData() + element.offsetBytes;
+					positionStrideBytes	= stream.strideBytes;
+					positionVertexCount	= stream.GetSizeBytes() / stream.strideBytes;
+				}
+			}
+
+			const uSize streamVertexCount = stream.GetSizeBytes() / stream.strideBytes;
+			vertexCount = streamVertexCount > vertexCount ? streamVertexCount : vertexCount;
+			sizeBytesBefore += stream.GetSizeBytes();
+		}
+
+		/* Bounds */
+
+		if (pPositions && positionVertexCount > 0)
+		{
+			float minimum[3];
+			float maximum[3];
+
+			MemCopy(minimum, pPositions, sizeof(minimum));
+			MemCopy(maximum, pPositions, sizeof(maximum));
+
+			for (uSize i = 1; i < positionVertexCount; i++)
+			{
+				float position[3];
+				MemCopy(position, pPositions + i * positionStrideBytes, sizeof(position));
+
+				for (uSize j = 0; j < 3; j++)
+				{
+					minimum[j] = position[j] < minimum[j] ? position[j] : minimum[j];
+					maximum[j] = position[j] > maximum[j] ? position[j] : maximum[j];
+				}
+			}
+
+			model.bounds.min.x = minimum[0];
+			model.bounds.min.y = minimum[1];
+			model.bounds.min.z = minimum[2];
+			model.bounds.max.x = maximum[0];
+			model.bounds.max.y = maximum[1];
+			model.bounds.max.z = maximum[2];
+		}
+
+		/* Repack streams */
+
+		VertexQuantizeErrors errors;
+		ResetErrors(errors.position, vertexCount);
+		ResetErrors(errors.direction, vertexCount);
+		ResetErrors(errors.texCoord, vertexCount);
+
+		uSize sizeBytesAfter = 0;
+
+		for (VertexStream& stream : model.vertexStreams)
+		{
+			if (!stream.HasData())
+			{
+				continue;
+			}
+
+			Array<VertexElement, 8> quantizedElements;
+			uInt32 quantizedStrideBytes = 0;
+			bool quantized = false;
+
+			for (const VertexElement& element : stream.vertexElements)
+			{
+				VertexElement quantizedElement = element;
+				quantizedElement.format			= QuantizedFormat(element, flags);
+				quantizedElement.offsetBytes	= quantizedStrideBytes;
+				quantizedElement.sizeBytes		= VertexFormatSizeBytes(quantizedElement.format);
+
+				quantizedStrideBytes += quantizedElement.sizeBytes;
+				quantized |= quantizedElement.format != element.format;
+
+				quantizedElements.PushBack(quantizedElement);
+			}
+
+			if (!quantized)
+			{
+				sizeBytesAfter += stream.GetSizeBytes();
+				continue;
+			}
+
+			const uSize streamVertexCount	= stream.GetSizeBytes() / stream.strideBytes;
+			const uSize streamSizeBytes		= streamVertexCount * quantizedStrideBytes;
+
+			ByteBuffer* pQuantizedBuffer = bufferAllocator.Allocate(streamSizeBytes);
+
+			if (!pQuantizedBuffer)
+			{
+				LogError("Failed to quantize model. Could not allocate vertex stream %d.", stream.streamIdx);
+				return false;
+			}
+
+			pQuantizedBuffer->Allocate(streamSizeBytes);
+
+			const uInt8* pSourceData	= stream.GetData();
+			uInt8* pDestData			= pQuantizedBuffer->Data();
+
+			for (uSize i = 0; i < streamVertexCount; i++)
+			{
+				const uInt8* pSourceVertex	= pSourceData + i * stream.strideBytes;
+				uInt8* pDestVertex			= pDestData + i * quantizedStrideBytes;
+
+				for (uSize j = 0; j < quantizedElements.Size(); j++)
+				{
+					const VertexElement& element			= stream.vertexElements[j];
+					const VertexElement& quantizedElement	= quantizedElements[j];
+
+					QuantizeElement(element, quantizedElement, pSourceVertex + element.offsetBytes,
+						pDestVertex + quantizedElement.offsetBytes, model.bounds, i, errors);
+				}
+			}
+
+			if (stream.pVertexBuffer)
+			{
+				bufferAllocator.Free(stream.pVertexBuffer);
+			}
+
+			stream.pVertexBuffer	= pQuantizedBuffer;
+			stream.pMappedData		= nullptr;
+			stream.mappedSizeBytes	= 0;
+			stream.strideBytes		= quantizedStrideBytes;
+			stream.vertexElements	= quantizedElements;
+
+			sizeBytesAfter += streamSizeBytes;
+		}
+
+		/* Report */
+
+		if (pOutStats)
+		{
+			pOutStats->sizeBytesBefore	= sizeBytesBefore;
+			pOutStats->sizeBytesAfter	= sizeBytesAfter;
+			pOutStats->meshErrors.Clear();
+
+			if (model.meshes.Size() == 0)
+			{
+				VertexQuantizeError modelError;
+				GatherMeshError(model, 0, model.indexStream.indexCount, errors, modelError);
+				pOutStats->meshErrors.PushBack(modelError);
+			}
+
+			for (const Mesh& mesh : model.meshes)
+			{
+				VertexQuantizeError meshError;
+				GatherMeshError(model, mesh.indexStart, mesh.indexCount, errors, meshError);
+				pOutStats->meshErrors.PushBack(meshError);
+			}
+		}
+
+		return true;
+	}
+}
\ No newline at end of file
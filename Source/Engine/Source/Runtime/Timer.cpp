@@ -4,14 +4,14 @@ namespace Quartz
 {
 	void Timer::Start()
 	{
-		mStart = std::chrono::steady_clock::now();
+		mStart = ClockType::now();
 		mMark = mStart;
 	}
 
 	double Timer::Mark()
 	{
-		auto& now = std::chrono::steady_clock::now();
-		auto& time = std::chrono::duration_cast<Duration>(now - mMark);
+		const auto now = ClockType::now();
+		const auto time = std::chrono::duration_cast<Duration>(now - mMark);
 		mMark = now;
 
 		return time.count();
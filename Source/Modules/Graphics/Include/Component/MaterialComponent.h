@@ -3,6 +3,7 @@
 #include "GfxAPI.h"
 #include "Entity/Component.h"
 #include "Resource/Assets/Material.h"
+#include "Resource/AssetHandle.h"
 
 #include "Types/String.h"
 
@@ -12,6 +13,7 @@ namespace Quartz
 	{
 		Array<String> materialPaths;
 		Array<Material*> pCachedMaterials;
+		Array<AssetHandle<Material>> materialHandles; // One per material path, held so drawn materials are not evicted
 
 		MaterialComponent() = default;
 		MaterialComponent(const Array<String>& materialPaths);
@@ -3,6 +3,7 @@
 #include "GfxAPI.h"
 #include "Entity/Component.h"
 #include "Resource/Assets/Model.h"
+#include "Resource/AssetHandle.h"
 
 namespace Quartz
 {
@@ -11,6 +12,7 @@ namespace Quartz
 		String modelURI;
 		uInt64 modelURIHash;
 		Model* pCachedModel;
+		AssetHandle<Model> modelHandle; // Pending load, the mesh is not drawn until it completes
 
 		MeshComponent();
 		MeshComponent(const String& uri);
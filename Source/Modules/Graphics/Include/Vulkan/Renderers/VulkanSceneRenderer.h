@@ -18,6 +18,7 @@
 #include "Component/LightComponent.h"
 
 #include "Resource/Assets/Image.h"
+#include "Resource/AssetHandle.h"
 
 namespace Quartz
 {
@@ -43,6 +44,8 @@ namespace Quartz
 		Mat4f model;
 		Mat4f view;
 		Mat4f proj;
+		Vec4f positionScale;	// Decodes VERTEX_FORMAT_UNORM16_4 positions, identity otherwise
+		Vec4f positionOffset;
 	};
 
 #pragma pack(pop)
@@ -62,6 +65,7 @@ namespace Quartz
 		// TEMP
 		VkSampler mVkDefaultSampler;
 		Map<String, VulkanImageView*> mTextureCache;
+		Map<String, AssetHandle<Image>> mTextureHandles; // Textures still loading, released once in mTextureCache
 
 	private:
 		void GenAndCopyImageMipmapped(const Image* pImage, VulkanImage*& pVulkanImage, uInt32 mipCount);
@@ -9,8 +9,39 @@
 // TEMP
 #include "Resource/Assets/Image.h"
 
+#include <math.h>
+
+#define VULKAN_SCENE_LOD_MAX_PIXEL_ERROR	1.0f	// Screen space error a simplified LOD may show
+
 namespace Quartz
 {
+	/*
+		Meshes with a lod above 0 are the simplified levels of the LOD 0 before them. The coarsest
+		level whose error, projected at pixelsPerUnit, stays within VULKAN_SCENE_LOD_MAX_PIXEL_ERROR
+		is drawn and the rest of its chain is skipped.
+	*/
+	static bool IsSelectedLod(const Array<Mesh>& meshes, uSize meshIdx, float pixelsPerUnit)
+	{
+		uSize chainStart = meshIdx;
+
+		while (chainStart > 0 && meshes[chainStart].lod != 0)
+		{
+			chainStart--;
+		}
+
+		uSize selectedIdx = chainStart;
+
+		for (uSize i = chainStart + 1; i < meshes.Size() && meshes[i].lod != 0; i++)
+		{
+			if (meshes[i].lodError * pixelsPerUnit <= VULKAN_SCENE_LOD_MAX_PIXEL_ERROR)
+			{
+				selectedIdx = i;
+			}
+		}
+
+		return selectedIdx == meshIdx;
+	}
+
 	void VulkanSceneRenderer::Initialize(VulkanGraphics& graphics, VulkanDevice& device, VulkanShaderCache& shaderCache,
 		VulkanPipelineCache& pipelineCache, uSize maxInFlightCount)
 	{
@@ -191,11 +222,16 @@ namespace Quartz
 
 			if (!pModel)
 			{
-				pModel = Engine::GetAssetManager().GetOrLoadAsset<Model>(meshComponent.modelURI);
+				if (!meshComponent.modelHandle.IsValid())
+				{
+					meshComponent.modelHandle = Engine::GetAssetManager().LoadAssetAsync<Model>(meshComponent.modelURI);
+				}
+
+				pModel = meshComponent.modelHandle.Get();
 
 				if (!pModel)
 				{
-					// Failed to load model
+					// Still loading, or failed to load model
 					continue;
 				}
 
@@ -209,9 +245,25 @@ namespace Quartz
 			// @TODO: error check ^
 
 			VulkanRenderablePerModelUBO perModelUbo = {};
-			perModelUbo.model	= transformComponent.GetMatrix();
-			perModelUbo.view	= cameraTransform.GetViewMatrix();
-			perModelUbo.proj	= camera.GetProjectionMatrix();
+			perModelUbo.model			= transformComponent.GetMatrix();
+			perModelUbo.view			= cameraTransform.GetViewMatrix();
+			perModelUbo.proj			= camera.GetProjectionMatrix();
+			perModelUbo.positionScale	= Vec4f(1.0f, 1.0f, 1.0f, 0.0f);
+			perModelUbo.positionOffset	= Vec4f(0.0f, 0.0f, 0.0f, 0.0f);
+
+			for (const VertexStream& stream : pModel->vertexStreams)
+			{
+				for (const VertexElement& element : stream.vertexElements)
+				{
+					if (element.attribute == VERTEX_ATTRIBUTE_POSITION && element.format == VERTEX_FORMAT_UNORM16_4)
+					{
+						// Quantized positions are fractions of the model bounds
+						const Bounds3f& bounds = pModel->bounds;
+						perModelUbo.positionScale	= Vec4f(bounds.max - bounds.min, 0.0f);
+						perModelUbo.positionOffset	= Vec4f(bounds.min, 0.0f);
+					}
+				}
+			}
 
 			UniformBufferLocation transformBufferLocation;
 			bufferCache.AllocateAndWriteUniformData(transformBufferLocation, 0, &perModelUbo, sizeof(VulkanRenderablePerModelUBO), 64);
@@ -228,7 +280,7 @@ namespace Quartz
 			uSize location = 0;
 			for (const VertexStream& stream : pModel->vertexStreams)
 			{
-				if (!stream.pVertexBuffer)
+				if (!stream.HasData())
 				{
 					continue;
 				}
@@ -260,6 +312,10 @@ namespace Quartz
 						case VERTEX_FORMAT_UINT_2_10_10_10:		vkAttribFormat = VK_FORMAT_A2R10G10B10_UINT_PACK32; break;
 						case VERTEX_FORMAT_FLOAT_10_11_11:		vkAttribFormat = VK_FORMAT_B10G11R11_UFLOAT_PACK32; break;
 						case VERTEX_FORMAT_FLOAT_16_16_16_16:	vkAttribFormat = VK_FORMAT_R16G16B16A16_SFLOAT; break;
+						case VERTEX_FORMAT_FLOAT16_2:			vkAttribFormat = VK_FORMAT_R16G16_SFLOAT; break;
+						case VERTEX_FORMAT_UNORM16_4:			vkAttribFormat = VK_FORMAT_R16G16B16A16_UNORM; break;
+						case VERTEX_FORMAT_SNORM16_2:			vkAttribFormat = VK_FORMAT_R16G16_SNORM; break;
+						case VERTEX_FORMAT_SNORM16_4:			vkAttribFormat = VK_FORMAT_R16G16B16A16_SNORM; break;
 					}
 
 					VkVertexInputAttributeDescription elementAttrib = {};
@@ -276,8 +332,21 @@ namespace Quartz
 
 			const IndexElement indexElement = pModel->indexStream.indexElement;
 
-			for (const Mesh& mesh : pModel->meshes)
+			// Pixels an object space unit covers at the model's distance
+			const float cameraDistance	= (transformComponent.position - cameraTransform.position).Magnitude();
+			const float pixelsPerRadian	= camera.height / (2.0f * tanf(ToRadians(camera.fov) * 0.5f));
+			const float lodPixelsPerUnit = cameraDistance > 0.0f ?
+				transformComponent.scale.Maximum() * pixelsPerRadian / cameraDistance : INFINITY;
+
+			for (uSize meshIdx = 0; meshIdx < pModel->meshes.Size(); meshIdx++)
 			{
+				const Mesh& mesh = pModel->meshes[meshIdx];
+
+				if (!IsSelectedLod(pModel->meshes, meshIdx, lodPixelsPerUnit))
+				{
+					continue;
+				}
+
 				VulkanRenderable renderable = {};
 
 				const IndexFormat indexType = indexElement.format;
@@ -303,7 +372,28 @@ namespace Quartz
 					}
 
 					const String& materialPath = materialComponent.materialPaths[materialIdx];
-					Material* pMaterial = Engine::GetAssetManager().GetOrLoadAsset<Material>(materialPath); // @TODO: Cache
+
+					while (materialComponent.materialHandles.Size() < materialComponent.materialPaths.Size())
+					{
+						materialComponent.materialHandles.PushBack(AssetHandle<Material>());
+					}
+
+					AssetHandle<Material>& materialHandle = materialComponent.materialHandles[materialIdx];
+
+					if (!materialHandle.IsValid())
+					{
+						materialHandle = Engine::GetAssetManager().LoadAssetAsync<Material>(materialPath);
+					}
+
+					if (materialHandle.IsPending())
+					{
+						// Drawn with the default pipeline until the material is loaded
+						renderable.pPipeline = mpDefaultPipeline;
+						mRenderables.PushBack(renderable);
+						continue;
+					}
+
+					Material* pMaterial = materialHandle.Get();
 					
 					if (!pMaterial)
 					{
@@ -343,6 +433,8 @@ namespace Quartz
 						renderable.vertexBinds.PushBack(vertexBufferBind);
 					}
 
+					bool texturesPending = false;
+
 					for (auto& valuePair : pMaterial->shaderValues)
 					{
 						const String& paramName				= valuePair.key;
@@ -381,7 +473,18 @@ namespace Quartz
 							}
 							else
 							{
-								Image* pImage = Engine::GetAssetManager().GetOrLoadAsset<Image>(texturePath);
+								auto& handleIt = mTextureHandles.Find(texturePath);
+
+								AssetHandle<Image>& imageHandle = handleIt != mTextureHandles.End() ? handleIt->value :
+									mTextureHandles.Put(texturePath, Engine::GetAssetManager().LoadAssetAsync<Image>(texturePath));
+
+								Image* pImage = imageHandle.Get();
+
+								if (!pImage)
+								{
+									texturesPending |= imageHandle.IsPending();
+									continue;
+								}
 
 								VulkanImage* pVulkanImage = VK_NULL_HANDLE;
 
@@ -410,6 +513,9 @@ namespace Quartz
 								renderable.imageBinds.PushBack(imageBind);
 
 								mTextureCache.Put(texturePath, pVulkanImageView);
+
+								// The uploaded copy is all that is drawn from now on
+								mTextureHandles.Remove(texturePath);
 							}
 
 							continue;
@@ -463,6 +569,19 @@ namespace Quartz
 							renderable.materialBuffer = materialBufferLocation;
 						}
 					}
+
+					if (texturesPending)
+					{
+						// Drawn with the default pipeline until every texture is loaded
+						renderable = {};
+						renderable.inputBuffer		= bufferLocation;
+						renderable.sceneBuffer		= sceneBufferLocation;
+						renderable.transformBuffer	= transformBufferLocation;
+						renderable.indexStart		= mesh.indexStart;
+						renderable.indexCount		= mesh.indexCount;
+						renderable.vkIndexType		= indexType == INDEX_FORMAT_UINT16 ? VK_INDEX_TYPE_UINT16 : VK_INDEX_TYPE_UINT32;
+						renderable.pPipeline		= mpDefaultPipeline;
+					}
 				}
 				else
 				{
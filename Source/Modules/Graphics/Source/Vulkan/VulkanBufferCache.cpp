@@ -136,8 +136,8 @@ namespace Quartz
 
 	void CopyMeshVertexData(const VertexStream& vertexStream, void* pOutVertexData, uInt32 vertexPadBytes)
 	{
-		const void* pVertexData			= vertexStream.pVertexBuffer->Data();
-		const uSize verticesSizeBytes	= vertexStream.pVertexBuffer->Size();
+		const void* pVertexData			= vertexStream.GetData();
+		const uSize verticesSizeBytes	= vertexStream.GetSizeBytes();
 
 		memcpy_s(pOutVertexData, verticesSizeBytes, pVertexData, verticesSizeBytes);
 		memset((uInt8*)pOutVertexData + verticesSizeBytes, 0, vertexPadBytes);
@@ -145,8 +145,8 @@ namespace Quartz
 
 	void CopyMeshIndexData(const IndexStream& indexStream, void* pOutIndexData, uInt32 indexPadBytes)
 	{
-		const void* pIndexData			= indexStream.pIndexBuffer->Data();
-		const uSize indicesSizeBytes	= indexStream.pIndexBuffer->Size();
+		const void* pIndexData			= indexStream.GetData();
+		const uSize indicesSizeBytes	= indexStream.GetSizeBytes();
 
 		memcpy_s(pOutIndexData, indicesSizeBytes, pIndexData, indicesSizeBytes);
 		memset((uInt8*)pOutIndexData + indicesSizeBytes, 0, indexPadBytes);
@@ -174,7 +174,7 @@ namespace Quartz
 		
 		for (const VertexStream& vertexStream : model.vertexStreams)
 		{
-			if (!vertexStream.pVertexBuffer)
+			if (!vertexStream.HasData())
 			{
 				// Empty streamIdx, continue
 				continue;
@@ -183,7 +183,7 @@ namespace Quartz
 			VulkanMultiBufferEntry	vertexEntry;
 			uInt8*					pVertexData;
 
-			uSize verticesSizeBytes		= vertexStream.pVertexBuffer->Size();
+			uSize verticesSizeBytes		= vertexStream.GetSizeBytes();
 			uInt32 vertexAlignmentDiff	= verticesSizeBytes % vertexAlignBytes;
 			//verticesSizeBytes			+= vertexAlignBytes - vertexAlignmentDiff;
 
@@ -242,7 +242,7 @@ namespace Quartz
 		VulkanMultiBufferEntry	indexEntry;
 		uInt8*					pIndexData;
 
-		uSize indicesSizeBytes		= indexStream.pIndexBuffer->Size();
+		uSize indicesSizeBytes		= indexStream.GetSizeBytes();
 		uInt32 indexAlignmentDiff	= indicesSizeBytes % indexAlignBytes;
 		//indicesSizeBytes			+= indexAlignBytes - indexAlignmentDiff;
 
@@ -322,7 +322,7 @@ namespace Quartz
 		
 		for (const VertexStream& vertexStream : model.vertexStreams)
 		{
-			if (!vertexStream.pVertexBuffer)
+			if (!vertexStream.HasData())
 			{
 				// Empty streamIdx, continue
 				continue;
@@ -331,7 +331,7 @@ namespace Quartz
 			VulkanMultiBufferEntry	stagingVertexEntry;
 			uInt8*					pStagingVertexData;
 
-			uSize verticesSizeBytes		= vertexStream.pVertexBuffer->Size();
+			uSize verticesSizeBytes		= vertexStream.GetSizeBytes();
 			uInt32 vertexAlignmentDiff	= verticesSizeBytes % vertexAlignBytes;
 			//verticesSizeBytes			+= vertexAlignBytes - vertexAlignmentDiff;
 
@@ -372,7 +372,7 @@ namespace Quartz
 		VulkanMultiBufferEntry	stagingIndexEntry;
 		uInt8*					pStagingIndexData;
 
-		uSize indicesSizeBytes		= indexStream.pIndexBuffer->Size();
+		uSize indicesSizeBytes		= indexStream.GetSizeBytes();
 		uInt32 indexAlignmentDiff	= indicesSizeBytes % indexAlignBytes;
 		//indicesSizeBytes			+= indexAlignBytes - indexAlignmentDiff;
 
@@ -221,6 +221,17 @@ namespace Quartz
 
 	bool WinApiFilesystemHandler::UnmapFile(File& file)
 	{
+		if (!file.GetMappedData())
+		{
+			return true;
+		}
+
+		if (!UnmapViewOfFile(file.GetMappedData()))
+		{
+			WinApiPrintError();
+			return false;
+		}
+
 		return true;
 	}
 
@@ -0,0 +1,599 @@
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#include <io.h>
+#undef CreateFile
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#include <sys/stat.h>
+
+#include "Log.h"
+#include "Filesystem/File.h"
+#include "Filesystem/FilesystemHandler.h"
+#include "Resource/Binary/QModelParser.h"
+#include "Resource/AssetManager.h"
+#include "Memory/PoolAllocator.h"
+#include "Types/Array.h"
+
+#include <chrono>
+#include <math.h>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+
+/*
+	QModel load throughput, uncompressed against per-stream LZ compression.
+	Every model is written in both formats, then loaded with the page cache
+	dropped (cold) and again with the files cached (warm). Loading includes
+	touching every stream byte, as the upload to the GPU would.
+	Before timing, checks that AssetManager keeps assets loaded under a
+	memory budget smaller than any one of them.
+	Usage: AssetBenchmark [models] [vertices per model] [repeats]
+*/
+
+using namespace Quartz;
+
+/* Plain C file access, so the benchmark runs without the platform module */
+class BenchmarkFilesystemHandler : public FilesystemHandler
+{
+public:
+	bool OpenFile(File& file, FileOpenFlags openFlags, void*& pOutHandle, FileFlags& outFlags) override
+	{
+		const char* pMode = (openFlags & FILE_OPEN_WRITE) ? ((openFlags & FILE_OPEN_CLEAR) ? "w+b" : "r+b") : "rb";
+		FILE* pFile = fopen(file.GetPath().Str(), pMode);
+
+		if (!pFile)
+		{
+			return false;
+		}
+
+		pOutHandle = pFile;
+		outFlags |= FILE_OPEN | FILE_READ | ((openFlags & FILE_OPEN_WRITE) ? FILE_WRITE : 0);
+
+		return true;
+	}
+
+	bool CloseFile(File& file, void*& pOutHandle, FileFlags& outFlags) override
+	{
+		if (!pOutHandle)
+		{
+			return false;
+		}
+
+		fclose((FILE*)pOutHandle);
+		pOutHandle = nullptr;
+		outFlags &= ~(FILE_OPEN | FILE_READ | FILE_WRITE);
+
+		return true;
+	}
+
+	bool OpenFolder(Folder& folder, void*& pOutHandle) override { return false; }
+	bool CloseFolder(Folder& folder, void*& pOutHandle) override { return false; }
+	bool CreateFile(const String& path, File*& pOutFile, FileOpenFlags openFlags) override { return false; }
+	bool CreateFolder(const String& path, Folder*& pOutFolder, uSize priority) override { return false; }
+	bool DeleteFolder(Folder& Folder) override { return false; }
+
+	bool MapFile(File& file, uInt8*& pOutMapPtr, uInt64 reserveBytes, FileMapFlags mapFlags) override
+	{
+		FILE* pFile = (FILE*)file.GetNativeHandle();
+
+#ifdef _WIN32
+		HANDLE mapHandle = CreateFileMapping((HANDLE)_get_osfhandle(_fileno(pFile)), NULL, PAGE_READONLY, 0, 0, NULL);
+
+		if (!mapHandle)
+		{
+			return false;
+		}
+
+		// The view keeps the mapping alive
+		pOutMapPtr = (uInt8*)MapViewOfFile(mapHandle, SYS_FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapHandle);
+
+		return pOutMapPtr != nullptr;
+#else
+		void* pMapPtr = mmap(nullptr, file.GetSize(), PROT_READ, MAP_PRIVATE, fileno(pFile), 0);
+
+		if (pMapPtr == MAP_FAILED)
+		{
+			return false;
+		}
+
+		pOutMapPtr = (uInt8*)pMapPtr;
+
+		return true;
+#endif
+	}
+
+	bool UnmapFile(File& file) override
+	{
+#ifdef _WIN32
+		return UnmapViewOfFile(file.GetMappedData());
+#else
+		return munmap(file.GetMappedData(), file.GetSize()) == 0;
+#endif
+	}
+
+	bool ReadFile(File& file, void* pOutData, uSize sizeBytes) override
+	{
+		return fread(pOutData, 1, sizeBytes, (FILE*)file.GetNativeHandle()) == sizeBytes;
+	}
+
+	bool WriteFile(File& file, void* pInData, uSize sizeBytes) override
+	{
+		return fwrite(pInData, 1, sizeBytes, (FILE*)file.GetNativeHandle()) == sizeBytes;
+	}
+
+	bool SetFilePtr(File& file, int64 offset, FilePtrRelative relative, uInt64& outIntPtr) override
+	{
+		const int origin = relative == FILE_PTR_BEGIN ? SEEK_SET : (relative == FILE_PTR_CURRENT ? SEEK_CUR : SEEK_END);
+
+#ifdef _WIN32
+		const bool result = _fseeki64((FILE*)file.GetNativeHandle(), offset, origin) == 0;
+#else
+		const bool result = fseeko((FILE*)file.GetNativeHandle(), offset, origin) == 0;
+#endif
+
+		return result && GetFilePtr(file, outIntPtr);
+	}
+
+	bool GetFilePtr(const File& file, uInt64& outIntPtr) override
+	{
+#ifdef _WIN32
+		outIntPtr = (uInt64)_ftelli64((FILE*)file.GetNativeHandle());
+#else
+		outIntPtr = (uInt64)ftello((FILE*)file.GetNativeHandle());
+#endif
+
+		return true;
+	}
+
+	bool PopulateChildren(Folder& folder, const Filesystem& filesystem,
+		Array<Folder*>& outFolders, Array<File*>& outFiles) override
+	{
+		return false;
+	}
+
+	bool IsVirtual() const override { return false; }
+};
+
+static uInt64 GetFileSize(const char* pPath)
+{
+#ifdef _WIN32
+	struct _stat64 fileStat;
+	return _stat64(pPath, &fileStat) == 0 ? (uInt64)fileStat.st_size : 0;
+#else
+	struct stat fileStat;
+	return stat(pPath, &fileStat) == 0 ? (uInt64)fileStat.st_size : 0;
+#endif
+}
+
+/* Drops the file's pages from the OS cache. False if the OS would not */
+static bool EvictFromCache(const char* pPath)
+{
+#ifdef _WIN32
+	// Opening a file unbuffered discards its cached pages
+	HANDLE handle = CreateFileA(pPath, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_FLAG_NO_BUFFERING, NULL);
+
+	if (handle == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+
+	CloseHandle(handle);
+
+	return true;
+#else
+	const int fd = open(pPath, O_RDONLY);
+
+	if (fd < 0)
+	{
+		return false;
+	}
+
+	// Dirty pages are not dropped, so the freshly written files are flushed first
+	fsync(fd);
+	const bool result = posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED) == 0;
+	close(fd);
+
+	return result;
+#endif
+}
+
+/* A noisy terrain patch: positions in stream 0, normals and texcoords in stream 1 */
+static void BuildTerrain(Model& model, uSize vertexCount, uInt32 seed)
+{
+	std::mt19937 random(seed);
+	std::uniform_real_distribution<float> noiseDist(-0.05f, 0.05f);
+
+	const uSize side		= (uSize)sqrt((double)vertexCount) < 2 ? 2 : (uSize)sqrt((double)vertexCount);
+	const uSize quadCount	= (side - 1) * (side - 1);
+	const float phase		= (float)(seed % 16);
+
+	model.vertexStreams.Resize(2);
+
+	VertexStream& positionStream	= model.vertexStreams[0];
+	positionStream.streamIdx		= 0;
+	positionStream.strideBytes		= 12;
+	positionStream.vertexElements.PushBack({ VERTEX_ATTRIBUTE_POSITION, VERTEX_FORMAT_FLOAT3, 0, 12 });
+	positionStream.pVertexBuffer	= new ByteBuffer();
+	positionStream.pVertexBuffer->Allocate(side * side * 12);
+
+	VertexStream& attributeStream	= model.vertexStreams[1];
+	attributeStream.streamIdx		= 1;
+	attributeStream.strideBytes		= 20;
+	attributeStream.vertexElements.PushBack({ VERTEX_ATTRIBUTE_NORMAL, VERTEX_FORMAT_FLOAT3, 0, 12 });
+	attributeStream.vertexElements.PushBack({ VERTEX_ATTRIBUTE_TEXCOORD, VERTEX_FORMAT_FLOAT2, 12, 8 });
+	attributeStream.pVertexBuffer	= new ByteBuffer();
+	attributeStream.pVertexBuffer->Allocate(side * side * 20);
+
+	float* pPositions	= (float*)positionStream.pVertexBuffer->Data();
+	float* pAttributes	= (float*)attributeStream.pVertexBuffer->Data();
+
+	for (uSize z = 0; z < side; z++)
+	{
+		for (uSize x = 0; x < side; x++)
+		{
+			const uSize i = z * side + x;
+			const float height = sinf(x * 0.05f + phase) * cosf(z * 0.05f) * 4.0f + noiseDist(random);
+
+			pPositions[i * 3 + 0] = (float)x;
+			pPositions[i * 3 + 1] = height;
+			pPositions[i * 3 + 2] = (float)z;
+
+			pAttributes[i * 5 + 0] = 0.0f;
+			pAttributes[i * 5 + 1] = 1.0f;
+			pAttributes[i * 5 + 2] = 0.0f;
+			pAttributes[i * 5 + 3] = (float)x / (float)side;
+			pAttributes[i * 5 + 4] = (float)z / (float)side;
+		}
+	}
+
+	IndexStream& indexStream			= model.indexStream;
+	indexStream.indexElement.format		= INDEX_FORMAT_UINT32;
+	indexStream.indexElement.sizeBytes	= 4;
+	indexStream.indexCount				= (uInt32)(quadCount * 6);
+	indexStream.maxIndex				= (uInt32)(side * side - 1);
+	indexStream.pIndexBuffer			= new ByteBuffer();
+	indexStream.pIndexBuffer->Allocate(quadCount * 6 * 4);
+
+	uInt32* pIndices = (uInt32*)indexStream.pIndexBuffer->Data();
+
+	for (uSize z = 0; z < side - 1; z++)
+	{
+		for (uSize x = 0; x < side - 1; x++)
+		{
+			const uInt32 i = (uInt32)(z * side + x);
+
+			*pIndices++ = i;
+			*pIndices++ = i + (uInt32)side;
+			*pIndices++ = i + 1;
+			*pIndices++ = i + 1;
+			*pIndices++ = i + (uInt32)side;
+			*pIndices++ = i + (uInt32)side + 1;
+		}
+	}
+
+	Mesh mesh;
+	mesh.name			= "Terrain";
+	mesh.lod			= 0;
+	mesh.lodError		= 0.0f;
+	mesh.materialIdx	= 0;
+	mesh.indexStart		= 0;
+	mesh.indexCount		= indexStream.indexCount;
+
+	model.meshes.PushBack(mesh);
+}
+
+static void FreeTerrain(Model& model)
+{
+	for (VertexStream& stream : model.vertexStreams)
+	{
+		delete stream.pVertexBuffer;
+	}
+
+	delete model.indexStream.pIndexBuffer;
+}
+
+struct LoadResult
+{
+	double seconds;
+	uInt64 rawBytes;
+	uInt64 checksum;
+};
+
+/* Loads every file as ModelHandler would, reads every stream byte, then unloads */
+static bool LoadModels(BenchmarkFilesystemHandler& handler, const Array<String>& paths,
+	PoolAllocator<Model>& modelPool, PoolAllocator<ByteBuffer>& bufferPool, LoadResult& outResult)
+{
+	outResult = {};
+
+	auto start = std::chrono::high_resolution_clock::now();
+
+	for (const String& path : paths)
+	{
+		File file(path, handler, nullptr, FILE_VALID, GetFileSize(path.Str()), 0);
+		QModelParser parser(file, &modelPool, &bufferPool);
+
+		if (!parser.Read())
+		{
+			printf("Failed to read [%s].\n", path.Str());
+			return false;
+		}
+
+		Model* pModel = parser.GetModel();
+
+		for (const VertexStream& stream : pModel->vertexStreams)
+		{
+			const uInt8* pData = stream.GetData();
+
+			// One read per 64 bytes touches every page and cache line
+			for (uSize i = 0; i < stream.GetSizeBytes(); i += 64)
+			{
+				outResult.checksum += pData[i];
+			}
+
+			outResult.rawBytes += stream.GetSizeBytes();
+		}
+
+		const uInt8* pIndexData = pModel->indexStream.GetData();
+
+		for (uSize i = 0; i < pModel->indexStream.GetSizeBytes(); i += 64)
+		{
+			outResult.checksum += pIndexData[i];
+		}
+
+		outResult.rawBytes += pModel->indexStream.GetSizeBytes();
+
+		if (file.IsMapped())
+		{
+			file.Unmap();
+			file.Close();
+		}
+
+		for (VertexStream& stream : pModel->vertexStreams)
+		{
+			if (stream.pVertexBuffer)
+			{
+				bufferPool.Free(stream.pVertexBuffer);
+			}
+		}
+
+		if (pModel->indexStream.pIndexBuffer)
+		{
+			bufferPool.Free(pModel->indexStream.pIndexBuffer);
+		}
+
+		modelPool.Free(pModel);
+	}
+
+	auto end = std::chrono::high_resolution_clock::now();
+
+	outResult.seconds = std::chrono::duration<double>(end - start).count();
+
+	return true;
+}
+
+/* Resident but never read, so the budget check needs no files on disk */
+class BudgetAsset : public Asset
+{
+public:
+	String GetAssetTypeName() const override { return "BudgetAsset"; }
+	uSize GetSizeBytes() const override { return 4096; }
+};
+
+class BudgetAssetHandler : public AssetHandler
+{
+public:
+	std::atomic<uSize> unloadCount;
+
+	BudgetAssetHandler() : unloadCount(0) {}
+
+	bool LoadAsset(File& assetFile, Asset*& pOutAsset) override
+	{
+		// Long enough for waiting callers to pile up behind the load
+		std::this_thread::sleep_for(std::chrono::milliseconds(2));
+		pOutAsset = new BudgetAsset();
+		return true;
+	}
+
+	bool UnloadAsset(Asset* pInAsset) override
+	{
+		unloadCount++;
+		delete static_cast<BudgetAsset*>(pInAsset);
+		return true;
+	}
+};
+
+/* Loads raw pointers and handles with a budget below the size of one asset, none may be lost */
+static bool CheckAssetBudget(BenchmarkFilesystemHandler& handler)
+{
+	AssetManager assetManager;
+	BudgetAssetHandler budgetHandler;
+	assetManager.RegisterAssetHandler("budget", &budgetHandler);
+	assetManager.SetMemoryBudget(1);
+
+	File syncFile("AssetBenchmark_sync.budget", handler, nullptr, FILE_VALID, 0, 0);
+
+	BudgetAsset* pSyncAsset = assetManager.GetOrLoadAsset<BudgetAsset>(syncFile);
+
+	if (!pSyncAsset || !pSyncAsset->IsLoaded() || budgetHandler.unloadCount != 0)
+	{
+		printf("Budget check failed: a synchronous load was evicted before it returned.\n");
+		return false;
+	}
+
+	/* Synchronous callers waiting on loads running on the loader threads */
+
+	File sharedFile0("AssetBenchmark_shared0.budget", handler, nullptr, FILE_VALID, 0, 0);
+	File sharedFile1("AssetBenchmark_shared1.budget", handler, nullptr, FILE_VALID, 0, 0);
+	File* pSharedFiles[] = { &sharedFile0, &sharedFile1 };
+
+	assetManager.StartLoaders(ASSET_MANAGER_LOADER_THREADS);
+
+	AssetHandle<BudgetAsset> handles[2] =
+	{
+		assetManager.LoadAssetAsync<BudgetAsset>(sharedFile0),
+		assetManager.LoadAssetAsync<BudgetAsset>(sharedFile1)
+	};
+
+	// Dropped while loading, so only the waiting callers below keep the assets
+	handles[0].Release();
+	handles[1].Release();
+
+	std::atomic<uSize> lostCount(0);
+	Array<std::thread*> threads;
+
+	for (uSize i = 0; i < 8; i++)
+	{
+		threads.PushBack(new std::thread([&, i]()
+		{
+			BudgetAsset* pAsset = assetManager.GetOrLoadAsset<BudgetAsset>(*pSharedFiles[i % 2]);
+
+			if (!pAsset || !pAsset->IsLoaded())
+			{
+				lostCount++;
+			}
+		}));
+	}
+
+	for (std::thread* pThread : threads)
+	{
+		pThread->join();
+		delete pThread;
+	}
+
+	assetManager.StopLoaders();
+
+	if (lostCount != 0)
+	{
+		printf("Budget check failed: %zu waiting loads returned an evicted asset.\n", (size_t)lostCount.load());
+		return false;
+	}
+
+	// Everything is pinned, nothing can be trimmed
+	if (assetManager.GetResidentBytes() != 3 * 4096)
+	{
+		printf("Budget check failed: pinned assets were evicted.\n");
+		return false;
+	}
+
+	assetManager.UnloadAsset(pSyncAsset);
+	assetManager.UnloadAsset(assetManager.GetOrLoadAsset<BudgetAsset>(sharedFile0));
+	assetManager.UnloadAsset(assetManager.GetOrLoadAsset<BudgetAsset>(sharedFile1));
+
+	return true;
+}
+
+int main(int argc, char** argv)
+{
+	const uSize modelCount	= argc > 1 ? (uSize)atoll(argv[1]) : 8;
+	const uSize vertexCount	= argc > 2 ? (uSize)atoll(argv[2]) : 262144;
+	const uSize repeats		= argc > 3 ? (uSize)atoll(argv[3]) : 3;
+
+	Log benchmarkLog = Log({});
+	Log::SetInstance(benchmarkLog);
+
+	BenchmarkFilesystemHandler	handler;
+	PoolAllocator<Model>		modelPool(1024 * sizeof(Model));
+	PoolAllocator<ByteBuffer>	bufferPool(2048 * sizeof(ByteBuffer));
+
+	if (!CheckAssetBudget(handler))
+	{
+		return 1;
+	}
+
+	const QCompression compressions[] = { QCOMPRESSION_NONE, QCOMPRESSION_LZ };
+	const char* pFormatNames[] = { "raw", "lz" };
+
+	Array<String> paths[2];
+	uInt64 fileBytes[2] = {};
+
+	/* Write every model in both formats */
+
+	for (uSize i = 0; i < modelCount; i++)
+	{
+		Model model;
+		BuildTerrain(model, vertexCount, (uInt32)i);
+
+		for (uSize format = 0; format < 2; format++)
+		{
+			char path[64];
+			snprintf(path, sizeof(path), "AssetBenchmark_%zu_%s.qmodel", (size_t)i, pFormatNames[format]);
+
+			File file(path, handler, nullptr, FILE_VALID, 0, 0);
+			QModelParser writer(file);
+			writer.SetModel(model);
+			writer.SetCompression(compressions[format]);
+
+			if (!writer.Write())
+			{
+				printf("Failed to write [%s].\n", path);
+				FreeTerrain(model);
+				return 1;
+			}
+
+			paths[format].PushBack(path);
+			fileBytes[format] += GetFileSize(path);
+		}
+
+		FreeTerrain(model);
+	}
+
+	printf("QModel load, %zu models x %zu vertices x %zu repeats\n", (size_t)modelCount, (size_t)vertexCount, (size_t)repeats);
+
+	for (uSize format = 0; format < 2; format++)
+	{
+		LoadResult coldTotal = {};
+		LoadResult warmTotal = {};
+		LoadResult result;
+		bool evicted = true;
+
+		for (uSize r = 0; r < repeats; r++)
+		{
+			for (const String& path : paths[format])
+			{
+				evicted &= EvictFromCache(path.Str());
+			}
+
+			if (!LoadModels(handler, paths[format], modelPool, bufferPool, result))
+			{
+				return 1;
+			}
+
+			coldTotal.seconds	+= result.seconds;
+			coldTotal.rawBytes	+= result.rawBytes;
+			coldTotal.checksum	+= result.checksum;
+
+			// The cold pass left the files cached
+			if (!LoadModels(handler, paths[format], modelPool, bufferPool, result))
+			{
+				return 1;
+			}
+
+			warmTotal.seconds	+= result.seconds;
+			warmTotal.rawBytes	+= result.rawBytes;
+			warmTotal.checksum	+= result.checksum;
+		}
+
+		printf("  %-4s files=%8.2f MB  cold=%8.2f ms %8.1f MB/s%s  warm=%8.2f ms %8.1f MB/s  checksum=%llu\n",
+			pFormatNames[format], fileBytes[format] / 1e6,
+			coldTotal.seconds * 1000.0 / repeats, coldTotal.rawBytes / 1e6 / coldTotal.seconds, evicted ? "" : " (cache not dropped)",
+			warmTotal.seconds * 1000.0 / repeats, warmTotal.rawBytes / 1e6 / warmTotal.seconds,
+			(unsigned long long)(warmTotal.checksum / repeats));
+	}
+
+	for (uSize format = 0; format < 2; format++)
+	{
+		for (const String& path : paths[format])
+		{
+			remove(path.Str());
+		}
+	}
+
+	return 0;
+}
@@ -0,0 +1,229 @@
+#include "GJK.h"
+#include "GJKBatch.h"
+#include "CollisionDetection.h"
+#include "Types/Array.h"
+
+#include <chrono>
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+
+/*
+	Convex-vs-convex narrowphase throughput, of the GJK overlap test alone and of
+	the whole contact path: one Collide call per pair against CollideBatch.
+	Usage: GJKBenchmark [pairs] [repeats]
+*/
+
+using namespace Quartz;
+
+struct BenchmarkPair
+{
+	Vec3p points0[8];
+	Vec3p points1[8];
+};
+
+/* The same boxes as colliders, for the contact path */
+struct BenchmarkBoxes
+{
+	Array<RectCollider>		colliders;
+	Array<Transform>		transforms;
+};
+
+static void RandomBox(std::mt19937& random, const Vec3p& center, Vec3p(&outPoints)[8], BenchmarkBoxes& boxes)
+{
+	std::uniform_real_distribution<floatp> extentDist(0.25, 1.5);
+	std::uniform_real_distribution<floatp> angleDist(0.0, 6.2831853);
+
+	const Vec3p extent(extentDist(random), extentDist(random), extentDist(random));
+
+	const floatp yaw	= angleDist(random);
+	const floatp pitch	= angleDist(random);
+	const floatp cy = cos(yaw),		sy = sin(yaw);
+	const floatp cp = cos(pitch),	sp = sin(pitch);
+
+	for (uSize i = 0; i < 8; i++)
+	{
+		const Vec3p corner(
+			(i & 1) ? extent.x : -extent.x,
+			(i & 2) ? extent.y : -extent.y,
+			(i & 4) ? extent.z : -extent.z);
+
+		// Yaw around Y, then pitch around X
+		const Vec3p yawed(cy * corner.x + sy * corner.z, corner.y, -sy * corner.x + cy * corner.z);
+		const Vec3p pitched(yawed.x, cp * yawed.y - sp * yawed.z, sp * yawed.y + cp * yawed.z);
+
+		outPoints[i] = center + pitched;
+	}
+
+	const Quatf yawRotation		= Quatf().SetAxisAngle(Vec3f(0.0f, 1.0f, 0.0f), (float)yaw);
+	const Quatf pitchRotation	= Quatf().SetAxisAngle(Vec3f(1.0f, 0.0f, 0.0f), (float)pitch);
+
+	Transform transform;
+	transform.position	= Vec3f((float)center.x, (float)center.y, (float)center.z);
+	transform.rotation	= pitchRotation * yawRotation;
+	transform.scale		= Vec3f(1.0f, 1.0f, 1.0f);
+
+	const Vec3f halfExtent((float)extent.x, (float)extent.y, (float)extent.z);
+
+	boxes.colliders.PushBack(RectCollider(Bounds3f{ -halfExtent, halfExtent }));
+	boxes.transforms.PushBack(transform);
+}
+
+int main(int argc, char** argv)
+{
+	const uSize pairCount	= argc > 1 ? (uSize)atoll(argv[1]) : 100000;
+	const uSize repeats		= argc > 2 ? (uSize)atoll(argv[2]) : 10;
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<floatp> offsetDist(-2.5, 2.5);
+
+	Array<BenchmarkPair>	pairs;
+	Array<GJK::BatchPair>	batchPairs;
+	Array<Simplex>			simplices;
+	Array<bool>				results;
+	BenchmarkBoxes			boxes;
+	Array<CollisionPair>	collisionPairs;
+	Array<Collision>		collisions;
+
+	pairs.Resize(pairCount);
+	batchPairs.Resize(pairCount);
+	simplices.Resize(pairCount);
+	results.Resize(pairCount);
+	collisionPairs.Resize(pairCount);
+	collisions.Resize(pairCount);
+
+	for (uSize i = 0; i < pairCount; i++)
+	{
+		// Roughly half of the pairs overlap
+		const Vec3p offset(offsetDist(random), offsetDist(random), offsetDist(random));
+
+		RandomBox(random, Vec3p::ZERO, pairs[i].points0, boxes);
+		RandomBox(random, offset, pairs[i].points1, boxes);
+
+		batchPairs[i] = { pairs[i].points0, 8, pairs[i].points1, 8 };
+	}
+
+	// Filled once every box is in place, the arrays no longer move
+	for (uSize i = 0; i < pairCount; i++)
+	{
+		collisionPairs[i] = { &boxes.colliders[i * 2], &boxes.transforms[i * 2], &boxes.colliders[i * 2 + 1], &boxes.transforms[i * 2 + 1] };
+	}
+
+	const ShapeRect rect = {};
+
+	/* Scalar */
+
+	uSize scalarHits = 0;
+	auto scalarStart = std::chrono::high_resolution_clock::now();
+
+	for (uSize r = 0; r < repeats; r++)
+	{
+		scalarHits = 0;
+
+		for (uSize i = 0; i < pairCount; i++)
+		{
+			Simplex simplex;
+			scalarHits += GJK::GJKRectRect(rect, pairs[i].points0, rect, pairs[i].points1, simplex);
+		}
+	}
+
+	auto scalarEnd = std::chrono::high_resolution_clock::now();
+
+	/* Batched */
+
+	uSize batchHits = 0;
+	auto batchStart = std::chrono::high_resolution_clock::now();
+
+	for (uSize r = 0; r < repeats; r++)
+	{
+		batchHits = 0;
+
+		GJK::GJKBatch(batchPairs.Data(), pairCount, simplices.Data(), results.Data());
+
+		for (uSize i = 0; i < pairCount; i++)
+		{
+			batchHits += results[i];
+		}
+	}
+
+	auto batchEnd = std::chrono::high_resolution_clock::now();
+
+	/* Contacts, one pair at a time */
+
+	uSize scalarContactHits = 0;
+	uSize scalarContacts = 0;
+	auto scalarContactStart = std::chrono::high_resolution_clock::now();
+
+	for (uSize r = 0; r < repeats; r++)
+	{
+		scalarContactHits = 0;
+		scalarContacts = 0;
+
+		for (uSize i = 0; i < pairCount; i++)
+		{
+			const CollisionPair& pair = collisionPairs[i];
+
+			if (CollisionDetection::Collide(*pair.pCollider0, *pair.pTransform0, *pair.pCollider1, *pair.pTransform1, collisions[i]))
+			{
+				scalarContactHits++;
+				scalarContacts += collisions[i].count;
+			}
+		}
+	}
+
+	auto scalarContactEnd = std::chrono::high_resolution_clock::now();
+
+	/* Contacts, batched */
+
+	uSize batchContactHits = 0;
+	uSize batchContacts = 0;
+	auto batchContactStart = std::chrono::high_resolution_clock::now();
+
+	for (uSize r = 0; r < repeats; r++)
+	{
+		batchContactHits = 0;
+		batchContacts = 0;
+
+		CollisionDetection::CollideBatch(collisionPairs.Data(), pairCount, collisions.Data(), results.Data());
+
+		for (uSize i = 0; i < pairCount; i++)
+		{
+			if (results[i])
+			{
+				batchContactHits++;
+				batchContacts += collisions[i].count;
+			}
+		}
+	}
+
+	auto batchContactEnd = std::chrono::high_resolution_clock::now();
+
+	const double scalarSeconds	= std::chrono::duration<double>(scalarEnd - scalarStart).count();
+	const double batchSeconds	= std::chrono::duration<double>(batchEnd - batchStart).count();
+	const double scalarContactSeconds	= std::chrono::duration<double>(scalarContactEnd - scalarContactStart).count();
+	const double batchContactSeconds	= std::chrono::duration<double>(batchContactEnd - batchContactStart).count();
+	const double totalPairs		= (double)pairCount * (double)repeats;
+
+#if PHYSICS_SIMD_AVX
+	const char* pSimdName = "AVX";
+#elif PHYSICS_SIMD_SSE
+	const char* pSimdName = "SSE2";
+#else
+	const char* pSimdName = "Scalar";
+#endif
+
+	printf("GJK box-box, %zu pairs x %zu repeats\n", (size_t)pairCount, (size_t)repeats);
+	printf("  scalar:          %12.0f pairs/s  (%zu hits)\n", totalPairs / scalarSeconds, (size_t)scalarHits);
+	printf("  batched (%s x%d): %12.0f pairs/s  (%zu hits)\n", pSimdName, PHYSICS_SIMD_WIDTH,
+		totalPairs / batchSeconds, (size_t)batchHits);
+	printf("  speedup:         %12.2fx\n", scalarSeconds / batchSeconds);
+
+	printf("Contacts box-box, %zu pairs x %zu repeats\n", (size_t)pairCount, (size_t)repeats);
+	printf("  Collide:         %12.0f pairs/s  (%zu hits, %zu contacts)\n", totalPairs / scalarContactSeconds,
+		(size_t)scalarContactHits, (size_t)scalarContacts);
+	printf("  CollideBatch:    %12.0f pairs/s  (%zu hits, %zu contacts)\n", totalPairs / batchContactSeconds,
+		(size_t)batchContactHits, (size_t)batchContacts);
+	printf("  speedup:         %12.2fx\n", scalarContactSeconds / batchContactSeconds);
+
+	return 0;
+}
@@ -0,0 +1,448 @@
+#include "Log.h"
+#include "ObjHelper.h"
+#include "Memory/PoolAllocator.h"
+#include "Resource/Processing/MeshOptimizer.h"
+#include "Resource/Processing/MeshSimplifier.h"
+#include "Resource/Processing/MeshletBuilder.h"
+#include "Resource/Processing/VertexQuantizer.h"
+
+#include <chrono>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <thread>
+
+/*
+	OBJ parse throughput, one thread against every hardware thread, then
+	conversion to a Model against the Map based vertex deduplication it
+	replaced, then the vertex cache before and after mesh optimization.
+	Parses the sandbox sample models that are present, or the files given
+	on the command line, and checks the results match. Falls back to a
+	generated mesh when no files are found.
+	Usage: ObjBenchmark [repeats] [file.obj ...]
+*/
+
+using namespace Quartz;
+
+static const char* sSampleModels[] =
+{
+	"Assets/Models/sibenik.obj",
+	"Assets/Models/dva.obj",
+	"Assets/Models/bistro.obj",
+	"Assets/Models/bmw.obj",
+	"Assets/Models/bunny.obj",
+	"Assets/Models/bunny_no_normal.obj",
+	"Assets/Models/cube.obj",
+	"Assets/Models/cube_mat.obj",
+	"Assets/Models/dragon.obj",
+	"Assets/Models/rei.obj",
+	"Assets/Models/sponza.obj",
+	"Assets/Models/testScene.obj",
+	"Assets/Models/gun.obj"
+};
+
+static bool ReadText(const char* path, String& outText)
+{
+	FILE* pFile = fopen(path, "rb");
+
+	if (!pFile)
+	{
+		return false;
+	}
+
+	fseek(pFile, 0, SEEK_END);
+	const long sizeBytes = ftell(pFile);
+	fseek(pFile, 0, SEEK_SET);
+
+	outText = String((uSize)sizeBytes);
+	const bool result = fread((void*)outText.Data(), 1, sizeBytes, pFile) == (size_t)sizeBytes;
+
+	fclose(pFile);
+
+	return result;
+}
+
+/* A grid of quads in a few materials, written the way exporters usually do */
+static void BuildGridObj(uSize gridSize, String& outText)
+{
+	Array<char> text;
+	char line[128];
+
+	auto Append = [&](int length)
+	{
+		const uSize offset = text.Size();
+		text.Resize(offset + length);
+		memcpy(text.Data() + offset, line, length);
+	};
+
+	for (uSize y = 0; y <= gridSize; y++)
+	{
+		for (uSize x = 0; x <= gridSize; x++)
+		{
+			const float height = 0.5f * sinf(x * 0.13f) * cosf(y * 0.07f);
+
+			Append(snprintf(line, sizeof(line), "v %.6f %.6f %.6f\n", x * 0.25f, height, y * 0.25f));
+			Append(snprintf(line, sizeof(line), "vt %.6f %.6f\n", (float)x / gridSize, (float)y / gridSize));
+			Append(snprintf(line, sizeof(line), "vn %.6f %.6f %.6f\n", 0.0f, 1.0f, 0.0f));
+		}
+	}
+
+	for (uSize y = 0; y < gridSize; y++)
+	{
+		if (y % (gridSize / 4 + 1) == 0)
+		{
+			Append(snprintf(line, sizeof(line), "usemtl grid_%zu\n", (size_t)(y / (gridSize / 4 + 1))));
+		}
+
+		for (uSize x = 0; x < gridSize; x++)
+		{
+			const uSize i0 = y * (gridSize + 1) + x + 1;
+			const uSize i1 = i0 + 1;
+			const uSize i2 = i1 + gridSize + 1;
+			const uSize i3 = i0 + gridSize + 1;
+
+			Append(snprintf(line, sizeof(line), "f %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu %zu/%zu/%zu\n",
+				(size_t)i0, (size_t)i0, (size_t)i0, (size_t)i1, (size_t)i1, (size_t)i1,
+				(size_t)i2, (size_t)i2, (size_t)i2, (size_t)i3, (size_t)i3, (size_t)i3));
+		}
+	}
+
+	outText = String(text.Size());
+	memcpy((void*)outText.Data(), text.Data(), text.Size());
+}
+
+static bool SameModel(const ObjModel& model0, const ObjModel& model1)
+{
+	if (model0.positions.Size() != model1.positions.Size() ||
+		model0.normals.Size() != model1.normals.Size() ||
+		model0.texCoords.Size() != model1.texCoords.Size() ||
+		model0.objects.Size() != model1.objects.Size() ||
+		model0.maxIndex != model1.maxIndex)
+	{
+		return false;
+	}
+
+	if (memcmp(model0.positions.Data(), model1.positions.Data(), model0.positions.Size() * sizeof(Vec3f)) != 0 ||
+		memcmp(model0.normals.Data(), model1.normals.Data(), model0.normals.Size() * sizeof(Vec3f)) != 0 ||
+		memcmp(model0.texCoords.Data(), model1.texCoords.Data(), model0.texCoords.Size() * sizeof(Vec2f)) != 0)
+	{
+		return false;
+	}
+
+	for (uSize i = 0; i < model0.objects.Size(); i++)
+	{
+		const ObjObject& object0 = model0.objects[i];
+		const ObjObject& object1 = model1.objects[i];
+
+		if (object0.materialIdx != object1.materialIdx ||
+			object0.indices.Size() != object1.indices.Size() ||
+			memcmp(object0.indices.Data(), object1.indices.Data(), object0.indices.Size() * sizeof(OBJIndex)) != 0)
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+/* Best of repeats, in seconds */
+static double TimeParse(const String& text, uSize threadCount, uSize repeats, ObjModel& outModel)
+{
+	double bestSeconds = 1e30;
+
+	for (uSize r = 0; r < repeats; r++)
+	{
+		outModel = ObjModel();
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		ParseOBJ(text, outModel, threadCount);
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		bestSeconds = seconds < bestSeconds ? seconds : bestSeconds;
+	}
+
+	return bestSeconds;
+}
+
+/* The index buffer ConvertOBJToModel wrote before open addressing, deduplicated through Map */
+static void BuildMapIndices(const ObjModel& objModel, Array<uInt32>& outIndices)
+{
+	Map<OBJIndex, uInt32> indexMap;
+	uInt32 index = 0;
+
+	for (const ObjObject& object : objModel.objects)
+	{
+		for (const OBJIndex& objIndex : object.indices)
+		{
+			auto& idxIt = indexMap.Find(objIndex);
+			if (idxIt != indexMap.End())
+			{
+				outIndices.PushBack(idxIt->value);
+			}
+			else
+			{
+				outIndices.PushBack(index);
+				indexMap.Put(objIndex, index);
+				index++;
+			}
+		}
+	}
+}
+
+static bool SameIndices(const Model& model, const Array<uInt32>& indices)
+{
+	const IndexStream& indexStream = model.indexStream;
+
+	if (indexStream.indexCount != indices.Size())
+	{
+		return false;
+	}
+
+	const uInt8* pData = indexStream.GetData();
+
+	for (uSize i = 0; i < indices.Size(); i++)
+	{
+		uInt32 index;
+
+		if (indexStream.indexElement.format == INDEX_FORMAT_UINT16)
+		{
+			index = ((const uInt16*)pData)[i];
+		}
+		else
+		{
+			index = ((const uInt32*)pData)[i];
+		}
+
+		if (index != indices[i])
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
+
+static void FreeModelBuffers(Model& model, PoolAllocator<ByteBuffer>& bufferPool)
+{
+	for (VertexStream& stream : model.vertexStreams)
+	{
+		if (stream.pVertexBuffer)
+		{
+			bufferPool.Free(stream.pVertexBuffer);
+			stream.pVertexBuffer = nullptr;
+		}
+	}
+
+	if (model.indexStream.pIndexBuffer)
+	{
+		bufferPool.Free(model.indexStream.pIndexBuffer);
+		model.indexStream.pIndexBuffer = nullptr;
+	}
+}
+
+/* Same settings ModelHandler loads OBJ files with. Best of repeats, in seconds */
+static double TimeConvert(const ObjModel& objModel, uSize repeats, PoolAllocator<ByteBuffer>& bufferPool, Model& outModel)
+{
+	ObjConvertSettings settings = {};
+	settings.writePositions		= true;
+	settings.writeNormals		= true;
+	settings.writeTexCoords		= true;
+	settings.positionFormat		= VERTEX_FORMAT_FLOAT3;
+	settings.normalFormat		= VERTEX_FORMAT_FLOAT3;
+	settings.tangentFormat		= VERTEX_FORMAT_FLOAT3;
+	settings.biTangentFormat	= VERTEX_FORMAT_FLOAT3;
+	settings.texCoordFormat		= VERTEX_FORMAT_FLOAT2;
+	settings.useTangentBiTanW	= true;
+
+	double bestSeconds = 1e30;
+
+	for (uSize r = 0; r < repeats; r++)
+	{
+		FreeModelBuffers(outModel, bufferPool);
+		outModel = Model();
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		ConvertOBJToModel(settings, objModel, outModel, bufferPool);
+
+		auto end = std::chrono::high_resolution_clock::now();
+
+		const double seconds = std::chrono::duration<double>(end - start).count();
+		bestSeconds = seconds < bestSeconds ? seconds : bestSeconds;
+	}
+
+	return bestSeconds;
+}
+
+int main(int argc, char** argv)
+{
+	const uSize repeats = argc > 1 ? (uSize)atoll(argv[1]) : 5;
+	const uSize threadCount = std::thread::hardware_concurrency();
+
+	Log benchmarkLog = Log({});
+	Log::SetInstance(benchmarkLog);
+
+	PoolAllocator<ByteBuffer> bufferPool(64 * sizeof(ByteBuffer));
+
+	Array<const char*> paths;
+
+	for (int i = 2; i < argc; i++)
+	{
+		paths.PushBack(argv[i]);
+	}
+
+	if (paths.Size() == 0)
+	{
+		for (const char* pPath : sSampleModels)
+		{
+			paths.PushBack(pPath);
+		}
+	}
+
+	printf("OBJ parse (1 thread vs %zu threads), convert (Map vs open addressing dedupe), simplify, optimize, meshlets and quantize, best of %zu\n",
+		(size_t)threadCount, (size_t)repeats);
+
+	uSize parsedCount = 0;
+	bool matched = true;
+
+	auto Run = [&](const char* pName, const String& text)
+	{
+		ObjModel serialModel;
+		ObjModel parallelModel;
+
+		const double serialSeconds		= TimeParse(text, 1, repeats, serialModel);
+		const double parallelSeconds	= TimeParse(text, threadCount, repeats, parallelModel);
+		const bool same					= SameModel(serialModel, parallelModel);
+
+		printf("  %-28s %8.2f MB  1t=%8.2f ms %7.1f MB/s  %zut=%8.2f ms %7.1f MB/s  x%.2f%s\n",
+			pName, text.Length() / 1e6,
+			serialSeconds * 1000.0, text.Length() / 1e6 / serialSeconds,
+			(size_t)threadCount, parallelSeconds * 1000.0, text.Length() / 1e6 / parallelSeconds,
+			serialSeconds / parallelSeconds, same ? "" : "  MISMATCH");
+
+		Array<uInt32> mapIndices;
+		Model model;
+
+		auto mapStart = std::chrono::high_resolution_clock::now();
+
+		BuildMapIndices(parallelModel, mapIndices);
+
+		auto mapEnd = std::chrono::high_resolution_clock::now();
+
+		const double mapSeconds		= std::chrono::duration<double>(mapEnd - mapStart).count();
+		const double convertSeconds	= TimeConvert(parallelModel, repeats, bufferPool, model);
+		const bool sameIndices		= SameIndices(model, mapIndices);
+
+		printf("  %-28s %8zu corners  map dedupe=%8.2f ms  convert=%8.2f ms %7.2f Mcorners/s  vertices=%u%s\n",
+			"", (size_t)mapIndices.Size(), mapSeconds * 1000.0, convertSeconds * 1000.0,
+			mapIndices.Size() / 1e6 / convertSeconds, model.indexStream.maxIndex, sameIndices ? "" : "  MISMATCH");
+
+		LodChainSettings lodSettings = {};
+		lodSettings.lodCount		= 4;
+		lodSettings.reduction		= 0.5f;
+		lodSettings.maxError		= 0.01f;
+		lodSettings.minTriangles	= 64;
+
+		LodChainStats lodStats = {};
+
+		auto simplifyStart = std::chrono::high_resolution_clock::now();
+
+		const bool simplified = GenerateModelLods(model, lodSettings, bufferPool, &lodStats);
+
+		auto simplifyEnd = std::chrono::high_resolution_clock::now();
+
+		const double simplifySeconds = std::chrono::duration<double>(simplifyEnd - simplifyStart).count();
+
+		printf("  %-28s simplify=%8.2f ms  triangles", "", simplifySeconds * 1000.0);
+
+		for (uSize level = 0; level < lodStats.levelCount; level++)
+		{
+			printf(" %zu (%g)", (size_t)lodStats.triangleCounts[level], lodStats.maxErrors[level]);
+		}
+
+		printf("%s\n", simplified ? "" : "  FAILED");
+
+		MeshOptimizeStats optimizeStats = {};
+
+		auto optimizeStart = std::chrono::high_resolution_clock::now();
+
+		const bool optimized = OptimizeModel(model, &optimizeStats);
+
+		auto optimizeEnd = std::chrono::high_resolution_clock::now();
+
+		const double optimizeSeconds = std::chrono::duration<double>(optimizeEnd - optimizeStart).count();
+
+		printf("  %-28s optimize=%8.2f ms  ACMR %.3f -> %.3f  ATVR %.3f -> %.3f%s\n",
+			"", optimizeSeconds * 1000.0, optimizeStats.before.acmr, optimizeStats.after.acmr,
+			optimizeStats.before.atvr, optimizeStats.after.atvr, optimized ? "" : "  FAILED");
+
+		MeshletStats meshletStats = {};
+
+		auto meshletStart = std::chrono::high_resolution_clock::now();
+
+		const bool partitioned = BuildModelMeshlets(model, &meshletStats);
+
+		auto meshletEnd = std::chrono::high_resolution_clock::now();
+
+		const double meshletSeconds = std::chrono::duration<double>(meshletEnd - meshletStart).count();
+
+		printf("  %-28s meshlets=%8.2f ms  %zu meshlets  %.1f vertices  %.1f triangles  reuse %.2f  cones %.0f%% %.1f deg%s\n",
+			"", meshletSeconds * 1000.0, (size_t)meshletStats.meshletCount, meshletStats.averageVertices,
+			meshletStats.averageTriangles, meshletStats.vertexReuse, meshletStats.coneFraction * 100.0,
+			meshletStats.averageConeAngle, partitioned ? "" : "  FAILED");
+
+		VertexQuantizeStats quantizeStats = {};
+
+		auto quantizeStart = std::chrono::high_resolution_clock::now();
+
+		const bool quantized = QuantizeModel(model, VERTEX_QUANTIZE_ALL, bufferPool, &quantizeStats);
+
+		auto quantizeEnd = std::chrono::high_resolution_clock::now();
+
+		const double quantizeSeconds = std::chrono::duration<double>(quantizeEnd - quantizeStart).count();
+
+		VertexQuantizeError maxError = {};
+
+		for (const VertexQuantizeError& meshError : quantizeStats.meshErrors)
+		{
+			maxError.maxPositionError	= meshError.maxPositionError > maxError.maxPositionError ? meshError.maxPositionError : maxError.maxPositionError;
+			maxError.maxDirectionError	= meshError.maxDirectionError > maxError.maxDirectionError ? meshError.maxDirectionError : maxError.maxDirectionError;
+			maxError.maxTexCoordError	= meshError.maxTexCoordError > maxError.maxTexCoordError ? meshError.maxTexCoordError : maxError.maxTexCoordError;
+		}
+
+		printf("  %-28s quantize=%8.2f ms  vertices %.2f MB -> %.2f MB  max error: position %g  normal %.4f deg  uv %g%s\n",
+			"", quantizeSeconds * 1000.0, quantizeStats.sizeBytesBefore / 1e6, quantizeStats.sizeBytesAfter / 1e6,
+			maxError.maxPositionError, maxError.maxDirectionError, maxError.maxTexCoordError, quantized ? "" : "  FAILED");
+
+		FreeModelBuffers(model, bufferPool);
+
+		matched &= same && sameIndices && simplified && optimized && partitioned && quantized;
+		parsedCount++;
+	};
+
+	for (const char* pPath : paths)
+	{
+		String text;
+
+		if (!ReadText(pPath, text))
+		{
+			continue;
+		}
+
+		Run(pPath, text);
+	}
+
+	if (parsedCount == 0)
+	{
+		String text;
+		BuildGridObj(1024, text);
+
+		Run("(generated 1024x1024 grid)", text);
+	}
+
+	return matched ? 0 : 1;
+}
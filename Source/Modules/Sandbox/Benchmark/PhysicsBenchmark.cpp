@@ -0,0 +1,722 @@
+#include "Engine.h"
+#include "Physics.h"
+#include "Hull.h"
+#include "CollisionMesh.h"
+#include "Compound.h"
+#include "Types/Array.h"
+
+#include <random>
+#include <thread>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+	Headless physics benchmark, no graphics or modules are loaded.
+	Usage: PhysicsBenchmark [scenario|all] [frames] [narrowphase threads]
+	Scenarios: stack, rain, pyramid, bullets, swarm, mixed, compound, joints, terrain
+*/
+
+using namespace Quartz;
+
+class EngineImpl : public Engine
+{
+public:
+	Engine::mpWorld;
+	Engine::mpRuntime;
+	Engine::mpLog;
+};
+
+constexpr double BENCHMARK_FRAME_TIME = 1.0 / 60.0;
+constexpr uSize BENCHMARK_QUERY_COUNT = 4096;
+
+struct BenchmarkScene
+{
+	EntityWorld&	world;
+	Array<Entity>	bodies;
+	HullData		hullData;
+	CollisionMesh	groundMesh;
+	CompoundData	tableCompound;
+	CompoundData	dumbbellCompound;
+};
+
+static void AddBody(BenchmarkScene& scene, const Vec3f& position, const Quatf& rotation,
+	const RigidBody& rigidBody, const Collider& collider)
+{
+	// Transform first, the physics trigger reads it when the rigid body is added
+	TransformComponent transform(position, rotation, { 1.0f, 1.0f, 1.0f });
+	RigidBodyComponent physics(rigidBody, collider);
+
+	scene.bodies.PushBack(scene.world.CreateEntity(transform, physics));
+}
+
+static void AddGroundPlane(BenchmarkScene& scene)
+{
+	RigidBody groundBody(0.0f, 0.5f, 0.8f, { 0.0f, 0.0f, 0.0f });
+	PlaneCollider groundCollider({ 0.0f, 1.0f, 0.0f }, 0.0f, true);
+
+	AddBody(scene, { 0.0f, 0.0f, 0.0f }, Quatf(), groundBody, groundCollider);
+}
+
+/* Scenarios */
+
+static void BuildStacks(BenchmarkScene& scene)
+{
+	AddGroundPlane(scene);
+
+	RectCollider boxCollider(Bounds3f{ {-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f} }, false);
+
+	for (uSize x = 0; x < 4; x++)
+	{
+		for (uSize z = 0; z < 4; z++)
+		{
+			for (uSize y = 0; y < 8; y++)
+			{
+				const Vec3f position(x * 3.0f, 0.5f + y * 1.01f, z * 3.0f);
+				AddBody(scene, position, Quatf(), RigidBody(1.0f, 0.1f, 0.6f), boxCollider);
+			}
+		}
+	}
+}
+
+static void BuildRain(BenchmarkScene& scene)
+{
+	AddGroundPlane(scene);
+
+	std::mt19937 random(1234);
+	std::uniform_real_distribution<float> jitter(-0.2f, 0.2f);
+
+	SphereCollider sphereCollider(0.5f, false);
+
+	for (uSize x = 0; x < 10; x++)
+	{
+		for (uSize z = 0; z < 10; z++)
+		{
+			for (uSize y = 0; y < 3; y++)
+			{
+				const Vec3f position(x * 1.2f + jitter(random), 2.0f + y * 3.0f, z * 1.2f + jitter(random));
+				AddBody(scene, position, Quatf(), RigidBody(1.0f, 0.4f, 0.5f), sphereCollider);
+			}
+		}
+	}
+}
+
+static void BuildPyramid(BenchmarkScene& scene)
+{
+	AddGroundPlane(scene);
+
+	RectCollider boxCollider(Bounds3f{ {-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f} }, false);
+
+	constexpr uSize baseCount = 12;
+
+	for (uSize row = 0; row < baseCount; row++)
+	{
+		for (uSize i = 0; i < baseCount - row; i++)
+		{
+			const Vec3f position(i * 1.05f + row * 0.525f, 0.5f + row * 1.01f, 0.0f);
+			AddBody(scene, position, Quatf(), RigidBody(1.0f, 0.1f, 0.6f), boxCollider);
+		}
+	}
+}
+
+static void BuildProjectiles(BenchmarkScene& scene)
+{
+	AddGroundPlane(scene);
+
+	// Thinner than a projectile travels in one substep
+	RectCollider wallCollider(Bounds3f{ {-6.0f, 0.0f, -0.05f}, {6.0f, 6.0f, 0.05f} }, true);
+	AddBody(scene, { 0.0f, 0.0f, 20.0f }, Quatf(), RigidBody(0.0f, 0.5f, 0.8f, { 0.0f, 0.0f, 0.0f }), wallCollider);
+
+	SphereCollider projectileCollider(0.25f, false);
+
+	for (uSize x = 0; x < 8; x++)
+	{
+		for (uSize y = 0; y < 5; y++)
+		{
+			RigidBody projectileBody(1.0f, 0.3f, 0.5f);
+			projectileBody.linearVelocity = Vec3p(0.0f, 0.0f, 150.0f + y * 20.0f);
+			projectileBody.SetContinuous(true);
+
+			AddBody(scene, Vec3f(x * 1.2f - 4.2f, 1.0f + y * 1.0f, 0.0f), Quatf(), projectileBody, projectileCollider);
+		}
+	}
+}
+
+static void BuildSwarm(BenchmarkScene& scene)
+{
+	std::mt19937 random(4321);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	SphereCollider sphereCollider(0.5f, false);
+
+	// 50k drifting bodies in a long sheet, spread out enough to rarely touch, mostly measures integration
+	constexpr uSize rowCount = 1013;
+	constexpr uSize columnCount = 50;
+
+	for (uSize x = 0; x < rowCount; x++)
+	{
+		for (uSize z = 0; z < columnCount; z++)
+		{
+			RigidBody body(1.0f, 0.5f, 0.5f, { 0.0f, 0.0f, 0.0f });
+			body.linearVelocity = Vec3p(unit(random), unit(random), unit(random)) * 0.2f;
+			body.angularVelocity = Vec3p(unit(random), unit(random), unit(random)) * 2.0f;
+
+			AddBody(scene, Vec3f(x * 4.0f, 0.0f, z * 4.0f), Quatf(), body, sphereCollider);
+		}
+	}
+}
+
+static void BuildMixed(BenchmarkScene& scene)
+{
+	std::mt19937 random(5678);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	/* Static triangle mesh ground */
+
+	constexpr uSize gridSize = 32;
+	Array<Vec3f> vertices;
+	Array<uInt32> indices;
+
+	for (uSize z = 0; z <= gridSize; z++)
+	{
+		for (uSize x = 0; x <= gridSize; x++)
+		{
+			vertices.PushBack(Vec3f(x - gridSize * 0.5f, 0.0f, z - gridSize * 0.5f));
+		}
+	}
+
+	for (uSize z = 0; z < gridSize; z++)
+	{
+		for (uSize x = 0; x < gridSize; x++)
+		{
+			const uInt32 i00 = (uInt32)(z * (gridSize + 1) + x);
+			const uInt32 i10 = i00 + 1;
+			const uInt32 i01 = i00 + (uInt32)(gridSize + 1);
+			const uInt32 i11 = i01 + 1;
+
+			indices.PushBack(i00); indices.PushBack(i01); indices.PushBack(i10);
+			indices.PushBack(i10); indices.PushBack(i01); indices.PushBack(i11);
+		}
+	}
+
+	scene.groundMesh.Build(vertices.Data(), vertices.Size(), indices.Data(), indices.Size());
+	AddBody(scene, { 0.0f, 0.0f, 0.0f }, Quatf(), RigidBody(0.0f, 0.5f, 0.8f, { 0.0f, 0.0f, 0.0f }),
+		MeshCollider(scene.groundMesh));
+
+	/* Cooked hull from a random point cloud */
+
+	Array<Vec3p> hullPoints;
+
+	for (uSize i = 0; i < 24; i++)
+	{
+		hullPoints.PushBack(Vec3p(unit(random), unit(random), unit(random)).Normalized() * 0.5f);
+	}
+
+	scene.hullData.Cook(hullPoints.Data(), hullPoints.Size());
+
+	SphereCollider sphereCollider(0.5f, false);
+	RectCollider boxCollider(Bounds3f{ {-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f} }, false);
+	CapsuleCollider capsuleCollider(0.3f, 0.4f, false);
+	HullCollider hullCollider(scene.hullData, false);
+
+	for (uSize i = 0; i < 120; i++)
+	{
+		const Vec3f position(unit(random) * 8.0f, 1.0f + i * 0.25f, unit(random) * 8.0f);
+		const Quatf rotation(Vec3f(unit(random), unit(random), unit(random) + 2.0f), unit(random) * 3.14159f);
+
+		switch (i % 4)
+		{
+			case 0: AddBody(scene, position, rotation, RigidBody(1.0f, 0.3f, 0.5f), sphereCollider); break;
+			case 1: AddBody(scene, position, rotation, RigidBody(1.0f, 0.1f, 0.6f), boxCollider); break;
+			case 2: AddBody(scene, position, rotation, RigidBody(1.0f, 0.1f, 0.6f), capsuleCollider); break;
+			case 3: AddBody(scene, position, rotation, RigidBody(1.0f, 0.1f, 0.6f), hullCollider); break;
+		}
+	}
+}
+
+static void BuildTerrain(BenchmarkScene& scene)
+{
+	std::mt19937 random(8765);
+	std::uniform_real_distribution<float> unit(-1.0f, 1.0f);
+
+	/* Rolling static mesh of 2 * 354 * 354 = 250632 triangles */
+
+	constexpr uSize gridSize = 354;
+	constexpr float gridSpacing = 0.5f;
+	Array<Vec3f> vertices;
+	Array<uInt32> indices;
+
+	for (uSize z = 0; z <= gridSize; z++)
+	{
+		for (uSize x = 0; x <= gridSize; x++)
+		{
+			const float px = (x - gridSize * 0.5f) * gridSpacing;
+			const float pz = (z - gridSize * 0.5f) * gridSpacing;
+
+			vertices.PushBack(Vec3f(px, sinf(px * 0.3f) * cosf(pz * 0.25f) * 1.5f, pz));
+		}
+	}
+
+	for (uSize z = 0; z < gridSize; z++)
+	{
+		for (uSize x = 0; x < gridSize; x++)
+		{
+			const uInt32 i00 = (uInt32)(z * (gridSize + 1) + x);
+			const uInt32 i10 = i00 + 1;
+			const uInt32 i01 = i00 + (uInt32)(gridSize + 1);
+			const uInt32 i11 = i01 + 1;
+
+			indices.PushBack(i00); indices.PushBack(i01); indices.PushBack(i10);
+			indices.PushBack(i10); indices.PushBack(i01); indices.PushBack(i11);
+		}
+	}
+
+	scene.groundMesh.Build(vertices.Data(), vertices.Size(), indices.Data(), indices.Size());
+	AddBody(scene, { 0.0f, 0.0f, 0.0f }, Quatf(), RigidBody(0.0f, 0.5f, 0.8f, { 0.0f, 0.0f, 0.0f }),
+		MeshCollider(scene.groundMesh));
+
+	Array<Vec3p> hullPoints;
+
+	for (uSize i = 0; i < 24; i++)
+	{
+		hullPoints.PushBack(Vec3p(unit(random), unit(random), unit(random)).Normalized() * 0.5f);
+	}
+
+	scene.hullData.Cook(hullPoints.Data(), hullPoints.Size());
+
+	SphereCollider sphereCollider(0.5f, false);
+	RectCollider boxCollider(Bounds3f{ {-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f} }, false);
+	CapsuleCollider capsuleCollider(0.3f, 0.4f, false);
+	HullCollider hullCollider(scene.hullData, false);
+
+	// Far enough apart that nearly every narrowphase test is a body against the mesh
+	for (uSize x = 0; x < 16; x++)
+	{
+		for (uSize z = 0; z < 16; z++)
+		{
+			const Vec3f position((x - 7.5f) * 10.0f, 3.0f, (z - 7.5f) * 10.0f);
+			const Quatf rotation(Vec3f(unit(random), unit(random), unit(random) + 2.0f), unit(random) * 3.14159f);
+
+			switch ((x + z) % 4)
+			{
+				case 0: AddBody(scene, position, rotation, RigidBody(1.0f, 0.3f, 0.5f), sphereCollider); break;
+				case 1: AddBody(scene, position, rotation, RigidBody(1.0f, 0.1f, 0.6f), boxCollider); break;
+				case 2: AddBody(scene, position, rotation, RigidBody(1.0f, 0.1f, 0.6f), capsuleCollider); break;
+				case 3: AddBody(scene, position, rotation, RigidBody(1.0f, 0.1f, 0.6f), hullCollider); break;
+			}
+		}
+	}
+}
+
+static void BuildCompounds(BenchmarkScene& scene)
+{
+	AddGroundPlane(scene);
+
+	/* Table top on four legs, one body instead of five */
+
+	const Transform identity = TransformComponent({ 0.0f, 0.0f, 0.0f }, Quatf(), { 1.0f, 1.0f, 1.0f });
+	Transform childTransform = identity;
+
+	scene.tableCompound.AddChild(RectCollider(Bounds3f{ {-1.0f, 0.4f, -0.6f}, {1.0f, 0.5f, 0.6f} }), identity);
+
+	for (uSize i = 0; i < 4; i++)
+	{
+		childTransform.position = Vec3f((i & 1) ? 0.9f : -0.9f, 0.0f, (i & 2) ? 0.5f : -0.5f);
+		scene.tableCompound.AddChild(RectCollider(Bounds3f{ {-0.05f, -0.5f, -0.05f}, {0.05f, 0.4f, 0.05f} }), childTransform);
+	}
+
+	scene.tableCompound.Build();
+
+	/* Two spheres on a capsule bar, lying along x */
+
+	childTransform = identity;
+	childTransform.rotation = Quatf({ 0.0f, 0.0f, 1.0f }, 3.14159265f * 0.5f);
+	scene.dumbbellCompound.AddChild(CapsuleCollider(0.1f, 0.6f), childTransform);
+
+	childTransform = identity;
+	childTransform.position = Vec3f(-0.7f, 0.0f, 0.0f);
+	scene.dumbbellCompound.AddChild(SphereCollider(0.3f), childTransform);
+	childTransform.position = Vec3f(0.7f, 0.0f, 0.0f);
+	scene.dumbbellCompound.AddChild(SphereCollider(0.3f), childTransform);
+
+	scene.dumbbellCompound.Build();
+
+	CompoundCollider tableCollider(scene.tableCompound, false);
+	CompoundCollider dumbbellCollider(scene.dumbbellCompound, false);
+
+	for (uSize x = 0; x < 4; x++)
+	{
+		for (uSize z = 0; z < 4; z++)
+		{
+			for (uSize y = 0; y < 3; y++)
+			{
+				const Vec3f position(x * 3.0f, 0.5f + y * 1.2f, z * 2.0f);
+				AddBody(scene, position, Quatf(), RigidBody(1.0f, 0.1f, 0.6f), tableCollider);
+			}
+
+			// Dumbbells land on the top table of each stack
+			const Vec3f position(x * 3.0f, 4.5f, z * 2.0f);
+			const Quatf rotation(Vec3f(0.0f, 1.0f, 0.0f), (x + z) * 0.4f);
+			AddBody(scene, position, rotation, RigidBody(1.0f, 0.2f, 0.6f), dumbbellCollider);
+		}
+	}
+}
+
+static void AddJoint(BenchmarkScene& scene, Entity entity0, Entity entity1, const Joint& joint)
+{
+	scene.world.CreateEntity(JointComponent(entity0, entity1, joint));
+}
+
+static void BuildJoints(BenchmarkScene& scene)
+{
+	AddGroundPlane(scene);
+
+	const Transform identity = TransformComponent({ 0.0f, 0.0f, 0.0f }, Quatf(), { 1.0f, 1.0f, 1.0f });
+
+	/* Chains of spheres pinned to the world, released sideways so they swing */
+
+	SphereCollider linkCollider(0.2f, false);
+
+	for (uSize chain = 0; chain < 8; chain++)
+	{
+		const Vec3f pin(chain * 1.5f, 10.0f, 0.0f);
+		Entity prevLink = NullEntity;
+
+		for (uSize link = 0; link < 10; link++)
+		{
+			const Vec3f position(pin.x, pin.y, (link + 1) * 0.5f);
+			AddBody(scene, position, Quatf(), RigidBody(1.0f, 0.1f, 0.5f), linkCollider);
+
+			const Entity linkEntity = scene.bodies[scene.bodies.Size() - 1];
+			const Transform& transform = scene.world.Get<TransformComponent>(linkEntity);
+			const Transform& prevTransform = prevLink == NullEntity ? identity : scene.world.Get<TransformComponent>(prevLink);
+
+			// Every other chain hangs from a slack rope instead of a ball joint
+			if (link == 0 && (chain & 1))
+			{
+				AddJoint(scene, linkEntity, NullEntity, DistanceJoint(transform, identity, Vec3p(position), Vec3p(pin), true));
+			}
+			else
+			{
+				AddJoint(scene, linkEntity, prevLink, BallJoint(transform, prevTransform, Vec3p(position.x, position.y, position.z - 0.25f)));
+			}
+
+			prevLink = linkEntity;
+		}
+	}
+
+	/* Doors hinged to the world about their left edge, pushed open */
+
+	RectCollider doorCollider(Bounds3f{ {-0.5f, -1.0f, -0.05f}, {0.5f, 1.0f, 0.05f} }, false);
+
+	for (uSize door = 0; door < 4; door++)
+	{
+		const Vec3f position(door * 2.5f, 1.1f, -6.0f);
+
+		RigidBody doorBody(1.0f, 0.1f, 0.5f);
+		doorBody.linearVelocity = Vec3p(0.0f, 0.0f, 0.0f);
+		doorBody.angularVelocity = Vec3p(0.0f, 1.0f + door, 0.0f);
+
+		AddBody(scene, position, Quatf(), doorBody, doorCollider);
+
+		const Entity doorEntity = scene.bodies[scene.bodies.Size() - 1];
+		const Transform& transform = scene.world.Get<TransformComponent>(doorEntity);
+
+		AddJoint(scene, doorEntity, NullEntity, 
+			HingeJoint(transform, identity, Vec3p(position.x - 0.5f, position.y, position.z), Vec3p(0.0f, 1.0f, 0.0f)));
+	}
+
+	/* Plank bridge hinged end to end, with welded box pairs dropped on it */
+
+	RectCollider plankCollider(Bounds3f{ {-0.25f, -0.05f, -0.75f}, {0.25f, 0.05f, 0.75f} }, false);
+	RectCollider boxCollider(Bounds3f{ {-0.25f, -0.25f, -0.25f}, {0.25f, 0.25f, 0.25f} }, false);
+
+	// Hinge points sag along a parabola, so the bridge is slack between its two world hinges
+	Vec3p hingePoints[13];
+
+	for (uSize hinge = 0; hinge <= 12; hinge++)
+	{
+		const floatp t = (hinge - 6.0f) / 6.0f;
+		hingePoints[hinge] = Vec3p(-1.0f + hinge * 0.5f, 3.0f - 1.0f * (1.0f - t * t), 6.0f);
+	}
+
+	for (uSize plank = 0; plank < 12; plank++)
+	{
+		const Vec3p offset = hingePoints[plank + 1] - hingePoints[plank];
+		const Vec3p center = (hingePoints[plank] + hingePoints[plank + 1]) * 0.5f;
+		const Quatf rotation(Vec3f(0.0f, 0.0f, 1.0f), (float)atan2(offset.y, offset.x));
+
+		AddBody(scene, Vec3f(center), rotation, RigidBody(2.0f, 0.1f, 0.6f), plankCollider);
+	}
+
+	const uSize firstPlank = scene.bodies.Size() - 12;
+
+	// Hinge i joins plank i to the one before it, the two ends are hinged to the world
+	for (uSize hinge = 0; hinge <= 12; hinge++)
+	{
+		const Entity entity0 = scene.bodies[firstPlank + Min(hinge, (uSize)11)];
+		const Entity entity1 = (hinge == 0 || hinge == 12) ? NullEntity : scene.bodies[firstPlank + hinge - 1];
+
+		const Transform& transform0 = scene.world.Get<TransformComponent>(entity0);
+		const Transform& transform1 = entity1 == NullEntity ? identity : scene.world.Get<TransformComponent>(entity1);
+
+		AddJoint(scene, entity0, entity1, HingeJoint(transform0, transform1, hingePoints[hinge], Vec3p(0.0f, 0.0f, 1.0f)));
+	}
+
+	for (uSize pair = 0; pair < 3; pair++)
+	{
+		const Vec3f position(0.0f + pair * 1.5f, 5.0f + pair, 6.0f);
+
+		AddBody(scene, position, Quatf(), RigidBody(1.0f, 0.1f, 0.6f), boxCollider);
+		AddBody(scene, position + Vec3f(0.5f, 0.0f, 0.0f), Quatf(), RigidBody(1.0f, 0.1f, 0.6f), boxCollider);
+
+		const Entity box0 = scene.bodies[scene.bodies.Size() - 2];
+		const Entity box1 = scene.bodies[scene.bodies.Size() - 1];
+
+		AddJoint(scene, box0, box1, FixedJoint(scene.world.Get<TransformComponent>(box0), scene.world.Get<TransformComponent>(box1),
+			Vec3p(position.x + 0.25f, position.y, position.z)));
+	}
+}
+
+/* FNV-1a over the raw bits of every body's state */
+
+static void HashBytes(uInt64& hash, const void* pData, uSize size)
+{
+	const uInt8* pBytes = (const uInt8*)pData;
+
+	for (uSize i = 0; i < size; i++)
+	{
+		hash ^= pBytes[i];
+		hash *= 1099511628211ull;
+	}
+}
+
+static uInt64 HashState(BenchmarkScene& scene)
+{
+	uInt64 hash = 14695981039346656037ull;
+
+	for (Entity entity : scene.bodies)
+	{
+		const TransformComponent& transform = scene.world.Get<TransformComponent>(entity);
+		const RigidBody& rigidBody = scene.world.Get<RigidBodyComponent>(entity).rigidBody;
+
+		const float transformState[7] =
+		{
+			transform.position.x, transform.position.y, transform.position.z,
+			transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w
+		};
+
+		const floatp velocityState[6] =
+		{
+			rigidBody.linearVelocity.x, rigidBody.linearVelocity.y, rigidBody.linearVelocity.z,
+			rigidBody.angularVelocity.x, rigidBody.angularVelocity.y, rigidBody.angularVelocity.z
+		};
+
+		HashBytes(hash, transformState, sizeof(transformState));
+		HashBytes(hash, velocityState, sizeof(velocityState));
+	}
+
+	return hash;
+}
+
+struct BenchmarkScenario
+{
+	const char* pName;
+	void (*BuildFunc)(BenchmarkScene& scene);
+};
+
+/* Rays straight down onto the bodies and small overlaps around them, against the settled scene */
+static void RunQueries(const Physics& physics, EntityWorld& world, const BenchmarkScene& scene)
+{
+	Array<RaycastQuery> rays;
+	Array<OverlapQuery> overlaps;
+	SphereCollider probe(1.0f, false);
+
+	for (uSize i = 0; i < BENCHMARK_QUERY_COUNT; i++)
+	{
+		const Vec3p position = world.Get<TransformComponent>(scene.bodies[(i * 7919) % scene.bodies.Size()]).position;
+
+		rays.PushBack({ position + Vec3p(0.0f, 50.0f, 0.0f), Vec3p(0.0f, -1.0f, 0.0f), 100.0f, NullEntity });
+		overlaps.PushBack({ &probe, TransformComponent(Vec3f(position), Quatf(), Vec3f(1.0f, 1.0f, 1.0f)), NullEntity });
+	}
+
+	Array<QueryHit> hits;
+	Array<Entity> entities;
+	Array<uSize> counts;
+	hits.Resize(BENCHMARK_QUERY_COUNT);
+	entities.Resize(BENCHMARK_QUERY_COUNT * 16);
+	counts.Resize(BENCHMARK_QUERY_COUNT);
+
+	const uSize threadCount = Max((uSize)std::thread::hardware_concurrency(), (uSize)1);
+
+	Timer timer;
+	timer.Start();
+
+	physics.RaycastBatch(rays.Data(), rays.Size(), hits.Data(), threadCount);
+	const double rayNs = timer.Mark();
+
+	physics.OverlapBatch(overlaps.Data(), overlaps.Size(), entities.Data(), 16, counts.Data(), threadCount);
+	const double overlapNs = timer.Mark();
+
+	uSize hitCount = 0;
+	uSize overlapCount = 0;
+
+	for (uSize i = 0; i < BENCHMARK_QUERY_COUNT; i++)
+	{
+		hitCount += hits[i].hit ? 1 : 0;
+		overlapCount += counts[i];
+	}
+
+	printf("%-8s queries=%zu threads=%zu  rays=%7.3f ms (%zu hits)  overlaps=%7.3f ms (%zu found)\n",
+		"", (size_t)BENCHMARK_QUERY_COUNT, (size_t)threadCount, rayNs * 1.0e-6, (size_t)hitCount, 
+		overlapNs * 1.0e-6, (size_t)overlapCount);
+}
+
+static void RunScenario(EngineImpl& engine, const BenchmarkScenario& scenario, uSize frameCount, uSize threadCount)
+{
+	// Fresh world and runtime per scenario so triggers from the last run are gone
+	EntityDatabase database;
+	EntityGraph graph(&database);
+	EntityWorld world(&database, &graph);
+	Runtime runtime;
+
+	engine.mpWorld		= &world;
+	engine.mpRuntime	= &runtime;
+
+	Physics physics;
+	physics.Initialize();
+	physics.SetThreadCount(threadCount);
+	physics.SetPenetrationMeasuring(true);
+
+	BenchmarkScene scene = { world };
+	scenario.BuildFunc(scene);
+
+	PhysicsTimings totals = {};
+	PhysicsStats statTotals = {};
+	uSize narrowphaseTests = 0;
+	uSize meshTests = 0;
+	uSize meshQueryOverflows = 0;
+	Timer timer;
+	timer.Start();
+
+	for (uSize frame = 0; frame < frameCount; frame++)
+	{
+		physics.Step(world, BENCHMARK_FRAME_TIME);
+
+		const PhysicsTimings& timings = physics.GetTimings();
+		totals.broadphase	+= timings.broadphase;
+		totals.narrowphase	+= timings.narrowphase;
+		totals.solve		+= timings.solve;
+		totals.continuous	+= timings.continuous;
+		totals.integrate	+= timings.integrate;
+		totals.diagnostics	+= timings.diagnostics;
+
+		const PhysicsStats& stats = physics.GetStats();
+		statTotals.candidatePairs	+= stats.candidatePairs;
+		statTotals.reusedManifolds	+= stats.reusedManifolds;
+		statTotals.contacts			+= stats.contacts;
+		statTotals.solverIterations	+= stats.solverIterations;
+		statTotals.sleepingBodies	+= stats.sleepingBodies;
+		meshQueryOverflows			+= stats.meshQueryOverflows;
+
+		statTotals.maxPenetration		= Max(statTotals.maxPenetration, stats.maxPenetration);
+		statTotals.residualPenetration	= Max(statTotals.residualPenetration, stats.residualPenetration);
+		statTotals.maxSolverIterations	= Max(statTotals.maxSolverIterations, stats.maxSolverIterations);
+
+		for (uSize type0 = 0; type0 < SHAPE_TYPE_COUNT; type0++)
+		{
+			for (uSize type1 = 0; type1 < SHAPE_TYPE_COUNT; type1++)
+			{
+				narrowphaseTests += stats.narrowphaseTests[type0][type1];
+
+				if (type0 == SHAPE_MESH || type1 == SHAPE_MESH)
+				{
+					meshTests += stats.narrowphaseTests[type0][type1];
+				}
+			}
+		}
+
+		for (uSize i = 0; i < PHYSICS_EPA_STAT_BUCKETS; i++)
+		{
+			statTotals.epaIterations[i] += stats.epaIterations[i];
+		}
+	}
+
+	const double totalNs = timer.Mark();
+	const double frameMs = 1.0e-6 / (double)frameCount;
+
+	printf("%-8s bodies=%-4zu frames=%-5zu threads=%-2zu total=%9.2f ms  per frame: broad=%7.3f narrow=%7.3f solve=%7.3f continuous=%7.3f integrate=%7.3f diagnostics=%7.3f ms  hash=%016llx\n",
+		scenario.pName, (size_t)scene.bodies.Size(), (size_t)frameCount, (size_t)physics.GetThreadCount(), totalNs * 1.0e-6,
+		totals.broadphase * frameMs, totals.narrowphase * frameMs, totals.solve * frameMs, totals.continuous * frameMs, totals.integrate * frameMs, totals.diagnostics * frameMs,
+		(unsigned long long)HashState(scene));
+
+	const double perFrame = 1.0 / (double)frameCount;
+
+	printf("%-8s per frame: pairs=%.1f reused=%.1f tests=%.1f contacts=%.1f solver=%.1f asleep=%.1f  epa iterations 1/2/4/8/16/32+: %zu/%zu/%zu/%zu/%zu/%zu\n",
+		"", statTotals.candidatePairs * perFrame, statTotals.reusedManifolds * perFrame, narrowphaseTests * perFrame,
+		statTotals.contacts * perFrame, statTotals.solverIterations * perFrame, statTotals.sleepingBodies * perFrame,
+		(size_t)statTotals.epaIterations[0], (size_t)statTotals.epaIterations[1], (size_t)statTotals.epaIterations[2],
+		(size_t)statTotals.epaIterations[3], (size_t)statTotals.epaIterations[4], (size_t)statTotals.epaIterations[5]);
+
+	// Deepest over every frame, before the solver ran and once the substep had moved the bodies
+	printf("%-8s solver iterations per substep <= %zu  penetration before=%.5f after=%.5f\n",
+		"", (size_t)statTotals.maxSolverIterations, (double)statTotals.maxPenetration, (double)statTotals.residualPenetration);
+
+	// Whole narrowphase time over the tests run, so only a per mesh test cost where meshes are most of the tests
+	if (narrowphaseTests > 0)
+	{
+		printf("%-8s narrowphase per test=%.2f us  mesh tests=%.1f per frame (%.0f%%), %zu over the triangle limit\n",
+			"", totals.narrowphase * 1.0e-3 / (double)narrowphaseTests, meshTests * perFrame,
+			100.0 * (double)meshTests / (double)narrowphaseTests, (size_t)meshQueryOverflows);
+	}
+
+	RunQueries(physics, world, scene);
+}
+
+int main(int argc, char** argv)
+{
+	const char* pScenarioName	= argc > 1 ? argv[1] : "all";
+	const uSize frameCount		= argc > 2 ? (uSize)atoll(argv[2]) : 600;
+	const uSize threadCount		= argc > 3 ? (uSize)atoll(argv[3]) : 1;
+
+	Log benchmarkLog = Log({});
+	Log::SetInstance(benchmarkLog);
+
+	EngineImpl engineImpl;
+	engineImpl.mpLog = &benchmarkLog;
+
+	Engine::SetInstance(engineImpl);
+
+	const BenchmarkScenario scenarios[] =
+	{
+		{ "stack",		BuildStacks },
+		{ "rain",		BuildRain },
+		{ "pyramid",	BuildPyramid },
+		{ "bullets",	BuildProjectiles },
+		{ "swarm",		BuildSwarm },
+		{ "mixed",		BuildMixed },
+		{ "compound",	BuildCompounds },
+		{ "joints",		BuildJoints },
+		{ "terrain",	BuildTerrain }
+	};
+
+	bool found = false;
+
+	for (const BenchmarkScenario& scenario : scenarios)
+	{
+		if (strcmp(pScenarioName, "all") == 0 || strcmp(pScenarioName, scenario.pName) == 0)
+		{
+			RunScenario(engineImpl, scenario, frameCount, threadCount);
+			found = true;
+		}
+	}
+
+	if (!found)
+	{
+		printf("Unknown scenario \"%s\". Expected stack, rain, pyramid, bullets, swarm, mixed, compound, joints, terrain or all.\n", pScenarioName);
+		return 1;
+	}
+
+	return 0;
+}
@@ -16,8 +16,9 @@ namespace Quartz
 			ShapeCapsule	capsule;
 			ShapeHull		hull;
 			ShapeMesh		mesh;
+			ShapeCompound	compound;
 
-			struct { char _shapeData[8 * sizeof(float)]; } shapeData;
+			struct { char _shapeData[8 * sizeof(floatp)]; } shapeData;
 		};
 
 		ShapeType	shape;
@@ -82,9 +83,12 @@ namespace Quartz
 	class CapsuleCollider : public Collider
 	{
 	public:
-		inline CapsuleCollider(bool isStatic = false)
+		// Capsules stand along their local Y axis, halfHeight excludes the end caps
+		inline CapsuleCollider(float radius, float halfHeight, bool isStatic = false)
 		{
 			this->shape = SHAPE_CAPSULE;
+			this->capsule.radius = radius;
+			this->capsule.halfHeight = halfHeight;
 			this->isStatic = isStatic;
 		};
 
@@ -94,9 +98,11 @@ namespace Quartz
 	class HullCollider : public Collider
 	{
 	public:
-		inline HullCollider(bool isStatic = false)
+		// The hull data is not copied and must outlive the collider
+		inline HullCollider(const HullData& hullData, bool isStatic = false)
 		{
 			this->shape = SHAPE_HULL;
+			this->hull.pHullData = &hullData;
 			this->isStatic = isStatic;
 		};
 
@@ -106,12 +112,28 @@ namespace Quartz
 	class MeshCollider : public Collider
 	{
 	public:
-		inline MeshCollider(bool isStatic = false)
+		// Meshes can only be static. The mesh is not copied and must outlive the collider
+		inline MeshCollider(const CollisionMesh& collisionMesh)
 		{
 			this->shape = SHAPE_MESH;
-			this->isStatic = isStatic;
+			this->mesh.pMesh = &collisionMesh;
+			this->isStatic = true;
 		};
 
 		inline const ShapeMesh& GetMesh() const { return mesh; }
 	};
+
+	class CompoundCollider : public Collider
+	{
+	public:
+		// The compound is not copied and must outlive the collider, build it before adding the body
+		inline CompoundCollider(const CompoundData& compoundData, bool isStatic = false)
+		{
+			this->shape = SHAPE_COMPOUND;
+			this->compound.pCompound = &compoundData;
+			this->isStatic = isStatic;
+		};
+
+		inline const ShapeCompound& GetCompound() const { return compound; }
+	};
 }
\ No newline at end of file
@@ -3,8 +3,13 @@
 #include "Simplex.h"
 #include "PhysicsTypes.h"
 #include "Math/Matrix.h"
+#include "Math/Math.h"
 
-#define PHYSICS_MAX_CONTACT_POINTS 6
+#define PHYSICS_MAX_CONTACT_POINTS		6
+#define PHYSICS_MANIFOLD_POINTS			4
+#define PHYSICS_MANIFOLD_MATCH_DISTANCE	0.020f	// New contacts this close to an old one inherit its impulses
+#define PHYSICS_MANIFOLD_BREAK_DISTANCE	0.020f	// Old contacts that separate or slide this far are dropped
+#define PHYSICS_MANIFOLD_NORMAL_ANGLE	0.95f	// Cosine, old contacts are only kept if the normal barely changed
 
 namespace Quartz
 {
@@ -13,23 +18,33 @@ namespace Quartz
 		Vec3p	point;
 		floatp	depth;
 		Vec3p	normal;
+		Vec3p	tangents[2];
 		Vec3p	localPoint0;
 		Vec3p	localPoint1;
-		Vec3p	contactVelocity;
-		floatp	targetVelocity;
-		Mat3p	invContactBasis;
+
+		/* Surface points in the local frame of each body, used to follow the contact between steps */
+
+		Vec3p	localAnchor0;
+		Vec3p	localAnchor1;
+
+		/* Solver data */
+
+		floatp	normalMass;
+		floatp	tangentMass[2];
+		floatp	velocityBias;
+
+		/* Accumulated impulses, carried between steps for warm starting */
+
+		floatp	normalImpulse;
+		floatp	tangentImpulse[2];
 
 		Contact();
 		Contact(const Vec3p& point, floatp depth, const Vec3p& normal);
 
 		Contact& Flip();
 		void CalcLocalPoints(const Vec3p& position0, const Vec3p& position1);
-		void CalcContactVelocity(const Vec3p& lastAccel0, const Vec3p& lastAccel1, 
-			const Vec3p& angularVel0, const Vec3p& angularVel1, 
-			const Vec3p& linearVel0, const Vec3p& linearVel1, double stepTime);
-		void CalcTargetVelocity(const Vec3p& lastAccel0, const Vec3p& lastAccel1, 
-			floatp restitution0, floatp restitution1, double timeStep);
 		void CalcContactBasis();
+		void CalcAnchors(const Transform& transform0, const Transform& transform1);
 	};
 
 	struct Collision
@@ -41,5 +56,17 @@ namespace Quartz
 
 		void AddContact(const Contact& contact);
 		Collision& Flip();
+
+		/* Stores the anchors of every contact, call once the contacts are in their final body order */
+		void CalcAnchors(const Transform& transform0, const Transform& transform1);
+
+		/* Moves contacts with their bodies and recomputes depth, drops the ones that slid or separated */
+		void Refresh(const Transform& transform0, const Transform& transform1);
+
+		/* Replaces the contacts with new ones, keeping impulses of matching contacts and any old contacts still valid */
+		void Merge(const Collision& collision);
+
+		/* Keeps the PHYSICS_MANIFOLD_POINTS contacts that are deepest and cover the largest area */
+		void Reduce();
 	};
-}
\ No newline at end of file
+}
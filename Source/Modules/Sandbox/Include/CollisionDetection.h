@@ -6,6 +6,21 @@
 
 namespace Quartz
 {
+	struct CollisionPair
+	{
+		const Collider*		pCollider0;
+		const Transform*	pTransform0;
+		const Collider*		pCollider1;
+		const Transform*	pTransform1;
+	};
+
+	/* Narrowphase tests of the calling thread by the shape of each collider, compound children included */
+	struct NarrowphaseStats
+	{
+		uInt32 tests[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT];
+		uInt32 meshQueryOverflows;	// Mesh queries over PHYSICS_MESH_MAX_QUERY_TRIANGLES, the other triangles are skipped
+	};
+
 	class CollisionDetection
 	{
 	private:
@@ -46,9 +61,20 @@ namespace Quartz
 		static bool CollideMeshHull(		const MeshCollider& mesh0,			const Transform& transform0, const HullCollider& hull1,			const Transform& transform1, Collision& outCollision);
 		static bool CollideMeshMesh(		const MeshCollider& mesh0,			const Transform& transform0, const MeshCollider& mesh1,			const Transform& transform1, Collision& outCollision);
 
+		/* Collides the children of a compound that can touch the other collider, which may be a compound too */
+		static bool CollideCompound(const CompoundCollider& compound0, const Transform& transform0, 
+			const Collider& collider1, const Transform& transform1, Collision& outCollision);
+
 	public:
 		static bool Collide(const Collider& collider0, const Transform& transform0, 
 			const Collider& collider1, const Transform& transform1, Collision& outCollision);
+
+		/* Collides count pairs at once, box and hull pairs of at most PHYSICS_BATCH_MAX_POINTS vertices each are run through the batched GJK */
+		static void CollideBatch(const CollisionPair* pPairs, uSize count, 
+			Collision* pOutCollisions, bool* pOutColliding);
+
+		static NarrowphaseStats& ThreadStats();
+
 		//static void GenerateContacts(const Collider& collider0, const Collider& collider1, const Collision& collision);
 	};
 }
\ No newline at end of file
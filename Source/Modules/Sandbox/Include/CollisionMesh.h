@@ -0,0 +1,77 @@
+#pragma once
+
+#include "PhysicsTypes.h"
+#include "Types/Array.h"
+
+#define PHYSICS_MESH_LEAF_TRIANGLES		4
+#define PHYSICS_MESH_MAX_DEPTH			64
+#define PHYSICS_MESH_MAX_QUERY_TRIANGLES	256
+
+namespace Quartz
+{
+	struct Model;
+
+	/* 32 byte BVH node. Leaves have a triangle count, inner nodes store their right child (left is next) */
+	struct MeshBVHNode
+	{
+		float	min[3];
+		uInt32	firstTriangle;	// Or right child index for inner nodes
+		float	max[3];
+		uInt32	triangleCount;	// 0 for inner nodes
+	};
+
+	/*
+		Static triangle mesh with a bounding volume hierarchy.
+		Triangles are reordered so every leaf references a contiguous range.
+	*/
+	class CollisionMesh
+	{
+	private:
+		Array<Vec3f>		mVertices;
+		Array<uInt32>		mIndices;
+		Array<MeshBVHNode>	mNodes;
+
+	private:
+		uInt32 BuildNode(Array<uInt32>& triangles, const Array<Vec3f>& centroids, 
+			uInt32 firstTriangle, uInt32 triangleCount, uSize depth);
+
+	public:
+		CollisionMesh() = default;
+
+		bool Build(const Vec3f* pVertices, uSize vertexCount, const uInt32* pIndices, uSize indexCount);
+
+		/* Builds from the position stream and index stream of a model, the LOD 0 meshes are merged */
+		bool Build(const Model& model);
+
+		/* Collects the triangles overlapping a local-space box, returns the number written. pOutTruncated is set if more overlap than maxTriangles */
+		uSize QueryBounds(const Vec3f& min, const Vec3f& max, uInt32* pOutTriangles, uSize maxTriangles, bool* pOutTruncated = nullptr) const;
+
+		/* Closest triangle hit by a local-space ray within maxDistance, in units of direction. Triangles are two sided */
+		bool Raycast(const Vec3p& origin, const Vec3p& direction, floatp maxDistance, 
+			floatp& outDistance, uInt32& outTriangle) const;
+
+		inline void GetTriangle(uInt32 triangle, Vec3f& outA, Vec3f& outB, Vec3f& outC) const
+		{
+			outA = mVertices[mIndices[triangle * 3 + 0]];
+			outB = mVertices[mIndices[triangle * 3 + 1]];
+			outC = mVertices[mIndices[triangle * 3 + 2]];
+		}
+
+		/* Local-space bounds of the whole mesh, false if nothing has been built */
+		inline bool GetBounds(Vec3f& outMin, Vec3f& outMax) const
+		{
+			if (mNodes.Size() == 0)
+			{
+				return false;
+			}
+
+			outMin = Vec3f(mNodes[0].min[0], mNodes[0].min[1], mNodes[0].min[2]);
+			outMax = Vec3f(mNodes[0].max[0], mNodes[0].max[1], mNodes[0].max[2]);
+
+			return true;
+		}
+
+		inline uSize GetTriangleCount() const { return mIndices.Size() / 3; }
+		inline uSize GetNodeCount() const { return mNodes.Size(); }
+	};
+}
@@ -2,8 +2,10 @@
 
 #include "RigidBody.h"
 #include "Math/Math.h"
+#include "Entity/Entity.h"
 #include "Entity/Component.h"
 #include "Colliders.h"
+#include "Joint.h"
 
 namespace Quartz
 {
@@ -29,4 +31,17 @@ namespace Quartz
 			rigidBody.AddTorque(torque);
 		}
 	};
+
+	/* Joints live on their own entities, entity1 may be NullEntity to pin entity0 to the world */
+	struct JointComponent : public Component<JointComponent>
+	{
+		Entity	entity0;
+		Entity	entity1;
+		Joint	joint;
+
+		inline JointComponent() {}
+
+		inline JointComponent(Entity entity0, Entity entity1, const Joint& joint) :
+			entity0(entity0), entity1(entity1), joint(joint) {}
+	};
 }
\ No newline at end of file
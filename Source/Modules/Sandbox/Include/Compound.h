@@ -0,0 +1,80 @@
+#pragma once
+
+#include "PhysicsTypes.h"
+#include "Colliders.h"
+#include "Types/Array.h"
+
+#define PHYSICS_COMPOUND_MAX_CHILDREN	256
+#define PHYSICS_COMPOUND_LEAF_CHILDREN	2
+
+namespace Quartz
+{
+	struct CompoundChild
+	{
+		Collider	collider;
+		Transform	transform;	// Relative to the body, before the body's scale
+		Vec3p		min;		// Bounds in the body's local space
+		Vec3p		max;
+	};
+
+	/* Leaves have a child count, inner nodes store their right child (left is next) */
+	struct CompoundNode
+	{
+		Vec3p	min;
+		uInt32	firstChild;	// Or right child index for inner nodes
+		Vec3p	max;
+		uInt32	childCount;	// 0 for inner nodes
+	};
+
+	/*
+		Several shapes carried by one rigid body, with a bounding volume hierarchy over
+		their local bounds so collisions only visit the children that can touch.
+		Children are placed about the body's origin, which is also its centre of mass.
+	*/
+	class CompoundData
+	{
+	private:
+		Array<CompoundChild>	mChildren;
+		Array<CompoundNode>		mNodes;
+
+	private:
+		uInt32 BuildNode(uInt32 firstChild, uInt32 childCount);
+
+	public:
+		CompoundData() = default;
+
+		/* Spheres, rects, capsules and hulls can be children. Hull data must outlive the compound */
+		bool AddChild(const Collider& collider, const Transform& transform);
+
+		/* Bounds the children and builds the hierarchy, children are reordered to match the leaves */
+		bool Build();
+
+		/* Collects the children overlapping a local-space box, returns the number written */
+		uSize QueryBounds(const Vec3p& min, const Vec3p& max, uInt32* pOutChildren, uSize maxChildren) const;
+
+		/* Collects the children that can touch a collider, given the transform of the compound's body */
+		uSize QueryCollider(const Transform& transform, const Collider& collider, const Transform& colliderTransform,
+			uInt32* pOutChildren, uSize maxChildren) const;
+
+		/* Transform of a child placed on a body */
+		Transform GetChildTransform(uInt32 child, const Transform& transform) const;
+
+		/* Local-space bounds of every child, false if nothing has been built */
+		inline bool GetBounds(Vec3p& outMin, Vec3p& outMax) const
+		{
+			if (mNodes.Size() == 0)
+			{
+				return false;
+			}
+
+			outMin = mNodes[0].min;
+			outMax = mNodes[0].max;
+
+			return true;
+		}
+
+		inline const CompoundChild& GetChild(uInt32 child) const { return mChildren[child]; }
+		inline uSize GetChildCount() const { return mChildren.Size(); }
+		inline uSize GetNodeCount() const { return mNodes.Size(); }
+	};
+}
@@ -9,6 +9,7 @@
 #define PHYSICS_EPA_MAX_EDGES		256 //1536
 #define PHYSICS_EPA_MAX_TRIS		64 //256
 #define PHYSICS_EPA_MAX_TETRAS		64
+#define PHYSICS_EPA_STAT_BUCKETS	6
 
 namespace Quartz
 {
@@ -40,6 +41,26 @@ namespace Quartz
 			Tetrahedron(const Vec3p& a, const Vec3p& b, const Vec3p& c, const Vec3p& d);
 		};
 
+		/* EPA runs of the calling thread by iteration count: 1, 2-3, 4-7, 8-15, 16-31, then 32 or more */
+		struct EPAStats
+		{
+			uInt32 runs[PHYSICS_EPA_STAT_BUCKETS];
+		};
+
+		EPAStats& ThreadEPAStats();
+
+		inline void RecordEPA(uSize iterations)
+		{
+			uSize bucket = 0;
+
+			while (bucket + 1 < PHYSICS_EPA_STAT_BUCKETS && ((uSize)2 << bucket) <= iterations)
+			{
+				bucket++;
+			}
+
+			ThreadEPAStats().runs[bucket]++;
+		}
+
 		class Polytope
 		{
 		private:
@@ -50,16 +71,18 @@ namespace Quartz
 			Polytope();
 
 			bool AddSimplex(const Simplex& simplex);
-			void AddTriangle(const Triangle& tri);
+			bool AddTriangle(const Triangle& tri);
 			void RemoveTriangle(uSize index);
 			void ClosestTriangle(const Vec3p& point, Triangle& outTri,
 				uSize& outIndex, floatp& outDist, Vec3p& outNormal) const;
-			void Extend(const Vec3p& point);
+
+			/* False once PHYSICS_EPA_MAX_TRIS is reached, the polytope is then incomplete */
+			bool Extend(const Vec3p& point);
 		};
 
-		template<typename Shape0, typename Shape1>
-		Vec3p MinkowskiFurthestPoint(const Shape0& shape0, const Mat4f& transform0,
-			const Shape1& shape1, const Mat4f& transform1, const Vec3p direction)
+		template<typename Shape0, typename Shape1, typename Transform0, typename Transform1>
+		Vec3p MinkowskiFurthestPoint(const Shape0& shape0, const Transform0& transform0,
+			const Shape1& shape1, const Transform1& transform1, const Vec3p direction)
 		{
 			const Vec3p point0 = FurthestPoint(shape0, direction, transform0);
 			const Vec3p point1 = FurthestPoint(shape1, -direction, transform1);
@@ -67,8 +90,8 @@ namespace Quartz
 			return point0 - point1;
 		}
 
-		template<typename Shape>
-		Vec3p MinkowskiFurthestPointRect(const Shape& shape0, const Mat4f& transform0,
+		template<typename Shape, typename Transform0>
+		Vec3p MinkowskiFurthestPointRect(const Shape& shape0, const Transform0& transform0,
 			const ShapeRect& rect1, Vec3p(&points)[8], const Vec3p direction)
 		{
 			const Vec3p point0 = FurthestPoint(shape0, direction, transform0);
@@ -86,8 +109,24 @@ namespace Quartz
 			return point0 - point1;
 		}
 
-		template<typename Shape0, typename Shape1>
-		bool GJK(const Shape0& shape0, const Mat4f& transform0, const Shape1& shape1, const Mat4f& transform1, Simplex& outSimplex)
+		/* Builds the collision from the closest polytope face. The normal points out of the minkowski difference. */
+		inline bool EPACollision(const Simplex& contactPoints, const Vec3p& normal, floatp depth, Collision& outCollision)
+		{
+			Collision collision;
+
+			// Separating shape0 means moving it against the face normal
+			for (uSize i = 0; i < contactPoints.Size(); i++)
+			{
+				collision.AddContact(Contact(contactPoints[i] - normal * (depth * 0.5f), depth, -normal));
+			}
+
+			outCollision = collision;
+
+			return collision.count > 0;
+		}
+
+		template<typename Shape0, typename Shape1, typename Transform0, typename Transform1>
+		bool GJK(const Shape0& shape0, const Transform0& transform0, const Shape1& shape1, const Transform1& transform1, Simplex& outSimplex)
 		{
 			Simplex simplex;
 
@@ -134,8 +173,8 @@ namespace Quartz
 			return false; // Exceeded max iterations
 		}
 
-		template<typename Shape0>
-		bool GJKRect(const Shape0& shape0, const Mat4f& transform0, const ShapeRect& rect1, Vec3p(&points)[8], Simplex& outSimplex)
+		template<typename Shape0, typename Transform0>
+		bool GJKRect(const Shape0& shape0, const Transform0& transform0, const ShapeRect& rect1, Vec3p(&points)[8], Simplex& outSimplex)
 		{
 			Simplex simplex;
 
@@ -229,8 +268,8 @@ namespace Quartz
 			return false; // Exceeded max iterations
 		}
 
-		template<typename Shape0, typename Shape1>
-		bool EPA(const Shape0& shape0, const Mat4f& transform0, const Shape1& shape1, const Mat4f& transform1, const Simplex& simplex, Collision& outCollision)
+		template<typename Shape0, typename Shape1, typename Transform0, typename Transform1>
+		bool EPA(const Shape0& shape0, const Transform0& transform0, const Shape1& shape1, const Transform1& transform1, const Simplex& simplex, Collision& outCollision)
 		{
 			constexpr floatp tolerance = 0.01f;
 
@@ -253,29 +292,24 @@ namespace Quartz
 				// Get the furthest point in the normal direction
 				Vec3p furthestPoint = MinkowskiFurthestPoint(shape0, transform0, shape1, transform1, normal);
 
-				if (Dot(furthestPoint, normal) > dist + tolerance)
+				if (Dot(furthestPoint, normal) > dist + tolerance && polytope.Extend(furthestPoint))
 				{
-					polytope.Extend(furthestPoint);
+					continue;
 				}
-				else
-				{
-					//Vec3p extent0 = FurthestPoint(collider0, normal);
-					//Vec3p extent1 = extent0 - normal.Normalized() * dist;
 
-					Simplex contact0 = FurthestSimplex(shape0, -normal, transform0);
-					Simplex contact1 = FurthestSimplex(shape1, normal, transform1);
+				// Converged, or the polytope is full and the closest face so far is the best estimate
+				Simplex contact0 = FurthestSimplex(shape0, normal, transform0);
 
-					//return Collision(normal.Normalized(), dist, contact0, contact1);
-					//return Collision(); // No Collision
-					return false;
-				}
+				RecordEPA(iteration);
+				return EPACollision(contact0, normal, dist, outCollision);
 			}
 
+			RecordEPA(PHYSICS_EPA_MAX_ITERATIONS);
 			return false;
 		}
 
-		template<typename Shape0>
-		bool EPARect(const Shape0& shape0, const Mat4f& transform0, const ShapeRect& rect1, Vec3p(&points)[8], const Simplex& simplex, Collision& outCollision)
+		template<typename Shape0, typename Transform0>
+		bool EPARect(const Shape0& shape0, const Transform0& transform0, const ShapeRect& rect1, Vec3p(&points)[8], const Simplex& simplex, Collision& outCollision)
 		{
 			constexpr floatp tolerance = 0.01f;
 
@@ -296,33 +330,19 @@ namespace Quartz
 				// Get the furthest point in the normal direction
 				Vec3p furthestPoint = MinkowskiFurthestPointRect(shape0, transform0, rect1, points, normal);
 
-				if (Dot(furthestPoint, normal) > dist + tolerance)
+				if (Dot(furthestPoint, normal) > dist + tolerance && polytope.Extend(furthestPoint))
 				{
-					polytope.Extend(furthestPoint);
+					continue;
 				}
-				else
-				{
-					Simplex contact0 = FurthestSimplex(shape0, -normal, transform0);
-					Simplex contact1 = FurthestSimplex(rect1, normal, points);
-
-					//Collision collision(normal.Normalized(), dist);
-					//
-					//if (contact1.Size() > contact0.Size())
-					//{
-					//	contact0 = contact1;
-					//}
-					//
-					//for (uSize i = 0; i < contact0.Size(); i++)
-					//{
-					//	collision.AddContact(contact0[i]);
-					//}
-					//
-					//outCollision = collision;
 
-					return true;
-				}
+				// Converged, or the polytope is full and the closest face so far is the best estimate
+				Simplex contact0 = FurthestSimplex(shape0, normal, transform0);
+
+				RecordEPA(iteration);
+				return EPACollision(contact0, normal, dist, outCollision);
 			}
 
+			RecordEPA(PHYSICS_EPA_MAX_ITERATIONS);
 			return false;
 		}
 
@@ -347,24 +367,19 @@ namespace Quartz
 				// Get the furthest point in the normal direction
 				Vec3p furthestPoint = MinkowskiFurthestPointRectRect(rect0, points0, rect1, points1, normal);
 
-				if (Dot(furthestPoint, normal) > dist + tolerance)
+				if (Dot(furthestPoint, normal) > dist + tolerance && polytope.Extend(furthestPoint))
 				{
-					polytope.Extend(furthestPoint);
+					continue;
 				}
-				else
-				{
-					//Vec3p extent0 = FurthestPoint(rect0, normal);
-					//Vec3p extent1 = extent0 - normal.Normalized() * dist;
 
-					Simplex contact0 = FurthestSimplex(rect0, -normal, points0);
-					Simplex contact1 = FurthestSimplex(rect1, normal, points1);
+				// Converged, or the polytope is full and the closest face so far is the best estimate
+				Simplex contact0 = FurthestSimplex(rect0, normal, points0);
 
-					//return Collision(normal.Normalized(), dist, contact0, contact1);
-					//return Collision(); // No Collision
-					return false;
-				}
+				RecordEPA(iteration);
+				return EPACollision(contact0, normal, dist, outCollision);
 			}
 
+			RecordEPA(PHYSICS_EPA_MAX_ITERATIONS);
 			return false;
 		}
 	}
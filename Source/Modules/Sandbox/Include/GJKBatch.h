@@ -0,0 +1,66 @@
+#pragma once
+
+#include "Simplex.h"
+#include "PhysicsTypes.h"
+
+#if defined(__AVX__)
+	#include <immintrin.h>
+	#define PHYSICS_SIMD_AVX	1
+	#define PHYSICS_SIMD_WIDTH	8
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#include <emmintrin.h>
+	#define PHYSICS_SIMD_SSE	1
+	#define PHYSICS_SIMD_WIDTH	4
+#else
+	#define PHYSICS_SIMD_WIDTH	4
+#endif
+
+#define PHYSICS_BATCH_MAX_POINTS	32
+
+namespace Quartz
+{
+	namespace GJK
+	{
+		/* A pair of world-space convex point clouds */
+		struct BatchPair
+		{
+			const Vec3p*	pPoints0;
+			uSize			count0;
+			const Vec3p*	pPoints1;
+			uSize			count1;
+		};
+
+		/*
+			Point clouds of PHYSICS_SIMD_WIDTH pairs interleaved by lane, so that
+			point i of every lane is contiguous: x[i * PHYSICS_SIMD_WIDTH + lane].
+			Points are stored relative to a per-lane origin to keep float precision.
+		*/
+		struct SupportLanes
+		{
+			alignas(32) float x[PHYSICS_BATCH_MAX_POINTS * PHYSICS_SIMD_WIDTH];
+			alignas(32) float y[PHYSICS_BATCH_MAX_POINTS * PHYSICS_SIMD_WIDTH];
+			alignas(32) float z[PHYSICS_BATCH_MAX_POINTS * PHYSICS_SIMD_WIDTH];
+			uSize maxCount;
+
+			/* count must be at most PHYSICS_BATCH_MAX_POINTS */
+			void SetLane(uSize lane, const Vec3p* pPoints, uSize count, const Vec3p& origin);
+		};
+
+		/* Directions and results of one support query per lane */
+		struct SupportQuery
+		{
+			alignas(32) float x[PHYSICS_SIMD_WIDTH];
+			alignas(32) float y[PHYSICS_SIMD_WIDTH];
+			alignas(32) float z[PHYSICS_SIMD_WIDTH];
+		};
+
+		/* Furthest point of every lane along that lane's direction */
+		void SupportBatch(const SupportLanes& lanes, const SupportQuery& directions, SupportQuery& outPoints);
+
+		/*
+			Runs GJK on count pairs, PHYSICS_SIMD_WIDTH pairs at a time in lockstep.
+			Pairs with more than PHYSICS_BATCH_MAX_POINTS points in a cloud run on their own, without SIMD.
+		*/
+		void GJKBatch(const BatchPair* pPairs, uSize count, Simplex* pOutSimplices, bool* pOutResults);
+	}
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include "PhysicsTypes.h"
+#include "Types/Array.h"
+
+namespace Quartz
+{
+	/* A planar polygon of the hull, vertices are wound counter-clockwise about the normal */
+	struct HullFace
+	{
+		Vec3p	normal;
+		floatp	distance;
+		uInt32	firstIndex;
+		uInt32	indexCount;
+	};
+
+	/*
+		Cooked convex hull. Vertices keep their neighbours so support
+		queries can hill-climb instead of visiting every vertex.
+		Hulls are cooked when the collider is created, there is no
+		serialized form yet. Adjacency is kept between vertices rather
+		than faces: climbing face normals is not guaranteed to reach the
+		best face, so SupportFace visits every face instead.
+	*/
+	class HullData
+	{
+	private:
+		Array<Vec3p>	mVertices;
+		Array<uInt32>	mNeighbourOffsets;	// Neighbours of vertex i are [offsets[i], offsets[i + 1])
+		Array<uInt32>	mNeighbours;
+		Array<HullFace>	mFaces;
+		Array<uInt32>	mFaceIndices;
+		Vec3p			mCentroid;
+		floatp			mVolume;
+		Vec3p			mSecondMoments;		// Mean x^2, y^2 and z^2 over the solid, about the local origin
+
+	public:
+		HullData();
+
+		/* Builds the hull of a point cloud using quickhull, merging coplanar triangles into faces */
+		bool Cook(const Vec3p* pPoints, uSize count);
+
+		/* Index of the vertex furthest along a local direction, climbing from startIndex */
+		uInt32 SupportIndex(const Vec3p& direction, uInt32 startIndex = 0) const;
+
+		/* Index of the face whose normal is most aligned with a local direction */
+		uInt32 SupportFace(const Vec3p& direction) const;
+
+		inline const Array<Vec3p>&		GetVertices() const { return mVertices; }
+		inline const Array<HullFace>&	GetFaces() const { return mFaces; }
+		inline const Array<uInt32>&		GetFaceIndices() const { return mFaceIndices; }
+		inline const Vec3p&				GetCentroid() const { return mCentroid; }
+		inline floatp					GetVolume() const { return mVolume; }
+		inline const Vec3p&				GetSecondMoments() const { return mSecondMoments; }
+		inline bool						IsValid() const { return mFaces.Size() >= 4; }
+
+		/* Shared [-1, 1] cube, used to run boxes through the hull routines */
+		static const HullData& UnitBox();
+	};
+}
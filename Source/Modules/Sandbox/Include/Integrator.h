@@ -0,0 +1,45 @@
+#pragma once
+
+#include "PhysicsTypes.h"
+#include "Types/Array.h"
+
+namespace Quartz
+{
+	/*
+		Rigid body state laid out as a structure of arrays, one entry per
+		simulated body. Positions and rotations stay in double precision
+		across the substeps of a step and are written back after each one.
+	*/
+	struct BodyArrays
+	{
+		Array<floatp> positionX, positionY, positionZ;
+		Array<floatp> rotationX, rotationY, rotationZ, rotationW;
+		Array<floatp> linearX, linearY, linearZ;
+		Array<floatp> angularX, angularY, angularZ;
+		Array<floatp> forceX, forceY, forceZ;		// Already scaled into acceleration
+		Array<floatp> torqueX, torqueY, torqueZ;	// Already scaled into acceleration
+		Array<floatp> gravityX, gravityY, gravityZ;
+		Array<floatp> invInertiaX, invInertiaY, invInertiaZ;
+
+		/* World inverse inertia tensor, symmetric so only six entries are kept */
+		Array<floatp> tensorXX, tensorXY, tensorXZ, tensorYY, tensorYZ, tensorZZ;
+
+		Array<floatp> awake;	// 1 for bodies that integrate, 0 for sleeping ones
+		Array<floatp> dynamic;	// 1 for bodies with mass, gravity only applies to these
+
+		void Resize(uSize count);
+		inline uSize Size() const { return awake.Size(); }
+	};
+
+	namespace Integrator
+	{
+		/* Adds gravity and the gathered forces to the velocities, then applies drag. Forces are consumed */
+		void ApplyForces(BodyArrays& bodies, floatp stepTime, floatp linearDrag, floatp angularDrag);
+
+		/*
+			Advances positions by the velocities scaled by pMotionScales, rotations by the angular
+			velocities, then rebuilds the world inverse inertia tensors from the new rotations.
+		*/
+		void Integrate(BodyArrays& bodies, const floatp* pMotionScales, floatp stepTime);
+	}
+}
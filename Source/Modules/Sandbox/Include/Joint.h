@@ -0,0 +1,87 @@
+#pragma once
+
+#include "PhysicsTypes.h"
+#include "Math/Math.h"
+
+#define PHYSICS_JOINT_HERTZ				60.0f	// Stiffness of the drift correction
+#define PHYSICS_JOINT_DAMPING_RATIO		2.0f
+#define PHYSICS_JOINT_MAX_ROWS			6
+
+namespace Quartz
+{
+	enum JointType
+	{
+		JOINT_BALL,		// Anchors held together, free rotation
+		JOINT_HINGE,	// Anchors held together, rotation about the hinge axis only
+		JOINT_DISTANCE,	// Anchors held a fixed distance apart, or at most that distance for ropes
+		JOINT_FIXED		// Anchors held together, no relative rotation
+	};
+
+	/*
+		Constraint between two bodies, solved with the contacts. Anchors and axes are
+		given in world space when the joint is made and kept in each body's local frame.
+		Joints to the world pass an identity transform for body 1.
+	*/
+	struct Joint
+	{
+		JointType	type;
+		bool		collideConnected;	// Contacts between the two bodies are skipped unless set
+
+		Vec3p	localAnchor0;
+		Vec3p	localAnchor1;
+		Vec3p	localAxis0;			// Hinge axis
+		Vec3p	localAxis1;
+		Quatp	relativeRotation;	// Rotation of body 0 in body 1's frame, for fixed joints
+		floatp	distance;
+		bool	rope;				// Distance joints that only pull
+
+		/* Solver data */
+
+		Vec3p	localPoint0;		// Anchors relative to each body, in world space
+		Vec3p	localPoint1;
+		Vec3p	axis;				// Distance direction, or the hinge axis
+		Vec3p	angularRows[3];		// Directions the bodies may not rotate apart about
+		uSize	angularRowCount;
+		floatp	rowBias[PHYSICS_JOINT_MAX_ROWS];	// Anchor rows, then angular rows
+
+		/* Inverse effective mass over every row at once, so welds and hinges converge as one block */
+		floatp	rowMass[PHYSICS_JOINT_MAX_ROWS * PHYSICS_JOINT_MAX_ROWS];
+
+		floatp	axisMass;
+		floatp	axisBias;
+		floatp	massScale;			// Softness, keeps warm started joints from overshooting their drift correction
+		floatp	impulseScale;
+
+		/* Accumulated impulses, carried between steps for warm starting */
+
+		Vec3p	linearImpulse;
+		Vec3p	angularImpulse;
+		floatp	axisImpulse;
+
+		Joint();
+
+		/* Solver setup for the current poses */
+		void CalcLocalPoints(const Transform& transform0, const Transform& transform1);
+	};
+
+	struct BallJoint : public Joint
+	{
+		BallJoint(const Transform& transform0, const Transform& transform1, const Vec3p& anchor);
+	};
+
+	struct HingeJoint : public Joint
+	{
+		HingeJoint(const Transform& transform0, const Transform& transform1, const Vec3p& anchor, const Vec3p& axis);
+	};
+
+	struct DistanceJoint : public Joint
+	{
+		DistanceJoint(const Transform& transform0, const Transform& transform1,
+			const Vec3p& anchor0, const Vec3p& anchor1, bool rope = false);
+	};
+
+	struct FixedJoint : public Joint
+	{
+		FixedJoint(const Transform& transform0, const Transform& transform1, const Vec3p& anchor);
+	};
+}
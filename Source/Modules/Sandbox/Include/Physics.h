@@ -2,24 +2,81 @@
 
 #include "Engine.h"
 #include "Colliders.h"
+#include "Compound.h"
 #include "CollisionDetection.h"
+#include "GJK.h"
+#include "Joint.h"
+#include "Integrator.h"
+#include "PhysicsQuery.h"
 #include "Entity/World.h"
 #include "PhysicsTypes.h"
 #include "Component/PhysicsComponent.h"
 #include "Component/TransformComponent.h"
+#include "Runtime/Timer.h"
 
-#define PHYSICS_STEP_ITERATIONS			8
-#define PHYSICS_MAX_RESOLVE_ITERATIONS	8
-#define PHYSICS_MAX_VELOCITY_ITERATIONS	8
-#define PHYSICS_SMALLEST_DISTANCE		0.001f
-#define PHYSICS_SMALLEST_VELOCITY		0.200f
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#define PHYSICS_STEP_ITERATIONS			4
+#define PHYSICS_SOLVER_ITERATIONS		10
+#define PHYSICS_SOLVER_TOLERANCE		0.0001f
+#define PHYSICS_BAUMGARTE_FACTOR		0.2f
+#define PHYSICS_PENETRATION_SLOP		0.005f
+#define PHYSICS_RESTITUTION_VELOCITY	0.250f
+#define PHYSICS_MANIFOLD_REUSE_DISTANCE	0.002f	// Bodies that move less than this keep their manifold without a narrowphase
+#define PHYSICS_MANIFOLD_REUSE_SPEED	0.1f	// Linear and angular speed below which a body counts as resting
+#define PHYSICS_MANIFOLD_REUSE_ANGLE	0.99998f	// Cosine of half the rotation allowed, about 0.7 degrees
+#define PHYSICS_CONTINUOUS_SPACING		0.5f	// Sweep sample spacing as a fraction of the body's inner radius
+#define PHYSICS_CONTINUOUS_BISECTIONS	6
+#define PHYSICS_NARROWPHASE_MAX_THREADS	16
+#define PHYSICS_NARROWPHASE_CHUNK_SIZE	32	// Pairs a narrowphase thread takes at a time
+#define PHYSICS_NARROWPHASE_BATCH_SIZE	128	// Fewest pairs worth handing to another thread
 
 namespace Quartz
 {
+	/* Nanoseconds spent in each phase, summed over the substeps of the last Step() */
+	struct PhysicsTimings
+	{
+		double broadphase;
+		double narrowphase;
+		double solve;
+		double continuous;
+		double integrate;
+		double diagnostics;	// Residual penetration, only when measured
+	};
+
+	/* Counters of the last Step(), summed over its substeps unless noted */
+	struct PhysicsStats
+	{
+		uSize	bodies;
+		uSize	sleepingBodies;		// After the step
+		uSize	joints;
+		uSize	candidatePairs;		// Overlapping broadphase bounds
+		uSize	reusedManifolds;	// Candidates that kept last substep's contacts without a narrowphase test
+		uSize	collidingPairs;
+		uSize	contacts;
+		uSize	solverIterations;
+		uSize	maxSolverIterations;	// Most iterations a single substep needed
+		floatp	maxPenetration;		// Deepest contact before it was resolved
+		floatp	residualPenetration;	// Deepest contact left once the last substep moved the bodies, 0 unless measured
+
+		/* Shape pair tests, including continuous sweeps and compound children */
+		uSize	narrowphaseTests[SHAPE_TYPE_COUNT][SHAPE_TYPE_COUNT];
+		uSize	meshQueryOverflows;	// Mesh tests that only saw the first PHYSICS_MESH_MAX_QUERY_TRIANGLES triangles
+
+		/* EPA runs by iteration count: 1, 2-3, 4-7, 8-15, 16-31, then PHYSICS_EPA_MAX_ITERATIONS */
+		uSize	epaIterations[PHYSICS_EPA_STAT_BUCKETS];
+
+		PhysicsTimings timings;
+	};
+
 	class Physics
 	{
 	public:
 		using RigidBodyView = EntityView<RigidBodyComponent, TransformComponent>;
+		using JointView = EntityView<JointComponent>;
 
 	public:
 
@@ -31,14 +88,95 @@ namespace Quartz
 			RigidBodyComponent* pRigidBody1;
 			TransformComponent* pTransform0;
 			TransformComponent* pTransform1;
+			uInt64 pairKey;
 
 			Collision collision;
+
+			/* Poses when the narrowphase last ran for this pair */
+
+			Vec3f position0;
+			Vec3f position1;
+			Quatf rotation0;
+			Quatf rotation1;
+		};
+
+		struct JointData
+		{
+			Entity				entity;
+			JointComponent*		pJoint;
+			RigidBody*			pRigidBody0;
+			RigidBody*			pRigidBody1;
+			const Transform*	pTransform0;
+			const Transform*	pTransform1;
+			bool				dynamic0;
+			bool				dynamic1;
+		};
+
+		struct BroadphaseEntry
+		{
+			Vec3p	min;
+			Vec3p	max;
+			uInt32	index; // Into mEntities
+			bool	isStatic;
 		};
 
 	private:
 		static CollisionDetection collisionDetection;
 
+		Array<Entity>				mEntities;
+		Array<RigidBodyComponent*>	mBodyPhysics;		// Per mEntities
+		Array<TransformComponent*>	mBodyTransforms;	// Per mEntities
+		BodyArrays					mBodies;			// Per mEntities
+
+		Array<BroadphaseEntry>	mBroadphase;
+		Array<CollisionData>	mCandidates;
+		Array<CollisionPair>	mCandidatePairs;
+		Array<uSize>			mCandidateIndices; // Into mCandidates, for pairs sent to the narrowphase
+		Array<Collision>		mCandidateCollisions;
+		Array<bool>				mCandidateResults;
+		Array<floatp>			mMotionScales; // Per mEntities, fraction of the step each body may travel
+
+		/* Bounds at the end of the last Step(), indices into mEntities */
+
+		SweepBounds	mQueryStatic;
+		SweepBounds	mQueryDynamic;
+
 		Array<CollisionData> mCollisions;
+		Array<CollisionData> mPrevCollisions; // Sorted by pairKey
+		uSize	mSolverIterations;
+		floatp	mMaxPenetration;
+		floatp	mResidualPenetration;
+		floatp	mLinearDrag;
+		floatp	mAngularDrag;
+
+		Array<JointData>	mJoints;
+		Array<uInt64>		mJointPairs;	// Sorted, body pairs whose contacts are skipped
+		RigidBody			mWorldBody;		// Stands in for NullEntity in joints
+		Transform			mWorldTransform;
+
+		uSize			mThreadCount;
+
+		/* Narrowphase workers, started by SetThreadCount and parked between substeps */
+
+		Array<std::thread*>		mWorkers;
+		std::mutex				mWorkMutex;
+		std::condition_variable	mWorkCondition;
+		std::condition_variable	mWorkDoneCondition;
+		uSize					mWorkGeneration;	// Bumped to hand the workers a substep
+		uSize					mWorkActive;		// Workers given chunks in this substep
+		uSize					mWorkPending;		// Active workers still colliding
+		bool					mStopWorkers;
+		std::atomic<uSize>		mNextChunk;
+		NarrowphaseStats		mWorkerStats[PHYSICS_NARROWPHASE_MAX_THREADS];
+		GJK::EPAStats			mWorkerEPAStats[PHYSICS_NARROWPHASE_MAX_THREADS];
+
+		Timer			mTimer;
+		PhysicsTimings	mTimings;
+		PhysicsStats	mStats;
+		bool			mLogStats;
+		bool			mMeasurePenetration;
+		bool			mMeshOverflowWarned;
+		uInt64			mStateHash;
 
 	private:
 
@@ -50,27 +188,153 @@ namespace Quartz
 		static Vec3p InitalInertiaCapsule(const RigidBody& rigidBody, const CapsuleCollider& capsule, const Vec3p& scale);
 		static Vec3p InitalInertiaHull(const RigidBody& rigidBody, const HullCollider& hull, const Vec3p& scale);
 		static Vec3p InitalInertiaMesh(const RigidBody& rigidBody, const MeshCollider& mesh, const Vec3p& scale);
+		static Vec3p InitalInertiaCompound(const RigidBody& rigidBody, const CompoundCollider& compound, const Vec3p& scale);
 
 		static Vec3p InitalInertia(const RigidBody& rigidBody, const Collider& collider, const Vec3p& scale);
 
+		/* World Bounds */
+
+		static void CalcBoundsSphere(const SphereCollider& sphere, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+		static void CalcBoundsPlane(const PlaneCollider& plane, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+		static void CalcBoundsRect(const RectCollider& rect, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+		static void CalcBoundsCapsule(const CapsuleCollider& capsule, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+		static void CalcBoundsHull(const HullCollider& hull, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+		static void CalcBoundsMesh(const MeshCollider& mesh, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+		static void CalcBoundsCompound(const CompoundCollider& compound, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+
+		/* Continuous */
+
+		static floatp CalcInnerRadius(const Collider& collider, const Transform& transform);
+		static bool TimeOfImpact(const Collider& collider0, const Transform& transform0, const Vec3p& motion, 
+			const Collider& collider1, const Transform& transform1, floatp spacing, floatp& outTime);
+
+		/* Raycasts */
+
+		static bool RaycastSphere(const SphereCollider& sphere, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+		static bool RaycastPlane(const PlaneCollider& plane, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+		static bool RaycastRect(const RectCollider& rect, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+		static bool RaycastCapsule(const CapsuleCollider& capsule, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+		static bool RaycastHull(const HullCollider& hull, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+		static bool RaycastMesh(const MeshCollider& mesh, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+		static bool RaycastCompound(const CompoundCollider& compound, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+
+		static bool RaycastCollider(const Collider& collider, const Transform& transform, const Vec3p& origin, const Vec3p& direction, floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+
+		/* Scene Queries */
+
+		void UpdateQueryBounds();
+
+		template<typename Func>
+		inline void QueryBounds(const Vec3p& min, const Vec3p& max, Func&& func) const
+		{
+			if (mQueryStatic.Query(min, max, func))
+			{
+				mQueryDynamic.Query(min, max, func);
+			}
+		}
+
 		/* Apply Physics */
 
+		void GatherBodies(EntityWorld& world, RigidBodyView& rigidBodies);
+		void SortBodies();
+		bool GetJointBody(EntityWorld& world, Entity entity, RigidBody*& pOutRigidBody, const Transform*& pOutTransform, bool& outDynamic);
+		void GatherJoints(EntityWorld& world, JointView& joints);
+		bool IsJointPair(Entity entity0, Entity entity1) const;
+		void GatherVelocities();
 		void ApplyForces(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime);
+		void FindCandidates(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime);
 		void FindCollisions(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime);
+		void CollideCandidates();
+		void CollideChunks();
+		void WorkerThread(uSize worker);
+		void StartWorkers(uSize workerCount);
+		void StopWorkers();
 		void ResolveCollisions(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime);
+		void SweepContinuous(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime);
+		void IntegrateVelocities(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime);
+		void MeasurePenetration();
+
+		/* Determinism */
+
+		uInt64 CalcStateHash() const;
+
+		/* Statistics */
+
+		void BeginStats();
+		void EndStats();
 
 		/* Triggers */
 
 		void OnRigidBodyAdded(Runtime& runtime, const ComponentAddedEvent<RigidBodyComponent>& event);
 
 	public:
+		Physics();
+		~Physics();
+
 		void Initialize();
 
 		bool Collide(const Collider& collider0, const Transform& transform0,
 			const Collider& collider1, const Transform& transform1, Collision& outCollision);
 
+		/* World-space bounds of a collider */
+		static void CalcBounds(const Collider& collider, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+
 		//void GenerateContacts(const Collider& collider0, const Collider& collider1, const Collision& collision);
 
 		void Step(EntityWorld& world, double deltaTime);
+
+		/*
+			Scene queries run against the bodies as they were at the end of the last Step().
+			They only read physics state, so any number of threads may query at once between steps.
+		*/
+
+		bool Raycast(const RaycastQuery& query, QueryHit& outHit) const;
+		bool ShapeCast(const ShapeCastQuery& query, QueryHit& outHit) const;
+
+		/* Writes up to maxEntities overlapping entities, returns the number written */
+		uSize Overlap(const OverlapQuery& query, Entity* pOutEntities, uSize maxEntities) const;
+
+		/*
+			Batches split the queries over up to threadCount threads, the calling thread included.
+			A job system can instead call these with a threadCount of 1 on its own slices of a batch.
+		*/
+
+		void RaycastBatch(const RaycastQuery* pQueries, uSize count, QueryHit* pOutHits, uSize threadCount = 1) const;
+		void ShapeCastBatch(const ShapeCastQuery* pQueries, uSize count, QueryHit* pOutHits, uSize threadCount = 1) const;
+
+		/* Query i writes to pOutEntities[i * maxEntities] and its count to pOutCounts[i] */
+		void OverlapBatch(const OverlapQuery* pQueries, uSize count, Entity* pOutEntities, uSize maxEntities, 
+			uSize* pOutCounts, uSize threadCount = 1) const;
+
+		/* Threads the narrowphase may use, the calling thread included. Results do not depend on the count */
+		void SetThreadCount(uSize threadCount);
+		inline uSize GetThreadCount() const { return mThreadCount; }
+
+		/* Solver iterations used by the last substep */
+		inline uSize GetSolverIterations() const { return mSolverIterations; }
+
+		/* Deepest contact found by the last substep, before it was resolved */
+		inline floatp GetMaxPenetration() const { return mMaxPenetration; }
+
+		/* Deepest contact left after the last substep's position update, 0 unless measured */
+		inline floatp GetResidualPenetration() const { return mResidualPenetration; }
+
+		/* Phase timings of the last Step() */
+		inline const PhysicsTimings& GetTimings() const { return mTimings; }
+
+		/* Counters of the last Step() */
+		inline const PhysicsStats& GetStats() const { return mStats; }
+
+		/* Logs the counters of the last Step() */
+		void LogStats() const;
+
+		/* Logs the counters after every Step() */
+		inline void SetStatsLogging(bool enabled) { mLogStats = enabled; }
+
+		/* Re-collides every manifold after each substep to find the residual penetration, also on while logging */
+		inline void SetPenetrationMeasuring(bool enabled) { mMeasurePenetration = enabled; }
+
+		/* Bitwise hash of every body after the last Step(), always 0 unless PHYSICS_DETERMINISTIC is set */
+		inline uInt64 GetStateHash() const { return mStateHash; }
 	};
 }
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include "PhysicsTypes.h"
+#include "Colliders.h"
+#include "Entity/World.h"
+#include "Types/Array.h"
+
+#define PHYSICS_QUERY_MAX_THREADS	16
+#define PHYSICS_QUERY_BATCH_SIZE	64	// Fewest queries worth handing to another thread
+
+namespace Quartz
+{
+	struct RaycastQuery
+	{
+		Vec3p	origin;
+		Vec3p	direction;		// Normalized by the query
+		floatp	maxDistance;
+		Entity	ignore;			// Usually the entity casting the ray, NullEntity ignores nothing
+	};
+
+	/* Sweeps a collider from its transform along a direction. Planes and meshes can not be cast */
+	struct ShapeCastQuery
+	{
+		const Collider*	pCollider;
+		Transform		transform;
+		Vec3p			direction;	// Normalized by the query
+		floatp			maxDistance;
+		Entity			ignore;
+	};
+
+	struct OverlapQuery
+	{
+		const Collider*	pCollider;
+		Transform		transform;
+		Entity			ignore;
+	};
+
+	struct QueryHit
+	{
+		Entity	entity;
+		floatp	distance;	// Along the query direction, 0 if the query started inside the body
+		Vec3p	point;
+		Vec3p	normal;		// Surface normal of the hit body, facing the query
+		bool	hit;
+	};
+
+	/*
+		World bounds sorted along x. A range query binary searches the last entry
+		starting before the range ends, then walks back until no earlier entry
+		can reach the start of the range.
+	*/
+	class SweepBounds
+	{
+	public:
+		struct Entry
+		{
+			Vec3p	min;
+			Vec3p	max;
+			uInt32	index;
+		};
+
+	private:
+		Array<Entry>	mEntries;
+		Array<floatp>	mReach; // Largest max.x of the entries up to and including i
+
+	public:
+		void Clear();
+		void Add(const Vec3p& min, const Vec3p& max, uInt32 index);
+
+		/* Sorts the entries, call once every entry has been added */
+		void Sort();
+
+		/* Calls func(entry) for every entry overlapping the box, stops early and returns false if func does */
+		template<typename Func>
+		bool Query(const Vec3p& min, const Vec3p& max, Func&& func) const
+		{
+			uSize low	= 0;
+			uSize high	= mEntries.Size();
+
+			while (low < high)
+			{
+				const uSize middle = (low + high) / 2;
+
+				if (mEntries[middle].min.x <= max.x)
+				{
+					low = middle + 1;
+				}
+				else
+				{
+					high = middle;
+				}
+			}
+
+			for (uSize i = low; i > 0 && mReach[i - 1] >= min.x; i--)
+			{
+				const Entry& entry = mEntries[i - 1];
+
+				if (entry.max.x < min.x ||
+					entry.max.y < min.y || max.y < entry.min.y ||
+					entry.max.z < min.z || max.z < entry.min.z)
+				{
+					continue;
+				}
+
+				if (!func(entry))
+				{
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		inline uSize Size() const { return mEntries.Size(); }
+	};
+}
@@ -4,6 +4,15 @@
 
 #define PHYSICS_USE_DOUBLE 1
 
+/*
+	Deterministic builds gather bodies in entity handle order and hash the
+	simulated state after every step. Set through SANDBOX_DETERMINISTIC_PHYSICS,
+	which also turns off floating point contraction so results match across builds.
+*/
+#ifndef PHYSICS_DETERMINISTIC
+#define PHYSICS_DETERMINISTIC 0
+#endif
+
 namespace Quartz
 {
 #if PHYSICS_USE_DOUBLE
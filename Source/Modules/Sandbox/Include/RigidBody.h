@@ -19,6 +19,7 @@ namespace Quartz
 		Vec3p inertiaVector;
 		Mat3p invInertiaTensor;
 		bool  asleep;
+		bool  continuous;	// Swept against the scene every substep, for fast movers
 
 		Vec3p lastAcceleration;
 
@@ -26,14 +27,18 @@ namespace Quartz
 			invMass(1.0f),
 			restitution(0.5f),
 			friction(0.5f),
-			gravity(0.0f, -9.81f, 0.0f) {}
+			gravity(0.0f, -9.81f, 0.0f),
+			asleep(false),
+			continuous(false) {}
 
 		inline RigidBody(floatp invMass, floatp restitution, floatp friction,
 			const Vec3p& gravity = { 0.0f, -9.81f, 0.0f }) :
 			invMass(invMass),
 			restitution(restitution),
 			friction(friction),
-			gravity(gravity) {}
+			gravity(gravity),
+			asleep(false),
+			continuous(false) {}
 
 		inline void AddForce(const Vec3p& force)
 		{
@@ -55,6 +60,11 @@ namespace Quartz
 			this->angularVelocity += velocity;
 		}
 
+		inline void SetContinuous(bool continuous)
+		{
+			this->continuous = continuous;
+		}
+
         static inline void _calculateTransformMatrix(Mat4p& transformMatrix,
             const Vec3p& position,
             const Quatp& orientation)
@@ -154,7 +164,8 @@ namespace Quartz
                 Mat4p rotMat;
                 _calculateTransformMatrix(rotMat, transform.position, transform.rotation);
                 //Mat4p rotMat(transform.GetMatrix());
-                _transformInertiaTensor(invInertiaTensor, Mat3p().SetIdentity(inertiaVector), rotMat);
+                const Vec3p invInertiaVector(1.0f / inertiaVector.x, 1.0f / inertiaVector.y, 1.0f / inertiaVector.z);
+                _transformInertiaTensor(invInertiaTensor, Mat3p().SetIdentity(invInertiaVector), rotMat);
 
                 //invInertiaTensor = Mat3p().SetIdentity();
 
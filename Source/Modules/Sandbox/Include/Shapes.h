@@ -2,11 +2,15 @@
 
 #include "Simplex.h"
 #include "PhysicsTypes.h"
+#include "Hull.h"
+#include "CollisionMesh.h"
 #include "Math/Math.h"
 #include <float.h>
 
 namespace Quartz
 {
+	class CompoundData;
+
 	enum ShapeType
 	{
 		SHAPE_NONE		= -1,
@@ -15,9 +19,12 @@ namespace Quartz
 		SHAPE_RECT		= 2,
 		SHAPE_CAPSULE	= 3,
 		SHAPE_HULL		= 4,
-		SHAPE_MESH		= 5
+		SHAPE_MESH		= 5,
+		SHAPE_COMPOUND	= 6
 	};
 
+	constexpr uSize SHAPE_TYPE_COUNT = 7;
+
 	struct ShapeSphere
 	{
 		floatp radius;
@@ -36,19 +43,89 @@ namespace Quartz
 		Bounds3f bounds;
 	};
 
+	/* Sphere swept along the local Y axis, from -halfHeight to halfHeight */
 	struct ShapeCapsule
 	{
-
+		floatp radius;
+		floatp halfHeight;
 	};
 
 	struct ShapeHull
 	{
-
+		const HullData* pHullData;
 	};
 
 	struct ShapeMesh
 	{
+		const CollisionMesh* pMesh;
+	};
 
+	struct ShapeCompound
+	{
+		const CompoundData* pCompound;
+	};
+
+	/* World-space triangle, only used as the second shape of mesh contact queries */
+	struct ShapeTriangle
+	{
+		Vec3p points[3];
+	};
+
+	/*
+		Decomposed transform for shapes queried in local space.
+		Boxes map their bounds onto the [-1, 1] cube of HullData::UnitBox().
+	*/
+	struct ShapeTransform
+	{
+		Vec3p position;
+		Mat3p rotation;
+		Mat3p invRotation;
+		Vec3p scale;
+
+		inline ShapeTransform(const Transform& transform) :
+			position(transform.position),
+			rotation(Mat3p().SetRotation(Quatp(transform.rotation))),
+			scale(transform.scale)
+		{
+			invRotation = rotation.Transposed();
+		}
+
+		inline ShapeTransform(const Transform& transform, const Bounds3f& bounds) :
+			ShapeTransform(transform)
+		{
+			const Vec3p center = (Vec3p(bounds.BottomLeftBack()) + Vec3p(bounds.TopRightFront())) * 0.5f;
+			const Vec3p halfSize(bounds.Width() * 0.5f, bounds.Height() * 0.5f, bounds.Depth() * 0.5f);
+
+			position += rotation * Scale(center);
+			scale = Scale(halfSize);
+		}
+
+		inline Vec3p Scale(const Vec3p& vector) const
+		{
+			return Vec3p(vector.x * scale.x, vector.y * scale.y, vector.z * scale.z);
+		}
+
+		inline Vec3p ToLocalDirection(const Vec3p& direction) const
+		{
+			return Scale(invRotation * direction);
+		}
+
+		inline Vec3p ToWorldPoint(const Vec3p& point) const
+		{
+			return position + rotation * Scale(point);
+		}
+
+		inline Vec3p ToLocalPoint(const Vec3p& point) const
+		{
+			const Vec3p local = invRotation * (point - position);
+			return Vec3p(local.x / scale.x, local.y / scale.y, local.z / scale.z);
+		}
+
+		inline Vec3p ToWorldNormal(const Vec3p& normal) const
+		{
+			const Vec3p scaled(normal.x / scale.x, normal.y / scale.y, normal.z / scale.z);
+			return (rotation * scaled).Normalized();
+		}
 	};
 
 	namespace ShapeUtils
@@ -118,12 +195,45 @@ namespace Quartz
 			return Vec3p::ZERO;
 		}
 
+		inline Vec3p FurthestPoint(const ShapeSphere& sphere, const Vec3p& direction, const ShapeTransform& transform)
+		{
+			return transform.position + direction.Normalized() * (sphere.radius * transform.scale.Maximum());
+		}
+
+		inline Vec3p FurthestPoint(const ShapeCapsule& capsule, const Vec3p& direction, const ShapeTransform& transform)
+		{
+			const Vec3p axis = transform.rotation * Vec3p(0.0f, capsule.halfHeight * transform.scale.y, 0.0f);
+			const Vec3p center = Dot(axis, direction) >= 0.0f ? transform.position + axis : transform.position - axis;
+			return center + direction.Normalized() * (capsule.radius * Max(transform.scale.x, transform.scale.z));
+		}
+
+		inline Vec3p FurthestPoint(const ShapeHull& hull, const Vec3p& direction, const ShapeTransform& transform)
+		{
+			const HullData& hullData = *hull.pHullData;
+			const uInt32 index = hullData.SupportIndex(transform.ToLocalDirection(direction));
+			return transform.ToWorldPoint(hullData.GetVertices()[index]);
+		}
+
 		template<typename... Transforms>
 		Vec3p FurthestPoint(const ShapeMesh& mesh, const Vec3p& direction, const Transforms&... transforms)
 		{
 			return Vec3p::ZERO;
 		}
 
+		inline Vec3p FurthestPoint(const ShapeTriangle& triangle, const Vec3p& direction, const Vec3p& offset)
+		{
+			const floatp dist0 = Dot(triangle.points[0], direction);
+			const floatp dist1 = Dot(triangle.points[1], direction);
+			const floatp dist2 = Dot(triangle.points[2], direction);
+
+			if (dist0 >= dist1 && dist0 >= dist2)
+			{
+				return triangle.points[0] + offset;
+			}
+
+			return (dist1 >= dist2 ? triangle.points[1] : triangle.points[2]) + offset;
+		}
+
 		template<typename... Transforms>
 		Simplex FurthestSimplex(const ShapeSphere& sphere, const Vec3p& direction, const Transforms&... transforms)
 		{
@@ -238,6 +348,27 @@ namespace Quartz
 			return Simplex();
 		}
 
+		inline Simplex FurthestSimplex(const ShapeSphere& sphere, const Vec3p& direction, const ShapeTransform& transform)
+		{
+			Simplex simplex;
+			simplex.Push(FurthestPoint(sphere, direction, transform));
+			return simplex;
+		}
+
+		inline Simplex FurthestSimplex(const ShapeCapsule& capsule, const Vec3p& direction, const ShapeTransform& transform)
+		{
+			Simplex simplex;
+			simplex.Push(FurthestPoint(capsule, direction, transform));
+			return simplex;
+		}
+
+		inline Simplex FurthestSimplex(const ShapeHull& hull, const Vec3p& direction, const ShapeTransform& transform)
+		{
+			Simplex simplex;
+			simplex.Push(FurthestPoint(hull, direction, transform));
+			return simplex;
+		}
+
 		template<typename... Transforms>
 		Simplex FurthestSimplex(const ShapeMesh& mesh, const Vec3p& direction, const Transforms&... transforms)
 		{
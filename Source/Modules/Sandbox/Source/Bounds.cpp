@@ -0,0 +1,124 @@
+#include "Physics.h"
+#include <float.h>
+
+namespace Quartz
+{
+	/* Bounds of the 8 corners of a local box */
+	static void TransformedBox(const Vec3p& localMin, const Vec3p& localMax, const ShapeTransform& transform, 
+		Vec3p& outMin, Vec3p& outMax)
+	{
+		outMin = Vec3p(FLT_MAX);
+		outMax = Vec3p(-FLT_MAX);
+
+		for (uSize i = 0; i < 8; i++)
+		{
+			const Vec3p corner(
+				(i & 1) ? localMax.x : localMin.x,
+				(i & 2) ? localMax.y : localMin.y,
+				(i & 4) ? localMax.z : localMin.z);
+
+			const Vec3p point = transform.ToWorldPoint(corner);
+
+			outMin = Vec3p(Min(outMin.x, point.x), Min(outMin.y, point.y), Min(outMin.z, point.z));
+			outMax = Vec3p(Max(outMax.x, point.x), Max(outMax.y, point.y), Max(outMax.z, point.z));
+		}
+	}
+
+	void Physics::CalcBoundsSphere(const SphereCollider& sphere, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		const floatp radius = sphere.GetSphere().radius * transform.scale.Maximum();
+
+		outMin = Vec3p(transform.position) - Vec3p(radius);
+		outMax = Vec3p(transform.position) + Vec3p(radius);
+	}
+
+	void Physics::CalcBoundsPlane(const PlaneCollider& plane, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		// Planes are infinite
+		outMin = Vec3p(-FLT_MAX);
+		outMax = Vec3p(FLT_MAX);
+	}
+
+	void Physics::CalcBoundsRect(const RectCollider& rect, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		const ShapeTransform transform0(transform, rect.GetRect().bounds);
+
+		TransformedBox(Vec3p(-1.0f), Vec3p(1.0f), transform0, outMin, outMax);
+	}
+
+	void Physics::CalcBoundsCapsule(const CapsuleCollider& capsule, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		const Vec3p axis = Quatp(transform.rotation) * Vec3p(0.0f, capsule.GetCapsule().halfHeight * transform.scale.y, 0.0f);
+		const floatp radius = capsule.GetCapsule().radius * Max(transform.scale.x, transform.scale.z);
+		const Vec3p extent(Abs(axis.x) + radius, Abs(axis.y) + radius, Abs(axis.z) + radius);
+
+		outMin = Vec3p(transform.position) - extent;
+		outMax = Vec3p(transform.position) + extent;
+	}
+
+	void Physics::CalcBoundsHull(const HullCollider& hull, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		const ShapeTransform transform0(transform);
+		const ShapeHull& shape = hull.GetHull();
+
+		outMin = Vec3p(
+			ShapeUtils::FurthestPoint(shape, -Vec3p::X_AXIS, transform0).x,
+			ShapeUtils::FurthestPoint(shape, -Vec3p::Y_AXIS, transform0).y,
+			ShapeUtils::FurthestPoint(shape, -Vec3p::Z_AXIS, transform0).z);
+
+		outMax = Vec3p(
+			ShapeUtils::FurthestPoint(shape, Vec3p::X_AXIS, transform0).x,
+			ShapeUtils::FurthestPoint(shape, Vec3p::Y_AXIS, transform0).y,
+			ShapeUtils::FurthestPoint(shape, Vec3p::Z_AXIS, transform0).z);
+	}
+
+	void Physics::CalcBoundsMesh(const MeshCollider& mesh, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		Vec3f localMin;
+		Vec3f localMax;
+
+		if (!mesh.GetMesh().pMesh->GetBounds(localMin, localMax))
+		{
+			// Empty meshes never overlap anything
+			outMin = Vec3p(FLT_MAX);
+			outMax = Vec3p(-FLT_MAX);
+			return;
+		}
+
+		TransformedBox(localMin, localMax, ShapeTransform(transform), outMin, outMax);
+	}
+
+	void Physics::CalcBoundsCompound(const CompoundCollider& compound, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		Vec3p localMin;
+		Vec3p localMax;
+
+		if (!compound.GetCompound().pCompound->GetBounds(localMin, localMax))
+		{
+			// Unbuilt compounds never overlap anything
+			outMin = Vec3p(FLT_MAX);
+			outMax = Vec3p(-FLT_MAX);
+			return;
+		}
+
+		TransformedBox(localMin, localMax, ShapeTransform(transform), outMin, outMax);
+	}
+
+	void Physics::CalcBounds(const Collider& collider, const Transform& transform, Vec3p& outMin, Vec3p& outMax)
+	{
+		using CalcBoundsFunc = void(*)(const Collider& collider, const Transform& transform, Vec3p& outMin, Vec3p& outMax);
+
+		static CalcBoundsFunc functionTable[7]
+		{
+			(CalcBoundsFunc) CalcBoundsSphere,
+			(CalcBoundsFunc) CalcBoundsPlane,
+			(CalcBoundsFunc) CalcBoundsRect,
+			(CalcBoundsFunc) CalcBoundsCapsule,
+			(CalcBoundsFunc) CalcBoundsHull,
+			(CalcBoundsFunc) CalcBoundsMesh,
+			(CalcBoundsFunc) CalcBoundsCompound
+		};
+
+		functionTable[(uSize)collider.GetShapeType()](collider, transform, outMin, outMax);
+	}
+}
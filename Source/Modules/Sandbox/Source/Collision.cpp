@@ -4,10 +4,14 @@
 namespace Quartz
 {
 	Contact::Contact() :
-		point(), depth(), normal() {}
+		point(), depth(), normal(), 
+		normalMass(0), tangentMass{}, velocityBias(0), 
+		normalImpulse(0), tangentImpulse{} {}
 
 	Contact::Contact(const Vec3p& point, floatp depth, const Vec3p& normal) :
-		point(point), depth(depth), normal(normal) { }
+		point(point), depth(depth), normal(normal), 
+		normalMass(0), tangentMass{}, velocityBias(0),
+		normalImpulse(0), tangentImpulse{} { }
 
 	Contact& Contact::Flip()
 	{
@@ -21,43 +25,6 @@ namespace Quartz
 		localPoint1 = point - position1;
 	}
 
-	void Contact::CalcContactVelocity(const Vec3p& lastAccel0, const Vec3p& lastAccel1, 
-		const Vec3p& angularVel0, const Vec3p& angularVel1, const Vec3p& linearVel0, const Vec3p& linearVel1, double stepTime)
-	{
-		const Vec3p velocity0 = Cross(angularVel0, localPoint0) + linearVel0;
-		const Vec3p velocity1 = Cross(angularVel1, localPoint1) + linearVel1;
-
-		Vec3p contactVelocity0 = invContactBasis.Transposed() * velocity0; // Move basis down
-		Vec3p contactVelocity1 = invContactBasis.Transposed() * velocity1;
-
-		Vec3p accelVelocity0 = invContactBasis.Transposed() * (lastAccel0 * stepTime);
-		Vec3p accelVelocity1 = invContactBasis.Transposed() * (lastAccel1 * stepTime);
-
-		accelVelocity0.x = 0.0f;
-		accelVelocity1.x = 0.0f;
-
-		contactVelocity0 += accelVelocity0;
-		contactVelocity1 += accelVelocity1;
-
-		contactVelocity = contactVelocity0 - contactVelocity1;
-	}
-
-	void Contact::CalcTargetVelocity(const Vec3p& lastAccel0, const Vec3p& lastAccel1, floatp restitution0, floatp restitution1, double stepTime)
-	{
-		const floatp accelVelocity0 = Dot(lastAccel0 * stepTime, normal);
-		const floatp accelVelocity1 = Dot(lastAccel1 * stepTime, normal);
-		const floatp accelVelocity = accelVelocity0 - accelVelocity1;
-
-		floatp restitution = Min(restitution0, restitution1);
-
-		if (Abs(contactVelocity.x) < 0.25f) // Velocity limit
-		{
-			restitution = 0.0f;
-		}
-
-		targetVelocity = -contactVelocity.x - restitution * (contactVelocity.x - accelVelocity);
-	}
-
 	void Contact::CalcContactBasis()
 	{
 		Vec3p tangentZ;
@@ -88,7 +55,21 @@ namespace Quartz
 			tangentY.z = normal.x * tangentZ.y;
 		}
 
-		invContactBasis = Mat3p().SetRows(normal, tangentZ, tangentY);
+		tangents[0] = tangentZ;
+		tangents[1] = tangentY;
+	}
+
+	void Contact::CalcAnchors(const Transform& transform0, const Transform& transform1)
+	{
+		const Mat3p invRotation0 = Mat3p().SetRotation(Quatp(transform0.rotation)).Transposed();
+		const Mat3p invRotation1 = Mat3p().SetRotation(Quatp(transform1.rotation)).Transposed();
+
+		// The normal points into body 0, so its deepest point lies behind the contact point
+		const Vec3p surfacePoint0 = point - normal * (depth * 0.5f);
+		const Vec3p surfacePoint1 = point + normal * (depth * 0.5f);
+
+		localAnchor0 = invRotation0 * (surfacePoint0 - Vec3p(transform0.position));
+		localAnchor1 = invRotation1 * (surfacePoint1 - Vec3p(transform1.position));
 	}
 
 	Collision::Collision() : count(0) {}
@@ -110,4 +91,236 @@ namespace Quartz
 
 		return *this;
 	}
+
+	void Collision::CalcAnchors(const Transform& transform0, const Transform& transform1)
+	{
+		for (uSize i = 0; i < count; i++)
+		{
+			contacts[i].CalcAnchors(transform0, transform1);
+		}
+	}
+
+	void Collision::Refresh(const Transform& transform0, const Transform& transform1)
+	{
+		constexpr floatp breakDistSquared = PHYSICS_MANIFOLD_BREAK_DISTANCE * PHYSICS_MANIFOLD_BREAK_DISTANCE;
+
+		const Mat3p rotation0 = Mat3p().SetRotation(Quatp(transform0.rotation));
+		const Mat3p rotation1 = Mat3p().SetRotation(Quatp(transform1.rotation));
+
+		uSize kept = 0;
+
+		for (uSize i = 0; i < count; i++)
+		{
+			Contact& contact = contacts[i];
+
+			const Vec3p surfacePoint0 = Vec3p(transform0.position) + rotation0 * contact.localAnchor0;
+			const Vec3p surfacePoint1 = Vec3p(transform1.position) + rotation1 * contact.localAnchor1;
+			const Vec3p offset = surfacePoint1 - surfacePoint0;
+
+			const floatp depth = Dot(offset, contact.normal);
+			const Vec3p drift = offset - contact.normal * depth;
+
+			if (depth < -PHYSICS_MANIFOLD_BREAK_DISTANCE || Dot(drift, drift) > breakDistSquared)
+			{
+				continue; // Broken
+			}
+
+			contact.point = (surfacePoint0 + surfacePoint1) * 0.5f;
+			contact.depth = depth;
+
+			contacts[kept++] = contact;
+		}
+
+		count = kept;
+	}
+
+	/* Picks a deepest, b furthest from a, then the points furthest either side of ab */
+	static uSize ReduceContacts(const Contact* pContacts, uSize count, Contact* pOutContacts)
+	{
+		if (count <= PHYSICS_MANIFOLD_POINTS)
+		{
+			for (uSize i = 0; i < count; i++)
+			{
+				pOutContacts[i] = pContacts[i];
+			}
+
+			return count;
+		}
+
+		const Vec3p& normal = pContacts[0].normal;
+
+		uSize a = 0;
+
+		for (uSize i = 1; i < count; i++)
+		{
+			if (pContacts[i].depth > pContacts[a].depth)
+			{
+				a = i;
+			}
+		}
+
+		uSize b = a;
+		floatp maxDistSquared = -1.0f;
+
+		for (uSize i = 0; i < count; i++)
+		{
+			const Vec3p diff = pContacts[i].point - pContacts[a].point;
+			const floatp distSquared = Dot(diff, diff);
+
+			if (i != a && distSquared > maxDistSquared)
+			{
+				maxDistSquared = distSquared;
+				b = i;
+			}
+		}
+
+		uSize c = a;
+		uSize d = a;
+		floatp maxArea = 0.0f;
+		floatp minArea = 0.0f;
+
+		const Vec3p edge = pContacts[b].point - pContacts[a].point;
+
+		for (uSize i = 0; i < count; i++)
+		{
+			if (i == a || i == b)
+			{
+				continue;
+			}
+
+			// Signed area about the normal, the two extremes lie on opposite sides of ab
+			const floatp area = Dot(Cross(edge, pContacts[i].point - pContacts[a].point), normal);
+
+			if (area > maxArea)
+			{
+				maxArea = area;
+				c = i;
+			}
+
+			if (area < minArea)
+			{
+				minArea = area;
+				d = i;
+			}
+		}
+
+		uSize outCount = 0;
+		pOutContacts[outCount++] = pContacts[a];
+		pOutContacts[outCount++] = pContacts[b];
+
+		if (c != a)
+		{
+			pOutContacts[outCount++] = pContacts[c];
+		}
+
+		if (d != a)
+		{
+			pOutContacts[outCount++] = pContacts[d];
+		}
+
+		return outCount;
+	}
+
+	void Collision::Merge(const Collision& collision)
+	{
+		constexpr floatp matchDistSquared = PHYSICS_MANIFOLD_MATCH_DISTANCE * PHYSICS_MANIFOLD_MATCH_DISTANCE;
+
+		Contact merged[PHYSICS_MAX_CONTACT_POINTS + PHYSICS_MANIFOLD_POINTS];
+		bool matched[PHYSICS_MAX_CONTACT_POINTS] = {};
+		uSize mergedCount = 0;
+
+		/* New contacts inherit the accumulated impulses of an old contact, closest pairs first, each old contact once */
+
+		uSize matches[PHYSICS_MAX_CONTACT_POINTS];
+
+		for (uSize i = 0; i < collision.count; i++)
+		{
+			matches[i] = count;
+		}
+
+		while (true)
+		{
+			floatp closestDistSquared = matchDistSquared;
+			uSize closestNew = collision.count;
+			uSize closestOld = count;
+
+			for (uSize i = 0; i < collision.count; i++)
+			{
+				if (matches[i] != count)
+				{
+					continue;
+				}
+
+				for (uSize j = 0; j < count; j++)
+				{
+					if (matched[j])
+					{
+						continue;
+					}
+
+					const Vec3p diff = collision.contacts[i].point - contacts[j].point;
+					const floatp distSquared = Dot(diff, diff);
+
+					if (distSquared < closestDistSquared)
+					{
+						closestDistSquared = distSquared;
+						closestNew = i;
+						closestOld = j;
+					}
+				}
+			}
+
+			if (closestNew == collision.count)
+			{
+				break;
+			}
+
+			matches[closestNew] = closestOld;
+			matched[closestOld] = true;
+		}
+
+		for (uSize i = 0; i < collision.count; i++)
+		{
+			Contact contact = collision.contacts[i];
+
+			if (matches[i] != count)
+			{
+				contact.normalImpulse		= contacts[matches[i]].normalImpulse;
+				contact.tangentImpulse[0]	= contacts[matches[i]].tangentImpulse[0];
+				contact.tangentImpulse[1]	= contacts[matches[i]].tangentImpulse[1];
+			}
+
+			merged[mergedCount++] = contact;
+		}
+
+		/* Unmatched old contacts survive while the normal holds, this builds up single point manifolds */
+
+		if (collision.count > 0)
+		{
+			for (uSize j = 0; j < count; j++)
+			{
+				if (!matched[j] && Dot(contacts[j].normal, collision.contacts[0].normal) > PHYSICS_MANIFOLD_NORMAL_ANGLE)
+				{
+					merged[mergedCount] = contacts[j];
+					merged[mergedCount].normal = collision.contacts[0].normal;
+					mergedCount++;
+				}
+			}
+		}
+
+		count = ReduceContacts(merged, mergedCount, contacts);
+	}
+
+	void Collision::Reduce()
+	{
+		Contact reduced[PHYSICS_MANIFOLD_POINTS];
+		const uSize reducedCount = ReduceContacts(contacts, count, reduced);
+
+		for (uSize i = 0; i < reducedCount; i++)
+		{
+			contacts[i] = reduced[i];
+		}
+
+		count = reducedCount;
+	}
 }
\ No newline at end of file
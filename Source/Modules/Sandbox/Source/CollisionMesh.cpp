@@ -0,0 +1,443 @@
+#include "CollisionMesh.h"
+#include "Resource/Assets/Model.h"
+#include "Log.h"
+#include "Utility/Swap.h"
+
+#include <algorithm>
+#include <float.h>
+
+namespace Quartz
+{
+	static float Axis(const Vec3f& vector, uSize axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	uInt32 CollisionMesh::BuildNode(Array<uInt32>& triangles, const Array<Vec3f>& centroids,
+		uInt32 firstTriangle, uInt32 triangleCount, uSize depth)
+	{
+		const uInt32 nodeIndex = mNodes.Size();
+
+		MeshBVHNode node;
+		node.min[0] = node.min[1] = node.min[2] = FLT_MAX;
+		node.max[0] = node.max[1] = node.max[2] = -FLT_MAX;
+
+		float centroidMin[3] = { FLT_MAX, FLT_MAX, FLT_MAX };
+		float centroidMax[3] = { -FLT_MAX, -FLT_MAX, -FLT_MAX };
+
+		for (uInt32 i = firstTriangle; i < firstTriangle + triangleCount; i++)
+		{
+			const uInt32 triangle = triangles[i];
+
+			for (uSize v = 0; v < 3; v++)
+			{
+				const Vec3f& vertex = mVertices[mIndices[triangle * 3 + v]];
+
+				for (uSize axis = 0; axis < 3; axis++)
+				{
+					node.min[axis] = Min(node.min[axis], Axis(vertex, axis));
+					node.max[axis] = Max(node.max[axis], Axis(vertex, axis));
+				}
+			}
+
+			for (uSize axis = 0; axis < 3; axis++)
+			{
+				centroidMin[axis] = Min(centroidMin[axis], Axis(centroids[triangle], axis));
+				centroidMax[axis] = Max(centroidMax[axis], Axis(centroids[triangle], axis));
+			}
+		}
+
+		mNodes.PushBack(node);
+
+		if (triangleCount <= PHYSICS_MESH_LEAF_TRIANGLES || depth >= PHYSICS_MESH_MAX_DEPTH - 1)
+		{
+			mNodes[nodeIndex].firstTriangle = firstTriangle;
+			mNodes[nodeIndex].triangleCount = triangleCount;
+			return nodeIndex;
+		}
+
+		/* Median split along the widest centroid axis */
+
+		uSize splitAxis = 0;
+
+		for (uSize axis = 1; axis < 3; axis++)
+		{
+			if (centroidMax[axis] - centroidMin[axis] > centroidMax[splitAxis] - centroidMin[splitAxis])
+			{
+				splitAxis = axis;
+			}
+		}
+
+		const uInt32 leftCount = triangleCount / 2;
+		uInt32* pFirst = triangles.Data() + firstTriangle;
+
+		std::nth_element(pFirst, pFirst + leftCount, pFirst + triangleCount,
+			[&](uInt32 triangle0, uInt32 triangle1)
+			{
+				return Axis(centroids[triangle0], splitAxis) < Axis(centroids[triangle1], splitAxis);
+			});
+
+		BuildNode(triangles, centroids, firstTriangle, leftCount, depth + 1);
+		const uInt32 rightIndex = BuildNode(triangles, centroids, firstTriangle + leftCount, triangleCount - leftCount, depth + 1);
+
+		mNodes[nodeIndex].firstTriangle = rightIndex;
+		mNodes[nodeIndex].triangleCount = 0;
+
+		return nodeIndex;
+	}
+
+	bool CollisionMesh::Build(const Vec3f* pVertices, uSize vertexCount, const uInt32* pIndices, uSize indexCount)
+	{
+		mVertices.Clear();
+		mIndices.Clear();
+		mNodes.Clear();
+
+		if (indexCount < 3 || indexCount % 3 != 0)
+		{
+			LogError("Failed to build collision mesh: index count (%d) is not a multiple of 3.", (int)indexCount);
+			return false;
+		}
+
+		mVertices.Resize(vertexCount);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			mVertices[i] = pVertices[i];
+		}
+
+		const uInt32 triangleCount = indexCount / 3;
+
+		Array<uInt32> triangles;
+		Array<Vec3f> centroids;
+		triangles.Resize(triangleCount);
+		centroids.Resize(triangleCount);
+		mIndices.Resize(indexCount);
+
+		for (uInt32 t = 0; t < triangleCount; t++)
+		{
+			for (uSize v = 0; v < 3; v++)
+			{
+				if (pIndices[t * 3 + v] >= vertexCount)
+				{
+					LogError("Failed to build collision mesh: index %d is out of range.", (int)pIndices[t * 3 + v]);
+					return false;
+				}
+
+				mIndices[t * 3 + v] = pIndices[t * 3 + v];
+			}
+
+			triangles[t] = t;
+			centroids[t] = (mVertices[mIndices[t * 3]] + mVertices[mIndices[t * 3 + 1]] + mVertices[mIndices[t * 3 + 2]]) * (1.0f / 3.0f);
+		}
+
+		mNodes.Reserve(2 * (triangleCount / PHYSICS_MESH_LEAF_TRIANGLES + 1));
+		BuildNode(triangles, centroids, 0, triangleCount, 0);
+
+		/* Reorder triangles to match the leaves */
+
+		Array<uInt32> sortedIndices;
+		sortedIndices.Resize(indexCount);
+
+		for (uInt32 t = 0; t < triangleCount; t++)
+		{
+			sortedIndices[t * 3 + 0] = mIndices[triangles[t] * 3 + 0];
+			sortedIndices[t * 3 + 1] = mIndices[triangles[t] * 3 + 1];
+			sortedIndices[t * 3 + 2] = mIndices[triangles[t] * 3 + 2];
+		}
+
+		Swap(mIndices, sortedIndices);
+
+		return true;
+	}
+
+	bool CollisionMesh::Build(const Model& model)
+	{
+		const VertexStream* pPositionStream = nullptr;
+		const VertexElement* pPositionElement = nullptr;
+
+		for (const VertexStream& stream : model.vertexStreams)
+		{
+			for (const VertexElement& element : stream.vertexElements)
+			{
+				if (element.attribute == VERTEX_ATTRIBUTE_POSITION && 
+					(element.format == VERTEX_FORMAT_FLOAT3 || element.format == VERTEX_FORMAT_UNORM16_4))
+				{
+					pPositionStream = &stream;
+					pPositionElement = &element;
+				}
+			}
+		}
+
+		if (!pPositionStream || !model.indexStream.HasData())
+		{
+			LogError("Failed to build collision mesh: model has no FLOAT3 or UNORM16_4 position stream or no indices.");
+			return false;
+		}
+
+		const uInt8* pVertexData = pPositionStream->GetData();
+		const uSize vertexCount = pPositionStream->GetSizeBytes() / pPositionStream->strideBytes;
+
+		Array<Vec3f> positions;
+		positions.Resize(vertexCount);
+
+		// Quantized positions are fractions of the model bounds
+		const Vec3f boundsMin = model.bounds.min;
+		const Vec3f boundsExtent = (model.bounds.max - model.bounds.min) * (1.0f / 65535.0f);
+
+		for (uSize i = 0; i < vertexCount; i++)
+		{
+			const uInt8* pVertex = pVertexData + i * pPositionStream->strideBytes + pPositionElement->offsetBytes;
+
+			if (pPositionElement->format == VERTEX_FORMAT_UNORM16_4)
+			{
+				const uInt16* pPosition = (const uInt16*)pVertex;
+				positions[i] = Vec3f(
+					boundsMin.x + pPosition[0] * boundsExtent.x,
+					boundsMin.y + pPosition[1] * boundsExtent.y,
+					boundsMin.z + pPosition[2] * boundsExtent.z);
+			}
+			else
+			{
+				const float* pPosition = (const float*)pVertex;
+				positions[i] = Vec3f(pPosition[0], pPosition[1], pPosition[2]);
+			}
+		}
+
+		const IndexStream& indexStream = model.indexStream;
+		const uInt8* pIndexData = indexStream.GetData();
+
+		Array<uInt32> indices;
+
+		// Coarser LODs share the index stream, only full detail meshes are collided with
+		for (const Mesh& mesh : model.meshes)
+		{
+			if (mesh.lod != 0)
+			{
+				continue;
+			}
+
+			if ((uSize)mesh.indexStart + mesh.indexCount > indexStream.indexCount)
+			{
+				LogError("Failed to build collision mesh: mesh [%s] indices are outside the index stream.", mesh.name.Str());
+				return false;
+			}
+
+			for (uSize i = mesh.indexStart; i < (uSize)mesh.indexStart + mesh.indexCount; i++)
+			{
+				switch (indexStream.indexElement.format)
+				{
+					case INDEX_FORMAT_UINT8:	indices.PushBack(pIndexData[i]); break;
+					case INDEX_FORMAT_UINT16:	indices.PushBack(((const uInt16*)pIndexData)[i]); break;
+					case INDEX_FORMAT_UINT32:	indices.PushBack(((const uInt32*)pIndexData)[i]); break;
+					default:
+					{
+						LogError("Failed to build collision mesh: invalid index format.");
+						return false;
+					}
+				}
+			}
+		}
+
+		return Build(positions.Data(), positions.Size(), indices.Data(), indices.Size());
+	}
+
+	uSize CollisionMesh::QueryBounds(const Vec3f& min, const Vec3f& max, uInt32* pOutTriangles, uSize maxTriangles, bool* pOutTruncated) const
+	{
+		if (pOutTruncated)
+		{
+			*pOutTruncated = false;
+		}
+
+		if (mNodes.Size() == 0)
+		{
+			return 0;
+		}
+
+		uInt32 stack[PHYSICS_MESH_MAX_DEPTH + 1];
+		uSize stackSize = 0;
+		uSize count = 0;
+
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const MeshBVHNode& node = mNodes[stack[--stackSize]];
+
+			if (node.min[0] > max.x || node.max[0] < min.x ||
+				node.min[1] > max.y || node.max[1] < min.y ||
+				node.min[2] > max.z || node.max[2] < min.z)
+			{
+				continue;
+			}
+
+			if (node.triangleCount > 0)
+			{
+				for (uInt32 t = node.firstTriangle; t < node.firstTriangle + node.triangleCount; t++)
+				{
+					if (count == maxTriangles)
+					{
+						if (pOutTruncated)
+						{
+							*pOutTruncated = true;
+						}
+
+						return count;
+					}
+
+					pOutTriangles[count++] = t;
+				}
+
+				continue;
+			}
+
+			const uInt32 nodeIndex = (uInt32)(&node - mNodes.Data());
+
+			stack[stackSize++] = node.firstTriangle;	// Right
+			stack[stackSize++] = nodeIndex + 1;			// Left
+		}
+
+		return count;
+	}
+	/* Slab test of a ray against a node, returns the entry distance or FLT_MAX if it misses */
+	static floatp RayNode(const MeshBVHNode& node, const Vec3p& origin, const Vec3p& invDirection, floatp maxDistance)
+	{
+		const floatp originAxes[3]	= { origin.x, origin.y, origin.z };
+		const floatp invAxes[3]		= { invDirection.x, invDirection.y, invDirection.z };
+
+		floatp enter	= 0.0f;
+		floatp exit		= maxDistance;
+
+		for (uSize axis = 0; axis < 3; axis++)
+		{
+			floatp t0 = (node.min[axis] - originAxes[axis]) * invAxes[axis];
+			floatp t1 = (node.max[axis] - originAxes[axis]) * invAxes[axis];
+
+			if (t0 > t1)
+			{
+				Swap(t0, t1);
+			}
+
+			enter	= Max(enter, t0);
+			exit	= Min(exit, t1);
+
+			if (enter > exit)
+			{
+				return FLT_MAX;
+			}
+		}
+
+		return enter;
+	}
+
+	/* Moller-Trumbore, both sides of the triangle are hit */
+	static bool RayTriangle(const Vec3p& origin, const Vec3p& direction, 
+		const Vec3p& a, const Vec3p& b, const Vec3p& c, floatp& outDistance)
+	{
+		const Vec3p edge0 = b - a;
+		const Vec3p edge1 = c - a;
+		const Vec3p p = Cross(direction, edge1);
+		const floatp det = Dot(edge0, p);
+
+		if (Abs(det) < 1e-12f)
+		{
+			return false; // Parallel
+		}
+
+		const floatp invDet = 1.0f / det;
+		const Vec3p s = origin - a;
+		const floatp u = Dot(s, p) * invDet;
+
+		if (u < 0.0f || u > 1.0f)
+		{
+			return false;
+		}
+
+		const Vec3p q = Cross(s, edge0);
+		const floatp v = Dot(direction, q) * invDet;
+
+		if (v < 0.0f || u + v > 1.0f)
+		{
+			return false;
+		}
+
+		outDistance = Dot(edge1, q) * invDet;
+
+		return outDistance >= 0.0f;
+	}
+
+	bool CollisionMesh::Raycast(const Vec3p& origin, const Vec3p& direction, floatp maxDistance, 
+		floatp& outDistance, uInt32& outTriangle) const
+	{
+		if (mNodes.Size() == 0)
+		{
+			return false;
+		}
+
+		// Zero components use a huge inverse instead of infinity, which would give NaN for origins on a slab
+		const Vec3p invDirection(
+			direction.x != 0.0f ? 1.0f / direction.x : FLT_MAX,
+			direction.y != 0.0f ? 1.0f / direction.y : FLT_MAX,
+			direction.z != 0.0f ? 1.0f / direction.z : FLT_MAX);
+
+		uInt32 stack[PHYSICS_MESH_MAX_DEPTH + 1];
+		uSize stackSize = 0;
+
+		floatp closest = maxDistance;
+		bool hit = false;
+
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const MeshBVHNode& node = mNodes[stack[--stackSize]];
+
+			if (RayNode(node, origin, invDirection, closest) == FLT_MAX)
+			{
+				continue;
+			}
+
+			if (node.triangleCount > 0)
+			{
+				for (uInt32 t = node.firstTriangle; t < node.firstTriangle + node.triangleCount; t++)
+				{
+					Vec3f a, b, c;
+					GetTriangle(t, a, b, c);
+
+					floatp distance;
+
+					if (RayTriangle(origin, direction, a, b, c, distance) && distance <= closest)
+					{
+						closest		= distance;
+						outTriangle	= t;
+						hit			= true;
+					}
+				}
+
+				continue;
+			}
+
+			const uInt32 nodeIndex	= (uInt32)(&node - mNodes.Data());
+			const uInt32 left		= nodeIndex + 1;
+			const uInt32 right		= node.firstTriangle;
+
+			// Visit the nearer child first so it can shorten the ray for the other
+			const floatp leftDistance	= RayNode(mNodes[left], origin, invDirection, closest);
+			const floatp rightDistance	= RayNode(mNodes[right], origin, invDirection, closest);
+
+			if (leftDistance <= rightDistance)
+			{
+				if (rightDistance != FLT_MAX) stack[stackSize++] = right;
+				if (leftDistance != FLT_MAX) stack[stackSize++] = left;
+			}
+			else
+			{
+				if (leftDistance != FLT_MAX) stack[stackSize++] = left;
+				if (rightDistance != FLT_MAX) stack[stackSize++] = right;
+			}
+		}
+
+		outDistance = closest;
+
+		return hit;
+	}
+}
@@ -1,9 +1,834 @@
 #include "CollisionDetection.h"
+#include "Compound.h"
 #include "GJK.h"
+#include "GJKBatch.h"
+#include "Types/Array.h"
+#include "Utility/Swap.h"
 #include <float.h>
 
+#define PHYSICS_CLIP_MAX_POINTS	64
+
 namespace Quartz
 {
+	static thread_local NarrowphaseStats threadNarrowphaseStats = {};
+
+	/* CollideBatch working memory, kept per thread so batches after the first allocate nothing */
+	struct BatchScratch
+	{
+		Array<uSize>			indices;
+		Array<Vec3p>			points;
+		Array<GJK::BatchPair>	pairs;
+		Array<Simplex>			simplices;
+		Array<bool>				results;
+	};
+
+	static thread_local BatchScratch threadBatchScratch;
+
+	/* Keeps the deepest contact, then repeatedly the one furthest from those already kept */
+	static void ReduceContacts(const Contact* pContacts, uSize count, Collision& outCollision)
+	{
+		Collision collision;
+
+		if (count <= PHYSICS_MAX_CONTACT_POINTS)
+		{
+			for (uSize i = 0; i < count; i++)
+			{
+				collision.AddContact(pContacts[i]);
+			}
+
+			outCollision = collision;
+			return;
+		}
+
+		bool used[PHYSICS_CLIP_MAX_POINTS] = {};
+		uSize deepest = 0;
+
+		for (uSize i = 1; i < count; i++)
+		{
+			if (pContacts[i].depth > pContacts[deepest].depth)
+			{
+				deepest = i;
+			}
+		}
+
+		collision.AddContact(pContacts[deepest]);
+		used[deepest] = true;
+
+		while (collision.count < PHYSICS_MAX_CONTACT_POINTS)
+		{
+			floatp bestDist = -1.0f;
+			uSize best = 0;
+
+			for (uSize i = 0; i < count; i++)
+			{
+				if (used[i])
+				{
+					continue;
+				}
+
+				floatp minDist = FLT_MAX;
+
+				for (uSize j = 0; j < collision.count; j++)
+				{
+					const Vec3p diff = pContacts[i].point - collision.contacts[j].point;
+					minDist = Min(minDist, Dot(diff, diff));
+				}
+
+				if (minDist > bestDist)
+				{
+					bestDist = minDist;
+					best = i;
+				}
+			}
+
+			collision.AddContact(pContacts[best]);
+			used[best] = true;
+		}
+
+		outCollision = collision;
+	}
+
+	static uSize WorldFace(const HullData& hull, const ShapeTransform& transform, uInt32 faceIndex, Vec3p* pOutPoints)
+	{
+		const HullFace& face = hull.GetFaces()[faceIndex];
+		const uSize count = Min((uSize)face.indexCount, (uSize)PHYSICS_CLIP_MAX_POINTS / 2);
+
+		for (uSize i = 0; i < count; i++)
+		{
+			pOutPoints[i] = transform.ToWorldPoint(hull.GetVertices()[hull.GetFaceIndices()[face.firstIndex + i]]);
+		}
+
+		return count;
+	}
+
+	static uInt32 WorldSupportFace(const HullData& hull, const ShapeTransform& transform, const Vec3p& direction, floatp& outAlignment)
+	{
+		uInt32 bestFace = 0;
+		outAlignment = -FLT_MAX;
+
+		for (uInt32 f = 0; f < hull.GetFaces().Size(); f++)
+		{
+			const floatp alignment = Dot(transform.ToWorldNormal(hull.GetFaces()[f].normal), direction);
+
+			if (alignment > outAlignment)
+			{
+				outAlignment = alignment;
+				bestFace = f;
+			}
+		}
+
+		return bestFace;
+	}
+
+	/*
+		Clips the incident polygon against the side planes of the reference polygon (wound
+		counter-clockwise about refNormal) and keeps the points below the reference plane.
+	*/
+	static uSize ClipPolygons(const Vec3p* pRefPoints, uSize refCount, const Vec3p& refNormal,
+		const Vec3p* pIncPoints, uSize incCount, const Vec3p& contactNormal, Contact* pOutContacts)
+	{
+		Vec3p clipBuffers[2][PHYSICS_CLIP_MAX_POINTS];
+		uSize clipCount = Min(incCount, (uSize)PHYSICS_CLIP_MAX_POINTS);
+		uSize current = 0;
+
+		for (uSize i = 0; i < clipCount; i++)
+		{
+			clipBuffers[0][i] = pIncPoints[i];
+		}
+
+		/* Sutherland-Hodgman against each reference edge */
+
+		for (uSize e = 0; e < refCount && clipCount > 0; e++)
+		{
+			const Vec3p& edge0 = pRefPoints[e];
+			const Vec3p& edge1 = pRefPoints[(e + 1) % refCount];
+			const Vec3p sideNormal = Cross(edge1 - edge0, refNormal);
+
+			const Vec3p* pInput = clipBuffers[current];
+			Vec3p* pOutput = clipBuffers[1 - current];
+			uSize outCount = 0;
+
+			for (uSize i = 0; i < clipCount; i++)
+			{
+				const Vec3p& point0 = pInput[i];
+				const Vec3p& point1 = pInput[(i + 1) % clipCount];
+				const floatp dist0 = Dot(sideNormal, point0 - edge0);
+				const floatp dist1 = Dot(sideNormal, point1 - edge0);
+
+				if (dist0 <= 0.0f && outCount < PHYSICS_CLIP_MAX_POINTS)
+				{
+					pOutput[outCount++] = point0;
+				}
+
+				if ((dist0 < 0.0f) != (dist1 < 0.0f) && outCount < PHYSICS_CLIP_MAX_POINTS)
+				{
+					const floatp t = dist0 / (dist0 - dist1);
+					pOutput[outCount++] = point0 + (point1 - point0) * t;
+				}
+			}
+
+			clipCount = outCount;
+			current = 1 - current;
+		}
+
+		/* Keep the points below the reference plane */
+
+		uSize contactCount = 0;
+
+		for (uSize i = 0; i < clipCount; i++)
+		{
+			const Vec3p& point = clipBuffers[current][i];
+			const floatp depth = Dot(refNormal, pRefPoints[0] - point);
+
+			if (depth >= 0.0f)
+			{
+				pOutContacts[contactCount++] = Contact(point + refNormal * (depth * 0.5f), depth, contactNormal);
+			}
+		}
+
+		return contactCount;
+	}
+
+	/* The reference face belongs to the hull whose face is best aligned with the normal */
+	static bool ClipHullFaces(const HullData& hull0, const ShapeTransform& transform0,
+		const HullData& hull1, const ShapeTransform& transform1, const Vec3p& normal, Collision& outCollision)
+	{
+		floatp alignment0;
+		floatp alignment1;
+		const uInt32 face0 = WorldSupportFace(hull0, transform0, -normal, alignment0);
+		const uInt32 face1 = WorldSupportFace(hull1, transform1, normal, alignment1);
+
+		const bool referenceIs1 = alignment1 >= alignment0;
+
+		const HullData& refHull				= referenceIs1 ? hull1 : hull0;
+		const ShapeTransform& refTransform	= referenceIs1 ? transform1 : transform0;
+		const HullData& incHull				= referenceIs1 ? hull0 : hull1;
+		const ShapeTransform& incTransform	= referenceIs1 ? transform0 : transform1;
+		const uInt32 refFace				= referenceIs1 ? face1 : face0;
+		const uInt32 incFace				= referenceIs1 ? face0 : face1;
+
+		Vec3p refPoints[PHYSICS_CLIP_MAX_POINTS];
+		Vec3p incPoints[PHYSICS_CLIP_MAX_POINTS];
+
+		const uSize refCount = WorldFace(refHull, refTransform, refFace, refPoints);
+		const uSize incCount = WorldFace(incHull, incTransform, incFace, incPoints);
+		const Vec3p refNormal = refTransform.ToWorldNormal(refHull.GetFaces()[refFace].normal);
+
+		Contact contacts[PHYSICS_CLIP_MAX_POINTS];
+		const uSize contactCount = ClipPolygons(refPoints, refCount, refNormal, incPoints, incCount, normal, contacts);
+
+		if (contactCount == 0)
+		{
+			return false;
+		}
+
+		ReduceContacts(contacts, contactCount, outCollision);
+
+		return true;
+	}
+
+	/* GJK/EPA for the normal and depth, then face clipping for the manifold */
+	static bool CollideConvexHulls(const HullData& hull0, const ShapeTransform& transform0,
+		const HullData& hull1, const ShapeTransform& transform1, const Simplex* pSimplex, Collision& outCollision)
+	{
+		const ShapeHull shape0 = { &hull0 };
+		const ShapeHull shape1 = { &hull1 };
+
+		Simplex simplex;
+
+		if (pSimplex)
+		{
+			simplex = *pSimplex;
+		}
+		else if (!GJK::GJK(shape0, transform0, shape1, transform1, simplex))
+		{
+			return false; // No Collision
+		}
+
+		Collision collision;
+
+		if (!GJK::EPA(shape0, transform0, shape1, transform1, simplex, collision))
+		{
+			return false; // No Collision
+		}
+
+		if (!ClipHullFaces(hull0, transform0, hull1, transform1, collision.contacts[0].normal, outCollision))
+		{
+			outCollision = collision;
+		}
+
+		return true;
+	}
+
+	/* Closest point on triangle abc to point p (Ericson, Real-Time Collision Detection 5.1.5) */
+	static Vec3p ClosestPointTriangle(const Vec3p& p, const Vec3p& a, const Vec3p& b, const Vec3p& c)
+	{
+		const Vec3p ab = b - a;
+		const Vec3p ac = c - a;
+		const Vec3p ap = p - a;
+
+		const floatp d1 = Dot(ab, ap);
+		const floatp d2 = Dot(ac, ap);
+		if (d1 <= 0.0f && d2 <= 0.0f) return a;
+
+		const Vec3p bp = p - b;
+		const floatp d3 = Dot(ab, bp);
+		const floatp d4 = Dot(ac, bp);
+		if (d3 >= 0.0f && d4 <= d3) return b;
+
+		const floatp vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f)
+		{
+			return a + ab * (d1 / (d1 - d3));
+		}
+
+		const Vec3p cp = p - c;
+		const floatp d5 = Dot(ab, cp);
+		const floatp d6 = Dot(ac, cp);
+		if (d6 >= 0.0f && d5 <= d6) return c;
+
+		const floatp vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f)
+		{
+			return a + ac * (d2 / (d2 - d6));
+		}
+
+		const floatp va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && (d4 - d3) >= 0.0f && (d5 - d6) >= 0.0f)
+		{
+			return b + (c - b) * ((d4 - d3) / ((d4 - d3) + (d5 - d6)));
+		}
+
+		const floatp denom = 1.0f / (va + vb + vc);
+		return a + ab * (vb * denom) + ac * (vc * denom);
+	}
+
+	/* Mesh triangles overlapping a world-space box */
+	static uSize QueryMeshTriangles(const CollisionMesh& mesh, const ShapeTransform& meshTransform,
+		const Vec3p& worldMin, const Vec3p& worldMax, uInt32* pOutTriangles)
+	{
+		Vec3p localMin = Vec3p(FLT_MAX);
+		Vec3p localMax = Vec3p(-FLT_MAX);
+
+		for (uSize i = 0; i < 8; i++)
+		{
+			const Vec3p corner(
+				(i & 1) ? worldMax.x : worldMin.x,
+				(i & 2) ? worldMax.y : worldMin.y,
+				(i & 4) ? worldMax.z : worldMin.z);
+
+			const Vec3p local = meshTransform.ToLocalPoint(corner);
+
+			localMin = Vec3p(Min(localMin.x, local.x), Min(localMin.y, local.y), Min(localMin.z, local.z));
+			localMax = Vec3p(Max(localMax.x, local.x), Max(localMax.y, local.y), Max(localMax.z, local.z));
+		}
+
+		bool truncated;
+		const uSize count = mesh.QueryBounds(Vec3f(localMin), Vec3f(localMax), pOutTriangles, PHYSICS_MESH_MAX_QUERY_TRIANGLES, &truncated);
+
+		if (truncated)
+		{
+			threadNarrowphaseStats.meshQueryOverflows++;
+		}
+
+		return count;
+	}
+
+	static ShapeTriangle WorldTriangle(const CollisionMesh& mesh, const ShapeTransform& meshTransform, uInt32 triangle)
+	{
+		Vec3f a, b, c;
+		mesh.GetTriangle(triangle, a, b, c);
+
+		return ShapeTriangle{ { meshTransform.ToWorldPoint(a), meshTransform.ToWorldPoint(b), meshTransform.ToWorldPoint(c) } };
+	}
+
+	/* Triangles sharing an edge or vertex report the same point, keep one */
+	static void AddUniqueContact(Contact* pContacts, uSize& count, const Contact& contact)
+	{
+		constexpr floatp minDistSquared = 1e-8f;
+
+		for (uSize i = 0; i < count; i++)
+		{
+			const Vec3p diff = pContacts[i].point - contact.point;
+
+			if (Dot(diff, diff) < minDistSquared)
+			{
+				if (contact.depth > pContacts[i].depth)
+				{
+					pContacts[i] = contact;
+				}
+
+				return;
+			}
+		}
+
+		if (count < PHYSICS_CLIP_MAX_POINTS)
+		{
+			pContacts[count++] = contact;
+		}
+	}
+
+	/* Hull against every nearby mesh triangle, the triangle face is used as the reference when possible */
+	static bool CollideHullMeshShapes(const HullData& hull0, const ShapeTransform& transform0,
+		const CollisionMesh& mesh1, const ShapeTransform& transform1, Collision& outCollision)
+	{
+		const ShapeHull shape0 = { &hull0 };
+
+		const Vec3p worldMin(
+			FurthestPoint(shape0, -Vec3p::X_AXIS, transform0).x,
+			FurthestPoint(shape0, -Vec3p::Y_AXIS, transform0).y,
+			FurthestPoint(shape0, -Vec3p::Z_AXIS, transform0).z);
+
+		const Vec3p worldMax(
+			FurthestPoint(shape0, Vec3p::X_AXIS, transform0).x,
+			FurthestPoint(shape0, Vec3p::Y_AXIS, transform0).y,
+			FurthestPoint(shape0, Vec3p::Z_AXIS, transform0).z);
+
+		uInt32 triangles[PHYSICS_MESH_MAX_QUERY_TRIANGLES];
+		const uSize triangleCount = QueryMeshTriangles(mesh1, transform1, worldMin, worldMax, triangles);
+
+		Contact contacts[PHYSICS_CLIP_MAX_POINTS];
+		uSize contactCount = 0;
+
+		for (uSize t = 0; t < triangleCount; t++)
+		{
+			const ShapeTriangle triangle = WorldTriangle(mesh1, transform1, triangles[t]);
+
+			Simplex simplex;
+			Collision collision;
+
+			if (!GJK::GJK(shape0, transform0, triangle, Vec3p::ZERO, simplex) ||
+				!GJK::EPA(shape0, transform0, triangle, Vec3p::ZERO, simplex, collision))
+			{
+				continue;
+			}
+
+			const Vec3p& normal = collision.contacts[0].normal;
+			Vec3p triangleNormal = Cross(triangle.points[1] - triangle.points[0], triangle.points[2] - triangle.points[0]).Normalized();
+
+			Vec3p refPoints[3] = { triangle.points[0], triangle.points[1], triangle.points[2] };
+
+			if (Dot(triangleNormal, normal) < 0.0f)
+			{
+				// Keep the reference winding counter-clockwise about its normal
+				triangleNormal = -triangleNormal;
+				Swap(refPoints[1], refPoints[2]);
+			}
+
+			uSize clipCount = 0;
+			Contact clipContacts[PHYSICS_CLIP_MAX_POINTS];
+
+			if (Dot(triangleNormal, normal) > 0.7f)
+			{
+				floatp alignment;
+				Vec3p incPoints[PHYSICS_CLIP_MAX_POINTS];
+
+				const uInt32 incFace = WorldSupportFace(hull0, transform0, -normal, alignment);
+				const uSize incCount = WorldFace(hull0, transform0, incFace, incPoints);
+
+				clipCount = ClipPolygons(refPoints, 3, triangleNormal, incPoints, incCount, normal, clipContacts);
+			}
+
+			if (clipCount == 0)
+			{
+				AddUniqueContact(contacts, contactCount, collision.contacts[0]);
+			}
+
+			for (uSize i = 0; i < clipCount; i++)
+			{
+				AddUniqueContact(contacts, contactCount, clipContacts[i]);
+			}
+		}
+
+		if (contactCount == 0)
+		{
+			return false; // No Collision
+		}
+
+		ReduceContacts(contacts, contactCount, outCollision);
+
+		return true;
+	}
+
+	/*
+		Sphere against a single mesh triangle. Edge and vertex contacts are kept apart so they are
+		only used when no face is touched, otherwise internal edges of flat regions push at an angle.
+	*/
+	static void AddSphereTriangleContact(const ShapeTriangle& triangle, const Vec3p& center, floatp radius,
+		Contact* pFaceContacts, uSize& faceCount, Contact* pFeatureContacts, uSize& featureCount)
+	{
+		const Vec3p closest = ClosestPointTriangle(center, triangle.points[0], triangle.points[1], triangle.points[2]);
+
+		Vec3p normal = center - closest; // Mesh to sphere
+		const floatp distSquared = Dot(normal, normal);
+
+		if (distSquared >= radius * radius)
+		{
+			return;
+		}
+
+		const floatp dist = sqrt(distSquared);
+		const Vec3p triangleNormal = Cross(triangle.points[1] - triangle.points[0], triangle.points[2] - triangle.points[0]).Normalized();
+
+		if (dist <= 0.0f)
+		{
+			// Centre lies on the triangle
+			AddUniqueContact(pFaceContacts, faceCount, Contact(closest, radius, triangleNormal));
+			return;
+		}
+
+		normal = normal * (1.0f / dist);
+
+		if (Abs(Dot(normal, triangleNormal)) > 0.9999f)
+		{
+			AddUniqueContact(pFaceContacts, faceCount, Contact(closest, radius - dist, normal));
+		}
+		else
+		{
+			AddUniqueContact(pFeatureContacts, featureCount, Contact(closest, radius - dist, normal));
+		}
+	}
+
+	/* Closest point on segment ab to point p */
+	static Vec3p ClosestPointSegment(const Vec3p& p, const Vec3p& a, const Vec3p& b)
+	{
+		const Vec3p ab = b - a;
+		const floatp lengthSquared = Dot(ab, ab);
+
+		if (lengthSquared <= 0.0f)
+		{
+			return a;
+		}
+
+		const floatp t = Clamp(Dot(p - a, ab) / lengthSquared, (floatp)0.0f, (floatp)1.0f);
+		return a + ab * t;
+	}
+
+	/* Closest points between segments p0q0 and p1q1 (Ericson, Real-Time Collision Detection 5.1.9) */
+	static void ClosestPointsSegments(const Vec3p& p0, const Vec3p& q0, const Vec3p& p1, const Vec3p& q1,
+		Vec3p& outPoint0, Vec3p& outPoint1)
+	{
+		constexpr floatp epsilon = 1e-12f;
+
+		const Vec3p d0 = q0 - p0;
+		const Vec3p d1 = q1 - p1;
+		const Vec3p r = p0 - p1;
+
+		const floatp a = Dot(d0, d0);
+		const floatp e = Dot(d1, d1);
+		const floatp f = Dot(d1, r);
+
+		floatp s = 0.0f;
+		floatp t = 0.0f;
+
+		if (a <= epsilon && e <= epsilon)
+		{
+			outPoint0 = p0;
+			outPoint1 = p1;
+			return;
+		}
+
+		if (a <= epsilon)
+		{
+			t = Clamp(f / e, (floatp)0.0f, (floatp)1.0f);
+		}
+		else
+		{
+			const floatp c = Dot(d0, r);
+
+			if (e <= epsilon)
+			{
+				s = Clamp(-c / a, (floatp)0.0f, (floatp)1.0f);
+			}
+			else
+			{
+				const floatp b = Dot(d0, d1);
+				const floatp denom = a * e - b * b;
+
+				// Parallel segments pick any s, here the start of the first segment
+				s = denom > epsilon ? Clamp((b * f - c * e) / denom, (floatp)0.0f, (floatp)1.0f) : 0.0f;
+				t = (b * s + f) / e;
+
+				if (t < 0.0f)
+				{
+					t = 0.0f;
+					s = Clamp(-c / a, (floatp)0.0f, (floatp)1.0f);
+				}
+				else if (t > 1.0f)
+				{
+					t = 1.0f;
+					s = Clamp((b - c) / a, (floatp)0.0f, (floatp)1.0f);
+				}
+			}
+		}
+
+		outPoint0 = p0 + d0 * s;
+		outPoint1 = p1 + d1 * t;
+	}
+
+	/* Any unit vector perpendicular to a unit vector */
+	static Vec3p Perpendicular(const Vec3p& vector)
+	{
+		if (Abs(vector.x) > 0.57f)
+		{
+			return Vec3p(vector.y, -vector.x, 0.0f).Normalized();
+		}
+
+		return Vec3p(0.0f, vector.z, -vector.y).Normalized();
+	}
+
+	/* World-space capsule segment and radius */
+	struct CapsuleSegment
+	{
+		Vec3p	point0;
+		Vec3p	point1;
+		floatp	radius;
+	};
+
+	static CapsuleSegment WorldCapsule(const ShapeCapsule& capsule, const Transform& transform)
+	{
+		const Vec3p axis = Quatp(transform.rotation) * Vec3p(0.0f, capsule.halfHeight * transform.scale.y, 0.0f);
+		const floatp radius = capsule.radius * Max(transform.scale.x, transform.scale.z);
+
+		return CapsuleSegment{ Vec3p(transform.position) - axis, Vec3p(transform.position) + axis, radius };
+	}
+
+	static inline floatp Component(const Vec3p& vector, uSize axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	/*
+		Parameter along segment ab of the closest point to a box centred at the origin. The squared
+		distance is piecewise quadratic between the points where the segment crosses a slab plane,
+		so each piece is minimized in closed form. Returns false if the segment enters the box.
+	*/
+	static bool ClosestSegmentBox(const Vec3p& a, const Vec3p& b, const Vec3p& halfExtents, floatp& outT)
+	{
+		const Vec3p d = b - a;
+
+		floatp breaks[8] = { 0.0f, 1.0f };
+		uSize breakCount = 2;
+
+		for (uSize i = 0; i < 3; i++)
+		{
+			if (Abs(Component(d, i)) <= 1e-12f)
+			{
+				continue;
+			}
+
+			const floatp tMin = (-Component(halfExtents, i) - Component(a, i)) / Component(d, i);
+			const floatp tMax = (Component(halfExtents, i) - Component(a, i)) / Component(d, i);
+
+			if (tMin > 0.0f && tMin < 1.0f) breaks[breakCount++] = tMin;
+			if (tMax > 0.0f && tMax < 1.0f) breaks[breakCount++] = tMax;
+		}
+
+		// Insertion sort, at most 8 values
+		for (uSize i = 1; i < breakCount; i++)
+		{
+			for (uSize j = i; j > 0 && breaks[j] < breaks[j - 1]; j--)
+			{
+				Swap(breaks[j], breaks[j - 1]);
+			}
+		}
+
+		floatp bestDistSquared = FLT_MAX;
+		floatp bestT = 0.0f;
+
+		for (uSize k = 0; k + 1 < breakCount; k++)
+		{
+			const floatp t0 = breaks[k];
+			const floatp t1 = breaks[k + 1];
+			const floatp tMid = (t0 + t1) * 0.5f;
+
+			floatp numerator = 0.0f;
+			floatp denominator = 0.0f;
+
+			for (uSize i = 0; i < 3; i++)
+			{
+				const floatp mid = Component(a, i) + Component(d, i) * tMid;
+
+				if (mid > Component(halfExtents, i) || mid < -Component(halfExtents, i))
+				{
+					// Clamped on this axis over the whole piece
+					const floatp bound = mid > Component(halfExtents, i) ? Component(halfExtents, i) : -Component(halfExtents, i);
+					numerator	+= Component(d, i) * (Component(a, i) - bound);
+					denominator	+= Component(d, i) * Component(d, i);
+				}
+			}
+
+			if (denominator <= 0.0f && numerator == 0.0f)
+			{
+				outT = tMid;
+				return false; // Inside the box
+			}
+
+			const floatp t = denominator > 0.0f ? Clamp(-numerator / denominator, t0, t1) : t0;
+			const Vec3p point = a + d * t;
+			const Vec3p offset = point - Vec3p(
+				Clamp(point.x, -halfExtents.x, halfExtents.x),
+				Clamp(point.y, -halfExtents.y, halfExtents.y),
+				Clamp(point.z, -halfExtents.z, halfExtents.z));
+			const floatp distSquared = Dot(offset, offset);
+
+			if (distSquared < bestDistSquared)
+			{
+				bestDistSquared = distSquared;
+				bestT = t;
+			}
+		}
+
+		outT = bestT;
+		return bestDistSquared > 0.0f;
+	}
+
+	/*
+		Contacts for the part of segment ab over a box face, in box space.
+		The face is on axis with the given sign, depths include the capsule radius.
+	*/
+	static uSize CapsuleBoxFaceContacts(const Vec3p& a, const Vec3p& b, floatp radius, const Vec3p& halfExtents,
+		uSize axis, floatp sign, Vec3p* pOutPoints, floatp* pOutDepths)
+	{
+		const Vec3p d = b - a;
+		floatp tEnter = 0.0f;
+		floatp tExit = 1.0f;
+
+		// Clip against the slabs of the two other axes
+		for (uSize i = 0; i < 3; i++)
+		{
+			if (i == axis)
+			{
+				continue;
+			}
+
+			if (Abs(Component(d, i)) <= 1e-12f)
+			{
+				if (Component(a, i) > Component(halfExtents, i) || Component(a, i) < -Component(halfExtents, i))
+				{
+					return 0;
+				}
+
+				continue;
+			}
+
+			floatp t0 = (-Component(halfExtents, i) - Component(a, i)) / Component(d, i);
+			floatp t1 = (Component(halfExtents, i) - Component(a, i)) / Component(d, i);
+
+			if (t0 > t1)
+			{
+				Swap(t0, t1);
+			}
+
+			tEnter	= Max(tEnter, t0);
+			tExit	= Min(tExit, t1);
+		}
+
+		if (tEnter > tExit)
+		{
+			return 0;
+		}
+
+		uSize count = 0;
+		const floatp ts[2] = { tEnter, tExit };
+
+		for (uSize i = 0; i < (tExit - tEnter > 1e-6f ? 2 : 1); i++)
+		{
+			const Vec3p point = a + d * ts[i];
+			const floatp depth = Component(halfExtents, axis) + radius - sign * Component(point, axis);
+
+			if (depth > 0.0f)
+			{
+				pOutPoints[count] = point;
+				pOutDepths[count] = depth;
+				count++;
+			}
+		}
+
+		return count;
+	}
+
+	/* Capsule against every nearby mesh triangle, endpoints and segment-edge closest points are tested as spheres */
+	static bool CollideCapsuleMeshShapes(const CapsuleSegment& capsule, const CollisionMesh& mesh1, 
+		const ShapeTransform& transform1, Collision& outCollision)
+	{
+		const Vec3p worldMin = Vec3p(
+			Min(capsule.point0.x, capsule.point1.x), 
+			Min(capsule.point0.y, capsule.point1.y), 
+			Min(capsule.point0.z, capsule.point1.z)) - Vec3p(capsule.radius);
+
+		const Vec3p worldMax = Vec3p(
+			Max(capsule.point0.x, capsule.point1.x),
+			Max(capsule.point0.y, capsule.point1.y),
+			Max(capsule.point0.z, capsule.point1.z)) + Vec3p(capsule.radius);
+
+		uInt32 triangles[PHYSICS_MESH_MAX_QUERY_TRIANGLES];
+		const uSize triangleCount = QueryMeshTriangles(mesh1, transform1, worldMin, worldMax, triangles);
+
+		Contact faceContacts[PHYSICS_CLIP_MAX_POINTS];
+		Contact featureContacts[PHYSICS_CLIP_MAX_POINTS];
+		uSize faceCount = 0;
+		uSize featureCount = 0;
+
+		for (uSize t = 0; t < triangleCount; t++)
+		{
+			const ShapeTriangle triangle = WorldTriangle(mesh1, transform1, triangles[t]);
+			const Vec3p triangleNormal = Cross(triangle.points[1] - triangle.points[0], triangle.points[2] - triangle.points[0]).Normalized();
+
+			const floatp dist0 = Dot(triangleNormal, capsule.point0 - triangle.points[0]);
+			const floatp dist1 = Dot(triangleNormal, capsule.point1 - triangle.points[0]);
+
+			if ((dist0 < 0.0f) != (dist1 < 0.0f))
+			{
+				// Segment pierces the triangle plane, push out along the face from the deeper end
+				const Vec3p crossing = capsule.point0 + (capsule.point1 - capsule.point0) * (dist0 / (dist0 - dist1));
+				const Vec3p closest = ClosestPointTriangle(crossing, triangle.points[0], triangle.points[1], triangle.points[2]);
+				const Vec3p diff = closest - crossing;
+
+				if (Dot(diff, diff) < 1e-10f)
+				{
+					const bool point0Deeper = Abs(dist0) < Abs(dist1);
+					const floatp deepDist = point0Deeper ? dist0 : dist1;
+					const Vec3p& deepPoint = point0Deeper ? capsule.point0 : capsule.point1;
+					const Vec3p normal = deepDist < 0.0f ? triangleNormal : -triangleNormal;
+
+					AddUniqueContact(faceContacts, faceCount, 
+						Contact(deepPoint - normal * (Abs(deepDist) - capsule.radius), capsule.radius + Abs(deepDist), normal));
+					continue;
+				}
+			}
+
+			AddSphereTriangleContact(triangle, capsule.point0, capsule.radius, faceContacts, faceCount, featureContacts, featureCount);
+			AddSphereTriangleContact(triangle, capsule.point1, capsule.radius, faceContacts, faceCount, featureContacts, featureCount);
+
+			for (uSize e = 0; e < 3; e++)
+			{
+				Vec3p segmentPoint;
+				Vec3p edgePoint;
+
+				ClosestPointsSegments(capsule.point0, capsule.point1, 
+					triangle.points[e], triangle.points[(e + 1) % 3], segmentPoint, edgePoint);
+
+				AddSphereTriangleContact(triangle, segmentPoint, capsule.radius, faceContacts, faceCount, featureContacts, featureCount);
+			}
+		}
+
+		if (faceCount > 0)
+		{
+			ReduceContacts(faceContacts, faceCount, outCollision);
+		}
+		else if (featureCount > 0)
+		{
+			ReduceContacts(featureContacts, featureCount, outCollision);
+		}
+		else
+		{
+			return false; // No Collision
+		}
+
+		return true;
+	}
+
 	bool CollisionDetection::CollideSphereSphere(const SphereCollider& sphere0, const Transform& transform0, 
 		const SphereCollider& sphere1, const Transform& transform1, Collision& outCollision)
 	{
@@ -80,47 +905,111 @@ namespace Quartz
 	bool CollisionDetection::CollideSphereRect(const SphereCollider& sphere0, const Transform& transform0, 
 		const RectCollider& rect1, const Transform& transform1, Collision& outCollision)
 	{
-		const Mat4f& transform00 = transform0.GetMatrix();
-		const Mat4f& transform11 = transform1.GetMatrix();
-		const Bounds3f& bounds = rect1.GetRect().bounds;
+		const floatp radius0 = sphere0.GetSphere().radius * transform0.scale.Maximum();
 
-		Vec3p points[8]
+		// Box space: centred, unrotated and unscaled, scale holds the half extents
+		const ShapeTransform transform11(transform1, rect1.GetRect().bounds);
+		const Vec3p& halfExtents = transform11.scale;
+
+		const Vec3p centre = transform11.invRotation * (Vec3p(transform0.position) - transform11.position);
+		const Vec3p boxPoint(
+			Clamp(centre.x, -halfExtents.x, halfExtents.x),
+			Clamp(centre.y, -halfExtents.y, halfExtents.y),
+			Clamp(centre.z, -halfExtents.z, halfExtents.z));
+
+		Vec3p normal = centre - boxPoint; // Box to Sphere
+		const floatp distSquared = Dot(normal, normal);
+
+		if (distSquared >= radius0 * radius0)
 		{
-			transform11 * bounds.BottomRightFront(),
-			transform11 * bounds.BottomLeftFront(),
-			transform11 * bounds.BottomRightBack(),
-			transform11 * bounds.BottomLeftBack(),
-			transform11 * bounds.TopRightFront(),
-			transform11 * bounds.TopLeftFront(),
-			transform11 * bounds.TopRightBack(),
-			transform11 * bounds.TopLeftBack()
-		};
+			return false; // No Collision
+		}
 
-		Simplex simplex;
+		floatp depth;
 
-		if (GJK::GJKRect(sphere0.GetSphere(), transform00, rect1.GetRect(), points, simplex))
+		if (distSquared > 0.0f)
 		{
-			//return EPARect(sphere0, rect1, points, simplex);
+			const floatp dist = sqrt(distSquared);
+
+			normal = normal * (1.0f / dist);
+			depth = radius0 - dist;
 		}
+		else
+		{
+			// Centre is inside the box, push out through the shallowest face
+			floatp minDepth = FLT_MAX;
 
-		return false; // No Collision
+			for (uSize i = 0; i < 3; i++)
+			{
+				const floatp value = Component(centre, i);
+				const floatp extent = Component(halfExtents, i);
+				const floatp faceDepth = extent - Abs(value);
+
+				if (faceDepth < minDepth)
+				{
+					minDepth = faceDepth;
+					const floatp sign = value >= 0.0f ? 1.0f : -1.0f;
+					normal = Vec3p(i == 0 ? sign : 0.0f, i == 1 ? sign : 0.0f, i == 2 ? sign : 0.0f);
+				}
+			}
+
+			depth = radius0 + minDepth;
+		}
+
+		const Vec3p contactPoint = centre - normal * (radius0 - depth * 0.5f);
+
+		Collision collision;
+		collision.AddContact(Contact(transform11.position + transform11.rotation * contactPoint,
+			depth, transform11.rotation * normal));
+
+		outCollision = collision;
+
+		return true;
 	}
 
 	bool CollisionDetection::CollideSphereCapsule(const SphereCollider& sphere0, const Transform& transform0, 
 		const CapsuleCollider& capsule1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const Vec3p& position0	= transform0.position;
+		const floatp radius0	= sphere0.GetSphere().radius * transform0.scale.Maximum();
+		const CapsuleSegment capsule = WorldCapsule(capsule1.GetCapsule(), transform1);
+		const floatp totalRadius = radius0 + capsule.radius;
+
+		const Vec3p closest = ClosestPointSegment(position0, capsule.point0, capsule.point1);
+
+		Vec3p normal = position0 - closest; // Capsule to Sphere
+		const floatp distSquared = Dot(normal, normal);
+
+		if (distSquared >= totalRadius * totalRadius)
+		{
+			return false; // No Collision
+		}
+
+		const floatp dist = sqrt(distSquared);
+		const floatp depth = totalRadius - dist;
+
+		normal = dist > 0.0f ? normal * (1.0f / dist) : Perpendicular((capsule.point1 - capsule.point0).Normalized());
+
+		Collision collision;
+		collision.AddContact(Contact(closest + normal * (capsule.radius - depth * 0.5f), depth, normal));
+
+		outCollision = collision;
+
+		return true;
 	}
 
 	bool CollisionDetection::CollideSphereHull(const SphereCollider& sphere0, const Transform& transform0, 
 		const HullCollider& hull1, const Transform& transform1, Collision& outCollision)
 	{
+		const ShapeTransform transform00(transform0);
+		const ShapeTransform transform11(transform1);
+
 		Simplex simplex;
 
-		//if (GJK(sphere0, hull1, simplex))
-		//{
-		//	return EPA(sphere0, hull1, simplex);
-		//}
+		if (GJK::GJK(sphere0.GetSphere(), transform00, hull1.GetHull(), transform11, simplex))
+		{
+			return GJK::EPA(sphere0.GetSphere(), transform00, hull1.GetHull(), transform11, simplex, outCollision);
+		}
 
 		return false; // No Collision
 	}
@@ -128,7 +1017,43 @@ namespace Quartz
 	bool CollisionDetection::CollideSphereMesh(const SphereCollider& sphere0, const Transform& transform0, 
 		const MeshCollider& mesh1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const Vec3p& position0	= transform0.position;
+		const floatp radius0	= sphere0.GetSphere().radius * transform0.scale.Maximum();
+
+		const ShapeTransform transform11(transform1);
+		const CollisionMesh& mesh = *mesh1.GetMesh().pMesh;
+
+		uInt32 triangles[PHYSICS_MESH_MAX_QUERY_TRIANGLES];
+		const uSize triangleCount = QueryMeshTriangles(mesh, transform11, 
+			position0 - Vec3p(radius0), position0 + Vec3p(radius0), triangles);
+
+		Contact faceContacts[PHYSICS_CLIP_MAX_POINTS];
+		Contact featureContacts[PHYSICS_CLIP_MAX_POINTS];
+		uSize faceCount = 0;
+		uSize featureCount = 0;
+
+		for (uSize t = 0; t < triangleCount; t++)
+		{
+			const ShapeTriangle triangle = WorldTriangle(mesh, transform11, triangles[t]);
+
+			AddSphereTriangleContact(triangle, position0, radius0, 
+				faceContacts, faceCount, featureContacts, featureCount);
+		}
+
+		if (faceCount > 0)
+		{
+			ReduceContacts(faceContacts, faceCount, outCollision);
+		}
+		else if (featureCount > 0)
+		{
+			ReduceContacts(featureContacts, featureCount, outCollision);
+		}
+		else
+		{
+			return false; // No Collision
+		}
+
+		return true;
 	}
 
 	bool CollisionDetection::CollidePlaneSphere(const PlaneCollider& plane0, const Transform& transform0, 
@@ -193,32 +1118,78 @@ namespace Quartz
 			}
 		}
 
-		if (minDist < 0.0f)
+		if (minDist < 0.0f)
+		{
+			outCollision = collision;
+			return true;
+		}
+
+		return false; // No Collision
+	}
+
+	bool CollisionDetection::CollidePlaneCapsule(const PlaneCollider& plane0, const Transform& transform0, 
+		const CapsuleCollider& capsule1, const Transform& transform1, Collision& outCollision)
+	{
+		const Vec3p& position0	= transform0.position;
+		const Vec3p normal		= Quatp(transform0.rotation) * plane0.GetPlane().normal;
+		const CapsuleSegment capsule = WorldCapsule(capsule1.GetCapsule(), transform1);
+
+		Collision collision;
+
+		for (const Vec3p& point : { capsule.point0, capsule.point1 })
+		{
+			const floatp dist = Dot(normal, point - position0) - capsule.radius;
+
+			if (dist < 0.0f)
+			{
+				collision.AddContact(Contact(point - normal * capsule.radius, -dist, -normal));
+			}
+		}
+
+		if (collision.count == 0)
 		{
-			outCollision = collision;
-			return true;
+			return false; // No Collision
 		}
 
-		return false; // No Collision
-	}
+		outCollision = collision;
 
-	bool CollisionDetection::CollidePlaneCapsule(const PlaneCollider& plane0, const Transform& transform0, 
-		const CapsuleCollider& capsule1, const Transform& transform1, Collision& outCollision)
-	{
-		return false; // No Collision
+		return true;
 	}
 
 	bool CollisionDetection::CollidePlaneHull(const PlaneCollider& plane0, const Transform& transform0, 
 		const HullCollider& hull1, const Transform& transform1, Collision& outCollision)
 	{
-		Simplex simplex;
+		const Vec3p& position0	= transform0.position;
+		const Vec3p normal		= Quatp(transform0.rotation) * plane0.GetPlane().normal;
 
-		//if (GJK(plane0, hull1, simplex))
-		//{
-		//	return EPA(plane0, hull1, simplex, outCollision);
-		//}
+		const ShapeTransform transform11(transform1);
+		const HullData& hullData = *hull1.GetHull().pHullData;
 
-		return false; // No Collision
+		// Deepest vertex first, most hulls are nowhere near the plane
+		const Vec3p deepest = FurthestPoint(hull1.GetHull(), -normal, transform11);
+
+		if (Dot(normal, deepest - position0) >= 0.0f)
+		{
+			return false; // No Collision
+		}
+
+		Contact contacts[PHYSICS_CLIP_MAX_POINTS];
+		uSize contactCount = 0;
+
+		for (const Vec3p& vertex : hullData.GetVertices())
+		{
+			const Vec3p point = transform11.ToWorldPoint(vertex);
+			const floatp dist = Dot(normal, point - position0);
+
+			if (dist < 0.0f && contactCount < PHYSICS_CLIP_MAX_POINTS)
+			{
+				contacts[contactCount++] = Contact(point, -dist, -normal);
+			}
+		}
+
+		ReduceContacts(contacts, contactCount, outCollision);
+
+		return true;
 	}
 
 	bool CollisionDetection::CollidePlaneMesh(const PlaneCollider& plane0, const Transform& transform0, const MeshCollider& mesh1, 
@@ -246,86 +1217,38 @@ namespace Quartz
 	bool CollisionDetection::CollideRectRect(const RectCollider& rect0, const Transform& transform0,
 		const RectCollider& rect1, const Transform& transform1, Collision& outCollision)
 	{
-		const Mat4f& transform00 = transform0.GetMatrix();
-		const Mat4f& transform11 = transform1.GetMatrix();
-		const Bounds3f& bounds0 = rect1.GetRect().bounds;
-		const Bounds3f& bounds1 = rect1.GetRect().bounds;
-
-		Vec3p points0[8]
-		{
-			transform00 * bounds0.BottomRightFront(),
-			transform00 * bounds0.BottomLeftFront(),
-			transform00 * bounds0.BottomRightBack(),
-			transform00 * bounds0.BottomLeftBack(),
-			transform00 * bounds0.TopRightFront(),
-			transform00 * bounds0.TopLeftFront(),
-			transform00 * bounds0.TopRightBack(),
-			transform00 * bounds0.TopLeftBack()
-		};
-
-		Vec3p points1[8]
-		{
-			transform11 * bounds1.BottomRightFront(),
-			transform11 * bounds1.BottomLeftFront(),
-			transform11 * bounds1.BottomRightBack(),
-			transform11 * bounds1.BottomLeftBack(),
-			transform11 * bounds1.TopRightFront(),
-			transform11 * bounds1.TopLeftFront(),
-			transform11 * bounds1.TopRightBack(),
-			transform11 * bounds1.TopLeftBack()
-		};
-
-		Simplex simplex;
-
-		if (GJK::GJKRectRect(rect0.GetRect(), points0, rect1.GetRect(), points1, simplex))
-		{
-			return GJK::EPARectRect(rect0.GetRect(), points0, rect1.GetRect(), points1, simplex, outCollision);
-		}
+		const ShapeTransform transform00(transform0, rect0.GetRect().bounds);
+		const ShapeTransform transform11(transform1, rect1.GetRect().bounds);
 
-		return false; // No Collision
+		return CollideConvexHulls(HullData::UnitBox(), transform00, 
+			HullData::UnitBox(), transform11, nullptr, outCollision);
 	}
 
 	bool CollisionDetection::CollideRectCapsule(const RectCollider& rect0, const Transform& transform0, 
 		const CapsuleCollider& capsule1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		bool result = CollideCapsuleRect(capsule1, transform1, rect0, transform0, outCollision);
+		outCollision.Flip();
+		return result;
 	}
 
 	bool CollisionDetection::CollideRectHull(const RectCollider& rect0, const Transform& transform0, 
 		const HullCollider& hull1, const Transform& transform1, Collision& outCollision)
 	{
-		const Mat4f& transform00 = transform0.GetMatrix();
-		const Mat4f& transform11 = transform1.GetMatrix();
-		const Bounds3f& bounds = rect0.GetRect().bounds;
-
-		Vec3p points[8]
-		{
-			transform00 * bounds.BottomRightFront(),
-			transform00 * bounds.BottomLeftFront(),
-			transform00 * bounds.BottomRightBack(),
-			transform00 * bounds.BottomLeftBack(),
-			transform00 * bounds.TopRightFront(),
-			transform00 * bounds.TopLeftFront(),
-			transform00 * bounds.TopRightBack(),
-			transform00 * bounds.TopLeftBack()
-		};
-
-		Simplex simplex;
-
-		if (GJK::GJKRect(hull1.GetHull(), transform11, rect0.GetRect(), points, simplex))
-		{
-			bool result = GJK::EPARect(hull1.GetHull(), transform11, rect0.GetRect(), points, simplex, outCollision);
-			outCollision.Flip();
-			return result;
-		}
+		const ShapeTransform transform00(transform0, rect0.GetRect().bounds);
+		const ShapeTransform transform11(transform1);
 
-		return false; // No Collision
+		return CollideConvexHulls(HullData::UnitBox(), transform00, 
+			*hull1.GetHull().pHullData, transform11, nullptr, outCollision);
 	}
 
 	bool CollisionDetection::CollideRectMesh(const RectCollider& rect0, const Transform& transform0,
 		const MeshCollider& mesh1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const ShapeTransform transform00(transform0, rect0.GetRect().bounds);
+		const ShapeTransform transform11(transform1);
+
+		return CollideHullMeshShapes(HullData::UnitBox(), transform00, *mesh1.GetMesh().pMesh, transform11, outCollision);
 	}
 
 	bool CollisionDetection::CollideCapsuleSphere(const CapsuleCollider& capsule0, const Transform& transform0,
@@ -347,27 +1270,255 @@ namespace Quartz
 	bool CollisionDetection::CollideCapsuleRect(const CapsuleCollider& capsule0, const Transform& transform0,
 		const RectCollider& rect1, const Transform& transform1, Collision& outCollision)
 	{
-		bool result = CollideRectCapsule(rect1, transform1, capsule0, transform0, outCollision);
-		outCollision.Flip();
-		return result;
-	};
+		const CapsuleSegment capsule = WorldCapsule(capsule0.GetCapsule(), transform0);
+
+		// Box space: centred, unrotated and unscaled, scale holds the half extents
+		const ShapeTransform transform11(transform1, rect1.GetRect().bounds);
+		const Vec3p& halfExtents = transform11.scale;
+
+		const Vec3p a = transform11.invRotation * (capsule.point0 - transform11.position);
+		const Vec3p b = transform11.invRotation * (capsule.point1 - transform11.position);
+
+		floatp t;
+		uSize axis = 0;
+		floatp sign = 1.0f;
+
+		if (ClosestSegmentBox(a, b, halfExtents, t))
+		{
+			const Vec3p point = a + (b - a) * t;
+			const Vec3p boxPoint(
+				Clamp(point.x, -halfExtents.x, halfExtents.x),
+				Clamp(point.y, -halfExtents.y, halfExtents.y),
+				Clamp(point.z, -halfExtents.z, halfExtents.z));
+
+			Vec3p normal = point - boxPoint; // Box to Capsule
+			const floatp dist = normal.Magnitude();
+
+			if (dist >= capsule.radius)
+			{
+				return false; // No Collision
+			}
+
+			normal = normal * (1.0f / dist);
+
+			if (Abs(normal.x) < 0.9999f && Abs(normal.y) < 0.9999f && Abs(normal.z) < 0.9999f)
+			{
+				// Edge or vertex region
+				const floatp depth = capsule.radius - dist;
+				const Vec3p contactPoint = point - normal * (capsule.radius - depth * 0.5f);
+
+				Collision collision;
+				collision.AddContact(Contact(transform11.position + transform11.rotation * contactPoint, 
+					depth, transform11.rotation * normal));
+
+				outCollision = collision;
+
+				return true;
+			}
+
+			axis = Abs(normal.x) >= 0.9999f ? 0 : (Abs(normal.y) >= 0.9999f ? 1 : 2);
+			sign = Component(normal, axis) > 0.0f ? 1.0f : -1.0f;
+		}
+		else
+		{
+			// Segment enters the box, push out through the shallowest face
+			floatp minDepth = FLT_MAX;
+
+			for (uSize i = 0; i < 3; i++)
+			{
+				for (floatp faceSign : { 1.0f, -1.0f })
+				{
+					const floatp depth = Component(halfExtents, i) + capsule.radius - Min(faceSign * Component(a, i), faceSign * Component(b, i));
+
+					if (depth < minDepth)
+					{
+						minDepth = depth;
+						axis = i;
+						sign = faceSign;
+					}
+				}
+			}
+		}
+
+		const Vec3p normal(axis == 0 ? sign : 0.0f, axis == 1 ? sign : 0.0f, axis == 2 ? sign : 0.0f);
+
+		Vec3p points[2];
+		floatp depths[2];
+		const uSize count = CapsuleBoxFaceContacts(a, b, capsule.radius, halfExtents, axis, sign, points, depths);
+
+		if (count == 0)
+		{
+			return false; // No Collision
+		}
+
+		const Vec3p worldNormal = transform11.rotation * normal;
+
+		Collision collision;
+
+		for (uSize i = 0; i < count; i++)
+		{
+			const Vec3p contactPoint = points[i] - normal * (capsule.radius - depths[i] * 0.5f);
+			collision.AddContact(Contact(transform11.position + transform11.rotation * contactPoint, depths[i], worldNormal));
+		}
+
+		outCollision = collision;
+
+		return true;
+	}
 
 	bool CollisionDetection::CollideCapsuleCapsule(const CapsuleCollider& capsule0, const Transform& transform0,
 		const CapsuleCollider& capsule1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const CapsuleSegment segment0 = WorldCapsule(capsule0.GetCapsule(), transform0);
+		const CapsuleSegment segment1 = WorldCapsule(capsule1.GetCapsule(), transform1);
+		const floatp totalRadius = segment0.radius + segment1.radius;
+
+		Vec3p closest0;
+		Vec3p closest1;
+		ClosestPointsSegments(segment0.point0, segment0.point1, segment1.point0, segment1.point1, closest0, closest1);
+
+		Vec3p normal = closest0 - closest1; // Capsule1 to Capsule0
+		const floatp distSquared = Dot(normal, normal);
+
+		if (distSquared >= totalRadius * totalRadius)
+		{
+			return false; // No Collision
+		}
+
+		const Vec3p axis0 = segment0.point1 - segment0.point0;
+		const Vec3p axis1 = segment1.point1 - segment1.point0;
+		const floatp dist = sqrt(distSquared);
+
+		if (dist > 1e-6f)
+		{
+			normal = normal * (1.0f / dist);
+		}
+		else
+		{
+			// Axes cross, separate along their common perpendicular
+			const Vec3p crossAxis = Cross(axis0, axis1);
+			normal = Dot(crossAxis, crossAxis) > 1e-12f ? crossAxis.Normalized() : Perpendicular(axis0.Normalized());
+
+			if (Dot(normal, Vec3p(transform0.position) - Vec3p(transform1.position)) < 0.0f)
+			{
+				normal = -normal;
+			}
+		}
+
+		Collision collision;
+
+		const floatp length0Squared = Dot(axis0, axis0);
+		const floatp length1Squared = Dot(axis1, axis1);
+		const floatp alignment = Dot(axis0, axis1);
+
+		if (length0Squared > 0.0f && length1Squared > 0.0f && 
+			alignment * alignment > 0.998f * length0Squared * length1Squared)
+		{
+			// Parallel capsules rest on the overlap of their segments, one contact at each end
+			floatp t0 = Dot(segment1.point0 - segment0.point0, axis0) / length0Squared;
+			floatp t1 = Dot(segment1.point1 - segment0.point0, axis0) / length0Squared;
+
+			if (t0 > t1)
+			{
+				Swap(t0, t1);
+			}
+
+			t0 = Clamp(t0, (floatp)0.0f, (floatp)1.0f);
+			t1 = Clamp(t1, (floatp)0.0f, (floatp)1.0f);
+
+			if (t1 - t0 > 1e-6f)
+			{
+				for (floatp t : { t0, t1 })
+				{
+					const Vec3p point0 = segment0.point0 + axis0 * t;
+					const Vec3p point1 = ClosestPointSegment(point0, segment1.point0, segment1.point1);
+					const floatp depth = totalRadius - Dot(point0 - point1, normal);
+
+					if (depth > 0.0f)
+					{
+						collision.AddContact(Contact(point1 + normal * (segment1.radius - depth * 0.5f), depth, normal));
+					}
+				}
+			}
+		}
+
+		if (collision.count == 0)
+		{
+			const floatp depth = totalRadius - dist;
+			collision.AddContact(Contact(closest1 + normal * (segment1.radius - depth * 0.5f), depth, normal));
+		}
+
+		outCollision = collision;
+
+		return true;
 	}
 
 	bool CollisionDetection::CollideCapsuleHull(const CapsuleCollider& capsule0, const Transform& transform0,
 		const HullCollider& hull1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const ShapeTransform transform00(transform0);
+		const ShapeTransform transform11(transform1);
+		const HullData& hullData = *hull1.GetHull().pHullData;
+
+		Simplex simplex;
+		Collision collision;
+
+		if (!GJK::GJK(capsule0.GetCapsule(), transform00, hull1.GetHull(), transform11, simplex) ||
+			!GJK::EPA(capsule0.GetCapsule(), transform00, hull1.GetHull(), transform11, simplex, collision))
+		{
+			return false; // No Collision
+		}
+
+		// A capsule lying on a face touches along its whole segment, clip it to the face
+		const Vec3p normal = collision.contacts[0].normal;
+
+		floatp alignment;
+		const uInt32 refFace = WorldSupportFace(hullData, transform11, normal, alignment);
+
+		if (alignment > 0.7f)
+		{
+			const CapsuleSegment capsule = WorldCapsule(capsule0.GetCapsule(), transform0);
+			const Vec3p refNormal = transform11.ToWorldNormal(hullData.GetFaces()[refFace].normal);
+
+			Vec3p refPoints[PHYSICS_CLIP_MAX_POINTS];
+			const uSize refCount = WorldFace(hullData, transform11, refFace, refPoints);
+
+			const Vec3p incPoints[2] = 
+			{
+				capsule.point0 - refNormal * capsule.radius,
+				capsule.point1 - refNormal * capsule.radius
+			};
+
+			Contact clipContacts[PHYSICS_CLIP_MAX_POINTS];
+			const uSize clipCount = ClipPolygons(refPoints, refCount, refNormal, incPoints, 2, normal, clipContacts);
+
+			Contact contacts[PHYSICS_CLIP_MAX_POINTS];
+			uSize contactCount = 0;
+
+			for (uSize i = 0; i < clipCount; i++)
+			{
+				AddUniqueContact(contacts, contactCount, clipContacts[i]);
+			}
+
+			if (contactCount > 0)
+			{
+				ReduceContacts(contacts, contactCount, outCollision);
+				return true;
+			}
+		}
+
+		outCollision = collision;
+
+		return true;
 	}
 
 	bool CollisionDetection::CollideCapsuleMesh(const CapsuleCollider& capsule0, const Transform& transform0,
 		const MeshCollider& mesh1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const CapsuleSegment capsule = WorldCapsule(capsule0.GetCapsule(), transform0);
+		const ShapeTransform transform11(transform1);
+
+		return CollideCapsuleMeshShapes(capsule, *mesh1.GetMesh().pMesh, transform11, outCollision);
 	}
 
 	bool CollisionDetection::CollideHullSphere(const HullCollider& hull0, const Transform& transform0,
@@ -405,23 +1556,20 @@ namespace Quartz
 	bool CollisionDetection::CollideHullHull(const HullCollider& hull0, const Transform& transform0,
 		const HullCollider& hull1, const Transform& transform1, Collision& outCollision)
 	{
-		Simplex simplex;
+		const ShapeTransform transform00(transform0);
+		const ShapeTransform transform11(transform1);
 
-		const Mat4f& transform00 = transform0.GetMatrix();
-		const Mat4f& transform11 = transform1.GetMatrix();
-
-		if (GJK::GJK(hull0.GetHull(), transform00, hull1.GetHull(), transform11, simplex))
-		{
-			return GJK::EPA(hull0.GetHull(), transform00, hull1.GetHull(), transform11, simplex, outCollision);
-		}
-
-		return false; // No Collision
+		return CollideConvexHulls(*hull0.GetHull().pHullData, transform00, 
+			*hull1.GetHull().pHullData, transform11, nullptr, outCollision);
 	}
 
 	bool CollisionDetection::CollideHullMesh(const HullCollider& hull0, const Transform& transform0,
 		const MeshCollider& mesh1, const Transform& transform1, Collision& outCollision)
 	{
-		return false; // No Collision
+		const ShapeTransform transform00(transform0);
+		const ShapeTransform transform11(transform1);
+
+		return CollideHullMeshShapes(*hull0.GetHull().pHullData, transform00, *mesh1.GetMesh().pMesh, transform11, outCollision);
 	}
 
 	bool CollisionDetection::CollideMeshSphere(const MeshCollider& mesh0, const Transform& transform0,
@@ -470,6 +1618,46 @@ namespace Quartz
 		return false; // No Collision
 	}
 
+	/* Each child that can touch the other collider collides on its own, their contacts are reduced into one manifold */
+	bool CollisionDetection::CollideCompound(const CompoundCollider& compound0, const Transform& transform0,
+		const Collider& collider1, const Transform& transform1, Collision& outCollision)
+	{
+		const CompoundData& compoundData = *compound0.GetCompound().pCompound;
+
+		uInt32 children[PHYSICS_COMPOUND_MAX_CHILDREN];
+		const uSize childCount = compoundData.QueryCollider(transform0, collider1, transform1, 
+			children, PHYSICS_COMPOUND_MAX_CHILDREN);
+
+		Contact contacts[PHYSICS_CLIP_MAX_POINTS];
+		uSize contactCount = 0;
+		bool colliding = false;
+
+		for (uSize i = 0; i < childCount; i++)
+		{
+			const CompoundChild& child = compoundData.GetChild(children[i]);
+			const Transform childTransform = compoundData.GetChildTransform(children[i], transform0);
+
+			Collision collision;
+
+			if (!Collide(child.collider, childTransform, collider1, transform1, collision))
+			{
+				continue;
+			}
+
+			colliding = true;
+
+			// Up to PHYSICS_CLIP_MAX_POINTS in child order, contacts of children past that are dropped before reducing
+			for (uSize c = 0; c < collision.count && contactCount < PHYSICS_CLIP_MAX_POINTS; c++)
+			{
+				contacts[contactCount++] = collision.contacts[c];
+			}
+		}
+
+		ReduceContacts(contacts, contactCount, outCollision);
+
+		return colliding;
+	}
+
 	bool CollisionDetection::Collide(const Collider& collider0, const Transform& transform0, 
 		const Collider& collider1, const Transform& transform1, Collision& outCollision)
 	{
@@ -531,8 +1719,135 @@ namespace Quartz
 			return false; // No Collision
 		}
 
+		threadNarrowphaseStats.tests[type0][type1]++;
+
+		if (type0 == SHAPE_COMPOUND)
+		{
+			return CollideCompound((const CompoundCollider&)collider0, transform0, collider1, transform1, outCollision);
+		}
+
+		if (type1 == SHAPE_COMPOUND)
+		{
+			bool result = CollideCompound((const CompoundCollider&)collider1, transform1, collider0, transform0, outCollision);
+			outCollision.Flip();
+			return result;
+		}
+
 		uSize index = (uSize)type1 + ((uSize)type0 * 6);
 
 		return functionTable[index](collider0, transform0, collider1, transform1, outCollision);
 	}
-}
\ No newline at end of file
+
+	NarrowphaseStats& CollisionDetection::ThreadStats()
+	{
+		return threadNarrowphaseStats;
+	}
+
+	/* Boxes run as the shared unit cube hull, scaled to their bounds */
+	inline const HullData& BatchHull(const Collider& collider)
+	{
+		return collider.GetShapeType() == SHAPE_RECT ? HullData::UnitBox() : *((const HullCollider&)collider).GetHull().pHullData;
+	}
+
+	inline ShapeTransform BatchTransform(const Collider& collider, const Transform& transform)
+	{
+		return collider.GetShapeType() == SHAPE_RECT ? ShapeTransform(transform, ((const RectCollider&)collider).GetRect().bounds) : ShapeTransform(transform);
+	}
+
+	/* Boxes and hulls small enough for a SIMD lane, larger hulls take the scalar path with their hill-climbing support */
+	inline bool IsBatchConvex(const Collider& collider)
+	{
+		return collider.GetShapeType() == SHAPE_RECT || (collider.GetShapeType() == SHAPE_HULL &&
+			((const HullCollider&)collider).GetHull().pHullData->GetVertices().Size() <= PHYSICS_BATCH_MAX_POINTS);
+	}
+
+	void CollisionDetection::CollideBatch(const CollisionPair* pPairs, uSize count, 
+		Collision* pOutCollisions, bool* pOutColliding)
+	{
+		Array<uSize>&			batchIndices	= threadBatchScratch.indices;
+		Array<Vec3p>&			batchPoints		= threadBatchScratch.points;
+		Array<GJK::BatchPair>&	batchPairs		= threadBatchScratch.pairs;
+		Array<Simplex>&			batchSimplices	= threadBatchScratch.simplices;
+		Array<bool>&			batchResults	= threadBatchScratch.results;
+
+		batchIndices.Clear();
+
+		/* Other pairs go through the function table */
+
+		uSize pointCount = 0;
+
+		for (uSize i = 0; i < count; i++)
+		{
+			const CollisionPair& pair = pPairs[i];
+
+			if (IsBatchConvex(*pair.pCollider0) && IsBatchConvex(*pair.pCollider1))
+			{
+				threadNarrowphaseStats.tests[pair.pCollider0->GetShapeType()][pair.pCollider1->GetShapeType()]++;
+				batchIndices.PushBack(i);
+
+				pointCount += BatchHull(*pair.pCollider0).GetVertices().Size() + BatchHull(*pair.pCollider1).GetVertices().Size();
+				continue;
+			}
+
+			pOutColliding[i] = Collide(*pair.pCollider0, *pair.pTransform0, 
+				*pair.pCollider1, *pair.pTransform1, pOutCollisions[i]);
+		}
+
+		if (batchIndices.Size() == 0)
+		{
+			return;
+		}
+
+		/* Convex pairs run GJK together, on the world space vertices of both hulls */
+
+		batchPoints.Resize(pointCount);
+		batchPairs.Resize(batchIndices.Size());
+		batchSimplices.Resize(batchIndices.Size());
+		batchResults.Resize(batchIndices.Size());
+
+		Vec3p* pPoints = batchPoints.Data();
+
+		for (uSize i = 0; i < batchIndices.Size(); i++)
+		{
+			const CollisionPair& pair = pPairs[batchIndices[i]];
+			GJK::BatchPair& batchPair = batchPairs[i];
+
+			const Array<Vec3p>& vertices0 = BatchHull(*pair.pCollider0).GetVertices();
+			const Array<Vec3p>& vertices1 = BatchHull(*pair.pCollider1).GetVertices();
+			const ShapeTransform transform0 = BatchTransform(*pair.pCollider0, *pair.pTransform0);
+			const ShapeTransform transform1 = BatchTransform(*pair.pCollider1, *pair.pTransform1);
+
+			batchPair = { pPoints, vertices0.Size(), pPoints + vertices0.Size(), vertices1.Size() };
+
+			for (const Vec3p& vertex : vertices0)
+			{
+				*pPoints++ = transform0.ToWorldPoint(vertex);
+			}
+
+			for (const Vec3p& vertex : vertices1)
+			{
+				*pPoints++ = transform1.ToWorldPoint(vertex);
+			}
+		}
+
+		GJK::GJKBatch(batchPairs.Data(), batchPairs.Size(), batchSimplices.Data(), batchResults.Data());
+
+		/* Penetration depth is only needed for hits */
+
+		for (uSize i = 0; i < batchIndices.Size(); i++)
+		{
+			const uSize index = batchIndices[i];
+			const CollisionPair& pair = pPairs[index];
+
+			pOutColliding[index] = false;
+
+			if (batchResults[i])
+			{
+				pOutColliding[index] = CollideConvexHulls(
+					BatchHull(*pair.pCollider0), BatchTransform(*pair.pCollider0, *pair.pTransform0),
+					BatchHull(*pair.pCollider1), BatchTransform(*pair.pCollider1, *pair.pTransform1),
+					&batchSimplices[i], pOutCollisions[index]);
+			}
+		}
+	}
+}
@@ -0,0 +1,232 @@
+#include "Compound.h"
+#include "Physics.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <float.h>
+
+namespace Quartz
+{
+	static floatp Axis(const Vec3p& vector, uSize axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	bool CompoundData::AddChild(const Collider& collider, const Transform& transform)
+	{
+		const ShapeType type = collider.GetShapeType();
+
+		if (type != SHAPE_SPHERE && type != SHAPE_RECT && type != SHAPE_CAPSULE && type != SHAPE_HULL)
+		{
+			LogError("Failed to add compound child: only spheres, rects, capsules and hulls can be children.");
+			return false;
+		}
+
+		if (mChildren.Size() >= PHYSICS_COMPOUND_MAX_CHILDREN)
+		{
+			LogError("Failed to add compound child: compounds are limited to %d children.", PHYSICS_COMPOUND_MAX_CHILDREN);
+			return false;
+		}
+
+		CompoundChild child;
+		child.collider	= collider;
+		child.transform	= transform;
+
+		mChildren.PushBack(child);
+		mNodes.Clear();
+
+		return true;
+	}
+
+	uInt32 CompoundData::BuildNode(uInt32 firstChild, uInt32 childCount)
+	{
+		const uInt32 nodeIndex = mNodes.Size();
+
+		CompoundNode node;
+		node.min = Vec3p(FLT_MAX);
+		node.max = Vec3p(-FLT_MAX);
+
+		Vec3p centerMin = Vec3p(FLT_MAX);
+		Vec3p centerMax = Vec3p(-FLT_MAX);
+
+		for (uInt32 i = firstChild; i < firstChild + childCount; i++)
+		{
+			const CompoundChild& child = mChildren[i];
+			const Vec3p center = (child.min + child.max) * 0.5f;
+
+			node.min = Vec3p(Min(node.min.x, child.min.x), Min(node.min.y, child.min.y), Min(node.min.z, child.min.z));
+			node.max = Vec3p(Max(node.max.x, child.max.x), Max(node.max.y, child.max.y), Max(node.max.z, child.max.z));
+			centerMin = Vec3p(Min(centerMin.x, center.x), Min(centerMin.y, center.y), Min(centerMin.z, center.z));
+			centerMax = Vec3p(Max(centerMax.x, center.x), Max(centerMax.y, center.y), Max(centerMax.z, center.z));
+		}
+
+		mNodes.PushBack(node);
+
+		if (childCount <= PHYSICS_COMPOUND_LEAF_CHILDREN)
+		{
+			mNodes[nodeIndex].firstChild = firstChild;
+			mNodes[nodeIndex].childCount = childCount;
+			return nodeIndex;
+		}
+
+		/* Median split along the widest center axis */
+
+		uSize splitAxis = 0;
+
+		for (uSize axis = 1; axis < 3; axis++)
+		{
+			if (Axis(centerMax, axis) - Axis(centerMin, axis) > Axis(centerMax, splitAxis) - Axis(centerMin, splitAxis))
+			{
+				splitAxis = axis;
+			}
+		}
+
+		const uInt32 leftCount = childCount / 2;
+		CompoundChild* pFirst = mChildren.Data() + firstChild;
+
+		std::nth_element(pFirst, pFirst + leftCount, pFirst + childCount,
+			[splitAxis](const CompoundChild& child0, const CompoundChild& child1)
+			{
+				return Axis(child0.min + child0.max, splitAxis) < Axis(child1.min + child1.max, splitAxis);
+			});
+
+		BuildNode(firstChild, leftCount);
+		const uInt32 rightIndex = BuildNode(firstChild + leftCount, childCount - leftCount);
+
+		mNodes[nodeIndex].firstChild = rightIndex;
+		mNodes[nodeIndex].childCount = 0;
+
+		return nodeIndex;
+	}
+
+	bool CompoundData::Build()
+	{
+		mNodes.Clear();
+
+		if (mChildren.Size() == 0)
+		{
+			LogError("Failed to build compound: compound has no children.");
+			return false;
+		}
+
+		for (CompoundChild& child : mChildren)
+		{
+			Physics::CalcBounds(child.collider, child.transform, child.min, child.max);
+		}
+
+		mNodes.Reserve(2 * mChildren.Size());
+		BuildNode(0, (uInt32)mChildren.Size());
+
+		return true;
+	}
+
+	uSize CompoundData::QueryBounds(const Vec3p& min, const Vec3p& max, uInt32* pOutChildren, uSize maxChildren) const
+	{
+		if (mNodes.Size() == 0)
+		{
+			return 0;
+		}
+
+		// Median splits of at most PHYSICS_COMPOUND_MAX_CHILDREN children stay well under 64 levels
+		uInt32 stack[64];
+		uSize stackSize = 0;
+		uSize count = 0;
+
+		stack[stackSize++] = 0;
+
+		while (stackSize > 0)
+		{
+			const CompoundNode& node = mNodes[stack[--stackSize]];
+
+			if (node.min.x > max.x || node.max.x < min.x ||
+				node.min.y > max.y || node.max.y < min.y ||
+				node.min.z > max.z || node.max.z < min.z)
+			{
+				continue;
+			}
+
+			if (node.childCount > 0)
+			{
+				for (uInt32 c = node.firstChild; c < node.firstChild + node.childCount; c++)
+				{
+					const CompoundChild& child = mChildren[c];
+
+					if (count == maxChildren)
+					{
+						return count;
+					}
+
+					if (child.min.x > max.x || child.max.x < min.x ||
+						child.min.y > max.y || child.max.y < min.y ||
+						child.min.z > max.z || child.max.z < min.z)
+					{
+						continue;
+					}
+
+					pOutChildren[count++] = c;
+				}
+
+				continue;
+			}
+
+			const uInt32 nodeIndex = (uInt32)(&node - mNodes.Data());
+
+			stack[stackSize++] = node.firstChild;	// Right
+			stack[stackSize++] = nodeIndex + 1;		// Left
+		}
+
+		return count;
+	}
+
+	/* The collider's world bounds are taken into the compound's local space, which is what the children are bounded in */
+	uSize CompoundData::QueryCollider(const Transform& transform, const Collider& collider, const Transform& colliderTransform,
+		uInt32* pOutChildren, uSize maxChildren) const
+	{
+		// Planes are unbounded and may touch every child
+		if (collider.GetShapeType() == SHAPE_PLANE)
+		{
+			return QueryBounds(Vec3p(-FLT_MAX), Vec3p(FLT_MAX), pOutChildren, maxChildren);
+		}
+
+		const ShapeTransform transform0(transform);
+
+		Vec3p worldMin;
+		Vec3p worldMax;
+		Physics::CalcBounds(collider, colliderTransform, worldMin, worldMax);
+
+		Vec3p localMin = Vec3p(FLT_MAX);
+		Vec3p localMax = Vec3p(-FLT_MAX);
+
+		for (uSize i = 0; i < 8; i++)
+		{
+			const Vec3p corner(
+				(i & 1) ? worldMax.x : worldMin.x,
+				(i & 2) ? worldMax.y : worldMin.y,
+				(i & 4) ? worldMax.z : worldMin.z);
+
+			const Vec3p point = transform0.ToLocalPoint(corner);
+
+			localMin = Vec3p(Min(localMin.x, point.x), Min(localMin.y, point.y), Min(localMin.z, point.z));
+			localMax = Vec3p(Max(localMax.x, point.x), Max(localMax.y, point.y), Max(localMax.z, point.z));
+		}
+
+		return QueryBounds(localMin, localMax, pOutChildren, maxChildren);
+	}
+
+	/* Exact for uniform body scales, and for children whose rotation keeps their axes on the body's */
+	Transform CompoundData::GetChildTransform(uInt32 child, const Transform& transform) const
+	{
+		const Transform& local = mChildren[child].transform;
+		const Vec3p scaledPosition(
+			local.position.x * transform.scale.x,
+			local.position.y * transform.scale.y,
+			local.position.z * transform.scale.z);
+
+		Transform result = transform;
+		result.position	= Vec3f(Vec3p(transform.position) + Quatp(transform.rotation) * scaledPosition);
+		result.rotation	= transform.rotation * local.rotation;
+		result.scale	= Vec3f(transform.scale.x * local.scale.x, transform.scale.y * local.scale.y, transform.scale.z * local.scale.z);
+
+		return result;
+	}
+}
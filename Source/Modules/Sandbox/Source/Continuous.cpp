@@ -0,0 +1,212 @@
+#include "Physics.h"
+
+#include <math.h>
+
+#define PHYSICS_CONTINUOUS_MAX_SAMPLES	128
+
+namespace Quartz
+{
+	/* Inner Radius (largest sphere that fits inside the shape, about its centre) */
+
+	static floatp InnerRadiusSphere(const SphereCollider& sphere, const Transform& transform)
+	{
+		return sphere.GetSphere().radius * Min(transform.scale.x, Min(transform.scale.y, transform.scale.z));
+	}
+
+	static floatp InnerRadiusPlane(const PlaneCollider& plane, const Transform& transform)
+	{
+		return 0.0f; // Planes never move
+	}
+
+	static floatp InnerRadiusRect(const RectCollider& rect, const Transform& transform)
+	{
+		const Bounds3f& bounds = rect.GetRect().bounds;
+
+		return 0.5f * Min(bounds.Width() * transform.scale.x,
+			Min(bounds.Height() * transform.scale.y, bounds.Depth() * transform.scale.z));
+	}
+
+	static floatp InnerRadiusCapsule(const CapsuleCollider& capsule, const Transform& transform)
+	{
+		return capsule.GetCapsule().radius * Min(transform.scale.x, transform.scale.z);
+	}
+
+	static floatp InnerRadiusHull(const HullCollider& hull, const Transform& transform)
+	{
+		const HullData& hullData = *hull.GetHull().pHullData;
+		floatp radius = FLT_MAX;
+
+		for (const HullFace& face : hullData.GetFaces())
+		{
+			radius = Min(radius, face.distance - Dot(face.normal, hullData.GetCentroid()));
+		}
+
+		return hullData.IsValid() ? radius * Min(transform.scale.x, Min(transform.scale.y, transform.scale.z)) : 0.0f;
+	}
+
+	static floatp InnerRadiusMesh(const MeshCollider& mesh, const Transform& transform)
+	{
+		return 0.0f; // Meshes are always static
+	}
+
+	static floatp InnerRadius(const Collider& collider, const Transform& transform);
+
+	/* The thinnest child decides how far the compound can move before something slips past it */
+	static floatp InnerRadiusCompound(const CompoundCollider& compound, const Transform& transform)
+	{
+		const CompoundData& compoundData = *compound.GetCompound().pCompound;
+		floatp radius = FLT_MAX;
+
+		for (uInt32 i = 0; i < compoundData.GetChildCount(); i++)
+		{
+			const Transform childTransform = compoundData.GetChildTransform(i, transform);
+			radius = Min(radius, InnerRadius(compoundData.GetChild(i).collider, childTransform));
+		}
+
+		return compoundData.GetChildCount() > 0 ? radius : 0.0f;
+	}
+
+	static floatp InnerRadius(const Collider& collider, const Transform& transform)
+	{
+		using InnerRadiusFunc = floatp(*)(const Collider& collider, const Transform& transform);
+
+		static InnerRadiusFunc functionTable[7]
+		{
+			(InnerRadiusFunc) InnerRadiusSphere,
+			(InnerRadiusFunc) InnerRadiusPlane,
+			(InnerRadiusFunc) InnerRadiusRect,
+			(InnerRadiusFunc) InnerRadiusCapsule,
+			(InnerRadiusFunc) InnerRadiusHull,
+			(InnerRadiusFunc) InnerRadiusMesh,
+			(InnerRadiusFunc) InnerRadiusCompound
+		};
+
+		return functionTable[(uSize)collider.GetShapeType()](collider, transform);
+	}
+
+	floatp Physics::CalcInnerRadius(const Collider& collider, const Transform& transform)
+	{
+		return InnerRadius(collider, transform);
+	}
+
+	/*
+		Conservative advancement against a body held at its current pose. The motion is
+		sampled at spacing no larger than the inner radius, so the swept body cannot pass
+		through anything without at least one sample overlapping it. The first overlapping
+		sample is then bisected back towards the last free one.
+		Returns false if nothing is hit, otherwise outTime is the fraction of the motion at
+		which the bodies first overlap, 0 if they already touch.
+	*/
+	bool Physics::TimeOfImpact(const Collider& collider0, const Transform& transform0, const Vec3p& motion,
+		const Collider& collider1, const Transform& transform1, floatp spacing, floatp& outTime)
+	{
+		Collision collision;
+
+		if (collisionDetection.Collide(collider0, transform0, collider1, transform1, collision))
+		{
+			outTime = 0.0f;
+			return true;
+		}
+
+		const uSize sampleCount = Min((uSize)ceil(motion.Magnitude() / spacing), (uSize)PHYSICS_CONTINUOUS_MAX_SAMPLES);
+		const Vec3p start = transform0.position;
+
+		Transform swept = transform0;
+		floatp low = 0.0f;
+
+		for (uSize i = 1; i <= sampleCount; i++)
+		{
+			floatp high = (floatp)i / (floatp)sampleCount;
+
+			swept.position = Vec3f(start + motion * high);
+
+			if (!collisionDetection.Collide(collider0, swept, collider1, transform1, collision))
+			{
+				low = high;
+				continue;
+			}
+
+			/* Keep high overlapping so the next substep finds a contact */
+
+			for (uSize j = 0; j < PHYSICS_CONTINUOUS_BISECTIONS; j++)
+			{
+				const floatp middle = 0.5f * (low + high);
+				swept.position = Vec3f(start + motion * middle);
+
+				if (collisionDetection.Collide(collider0, swept, collider1, transform1, collision))
+				{
+					high = middle;
+				}
+				else
+				{
+					low = middle;
+				}
+			}
+
+			outTime = high;
+			return true;
+		}
+
+		return false;
+	}
+
+	void Physics::SweepContinuous(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
+	{
+		mMotionScales.Resize(mEntities.Size());
+
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			mMotionScales[i] = 1.0f;
+
+			RigidBodyComponent& physics		= *mBodyPhysics[i];
+			TransformComponent& transform	= *mBodyTransforms[i];
+
+			const RigidBody& rigidBody = physics.rigidBody;
+
+			if (!rigidBody.continuous || rigidBody.asleep || physics.collider.IsStatic() || rigidBody.invMass == 0.0f)
+			{
+				continue;
+			}
+
+			const Vec3p motion = rigidBody.linearVelocity * stepTime;
+			const floatp spacing = CalcInnerRadius(physics.collider, transform) * PHYSICS_CONTINUOUS_SPACING;
+
+			if (spacing <= 0.0f || Dot(motion, motion) <= spacing * spacing)
+			{
+				continue; // Slow enough for the discrete test to catch
+			}
+
+			/* Swept bounds against the broadphase bounds of this substep */
+
+			Vec3p sweptMin;
+			Vec3p sweptMax;
+			CalcBounds(physics.collider, transform, sweptMin, sweptMax);
+
+			sweptMin += Vec3p(Min(motion.x, (floatp)0.0f), Min(motion.y, (floatp)0.0f), Min(motion.z, (floatp)0.0f));
+			sweptMax += Vec3p(Max(motion.x, (floatp)0.0f), Max(motion.y, (floatp)0.0f), Max(motion.z, (floatp)0.0f));
+
+			for (const BroadphaseEntry& entry : mBroadphase)
+			{
+				if (entry.index == i ||
+					entry.max.x < sweptMin.x || sweptMax.x < entry.min.x ||
+					entry.max.y < sweptMin.y || sweptMax.y < entry.min.y ||
+					entry.max.z < sweptMin.z || sweptMax.z < entry.min.z)
+				{
+					continue;
+				}
+
+				RigidBodyComponent& otherPhysics	= *mBodyPhysics[entry.index];
+				TransformComponent& otherTransform	= *mBodyTransforms[entry.index];
+
+				floatp timeOfImpact;
+
+				// Bodies already touching are left to the discrete contact
+				if (TimeOfImpact(physics.collider, transform, motion, otherPhysics.collider, otherTransform, spacing, timeOfImpact) && 
+					timeOfImpact > 0.0f)
+				{
+					mMotionScales[i] = Min(mMotionScales[i], timeOfImpact);
+				}
+			}
+		}
+	}
+}
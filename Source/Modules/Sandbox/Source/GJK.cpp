@@ -5,6 +5,13 @@ namespace Quartz
 {
 	using namespace ShapeUtils;
 
+	static thread_local GJK::EPAStats threadEPAStats = {};
+
+	GJK::EPAStats& GJK::ThreadEPAStats()
+	{
+		return threadEPAStats;
+	}
+
 	GJK::Line::Line() :
 		points{} {}
 
@@ -46,10 +53,16 @@ namespace Quartz
 		return true;
 	}
 
-	void GJK::Polytope::AddTriangle(const Triangle& tri)
+	bool GJK::Polytope::AddTriangle(const Triangle& tri)
 	{
-		// @TODO assert mSize < PHYSICS_EPA_MAX_TRIANGLES
+		if (mSize == PHYSICS_EPA_MAX_TRIS)
+		{
+			return false;
+		}
+
 		mTris[mSize++] = tri;
+
+		return true;
 	}
 
 	void GJK::Polytope::RemoveTriangle(uSize index)
@@ -89,6 +102,13 @@ namespace Quartz
 		return normal.Normalized();
 	}
 
+	// Polytope faces are not consistently wound, orient them away from the origin (always inside)
+	Vec3p CalcOutwardNormal(const GJK::Triangle& tri)
+	{
+		const Vec3p normal = CalcTriangleNormal(tri);
+		return Dot(normal, tri.points[0]) < 0.0f ? -normal : normal;
+	}
+
 	floatp DistanceToPlane(const Vec3p& point, const Vec3p& planePoint, const Vec3p& normal)
 	{
 		const Vec3p diff = point - planePoint;
@@ -104,7 +124,7 @@ namespace Quartz
 
 		for (uSize i = 0; i < mSize; i++)
 		{
-			Vec3p normal = CalcTriangleNormal(mTris[i]);
+			Vec3p normal = CalcOutwardNormal(mTris[i]);
 			floatp dist = DistanceToPlane(point, mTris[i].points[0], normal);
 
 			if (dist < closestDist)
@@ -122,7 +142,7 @@ namespace Quartz
 		outNormal	= closestNormal;
 	}
 
-	void GJK::Polytope::Extend(const Vec3p& point)
+	bool GJK::Polytope::Extend(const Vec3p& point)
 	{
 		Line	lines[PHYSICS_EPA_MAX_EDGES];
 		uSize	lineCount = 0;
@@ -134,7 +154,7 @@ namespace Quartz
 			Vec3p b = mTris[i].points[1];
 			Vec3p c = mTris[i].points[2];
 
-			Vec3p normal = CalcTriangleNormal(mTris[i]);
+			Vec3p normal = CalcOutwardNormal(mTris[i]);
 
 			if (Dot(normal, point - a) > 0.0f)
 			{
@@ -202,7 +222,13 @@ namespace Quartz
 		for (uSize i = 0; i < lineCount; i++)
 		{
 			Triangle newTriangle(lines[i].points[0], lines[i].points[1], point);
-			AddTriangle(newTriangle);
+
+			if (!AddTriangle(newTriangle))
+			{
+				return false;
+			}
 		}
+
+		return true;
 	}
 }
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include "GJKBatch.h"
+#include "GJK.h"
+#include <float.h>
+#include <assert.h>
+
+namespace Quartz
+{
+	void GJK::SupportLanes::SetLane(uSize lane, const Vec3p* pPoints, uSize count, const Vec3p& origin)
+	{
+		// Larger clouds would make SupportBatch read past the lanes, GJKBatch keeps them out
+		assert(count <= PHYSICS_BATCH_MAX_POINTS);
+
+		for (uSize i = 0; i < PHYSICS_BATCH_MAX_POINTS; i++)
+		{
+			// Pad with the first point, it can never change the result
+			const Vec3p point = count ? pPoints[i < count ? i : 0] - origin : Vec3p::ZERO;
+
+			x[i * PHYSICS_SIMD_WIDTH + lane] = (float)point.x;
+			y[i * PHYSICS_SIMD_WIDTH + lane] = (float)point.y;
+			z[i * PHYSICS_SIMD_WIDTH + lane] = (float)point.z;
+		}
+
+		maxCount = Max(maxCount, count);
+	}
+
+#if PHYSICS_SIMD_AVX
+
+	void GJK::SupportBatch(const SupportLanes& lanes, const SupportQuery& directions, SupportQuery& outPoints)
+	{
+		const __m256 dirX = _mm256_load_ps(directions.x);
+		const __m256 dirY = _mm256_load_ps(directions.y);
+		const __m256 dirZ = _mm256_load_ps(directions.z);
+
+		__m256 maxDist	= _mm256_set1_ps(-FLT_MAX);
+		__m256 maxX		= _mm256_setzero_ps();
+		__m256 maxY		= _mm256_setzero_ps();
+		__m256 maxZ		= _mm256_setzero_ps();
+
+		for (uSize i = 0; i < lanes.maxCount; i++)
+		{
+			const __m256 pointX = _mm256_load_ps(&lanes.x[i * PHYSICS_SIMD_WIDTH]);
+			const __m256 pointY = _mm256_load_ps(&lanes.y[i * PHYSICS_SIMD_WIDTH]);
+			const __m256 pointZ = _mm256_load_ps(&lanes.z[i * PHYSICS_SIMD_WIDTH]);
+
+			const __m256 dist = _mm256_add_ps(_mm256_add_ps(
+				_mm256_mul_ps(pointX, dirX),
+				_mm256_mul_ps(pointY, dirY)),
+				_mm256_mul_ps(pointZ, dirZ));
+
+			const __m256 greater = _mm256_cmp_ps(dist, maxDist, _CMP_GT_OQ);
+
+			maxDist	= _mm256_blendv_ps(maxDist, dist, greater);
+			maxX	= _mm256_blendv_ps(maxX, pointX, greater);
+			maxY	= _mm256_blendv_ps(maxY, pointY, greater);
+			maxZ	= _mm256_blendv_ps(maxZ, pointZ, greater);
+		}
+
+		_mm256_store_ps(outPoints.x, maxX);
+		_mm256_store_ps(outPoints.y, maxY);
+		_mm256_store_ps(outPoints.z, maxZ);
+	}
+
+#elif PHYSICS_SIMD_SSE
+
+	inline __m128 Select(__m128 mask, __m128 a, __m128 b)
+	{
+		return _mm_or_ps(_mm_and_ps(mask, b), _mm_andnot_ps(mask, a));
+	}
+
+	void GJK::SupportBatch(const SupportLanes& lanes, const SupportQuery& directions, SupportQuery& outPoints)
+	{
+		const __m128 dirX = _mm_load_ps(directions.x);
+		const __m128 dirY = _mm_load_ps(directions.y);
+		const __m128 dirZ = _mm_load_ps(directions.z);
+
+		__m128 maxDist	= _mm_set1_ps(-FLT_MAX);
+		__m128 maxX		= _mm_setzero_ps();
+		__m128 maxY		= _mm_setzero_ps();
+		__m128 maxZ		= _mm_setzero_ps();
+
+		for (uSize i = 0; i < lanes.maxCount; i++)
+		{
+			const __m128 pointX = _mm_load_ps(&lanes.x[i * PHYSICS_SIMD_WIDTH]);
+			const __m128 pointY = _mm_load_ps(&lanes.y[i * PHYSICS_SIMD_WIDTH]);
+			const __m128 pointZ = _mm_load_ps(&lanes.z[i * PHYSICS_SIMD_WIDTH]);
+
+			const __m128 dist = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(pointX, dirX),
+				_mm_mul_ps(pointY, dirY)),
+				_mm_mul_ps(pointZ, dirZ));
+
+			const __m128 greater = _mm_cmpgt_ps(dist, maxDist);
+
+			maxDist	= Select(greater, maxDist, dist);
+			maxX	= Select(greater, maxX, pointX);
+			maxY	= Select(greater, maxY, pointY);
+			maxZ	= Select(greater, maxZ, pointZ);
+		}
+
+		_mm_store_ps(outPoints.x, maxX);
+		_mm_store_ps(outPoints.y, maxY);
+		_mm_store_ps(outPoints.z, maxZ);
+	}
+
+#else
+
+	void GJK::SupportBatch(const SupportLanes& lanes, const SupportQuery& directions, SupportQuery& outPoints)
+	{
+		float maxDist[PHYSICS_SIMD_WIDTH];
+
+		for (uSize lane = 0; lane < PHYSICS_SIMD_WIDTH; lane++)
+		{
+			maxDist[lane]		= -FLT_MAX;
+			outPoints.x[lane]	= 0.0f;
+			outPoints.y[lane]	= 0.0f;
+			outPoints.z[lane]	= 0.0f;
+		}
+
+		for (uSize i = 0; i < lanes.maxCount; i++)
+		{
+			for (uSize lane = 0; lane < PHYSICS_SIMD_WIDTH; lane++)
+			{
+				const uSize index = i * PHYSICS_SIMD_WIDTH + lane;
+
+				const float dist =
+					lanes.x[index] * directions.x[lane] +
+					lanes.y[index] * directions.y[lane] +
+					lanes.z[index] * directions.z[lane];
+
+				if (dist > maxDist[lane])
+				{
+					maxDist[lane]		= dist;
+					outPoints.x[lane]	= lanes.x[index];
+					outPoints.y[lane]	= lanes.y[index];
+					outPoints.z[lane]	= lanes.z[index];
+				}
+			}
+		}
+	}
+
+#endif
+
+	enum BatchLaneState
+	{
+		BATCH_LANE_ACTIVE,
+		BATCH_LANE_HIT,
+		BATCH_LANE_MISS
+	};
+
+	static Vec3p FurthestCloudPoint(const Vec3p* pPoints, uSize count, const Vec3p& direction)
+	{
+		uSize furthest = 0;
+		floatp maxDist = Dot(pPoints[0], direction);
+
+		for (uSize i = 1; i < count; i++)
+		{
+			const floatp dist = Dot(pPoints[i], direction);
+
+			if (dist > maxDist)
+			{
+				maxDist = dist;
+				furthest = i;
+			}
+		}
+
+		return pPoints[furthest];
+	}
+
+	/* The steps of one lane on its own, for clouds too large for the lanes */
+	static bool GJKCloud(const GJK::BatchPair& pair, Simplex& outSimplex)
+	{
+		Simplex simplex;
+
+		Vec3p direction = Vec3p::X_AXIS;
+		Vec3p furthestPoint = FurthestCloudPoint(pair.pPoints0, pair.count0, direction) - 
+			FurthestCloudPoint(pair.pPoints1, pair.count1, -direction);
+
+		if (furthestPoint.IsZero())
+		{
+			return false;
+		}
+
+		simplex.Push(furthestPoint);
+		direction = -furthestPoint;
+
+		uSize iter = 0;
+		while (iter++ < PHYSICS_GJK_MAX_ITERATIONS)
+		{
+			furthestPoint = FurthestCloudPoint(pair.pPoints0, pair.count0, direction) - 
+				FurthestCloudPoint(pair.pPoints1, pair.count1, -direction);
+
+			if (Dot(furthestPoint, direction) <= 0.0f)
+			{
+				return false;
+			}
+
+			simplex.Push(furthestPoint);
+
+			if (simplex.Next(direction))
+			{
+				outSimplex = simplex;
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void GJK::GJKBatch(const BatchPair* pPairs, uSize count, Simplex* pOutSimplices, bool* pOutResults)
+	{
+		SupportLanes	lanes0;
+		SupportLanes	lanes1;
+		SupportQuery	directions0;
+		SupportQuery	directions1;
+		SupportQuery	points0;
+		SupportQuery	points1;
+
+		for (uSize base = 0; base < count; base += PHYSICS_SIMD_WIDTH)
+		{
+			const uSize laneCount = Min(count - base, (uSize)PHYSICS_SIMD_WIDTH);
+
+			Simplex			simplices[PHYSICS_SIMD_WIDTH];
+			Vec3p			directions[PHYSICS_SIMD_WIDTH];
+			BatchLaneState	states[PHYSICS_SIMD_WIDTH];
+			uSize			activeCount = laneCount;
+
+			lanes0.maxCount = 0;
+			lanes1.maxCount = 0;
+
+			for (uSize lane = 0; lane < PHYSICS_SIMD_WIDTH; lane++)
+			{
+				if (lane < laneCount)
+				{
+					const BatchPair& pair = pPairs[base + lane];
+
+					if (pair.count0 > PHYSICS_BATCH_MAX_POINTS || pair.count1 > PHYSICS_BATCH_MAX_POINTS)
+					{
+						// Decided here, the lane runs empty with the others
+						lanes0.SetLane(lane, nullptr, 0, Vec3p::ZERO);
+						lanes1.SetLane(lane, nullptr, 0, Vec3p::ZERO);
+
+						states[lane] = GJKCloud(pair, simplices[lane]) ? BATCH_LANE_HIT : BATCH_LANE_MISS;
+						activeCount--;
+					}
+					else
+					{
+						// Both clouds share an origin, so the minkowski difference is unchanged
+						const Vec3p origin = pair.pPoints0[0];
+
+						lanes0.SetLane(lane, pair.pPoints0, pair.count0, origin);
+						lanes1.SetLane(lane, pair.pPoints1, pair.count1, origin);
+
+						states[lane] = BATCH_LANE_ACTIVE;
+					}
+				}
+				else
+				{
+					lanes0.SetLane(lane, nullptr, 0, Vec3p::ZERO);
+					lanes1.SetLane(lane, nullptr, 0, Vec3p::ZERO);
+
+					states[lane] = BATCH_LANE_MISS;
+				}
+
+				// Check any inital direction (x-axis) for the furthest point in minkowski difference.
+				directions[lane] = Vec3p::X_AXIS;
+			}
+
+			uSize iter = 0;
+			while (activeCount > 0 && iter++ <= PHYSICS_GJK_MAX_ITERATIONS)
+			{
+				for (uSize lane = 0; lane < PHYSICS_SIMD_WIDTH; lane++)
+				{
+					directions0.x[lane] = (float)directions[lane].x;
+					directions0.y[lane] = (float)directions[lane].y;
+					directions0.z[lane] = (float)directions[lane].z;
+					directions1.x[lane] = -directions0.x[lane];
+					directions1.y[lane] = -directions0.y[lane];
+					directions1.z[lane] = -directions0.z[lane];
+				}
+
+				SupportBatch(lanes0, directions0, points0);
+				SupportBatch(lanes1, directions1, points1);
+
+				for (uSize lane = 0; lane < laneCount; lane++)
+				{
+					if (states[lane] != BATCH_LANE_ACTIVE)
+					{
+						continue;
+					}
+
+					const Vec3p furthestPoint(
+						(floatp)points0.x[lane] - (floatp)points1.x[lane],
+						(floatp)points0.y[lane] - (floatp)points1.y[lane],
+						(floatp)points0.z[lane] - (floatp)points1.z[lane]);
+
+					Simplex& simplex = simplices[lane];
+					Vec3p& direction = directions[lane];
+
+					if (simplex.Size() == 0)
+					{
+						// If the initial minkowski point is zero,
+						// the colliders are touching but not overlapping. Do not collide.
+						if (furthestPoint.IsZero())
+						{
+							states[lane] = BATCH_LANE_MISS;
+							activeCount--;
+							continue;
+						}
+
+						// Search in the opposite direction of the inital point.
+						simplex.Push(furthestPoint);
+						direction = -furthestPoint;
+						continue;
+					}
+
+					// Is the origin outside the search region
+					if (Dot(furthestPoint, direction) <= 0.0f)
+					{
+						states[lane] = BATCH_LANE_MISS;
+						activeCount--;
+						continue;
+					}
+
+					simplex.Push(furthestPoint);
+
+					if (simplex.Next(direction))
+					{
+						states[lane] = BATCH_LANE_HIT;
+						activeCount--;
+					}
+				}
+			}
+
+			for (uSize lane = 0; lane < laneCount; lane++)
+			{
+				// Lanes still active exceeded max iterations
+				pOutResults[base + lane] = states[lane] == BATCH_LANE_HIT;
+
+				if (pOutSimplices && states[lane] == BATCH_LANE_HIT)
+				{
+					pOutSimplices[base + lane] = simplices[lane];
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,580 @@
+#include "Hull.h"
+#include "Log.h"
+
+#include <algorithm>
+#include <float.h>
+
+#define HULL_NO_FACE		0xFFFFFFFF
+#define HULL_MERGE_ANGLE	0.9999f
+
+namespace Quartz
+{
+	struct CookFace
+	{
+		uInt32	vertices[3];
+		Vec3p	normal;
+		floatp	distance;
+		bool	removed;
+	};
+
+	static CookFace MakeCookFace(const Vec3p* pPoints, uInt32 a, uInt32 b, uInt32 c)
+	{
+		CookFace face;
+		face.vertices[0]	= a;
+		face.vertices[1]	= b;
+		face.vertices[2]	= c;
+		face.normal			= Cross(pPoints[b] - pPoints[a], pPoints[c] - pPoints[a]).Normalized();
+		face.distance		= Dot(face.normal, pPoints[a]);
+		face.removed		= false;
+
+		return face;
+	}
+
+	static void OrientCookFace(const Vec3p* pPoints, CookFace& face, const Vec3p& inside)
+	{
+		if (Dot(face.normal, inside) - face.distance > 0.0f)
+		{
+			face = MakeCookFace(pPoints, face.vertices[0], face.vertices[2], face.vertices[1]);
+		}
+	}
+
+	static floatp Axis(const Vec3p& vector, uSize axis)
+	{
+		return axis == 0 ? vector.x : (axis == 1 ? vector.y : vector.z);
+	}
+
+	static bool HasEdge(const CookFace& face, uInt32 a, uInt32 b)
+	{
+		for (uSize e = 0; e < 3; e++)
+		{
+			if (face.vertices[e] == a && face.vertices[(e + 1) % 3] == b)
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	HullData::HullData() :
+		mCentroid(Vec3p::ZERO), mVolume(0.0f), mSecondMoments(Vec3p::ZERO) {}
+
+	bool HullData::Cook(const Vec3p* pPoints, uSize count)
+	{
+		mVertices.Clear();
+		mNeighbourOffsets.Clear();
+		mNeighbours.Clear();
+		mFaces.Clear();
+		mFaceIndices.Clear();
+
+		if (count < 4)
+		{
+			LogError("Failed to cook hull: at least 4 points are required, got %d.", (int)count);
+			return false;
+		}
+
+		/* Extremes */
+
+		uInt32 minIndices[3] = { 0, 0, 0 };
+		uInt32 maxIndices[3] = { 0, 0, 0 };
+
+		for (uInt32 i = 1; i < count; i++)
+		{
+			for (uSize axis = 0; axis < 3; axis++)
+			{
+				if (Axis(pPoints[i], axis) < Axis(pPoints[minIndices[axis]], axis)) minIndices[axis] = i;
+				if (Axis(pPoints[i], axis) > Axis(pPoints[maxIndices[axis]], axis)) maxIndices[axis] = i;
+			}
+		}
+
+		floatp size = 0.0f;
+		uInt32 i0 = 0;
+		uInt32 i1 = 0;
+
+		for (uSize axis = 0; axis < 3; axis++)
+		{
+			const floatp extent = (pPoints[maxIndices[axis]] - pPoints[minIndices[axis]]).Magnitude();
+
+			if (extent > size)
+			{
+				size	= extent;
+				i0		= minIndices[axis];
+				i1		= maxIndices[axis];
+			}
+		}
+
+		const floatp epsilon = size * 1e-5f;
+
+		/* Initial tetrahedron */
+
+		const Vec3p lineDir = (pPoints[i1] - pPoints[i0]).Normalized();
+		floatp maxDist = 0.0f;
+		uInt32 i2 = 0;
+
+		for (uInt32 i = 0; i < count; i++)
+		{
+			const floatp dist = Cross(pPoints[i] - pPoints[i0], lineDir).Magnitude();
+
+			if (dist > maxDist)
+			{
+				maxDist = dist;
+				i2 = i;
+			}
+		}
+
+		const Vec3p planeNormal = Cross(pPoints[i1] - pPoints[i0], pPoints[i2] - pPoints[i0]).Normalized();
+		maxDist = 0.0f;
+		uInt32 i3 = 0;
+
+		for (uInt32 i = 0; i < count; i++)
+		{
+			const floatp dist = Abs(Dot(pPoints[i] - pPoints[i0], planeNormal));
+
+			if (dist > maxDist)
+			{
+				maxDist = dist;
+				i3 = i;
+			}
+		}
+
+		if (size <= epsilon || maxDist <= epsilon)
+		{
+			LogError("Failed to cook hull: points are degenerate (coplanar, collinear or coincident).");
+			return false;
+		}
+
+		const Vec3p inside = (pPoints[i0] + pPoints[i1] + pPoints[i2] + pPoints[i3]) * 0.25f;
+
+		Array<CookFace> faces;
+		faces.PushBack(MakeCookFace(pPoints, i0, i1, i2));
+		faces.PushBack(MakeCookFace(pPoints, i0, i1, i3));
+		faces.PushBack(MakeCookFace(pPoints, i0, i2, i3));
+		faces.PushBack(MakeCookFace(pPoints, i1, i2, i3));
+
+		for (CookFace& face : faces)
+		{
+			OrientCookFace(pPoints, face, inside);
+		}
+
+		/* Assign every point to a face it lies outside of */
+
+		Array<uInt32> pointFaces;
+		pointFaces.Resize(count);
+
+		for (uInt32 i = 0; i < count; i++)
+		{
+			pointFaces[i] = HULL_NO_FACE;
+
+			for (uInt32 f = 0; f < faces.Size(); f++)
+			{
+				if (Dot(faces[f].normal, pPoints[i]) - faces[f].distance > epsilon)
+				{
+					pointFaces[i] = f;
+					break;
+				}
+			}
+		}
+
+		/* Expand towards the furthest outside point until none are left */
+
+		Array<uInt32> visible;
+		Array<uInt32> horizon;
+		Array<uInt32> newFaces;
+
+		while (true)
+		{
+			uInt32 eye = HULL_NO_FACE;
+			floatp eyeDist = epsilon;
+
+			for (uInt32 i = 0; i < count; i++)
+			{
+				const uInt32 f = pointFaces[i];
+
+				if (f != HULL_NO_FACE)
+				{
+					const floatp dist = Dot(faces[f].normal, pPoints[i]) - faces[f].distance;
+
+					if (dist > eyeDist)
+					{
+						eyeDist = dist;
+						eye = i;
+					}
+				}
+			}
+
+			if (eye == HULL_NO_FACE)
+			{
+				break;
+			}
+
+			visible.Clear();
+			horizon.Clear();
+			newFaces.Clear();
+
+			for (uInt32 f = 0; f < faces.Size(); f++)
+			{
+				if (!faces[f].removed && Dot(faces[f].normal, pPoints[eye]) - faces[f].distance > epsilon)
+				{
+					visible.PushBack(f);
+				}
+			}
+
+			// Horizon edges belong to exactly one visible face
+			for (uInt32 f : visible)
+			{
+				for (uSize e = 0; e < 3; e++)
+				{
+					const uInt32 a = faces[f].vertices[e];
+					const uInt32 b = faces[f].vertices[(e + 1) % 3];
+
+					bool shared = false;
+
+					for (uInt32 g : visible)
+					{
+						if (HasEdge(faces[g], b, a))
+						{
+							shared = true;
+							break;
+						}
+					}
+
+					if (!shared)
+					{
+						horizon.PushBack(a);
+						horizon.PushBack(b);
+					}
+				}
+			}
+
+			for (uInt32 f : visible)
+			{
+				faces[f].removed = true;
+			}
+
+			for (uSize h = 0; h < horizon.Size(); h += 2)
+			{
+				newFaces.PushBack(faces.Size());
+				faces.PushBack(MakeCookFace(pPoints, horizon[h], horizon[h + 1], eye));
+			}
+
+			pointFaces[eye] = HULL_NO_FACE;
+
+			for (uInt32 i = 0; i < count; i++)
+			{
+				const uInt32 f = pointFaces[i];
+
+				if (f == HULL_NO_FACE || !faces[f].removed)
+				{
+					continue;
+				}
+
+				pointFaces[i] = HULL_NO_FACE;
+
+				for (uInt32 newFace : newFaces)
+				{
+					if (Dot(faces[newFace].normal, pPoints[i]) - faces[newFace].distance > epsilon)
+					{
+						pointFaces[i] = newFace;
+						break;
+					}
+				}
+			}
+		}
+
+		/* Compact vertices */
+
+		Array<uInt32> remap;
+		Array<CookFace> triangles;
+		remap.Resize(count);
+
+		for (uInt32 i = 0; i < count; i++)
+		{
+			remap[i] = HULL_NO_FACE;
+		}
+
+		for (const CookFace& face : faces)
+		{
+			if (face.removed)
+			{
+				continue;
+			}
+
+			CookFace triangle = face;
+
+			for (uSize v = 0; v < 3; v++)
+			{
+				const uInt32 index = face.vertices[v];
+
+				if (remap[index] == HULL_NO_FACE)
+				{
+					remap[index] = mVertices.Size();
+					mVertices.PushBack(pPoints[index]);
+				}
+
+				triangle.vertices[v] = remap[index];
+			}
+
+			triangles.PushBack(triangle);
+		}
+
+		/* Merge coplanar neighbouring triangles into polygon faces */
+
+		Array<uInt32> triangleFaces;
+		Array<uInt32> stack;
+		Array<uInt32> boundary;
+		triangleFaces.Resize(triangles.Size());
+
+		for (uInt32 t = 0; t < triangles.Size(); t++)
+		{
+			triangleFaces[t] = HULL_NO_FACE;
+		}
+
+		for (uInt32 seed = 0; seed < triangles.Size(); seed++)
+		{
+			if (triangleFaces[seed] != HULL_NO_FACE)
+			{
+				continue;
+			}
+
+			const uInt32 faceIndex = mFaces.Size();
+			const Vec3p& normal = triangles[seed].normal;
+
+			stack.Clear();
+			stack.PushBack(seed);
+			triangleFaces[seed] = faceIndex;
+
+			for (uSize s = 0; s < stack.Size(); s++)
+			{
+				const CookFace& triangle = triangles[stack[s]];
+
+				for (uInt32 t = 0; t < triangles.Size(); t++)
+				{
+					if (triangleFaces[t] != HULL_NO_FACE || Dot(triangles[t].normal, normal) < HULL_MERGE_ANGLE)
+					{
+						continue;
+					}
+
+					for (uSize e = 0; e < 3; e++)
+					{
+						if (HasEdge(triangles[t], triangle.vertices[(e + 1) % 3], triangle.vertices[e]))
+						{
+							triangleFaces[t] = faceIndex;
+							stack.PushBack(t);
+							break;
+						}
+					}
+				}
+			}
+
+			// Outline edges are not shared by two triangles of the face
+			boundary.Clear();
+
+			for (uInt32 t : stack)
+			{
+				for (uSize e = 0; e < 3; e++)
+				{
+					const uInt32 a = triangles[t].vertices[e];
+					const uInt32 b = triangles[t].vertices[(e + 1) % 3];
+
+					bool shared = false;
+
+					for (uInt32 u : stack)
+					{
+						if (HasEdge(triangles[u], b, a))
+						{
+							shared = true;
+							break;
+						}
+					}
+
+					if (!shared)
+					{
+						boundary.PushBack(a);
+						boundary.PushBack(b);
+					}
+				}
+			}
+
+			HullFace face;
+			face.normal		= normal;
+			face.distance	= -FLT_MAX;
+			face.firstIndex	= mFaceIndices.Size();
+			face.indexCount	= 0;
+
+			// Chain the outline edges into a loop
+			uInt32 current = boundary[0];
+
+			for (uSize guard = 0; guard < boundary.Size() / 2; guard++)
+			{
+				mFaceIndices.PushBack(current);
+				face.distance = Max(face.distance, Dot(normal, mVertices[current]));
+				face.indexCount++;
+
+				uInt32 next = HULL_NO_FACE;
+
+				for (uSize b = 0; b < boundary.Size(); b += 2)
+				{
+					if (boundary[b] == current)
+					{
+						next = boundary[b + 1];
+						break;
+					}
+				}
+
+				if (next == HULL_NO_FACE || next == boundary[0])
+				{
+					break;
+				}
+
+				current = next;
+			}
+
+			mFaces.PushBack(face);
+		}
+
+		/* Vertex neighbours from the face outlines */
+
+		Array<uInt64> edges;
+
+		for (const HullFace& face : mFaces)
+		{
+			for (uInt32 i = 0; i < face.indexCount; i++)
+			{
+				const uInt64 a = mFaceIndices[face.firstIndex + i];
+				const uInt64 b = mFaceIndices[face.firstIndex + (i + 1) % face.indexCount];
+
+				edges.PushBack((a << 32) | b);
+				edges.PushBack((b << 32) | a);
+			}
+		}
+
+		std::sort(edges.Data(), edges.Data() + edges.Size());
+		const uSize edgeCount = std::unique(edges.Data(), edges.Data() + edges.Size()) - edges.Data();
+
+		mNeighbourOffsets.Resize(mVertices.Size() + 1);
+		mNeighbours.Resize(edgeCount);
+
+		uSize edgeIndex = 0;
+
+		for (uInt32 v = 0; v < mVertices.Size(); v++)
+		{
+			mNeighbourOffsets[v] = edgeIndex;
+
+			while (edgeIndex < edgeCount && (edges[edgeIndex] >> 32) == v)
+			{
+				mNeighbours[edgeIndex] = (uInt32)(edges[edgeIndex] & 0xFFFFFFFF);
+				edgeIndex++;
+			}
+		}
+
+		mNeighbourOffsets[mVertices.Size()] = edgeIndex;
+
+		/* Centroid */
+
+		mCentroid = Vec3p::ZERO;
+
+		for (const Vec3p& vertex : mVertices)
+		{
+			mCentroid += vertex;
+		}
+
+		mCentroid = mCentroid * (1.0f / (floatp)mVertices.Size());
+
+		/* Mass properties */
+
+		// Each face is fanned into tetrahedra with the centroid, which lies inside the hull
+		Vec3p moments = Vec3p::ZERO;
+		mVolume = 0.0f;
+
+		for (const HullFace& face : mFaces)
+		{
+			const Vec3p& a = mVertices[mFaceIndices[face.firstIndex]];
+
+			for (uInt32 i = 1; i + 1 < face.indexCount; i++)
+			{
+				const Vec3p& b = mVertices[mFaceIndices[face.firstIndex + i]];
+				const Vec3p& c = mVertices[mFaceIndices[face.firstIndex + i + 1]];
+
+				const floatp volume = Dot(a - mCentroid, Cross(b - mCentroid, c - mCentroid)) * (1.0f / 6.0f);
+				const Vec3p sum = mCentroid + a + b + c;
+
+				// Integral of x^2 over a tetrahedron is V / 20 * (sum of x_i^2 + (sum of x_i)^2)
+				moments.x += volume * (1.0f / 20.0f) * (mCentroid.x * mCentroid.x + a.x * a.x + b.x * b.x + c.x * c.x + sum.x * sum.x);
+				moments.y += volume * (1.0f / 20.0f) * (mCentroid.y * mCentroid.y + a.y * a.y + b.y * b.y + c.y * c.y + sum.y * sum.y);
+				moments.z += volume * (1.0f / 20.0f) * (mCentroid.z * mCentroid.z + a.z * a.z + b.z * b.z + c.z * c.z + sum.z * sum.z);
+
+				mVolume += volume;
+			}
+		}
+
+		mSecondMoments = mVolume > 0.0f ? moments * (1.0f / mVolume) : Vec3p::ZERO;
+
+		return true;
+	}
+
+	uInt32 HullData::SupportIndex(const Vec3p& direction, uInt32 startIndex) const
+	{
+		uInt32 current = startIndex < mVertices.Size() ? startIndex : 0;
+		floatp currentDist = Dot(mVertices[current], direction);
+
+		bool climbing = true;
+
+		while (climbing)
+		{
+			climbing = false;
+
+			for (uInt32 n = mNeighbourOffsets[current]; n < mNeighbourOffsets[current + 1]; n++)
+			{
+				const uInt32 neighbour = mNeighbours[n];
+				const floatp dist = Dot(mVertices[neighbour], direction);
+
+				if (dist > currentDist)
+				{
+					current		= neighbour;
+					currentDist	= dist;
+					climbing	= true;
+					break;
+				}
+			}
+		}
+
+		return current;
+	}
+
+	uInt32 HullData::SupportFace(const Vec3p& direction) const
+	{
+		uInt32 bestFace = 0;
+		floatp bestDot = -FLT_MAX;
+
+		for (uInt32 f = 0; f < mFaces.Size(); f++)
+		{
+			const floatp dot = Dot(mFaces[f].normal, direction);
+
+			if (dot > bestDot)
+			{
+				bestDot = dot;
+				bestFace = f;
+			}
+		}
+
+		return bestFace;
+	}
+
+	const HullData& HullData::UnitBox()
+	{
+		static const Vec3p points[8]
+		{
+			{ -1.0f, -1.0f, -1.0f }, {  1.0f, -1.0f, -1.0f },
+			{ -1.0f,  1.0f, -1.0f }, {  1.0f,  1.0f, -1.0f },
+			{ -1.0f, -1.0f,  1.0f }, {  1.0f, -1.0f,  1.0f },
+			{ -1.0f,  1.0f,  1.0f }, {  1.0f,  1.0f,  1.0f }
+		};
+
+		static HullData box;
+		static bool cooked = box.Cook(points, 8);
+
+		(void)cooked;
+
+		return box;
+	}
+}
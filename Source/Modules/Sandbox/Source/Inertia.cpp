@@ -1,4 +1,5 @@
 #include "Physics.h"
+#include <float.h>
 
 namespace Quartz
 {
@@ -45,31 +46,132 @@ namespace Quartz
 
 	Vec3p Physics::InitalInertiaCapsule(const RigidBody& rigidBody, const CapsuleCollider& capsule, const Vec3p& scale)
 	{
-		return Vec3p(1.0f);
+		if (rigidBody.invMass != 0.0f)
+		{
+			// Cylinder plus two hemispheres, mass split by volume
+			floatp radius	= capsule.GetCapsule().radius * Max(scale.x, scale.z);
+			floatp height	= capsule.GetCapsule().halfHeight * scale.y * 2.0f;
+
+			floatp cylinderVolume	= height * radius * radius;
+			floatp sphereVolume		= (4.0f / 3.0f) * radius * radius * radius;
+			floatp mass				= 1.0f / rigidBody.invMass;
+			floatp cylinderMass		= mass * cylinderVolume / (cylinderVolume + sphereVolume);
+			floatp sphereMass		= mass - cylinderMass;
+			floatp radiusSquared	= radius * radius;
+
+			floatp iy = cylinderMass * radiusSquared * 0.5f + sphereMass * radiusSquared * (2.0f / 5.0f);
+			floatp ix = cylinderMass * (radiusSquared * 0.25f + height * height * (1.0f / 12.0f)) +
+				sphereMass * (radiusSquared * (2.0f / 5.0f) + height * height * 0.25f + height * radius * (3.0f / 8.0f));
+
+			return Vec3p(ix, iy, ix);
+		}
+
+		return Vec3p(0, 0, 0);
 	}
 
 	Vec3p Physics::InitalInertiaHull(const RigidBody& rigidBody, const HullCollider& hull, const Vec3p& scale)
 	{
-		return Vec3p(1.0f);
+		if (rigidBody.invMass != 0.0f)
+		{
+			// Solid hull of uniform density about the body origin, scaling stretches each second moment
+			const Vec3p& moments = hull.GetHull().pHullData->GetSecondMoments();
+
+			floatp xx = moments.x * scale.x * scale.x;
+			floatp yy = moments.y * scale.y * scale.y;
+			floatp zz = moments.z * scale.z * scale.z;
+
+			floatp mass = 1.0f / rigidBody.invMass;
+
+			return Vec3p(mass * (yy + zz), mass * (xx + zz), mass * (xx + yy));
+		}
+
+		return Vec3p(0, 0, 0);
 	}
 
 	Vec3p Physics::InitalInertiaMesh(const RigidBody& rigidBody, const MeshCollider& mesh, const Vec3p& scale)
 	{
-		return Vec3p(1.0f);
+		return Vec3p(0, 0, 0); // Meshes are always static
+	}
+
+	Vec3p Physics::InitalInertiaCompound(const RigidBody& rigidBody, const CompoundCollider& compound, const Vec3p& scale)
+	{
+		if (rigidBody.invMass != 0.0f)
+		{
+			// Mass split by the volume of each child's bounds, about the body origin
+			const CompoundData& compoundData = *compound.GetCompound().pCompound;
+			floatp totalVolume = 0.0f;
+
+			for (uInt32 i = 0; i < compoundData.GetChildCount(); i++)
+			{
+				const CompoundChild& child = compoundData.GetChild(i);
+				const Vec3p size = child.max - child.min;
+
+				totalVolume += size.x * size.y * size.z;
+			}
+
+			if (totalVolume <= 0.0f)
+			{
+				return Vec3p(0, 0, 0);
+			}
+
+			const floatp mass = 1.0f / rigidBody.invMass;
+			Vec3p inertia = Vec3p(0, 0, 0);
+
+			for (uInt32 i = 0; i < compoundData.GetChildCount(); i++)
+			{
+				const CompoundChild& child = compoundData.GetChild(i);
+				const Vec3p size = child.max - child.min;
+				const floatp childMass = mass * (size.x * size.y * size.z) / totalVolume;
+
+				if (childMass <= 0.0f)
+				{
+					continue;
+				}
+
+				RigidBody childBody = rigidBody;
+				childBody.invMass = 1.0f / childMass;
+
+				const Transform& local = child.transform;
+				const Vec3p childScale(scale.x * local.scale.x, scale.y * local.scale.y, scale.z * local.scale.z);
+				const Vec3p childInertia = InitalInertia(childBody, child.collider, childScale);
+
+				// Diagonal of the child's rotated tensor, products of inertia are dropped as for every body
+				const Quatp rotation(local.rotation);
+				const Vec3p axisX = rotation * Vec3p::X_AXIS;
+				const Vec3p axisY = rotation * Vec3p::Y_AXIS;
+				const Vec3p axisZ = rotation * Vec3p::Z_AXIS;
+
+				inertia.x += axisX.x * axisX.x * childInertia.x + axisY.x * axisY.x * childInertia.y + axisZ.x * axisZ.x * childInertia.z;
+				inertia.y += axisX.y * axisX.y * childInertia.x + axisY.y * axisY.y * childInertia.y + axisZ.y * axisZ.y * childInertia.z;
+				inertia.z += axisX.z * axisX.z * childInertia.x + axisY.z * axisY.z * childInertia.y + axisZ.z * axisZ.z * childInertia.z;
+
+				// Parallel axis
+				const Vec3p offset(local.position.x * scale.x, local.position.y * scale.y, local.position.z * scale.z);
+
+				inertia.x += childMass * (offset.y * offset.y + offset.z * offset.z);
+				inertia.y += childMass * (offset.x * offset.x + offset.z * offset.z);
+				inertia.z += childMass * (offset.x * offset.x + offset.y * offset.y);
+			}
+
+			return inertia;
+		}
+
+		return Vec3p(0, 0, 0);
 	}
 
 	Vec3p Physics::InitalInertia(const RigidBody& rigidBody, const Collider& collider, const Vec3p& scale)
 	{
 		using InitalInertiaFunc = Vec3p(*)(const RigidBody& rigidBody, const Collider& collider, const Vec3p& scale);
 
-		static InitalInertiaFunc functionTable[6]
+		static InitalInertiaFunc functionTable[7]
 		{
 			(InitalInertiaFunc) InitalInertiaSphere,
 			(InitalInertiaFunc) InitalInertiaPlane,
 			(InitalInertiaFunc) InitalInertiaRect,
 			(InitalInertiaFunc) InitalInertiaCapsule,
 			(InitalInertiaFunc) InitalInertiaHull,
-			(InitalInertiaFunc) InitalInertiaMesh
+			(InitalInertiaFunc) InitalInertiaMesh,
+			(InitalInertiaFunc) InitalInertiaCompound
 		};
 
 		return functionTable[(uSize)collider.GetShapeType()](rigidBody, collider, scale);
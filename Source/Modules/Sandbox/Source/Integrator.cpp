@@ -0,0 +1,180 @@
+#include "Integrator.h"
+
+#include <math.h>
+
+namespace Quartz
+{
+	void BodyArrays::Resize(uSize count)
+	{
+		Array<floatp>* fields[] =
+		{
+			&positionX, &positionY, &positionZ,
+			&rotationX, &rotationY, &rotationZ, &rotationW,
+			&linearX, &linearY, &linearZ,
+			&angularX, &angularY, &angularZ,
+			&forceX, &forceY, &forceZ,
+			&torqueX, &torqueY, &torqueZ,
+			&gravityX, &gravityY, &gravityZ,
+			&invInertiaX, &invInertiaY, &invInertiaZ,
+			&tensorXX, &tensorXY, &tensorXZ, &tensorYY, &tensorYZ, &tensorZZ,
+			&awake, &dynamic
+		};
+
+		for (Array<floatp>* pField : fields)
+		{
+			pField->Resize(count);
+		}
+	}
+
+	/*
+		The kernels below are straight loops over contiguous arrays with no
+		branches, sleeping and static bodies are masked out by multiplying with
+		awake and dynamic, so the compiler can vectorize every loop.
+	*/
+
+	void Integrator::ApplyForces(BodyArrays& bodies, floatp stepTime, floatp linearDrag, floatp angularDrag)
+	{
+		const uSize count = bodies.Size();
+
+		floatp* pLinearX	= bodies.linearX.Data();
+		floatp* pLinearY	= bodies.linearY.Data();
+		floatp* pLinearZ	= bodies.linearZ.Data();
+		floatp* pAngularX	= bodies.angularX.Data();
+		floatp* pAngularY	= bodies.angularY.Data();
+		floatp* pAngularZ	= bodies.angularZ.Data();
+		floatp* pForceX		= bodies.forceX.Data();
+		floatp* pForceY		= bodies.forceY.Data();
+		floatp* pForceZ		= bodies.forceZ.Data();
+		floatp* pTorqueX	= bodies.torqueX.Data();
+		floatp* pTorqueY	= bodies.torqueY.Data();
+		floatp* pTorqueZ	= bodies.torqueZ.Data();
+
+		const floatp* pGravityX	= bodies.gravityX.Data();
+		const floatp* pGravityY	= bodies.gravityY.Data();
+		const floatp* pGravityZ	= bodies.gravityZ.Data();
+		const floatp* pAwake	= bodies.awake.Data();
+		const floatp* pDynamic	= bodies.dynamic.Data();
+
+		for (uSize i = 0; i < count; i++)
+		{
+			const floatp linearScale	= pAwake[i] * (linearDrag - 1.0f) + 1.0f;
+			const floatp angularScale	= pAwake[i] * (angularDrag - 1.0f) + 1.0f;
+			const floatp gravity		= pAwake[i] * pDynamic[i] * stepTime;
+			const floatp force			= pAwake[i] * stepTime;
+
+			pLinearX[i] = (pLinearX[i] + pGravityX[i] * gravity + pForceX[i] * force) * linearScale;
+			pLinearY[i] = (pLinearY[i] + pGravityY[i] * gravity + pForceY[i] * force) * linearScale;
+			pLinearZ[i] = (pLinearZ[i] + pGravityZ[i] * gravity + pForceZ[i] * force) * linearScale;
+
+			pAngularX[i] = (pAngularX[i] + pTorqueX[i] * force) * angularScale;
+			pAngularY[i] = (pAngularY[i] + pTorqueY[i] * force) * angularScale;
+			pAngularZ[i] = (pAngularZ[i] + pTorqueZ[i] * force) * angularScale;
+
+			// Forces only last for the first substep
+			pForceX[i] = 0.0f;
+			pForceY[i] = 0.0f;
+			pForceZ[i] = 0.0f;
+			pTorqueX[i] = 0.0f;
+			pTorqueY[i] = 0.0f;
+			pTorqueZ[i] = 0.0f;
+		}
+	}
+
+	void Integrator::Integrate(BodyArrays& bodies, const floatp* pMotionScales, floatp stepTime)
+	{
+		const uSize count = bodies.Size();
+
+		floatp* pPositionX	= bodies.positionX.Data();
+		floatp* pPositionY	= bodies.positionY.Data();
+		floatp* pPositionZ	= bodies.positionZ.Data();
+		floatp* pRotationX	= bodies.rotationX.Data();
+		floatp* pRotationY	= bodies.rotationY.Data();
+		floatp* pRotationZ	= bodies.rotationZ.Data();
+		floatp* pRotationW	= bodies.rotationW.Data();
+		floatp* pTensorXX	= bodies.tensorXX.Data();
+		floatp* pTensorXY	= bodies.tensorXY.Data();
+		floatp* pTensorXZ	= bodies.tensorXZ.Data();
+		floatp* pTensorYY	= bodies.tensorYY.Data();
+		floatp* pTensorYZ	= bodies.tensorYZ.Data();
+		floatp* pTensorZZ	= bodies.tensorZZ.Data();
+
+		const floatp* pLinearX		= bodies.linearX.Data();
+		const floatp* pLinearY		= bodies.linearY.Data();
+		const floatp* pLinearZ		= bodies.linearZ.Data();
+		const floatp* pAngularX		= bodies.angularX.Data();
+		const floatp* pAngularY		= bodies.angularY.Data();
+		const floatp* pAngularZ		= bodies.angularZ.Data();
+		const floatp* pInvInertiaX	= bodies.invInertiaX.Data();
+		const floatp* pInvInertiaY	= bodies.invInertiaY.Data();
+		const floatp* pInvInertiaZ	= bodies.invInertiaZ.Data();
+		const floatp* pAwake		= bodies.awake.Data();
+
+		for (uSize i = 0; i < count; i++)
+		{
+			/* Linear, clamped to the time of impact for continuous bodies */
+
+			const floatp linearTime = pAwake[i] * pMotionScales[i] * stepTime;
+
+			pPositionX[i] += pLinearX[i] * linearTime;
+			pPositionY[i] += pLinearY[i] * linearTime;
+			pPositionZ[i] += pLinearZ[i] * linearTime;
+
+			/* Angular, q += 0.5 * (w, 0) * q * dt */
+
+			const floatp halfTime = pAwake[i] * 0.5f * stepTime;
+			const floatp wx = pAngularX[i] * halfTime;
+			const floatp wy = pAngularY[i] * halfTime;
+			const floatp wz = pAngularZ[i] * halfTime;
+
+			floatp qx = pRotationX[i];
+			floatp qy = pRotationY[i];
+			floatp qz = pRotationZ[i];
+			floatp qw = pRotationW[i];
+
+			const floatp dx =  wx * qw + wy * qz - wz * qy;
+			const floatp dy =  wy * qw + wz * qx - wx * qz;
+			const floatp dz =  wz * qw + wx * qy - wy * qx;
+			const floatp dw = -wx * qx - wy * qy - wz * qz;
+
+			qx += dx;
+			qy += dy;
+			qz += dz;
+			qw += dw;
+
+			const floatp invLength = 1.0f / sqrt(qx * qx + qy * qy + qz * qz + qw * qw);
+
+			qx *= invLength;
+			qy *= invLength;
+			qz *= invLength;
+			qw *= invLength;
+
+			pRotationX[i] = qx;
+			pRotationY[i] = qy;
+			pRotationZ[i] = qz;
+			pRotationW[i] = qw;
+
+			/* World inverse inertia, R * diag(invInertia) * R^T */
+
+			const floatp r00 = 1.0f - 2.0f * (qy * qy + qz * qz);
+			const floatp r01 = 2.0f * (qx * qy - qw * qz);
+			const floatp r02 = 2.0f * (qx * qz + qw * qy);
+			const floatp r10 = 2.0f * (qx * qy + qw * qz);
+			const floatp r11 = 1.0f - 2.0f * (qx * qx + qz * qz);
+			const floatp r12 = 2.0f * (qy * qz - qw * qx);
+			const floatp r20 = 2.0f * (qx * qz - qw * qy);
+			const floatp r21 = 2.0f * (qy * qz + qw * qx);
+			const floatp r22 = 1.0f - 2.0f * (qx * qx + qy * qy);
+
+			const floatp ix = pInvInertiaX[i];
+			const floatp iy = pInvInertiaY[i];
+			const floatp iz = pInvInertiaZ[i];
+
+			pTensorXX[i] = r00 * r00 * ix + r01 * r01 * iy + r02 * r02 * iz;
+			pTensorXY[i] = r00 * r10 * ix + r01 * r11 * iy + r02 * r12 * iz;
+			pTensorXZ[i] = r00 * r20 * ix + r01 * r21 * iy + r02 * r22 * iz;
+			pTensorYY[i] = r10 * r10 * ix + r11 * r11 * iy + r12 * r12 * iz;
+			pTensorYZ[i] = r10 * r20 * ix + r11 * r21 * iy + r12 * r22 * iz;
+			pTensorZZ[i] = r20 * r20 * ix + r21 * r21 * iy + r22 * r22 * iz;
+		}
+	}
+}
@@ -0,0 +1,71 @@
+#include "Joint.h"
+
+namespace Quartz
+{
+	static Vec3p ToLocal(const Transform& transform, const Vec3p& point)
+	{
+		const Mat3p invRotation = Mat3p().SetRotation(Quatp(transform.rotation)).Transposed();
+		return invRotation * (point - Vec3p(transform.position));
+	}
+
+	static Vec3p ToLocalDirection(const Transform& transform, const Vec3p& direction)
+	{
+		const Mat3p invRotation = Mat3p().SetRotation(Quatp(transform.rotation)).Transposed();
+		return invRotation * direction;
+	}
+
+	Joint::Joint() :
+		type(JOINT_BALL), collideConnected(false),
+		localAnchor0(), localAnchor1(), localAxis0(), localAxis1(), relativeRotation(), distance(0), rope(false),
+		angularRowCount(0), rowBias{}, rowMass{}, axisMass(0), axisBias(0), massScale(1), impulseScale(0),
+		linearImpulse(), angularImpulse(), axisImpulse(0) {}
+
+	void Joint::CalcLocalPoints(const Transform& transform0, const Transform& transform1)
+	{
+		localPoint0 = Quatp(transform0.rotation) * localAnchor0;
+		localPoint1 = Quatp(transform1.rotation) * localAnchor1;
+	}
+
+	BallJoint::BallJoint(const Transform& transform0, const Transform& transform1, const Vec3p& anchor)
+	{
+		type			= JOINT_BALL;
+		localAnchor0	= ToLocal(transform0, anchor);
+		localAnchor1	= ToLocal(transform1, anchor);
+	}
+
+	HingeJoint::HingeJoint(const Transform& transform0, const Transform& transform1, const Vec3p& anchor, const Vec3p& axis)
+	{
+		const Vec3p direction = axis * (1.0f / sqrt(Dot(axis, axis)));
+
+		type			= JOINT_HINGE;
+		localAnchor0	= ToLocal(transform0, anchor);
+		localAnchor1	= ToLocal(transform1, anchor);
+		localAxis0		= ToLocalDirection(transform0, direction);
+		localAxis1		= ToLocalDirection(transform1, direction);
+	}
+
+	DistanceJoint::DistanceJoint(const Transform& transform0, const Transform& transform1,
+		const Vec3p& anchor0, const Vec3p& anchor1, bool rope)
+	{
+		const Vec3p offset = anchor0 - anchor1;
+
+		type			= JOINT_DISTANCE;
+		localAnchor0	= ToLocal(transform0, anchor0);
+		localAnchor1	= ToLocal(transform1, anchor1);
+		distance		= sqrt(Dot(offset, offset));
+		this->rope		= rope;
+	}
+
+	FixedJoint::FixedJoint(const Transform& transform0, const Transform& transform1, const Vec3p& anchor)
+	{
+		Quatp invRotation1 = Quatp(transform1.rotation);
+		invRotation1.x = -invRotation1.x;
+		invRotation1.y = -invRotation1.y;
+		invRotation1.z = -invRotation1.z;
+
+		type				= JOINT_FIXED;
+		localAnchor0		= ToLocal(transform0, anchor);
+		localAnchor1		= ToLocal(transform1, anchor);
+		relativeRotation	= invRotation1 * Quatp(transform0.rotation);
+	}
+}
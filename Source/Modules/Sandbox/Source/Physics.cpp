@@ -1,453 +1,1347 @@
 #include "Physics.h"
+#include "Log.h"
+#include "Utility/Swap.h"
+
+#include <algorithm>
 
 namespace Quartz
 {
-	void Physics::ApplyForces(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
+	Physics::Physics() :
+		mSolverIterations(0), mMaxPenetration(0), mResidualPenetration(0), mLinearDrag(1.0f), mAngularDrag(1.0f), 
+		mWorldBody(0.0f, 0.0f, 0.0f, { 0.0f, 0.0f, 0.0f }), mThreadCount(1),
+		mWorkGeneration(0), mWorkActive(0), mWorkPending(0), mStopWorkers(false), mNextChunk(0), mTimings{}, mStats{}, mLogStats(false), mMeasurePenetration(false), mMeshOverflowWarned(false), mStateHash(0)
+	{
+		mWorldBody.linearVelocity	= Vec3p(0.0f, 0.0f, 0.0f);
+		mWorldBody.angularVelocity	= Vec3p(0.0f, 0.0f, 0.0f);
+
+		mWorldTransform.position	= Vec3f(0.0f, 0.0f, 0.0f);
+		mWorldTransform.rotation	= Quatf();
+		mWorldTransform.scale		= Vec3f(1.0f, 1.0f, 1.0f);
+	}
+
+	Physics::~Physics()
+	{
+		StopWorkers();
+	}
+
+	inline uInt64 MakePairKey(Entity entity0, Entity entity1)
+	{
+		return ((uInt64)entity0.handle << 32) | (uInt64)entity1.handle;
+	}
+
+	inline bool IsDynamic(const RigidBodyComponent& physics)
+	{
+		return !physics.collider.IsStatic() && physics.rigidBody.invMass != 0.0f;
+	}
+
+	void Physics::GatherBodies(EntityWorld& world, RigidBodyView& rigidBodies)
 	{
+		mEntities.Clear();
+		mBodyPhysics.Clear();
+		mBodyTransforms.Clear();
+
 		for (Entity& entity : rigidBodies)
 		{
-			RigidBodyComponent& physics = world.Get<RigidBodyComponent>(entity);
-			TransformComponent& transform = world.Get<TransformComponent>(entity);
+			mEntities.PushBack(entity);
+			mBodyPhysics.PushBack(&world.Get<RigidBodyComponent>(entity));
+			mBodyTransforms.PushBack(&world.Get<TransformComponent>(entity));
+		}
 
-			RigidBody& rigidBody = physics.rigidBody;
+#if PHYSICS_DETERMINISTIC
+		SortBodies();
+#endif
 
-			if (rigidBody.asleep)
+		mBodies.Resize(mEntities.Size());
+
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			const RigidBody& rigidBody = mBodyPhysics[i]->rigidBody;
+			const TransformComponent& transform = *mBodyTransforms[i];
+
+			const floatp mass = rigidBody.invMass != 0.0f ? 1.0f / rigidBody.invMass : 0.0f;
+
+			mBodies.positionX[i]	= transform.position.x;
+			mBodies.positionY[i]	= transform.position.y;
+			mBodies.positionZ[i]	= transform.position.z;
+			mBodies.rotationX[i]	= transform.rotation.x;
+			mBodies.rotationY[i]	= transform.rotation.y;
+			mBodies.rotationZ[i]	= transform.rotation.z;
+			mBodies.rotationW[i]	= transform.rotation.w;
+			mBodies.forceX[i]		= rigidBody.force.x * mass;
+			mBodies.forceY[i]		= rigidBody.force.y * mass;
+			mBodies.forceZ[i]		= rigidBody.force.z * mass;
+			mBodies.torqueX[i]		= rigidBody.torque.x * mass;
+			mBodies.torqueY[i]		= rigidBody.torque.y * mass;
+			mBodies.torqueZ[i]		= rigidBody.torque.z * mass;
+			mBodies.gravityX[i]		= rigidBody.gravity.x;
+			mBodies.gravityY[i]		= rigidBody.gravity.y;
+			mBodies.gravityZ[i]		= rigidBody.gravity.z;
+			mBodies.awake[i]		= rigidBody.asleep ? 0.0f : 1.0f;
+			mBodies.dynamic[i]		= rigidBody.invMass != 0.0f ? 1.0f : 0.0f;
+
+			const Vec3p& inertia = rigidBody.inertiaVector;
+			mBodies.invInertiaX[i]	= inertia.x != 0.0f ? 1.0f / inertia.x : 0.0f;
+			mBodies.invInertiaY[i]	= inertia.y != 0.0f ? 1.0f / inertia.y : 0.0f;
+			mBodies.invInertiaZ[i]	= inertia.z != 0.0f ? 1.0f / inertia.z : 0.0f;
+		}
+	}
+
+	/*
+		Views follow component storage, which is reordered as bodies are added and removed.
+		Handles only depend on the order entities were created in, so sorting by them makes
+		the broadphase, pair orientation and everything after it independent of storage.
+	*/
+	void Physics::SortBodies()
+	{
+		Array<uInt32> order;
+		order.Resize(mEntities.Size());
+
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			order[i] = (uInt32)i;
+		}
+
+		std::sort(order.Data(), order.Data() + order.Size(),
+			[this](uInt32 index0, uInt32 index1) { return mEntities[index0].handle < mEntities[index1].handle; });
+
+		Array<Entity>				entities;
+		Array<RigidBodyComponent*>	bodyPhysics;
+		Array<TransformComponent*>	bodyTransforms;
+
+		for (uInt32 index : order)
+		{
+			entities.PushBack(mEntities[index]);
+			bodyPhysics.PushBack(mBodyPhysics[index]);
+			bodyTransforms.PushBack(mBodyTransforms[index]);
+		}
+
+		Swap(mEntities, entities);
+		Swap(mBodyPhysics, bodyPhysics);
+		Swap(mBodyTransforms, bodyTransforms);
+	}
+
+	bool Physics::GetJointBody(EntityWorld& world, Entity entity, 
+		RigidBody*& pOutRigidBody, const Transform*& pOutTransform, bool& outDynamic)
+	{
+		if (entity == NullEntity)
+		{
+			pOutRigidBody	= &mWorldBody;
+			pOutTransform	= &mWorldTransform;
+			outDynamic		= false;
+			return true;
+		}
+
+		if (!world.HasComponent<RigidBodyComponent>(entity) || !world.HasComponent<TransformComponent>(entity))
+		{
+			return false;
+		}
+
+		RigidBodyComponent& physics = world.Get<RigidBodyComponent>(entity);
+
+		pOutRigidBody	= &physics.rigidBody;
+		pOutTransform	= &world.Get<TransformComponent>(entity);
+		outDynamic		= IsDynamic(physics);
+
+		return true;
+	}
+
+	/* Joints whose bodies have been removed are skipped */
+	void Physics::GatherJoints(EntityWorld& world, JointView& joints)
+	{
+		mJoints.Clear();
+		mJointPairs.Clear();
+
+		for (Entity& entity : joints)
+		{
+			JointComponent& jointComponent = world.Get<JointComponent>(entity);
+
+			JointData data;
+			data.entity = entity;
+			data.pJoint = &jointComponent;
+
+			if (!GetJointBody(world, jointComponent.entity0, data.pRigidBody0, data.pTransform0, data.dynamic0) ||
+				!GetJointBody(world, jointComponent.entity1, data.pRigidBody1, data.pTransform1, data.dynamic1))
 			{
 				continue;
 			}
 
-			Vec3p linearAccel;
-			Vec3p angularAccel;
+			mJoints.PushBack(data);
 
-			if (rigidBody.invMass)
+			if (!jointComponent.joint.collideConnected && jointComponent.entity1 != NullEntity)
 			{
-				linearAccel = rigidBody.gravity + rigidBody.force * (1.0f / rigidBody.invMass);
-				angularAccel = rigidBody.torque * (1.0f / rigidBody.invMass);
+				const Entity entity0 = jointComponent.entity0.handle < jointComponent.entity1.handle ? jointComponent.entity0 : jointComponent.entity1;
+				const Entity entity1 = jointComponent.entity0.handle < jointComponent.entity1.handle ? jointComponent.entity1 : jointComponent.entity0;
+
+				mJointPairs.PushBack(MakePairKey(entity0, entity1));
 			}
+		}
+
+#if PHYSICS_DETERMINISTIC
+		std::sort(mJoints.Data(), mJoints.Data() + mJoints.Size(),
+			[](const JointData& data0, const JointData& data1) { return data0.entity.handle < data1.entity.handle; });
+#endif
+
+		std::sort(mJointPairs.Data(), mJointPairs.Data() + mJointPairs.Size());
+	}
+
+	bool Physics::IsJointPair(Entity entity0, Entity entity1) const
+	{
+		if (mJointPairs.Size() == 0)
+		{
+			return false;
+		}
 
-			/* Linear Integration */
+		const uInt64 pairKey = entity0.handle < entity1.handle ? MakePairKey(entity0, entity1) : MakePairKey(entity1, entity0);
 
-			rigidBody.linearVelocity += linearAccel * stepTime;
-			transform.position += rigidBody.linearVelocity * stepTime;
-			rigidBody.force = Vec3p::ZERO;
+		return std::binary_search(mJointPairs.Data(), mJointPairs.Data() + mJointPairs.Size(), pairKey);
+	}
 
-			/* Angular Integration */
+	/* Velocities are owned by the rigid bodies while the solver runs */
 
-			rigidBody.angularVelocity += angularAccel * stepTime;
-			transform.rotation *= rigidBody.angularVelocity * stepTime;
-			transform.rotation.Normalize();
-			rigidBody.torque = Vec3p::ZERO;
+	void Physics::GatherVelocities()
+	{
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			const RigidBody& rigidBody = mBodyPhysics[i]->rigidBody;
+
+			mBodies.linearX[i]	= rigidBody.linearVelocity.x;
+			mBodies.linearY[i]	= rigidBody.linearVelocity.y;
+			mBodies.linearZ[i]	= rigidBody.linearVelocity.z;
+			mBodies.angularX[i]	= rigidBody.angularVelocity.x;
+			mBodies.angularY[i]	= rigidBody.angularVelocity.y;
+			mBodies.angularZ[i]	= rigidBody.angularVelocity.z;
+		}
+	}
 
-			/* Drag */
+	void Physics::ApplyForces(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
+	{
+		GatherVelocities();
+
+		Integrator::ApplyForces(mBodies, stepTime, mLinearDrag, mAngularDrag);
 
-			rigidBody.linearVelocity *= pow(0.9, stepTime);
-			rigidBody.angularVelocity *= pow(0.1, stepTime);
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			RigidBody& rigidBody = mBodyPhysics[i]->rigidBody;
+
+			if (rigidBody.asleep)
+			{
+				continue;
+			}
+
+			rigidBody.linearVelocity	= Vec3p(mBodies.linearX[i], mBodies.linearY[i], mBodies.linearZ[i]);
+			rigidBody.angularVelocity	= Vec3p(mBodies.angularX[i], mBodies.angularY[i], mBodies.angularZ[i]);
+			rigidBody.force				= Vec3p::ZERO;
+			rigidBody.torque			= Vec3p::ZERO;
 
 			//????
 			rigidBody.lastAcceleration = rigidBody.gravity * rigidBody.invMass; //linearAccel + angularAccel;
+		}
+	}
+
+	void Physics::IntegrateVelocities(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
+	{
+		GatherVelocities();
+
+		Integrator::Integrate(mBodies, mMotionScales.Data(), stepTime);
+
+		/* Write back only the bodies that moved */
+
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			RigidBody& rigidBody = mBodyPhysics[i]->rigidBody;
+
+			if (rigidBody.asleep || (rigidBody.linearVelocity.IsZero() && rigidBody.angularVelocity.IsZero()))
+			{
+				continue;
+			}
 
-			rigidBody.UpdateInertia(transform);
+			TransformComponent& transform = *mBodyTransforms[i];
+
+			transform.position.x = (float)mBodies.positionX[i];
+			transform.position.y = (float)mBodies.positionY[i];
+			transform.position.z = (float)mBodies.positionZ[i];
+			transform.rotation.x = (float)mBodies.rotationX[i];
+			transform.rotation.y = (float)mBodies.rotationY[i];
+			transform.rotation.z = (float)mBodies.rotationZ[i];
+			transform.rotation.w = (float)mBodies.rotationW[i];
+
+			if (!rigidBody.inertiaVector.IsZero())
+			{
+				Mat3p& tensor = rigidBody.invInertiaTensor;
+
+				tensor.e[0] = mBodies.tensorXX[i];
+				tensor.e[1] = mBodies.tensorXY[i];
+				tensor.e[2] = mBodies.tensorXZ[i];
+				tensor.e[3] = mBodies.tensorXY[i];
+				tensor.e[4] = mBodies.tensorYY[i];
+				tensor.e[5] = mBodies.tensorYZ[i];
+				tensor.e[6] = mBodies.tensorXZ[i];
+				tensor.e[7] = mBodies.tensorYZ[i];
+				tensor.e[8] = mBodies.tensorZZ[i];
+			}
 		}
 	}
 
-	void Physics::FindCollisions(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
-	{	
-		Entity entity0;
-		Entity entity1;
+	void Physics::FindCandidates(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
+	{
+		mCandidates.Clear();
+		mCandidatePairs.Clear();
+		mBroadphase.Clear();
 
-		mCollisions.Clear();
+		/* World bounds */
 
-		for (auto& fit = rigidBodies.begin(); fit != rigidBodies.end(); ++fit)
+		for (uSize i = 0; i < mEntities.Size(); i++)
 		{
-			entity0 = *fit;
+			RigidBodyComponent& physics		= *mBodyPhysics[i];
+			TransformComponent& transform	= *mBodyTransforms[i];
 
-			//for (auto& rit = rigidBodies.rbegin(); rit != rigidBodies.rend(); --rit)
-			for (auto& rit = rigidBodies.begin(); rit != rigidBodies.end(); ++rit)
+			BroadphaseEntry entry;
+			CalcBounds(physics.collider, transform, entry.min, entry.max);
+			entry.index		= (uInt32)i;
+			entry.isStatic	= physics.collider.IsStatic();
+
+			mBroadphase.PushBack(entry);
+		}
+
+		/* Sort and sweep along x, ties broken by index so pair order is deterministic */
+
+		std::sort(mBroadphase.Data(), mBroadphase.Data() + mBroadphase.Size(),
+			[](const BroadphaseEntry& entry0, const BroadphaseEntry& entry1)
 			{
-				entity1 = *rit;
+				return entry0.min.x < entry1.min.x || (entry0.min.x == entry1.min.x && entry0.index < entry1.index);
+			});
 
-				if (entity0 == entity1)
+		for (uSize i = 0; i < mBroadphase.Size(); i++)
+		{
+			const BroadphaseEntry& entry0 = mBroadphase[i];
+
+			for (uSize j = i + 1; j < mBroadphase.Size(); j++)
+			{
+				const BroadphaseEntry& entry1 = mBroadphase[j];
+
+				if (entry1.min.x > entry0.max.x)
 				{
-					continue; // Ignore self collision
+					break; // Sorted, nothing further can overlap
 				}
 
-				RigidBodyComponent& physics0	= world.Get<RigidBodyComponent>(entity0);
-				TransformComponent& transform0	= world.Get<TransformComponent>(entity0);
-				RigidBody& rigidBody0			= physics0.rigidBody;
-				Collider& collider0				= physics0.collider;
+				if (entry0.isStatic && entry1.isStatic)
+				{
+					continue; // Ignore static-static collisions
+				}
 
-				RigidBodyComponent& physics1	= world.Get<RigidBodyComponent>(entity1);
-				TransformComponent& transform1	= world.Get<TransformComponent>(entity1);
-				RigidBody& rigidBody1			= physics1.rigidBody;
-				Collider& collider1				= physics1.collider;
+				if (entry0.max.y < entry1.min.y || entry1.max.y < entry0.min.y ||
+					entry0.max.z < entry1.min.z || entry1.max.z < entry0.min.z)
+				{
+					continue;
+				}
 
+				// Keep the creation order inside the pair, as the exhaustive search did
+				uInt32 index0 = Min(entry0.index, entry1.index);
+				uInt32 index1 = Max(entry0.index, entry1.index);
 
-				// @TODO: BAD
-				for (const CollisionData& data : (const Array<CollisionData>&)mCollisions)
+				// Ensure the first object has mass
+				if (mBodyPhysics[index0]->rigidBody.invMass == 0.0f)
 				{
-					if ((data.entity0 == entity0 && data.entity1 == entity1) || 
-						(data.entity0 == entity1 && data.entity1 == entity0))
-					{
-						goto endLoop;
-					}
+					Swap(index0, index1);
 				}
 
-				if (collider0.IsStatic() && collider1.IsStatic())
+				const Entity entity0 = mEntities[index0];
+				const Entity entity1 = mEntities[index1];
+
+				if (IsJointPair(entity0, entity1))
 				{
-					continue; // Ignore static-static collisions
+					continue; // Jointed bodies pass through each other unless the joint allows contacts
 				}
 
-				Collision collision; 
-				bool colliding = Collide(collider0, transform0, collider1, transform1, collision);
-				
-				if (colliding)
+				RigidBodyComponent& physics0	= *mBodyPhysics[index0];
+				TransformComponent& transform0	= *mBodyTransforms[index0];
+				RigidBodyComponent& physics1	= *mBodyPhysics[index1];
+				TransformComponent& transform1	= *mBodyTransforms[index1];
+
+				CollisionData data = { entity0, entity1, &physics0, &physics1, &transform0, &transform1, 
+					MakePairKey(entity0, entity1), Collision() };
+				mCandidates.PushBack(data);
+			}
+		}
+
+		mStats.candidatePairs += mCandidates.Size();
+	}
+
+	/* Wobbling bodies always refresh their contacts, reusing them there lets tall stacks drift */
+	inline bool IsResting(const RigidBody& rigidBody)
+	{
+		constexpr floatp maxSpeedSquared = PHYSICS_MANIFOLD_REUSE_SPEED * PHYSICS_MANIFOLD_REUSE_SPEED;
+
+		return Dot(rigidBody.linearVelocity, rigidBody.linearVelocity) < maxSpeedSquared &&
+			Dot(rigidBody.angularVelocity, rigidBody.angularVelocity) < maxSpeedSquared;
+	}
+
+	/* True if neither body has moved enough since the manifold was built to change its contacts */
+	inline bool IsManifoldReusable(const Physics::CollisionData& data, const Transform& transform0, const Transform& transform1)
+	{
+		constexpr floatp maxDistSquared = PHYSICS_MANIFOLD_REUSE_DISTANCE * PHYSICS_MANIFOLD_REUSE_DISTANCE;
+
+		const Vec3p offset0 = Vec3p(transform0.position) - Vec3p(data.position0);
+		const Vec3p offset1 = Vec3p(transform1.position) - Vec3p(data.position1);
+
+		const floatp alignment0 = 
+			transform0.rotation.x * data.rotation0.x + transform0.rotation.y * data.rotation0.y + 
+			transform0.rotation.z * data.rotation0.z + transform0.rotation.w * data.rotation0.w;
+
+		const floatp alignment1 = 
+			transform1.rotation.x * data.rotation1.x + transform1.rotation.y * data.rotation1.y + 
+			transform1.rotation.z * data.rotation1.z + transform1.rotation.w * data.rotation1.w;
+
+		return Dot(offset0, offset0) < maxDistSquared && Dot(offset1, offset1) < maxDistSquared &&
+			Abs(alignment0) > PHYSICS_MANIFOLD_REUSE_ANGLE && Abs(alignment1) > PHYSICS_MANIFOLD_REUSE_ANGLE;
+	}
+
+	void Physics::FindCollisions(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
+	{	
+		mCollisions.Clear();
+		mCandidatePairs.Clear();
+		mCandidateIndices.Clear();
+		mMaxPenetration = 0;
+
+		CollisionData* pPrevBegin = mPrevCollisions.Data();
+		CollisionData* pPrevEnd = mPrevCollisions.Data() + mPrevCollisions.Size();
+
+		/* Follow last step's manifolds, pairs that have barely moved skip the narrowphase */
+
+		for (uSize i = 0; i < mCandidates.Size(); i++)
+		{
+			CollisionData& data = mCandidates[i];
+
+			CollisionData* pPrev = std::lower_bound(pPrevBegin, pPrevEnd, data.pairKey,
+				[](const CollisionData& prevData, uInt64 key) { return prevData.pairKey < key; });
+
+			if (pPrev != pPrevEnd && pPrev->pairKey == data.pairKey)
+			{
+				data.collision = pPrev->collision;
+				data.collision.Refresh(*data.pTransform0, *data.pTransform1);
+
+				data.position0 = pPrev->position0;
+				data.position1 = pPrev->position1;
+				data.rotation0 = pPrev->rotation0;
+				data.rotation1 = pPrev->rotation1;
+
+				if (data.collision.count > 0 && IsManifoldReusable(data, *data.pTransform0, *data.pTransform1) && 
+					IsResting(data.pRigidBody0->rigidBody) && IsResting(data.pRigidBody1->rigidBody))
 				{
-					if (rigidBody0.invMass == 0.0f) // Ensure the first object has mass
-					{
-						collision.Flip();
-						CollisionData data = { entity1, entity0, &physics1, &physics0, &transform1, &transform0, collision };
-						mCollisions.PushBack(data);
-					}
-					else
-					{
-						CollisionData data = { entity0, entity1, &physics0, &physics1, &transform0, &transform1, collision };
-						mCollisions.PushBack(data);
-					}
+					mCollisions.PushBack(data);
+					continue;
 				}
+			}
+
+			CollisionPair pair = { &data.pRigidBody0->collider, data.pTransform0, &data.pRigidBody1->collider, data.pTransform1 };
+			mCandidatePairs.PushBack(pair);
+			mCandidateIndices.PushBack(i);
+		}
+
+		mStats.reusedManifolds += mCollisions.Size();
+
+		/* Narrowphase */
+
+		CollideCandidates();
 
-			endLoop:
+		for (uSize i = 0; i < mCandidatePairs.Size(); i++)
+		{
+			if (!mCandidateResults[i])
+			{
 				continue;
 			}
+
+			CollisionData data = mCandidates[mCandidateIndices[i]];
+
+			Collision& collision = mCandidateCollisions[i];
+			collision.CalcAnchors(*data.pTransform0, *data.pTransform1);
+
+			// Merge into the refreshed manifold, or start a new one
+			data.collision.Merge(collision);
+
+			data.position0 = data.pTransform0->position;
+			data.position1 = data.pTransform1->position;
+			data.rotation0 = data.pTransform0->rotation;
+			data.rotation1 = data.pTransform1->rotation;
+
+			mCollisions.PushBack(data);
 		}
+
+		for (const CollisionData& data : mCollisions)
+		{
+			for (uSize c = 0; c < data.collision.count; c++)
+			{
+				mMaxPenetration = Max(mMaxPenetration, data.collision.contacts[c].depth);
+			}
+
+			mStats.contacts += data.collision.count;
+		}
+
+		mStats.collidingPairs += mCollisions.Size();
+		mStats.maxPenetration = Max(mStats.maxPenetration, mMaxPenetration);
 	}
 
-	inline Vec3p CalculateImpulse(const Contact& contact, const RigidBody& rigidBody0, const RigidBody& rigidBody1)
+	/* Measured at the manifold anchors, so only contacts the solver worked on are counted */
+	void Physics::MeasurePenetration()
 	{
-		const Vec3p torque0 = Cross(contact.localPoint0, contact.normal);
-		const Vec3p angularMomentum0 = rigidBody0.invInertiaTensor * torque0;
-		const Vec3p deltaVelocity0 = Cross(angularMomentum0, contact.localPoint0);
+		mResidualPenetration = 0;
 
-		floatp totalVelocity = 0;
+		for (const CollisionData& data : mCollisions)
+		{
+			// A copy, the manifold carried into the next substep keeps its contacts
+			Collision collision = data.collision;
+			collision.Refresh(*data.pTransform0, *data.pTransform1);
 
-		const floatp angularImpulse0 = Dot(deltaVelocity0, contact.normal);
-		totalVelocity += angularImpulse0 + rigidBody0.invMass;
+			for (uSize c = 0; c < collision.count; c++)
+			{
+				mResidualPenetration = Max(mResidualPenetration, collision.contacts[c].depth);
+			}
+		}
+
+		mStats.residualPenetration = mResidualPenetration;
+	}
+
+	void Physics::CollideChunks()
+	{
+		const uSize count = mCandidatePairs.Size();
+		const uSize chunkCount = (count + PHYSICS_NARROWPHASE_CHUNK_SIZE - 1) / PHYSICS_NARROWPHASE_CHUNK_SIZE;
+		uSize chunk;
 
-		if (rigidBody1.invMass != 0.0f)
+		while ((chunk = mNextChunk.fetch_add(1, std::memory_order_relaxed)) < chunkCount)
 		{
-			const Vec3p torque1 = Cross(contact.localPoint1, contact.normal);
-			const Vec3p angularMomentum1 = rigidBody1.invInertiaTensor * torque1;
-			const Vec3p deltaVelocity1 = Cross(angularMomentum1, contact.localPoint1);
+			const uSize start	= chunk * PHYSICS_NARROWPHASE_CHUNK_SIZE;
+			const uSize end		= Min(start + PHYSICS_NARROWPHASE_CHUNK_SIZE, count);
 
-			const floatp angularImpulse1 = Dot(deltaVelocity1, contact.normal);
-			totalVelocity += angularImpulse1 + rigidBody1.invMass;
+			collisionDetection.CollideBatch(mCandidatePairs.Data() + start, end - start,
+				mCandidateCollisions.Data() + start, mCandidateResults.Data() + start);
 		}
+	}
 
-		const Vec3p impulseContact = Vec3p(contact.targetVelocity / totalVelocity, 0.0f, 0.0f);
-		const Vec3p impulse = contact.invContactBasis * impulseContact;
+	void Physics::WorkerThread(uSize worker)
+	{
+		uSize generation = 0;
 
-		return impulse;
+		while (true)
+		{
+			{
+				std::unique_lock<std::mutex> lock(mWorkMutex);
+
+				mWorkCondition.wait(lock, [this, generation] { return mStopWorkers || mWorkGeneration != generation; });
+
+				if (mStopWorkers)
+				{
+					return;
+				}
+
+				generation = mWorkGeneration;
+
+				if (worker >= mWorkActive)
+				{
+					continue;
+				}
+			}
+
+			// Counters are per thread, cleared here so each substep hands back only its own
+			CollisionDetection::ThreadStats()	= {};
+			GJK::ThreadEPAStats()				= {};
+
+			CollideChunks();
+
+			mWorkerStats[worker]	= CollisionDetection::ThreadStats();
+			mWorkerEPAStats[worker]	= GJK::ThreadEPAStats();
+
+			std::lock_guard<std::mutex> lock(mWorkMutex);
+
+			if (--mWorkPending == 0)
+			{
+				mWorkDoneCondition.notify_one();
+			}
+		}
 	}
 
-	inline void BalanceMovements(floatp& inOutAngularMovement, floatp& inOutLinearMovement, floatp limit, floatp limitScale)
+	void Physics::StartWorkers(uSize workerCount)
 	{
-		// Limit the rotational resolution to reduce new penetrations
-		floatp scaledLimit = limit * limitScale;
+		mStopWorkers = false;
 
-		if (inOutAngularMovement < -scaledLimit)
+		for (uSize i = 0; i < workerCount; i++)
 		{
-			floatp total = inOutLinearMovement + inOutAngularMovement;
-			inOutAngularMovement = -scaledLimit;
-			inOutLinearMovement = total - inOutAngularMovement;
+			mWorkers.PushBack(new std::thread(&Physics::WorkerThread, this, i));
 		}
-		else if (inOutAngularMovement > scaledLimit)
+	}
+
+	void Physics::StopWorkers()
+	{
 		{
-			floatp total = inOutLinearMovement + inOutAngularMovement;
-			inOutAngularMovement = scaledLimit;
-			inOutLinearMovement = total - inOutAngularMovement;
+			std::lock_guard<std::mutex> lock(mWorkMutex);
+			mStopWorkers = true;
 		}
+
+		mWorkCondition.notify_all();
+
+		for (std::thread* pThread : mWorkers)
+		{
+			pThread->join();
+			delete pThread;
+		}
+
+		mWorkers.Clear();
 	}
 
-	inline void CalculatePenetrationDeltas(Physics::CollisionData& collisionData, Contact& contact, 
-		Vec3p& outDeltaLinear0, Vec3p& outDeltaLinear1, Vec3p& outDeltaAngular0, Vec3p& outDeltaAngular1)
+	void Physics::SetThreadCount(uSize threadCount)
 	{
-		const Collider& collider0 = collisionData.pRigidBody0->collider;
-		const Collider& collider1 = collisionData.pRigidBody1->collider;
-		const RigidBody& rigidBody0 = collisionData.pRigidBody0->rigidBody;
-		const RigidBody& rigidBody1 = collisionData.pRigidBody1->rigidBody;
+		mThreadCount = Max(threadCount, (uSize)1);
 
-		floatp angularInertia0 = 0, angularInertia1 = 0;
-		floatp linearInertia0 = 0, linearInertia1 = 0;
-		floatp totalInertia = 0;
+		const uSize workerCount = Min(mThreadCount, (uSize)PHYSICS_NARROWPHASE_MAX_THREADS) - 1;
 
+		if (workerCount != mWorkers.Size())
 		{
-			const Vec3p torque0 = Cross(contact.localPoint0, contact.normal);
-			const Vec3p angularMomentum0 = rigidBody0.invInertiaTensor * torque0;
-			const Vec3p deltaVelocity0 = Cross(angularMomentum0, contact.localPoint0);
+			StopWorkers();
+			StartWorkers(workerCount);
+		}
+	}
+
+	/*
+		Threads take fixed chunks of the candidate pairs in turn and write every result to the
+		pair's own slot. Chunks are the same for any thread count, so the merge in FindCollisions
+		sees identical results in identical order however the work was shared out.
+	*/
+	void Physics::CollideCandidates()
+	{
+		const uSize count = mCandidatePairs.Size();
+		const uSize workerCount = Min(mWorkers.Size(), Max(count / PHYSICS_NARROWPHASE_BATCH_SIZE, (uSize)1) - 1);
 
-			linearInertia0 = rigidBody0.invMass;
+		mCandidateCollisions.Resize(count);
+		mCandidateResults.Resize(count);
 
-			angularInertia0 = Dot(deltaVelocity0, contact.normal);
-			totalInertia += angularInertia0 + linearInertia0;
+		mNextChunk.store(0, std::memory_order_relaxed);
 
-			if (rigidBody1.invMass != 0.0f)
+		if (workerCount > 0)
+		{
 			{
-				const Vec3p torque1 = Cross(contact.localPoint1, contact.normal);
-				const Vec3p angularMomentum1 = rigidBody1.invInertiaTensor * torque1;
-				const Vec3p deltaVelocity1 = Cross(angularMomentum1, contact.localPoint1);
+				std::lock_guard<std::mutex> lock(mWorkMutex);
+				mWorkActive		= workerCount;
+				mWorkPending	= workerCount;
+				mWorkGeneration++;
+			}
 
-				linearInertia1 = rigidBody1.invMass;
+			mWorkCondition.notify_all();
+		}
 
-				angularInertia1 = Dot(deltaVelocity1, contact.normal);
-				totalInertia += angularInertia1 + linearInertia1;
-			}
+		CollideChunks();
+
+		if (workerCount == 0)
+		{
+			return;
 		}
 
-		const floatp invInertia = 1.0f / totalInertia;
-		const floatp balanceLimit = 0.2f;
+		{
+			std::unique_lock<std::mutex> lock(mWorkMutex);
+			mWorkDoneCondition.wait(lock, [this] { return mWorkPending == 0; });
+		}
+
+		NarrowphaseStats& stats = CollisionDetection::ThreadStats();
+		GJK::EPAStats& epaStats = GJK::ThreadEPAStats();
 
-		if (!collider0.IsStatic())
+		for (uSize i = 0; i < workerCount; i++)
 		{
-			floatp linearMovement0 = contact.depth * linearInertia0 * invInertia;
-			floatp angularMovement0 = contact.depth * angularInertia0 * invInertia;
-			
-			Vec3p proj = contact.localPoint0;
-			proj += contact.normal * -Dot(contact.localPoint0, contact.normal);
+			for (uSize type0 = 0; type0 < SHAPE_TYPE_COUNT; type0++)
+			{
+				for (uSize type1 = 0; type1 < SHAPE_TYPE_COUNT; type1++)
+				{
+					stats.tests[type0][type1] += mWorkerStats[i].tests[type0][type1];
+				}
+			}
 
-			BalanceMovements(angularMovement0, linearMovement0, balanceLimit, proj.Magnitude());
+			stats.meshQueryOverflows += mWorkerStats[i].meshQueryOverflows;
 
-			if (angularMovement0 != 0.0f)
+			for (uSize bucket = 0; bucket < PHYSICS_EPA_STAT_BUCKETS; bucket++)
 			{
-				const Vec3p angularVelocityImpulse0 = rigidBody0.invInertiaTensor * Cross(contact.localPoint0, contact.normal);
-				const Vec3p rotation0 = angularVelocityImpulse0 * (angularMovement0 / angularInertia0);
-				outDeltaAngular0 = rotation0;
+				epaStats.runs[bucket] += mWorkerEPAStats[i].runs[bucket];
 			}
+		}
+	}
 
-			outDeltaLinear0 = contact.normal * linearMovement0;
+	inline floatp InverseMassAlong(const RigidBody& rigidBody, bool dynamic, const Vec3p& localPoint, const Vec3p& direction)
+	{
+		if (!dynamic)
+		{
+			return 0;
 		}
 
-		if (!collider1.IsStatic() && rigidBody1.invMass != 0.0f)
+		const Vec3p torque = Cross(localPoint, direction);
+		const Vec3p angularMomentum = rigidBody.invInertiaTensor * torque;
+		const Vec3p deltaVelocity = Cross(angularMomentum, localPoint);
+
+		return rigidBody.invMass + Dot(deltaVelocity, direction);
+	}
+
+	inline void ApplyImpulse(RigidBody& rigidBody, bool dynamic, const Vec3p& localPoint, const Vec3p& impulse)
+	{
+		if (!dynamic)
 		{
-			floatp linearMovement1 = -contact.depth * linearInertia1 * invInertia;
-			floatp angularMovement1 = -contact.depth * angularInertia1 * invInertia;
+			return;
+		}
+
+		rigidBody.linearVelocity += impulse * rigidBody.invMass;
+		rigidBody.angularVelocity += rigidBody.invInertiaTensor * Cross(localPoint, impulse);
+	}
 
-			Vec3p proj = contact.localPoint0;
-			proj += contact.normal * -Dot(contact.localPoint0, contact.normal);
+	inline Vec3p RelativeVelocity(const Contact& contact, const RigidBody& rigidBody0, const RigidBody& rigidBody1)
+	{
+		const Vec3p velocity0 = rigidBody0.linearVelocity + Cross(rigidBody0.angularVelocity, contact.localPoint0);
+		const Vec3p velocity1 = rigidBody1.linearVelocity + Cross(rigidBody1.angularVelocity, contact.localPoint1);
 
-			BalanceMovements(angularMovement1, linearMovement1, balanceLimit, proj.Magnitude());
+		return velocity0 - velocity1;
+	}
 
-			if (angularMovement1 != 0.0f)
-			{
-				const Vec3p angularVelocityImpulse1 = rigidBody1.invInertiaTensor * Cross(contact.localPoint1, contact.normal);
-				const Vec3p rotation1 = angularVelocityImpulse1 * (angularMovement1 / angularInertia1);
-				outDeltaAngular1 = rotation1;
-			}
+	inline void PrepareContact(Contact& contact, const RigidBody& rigidBody0, const RigidBody& rigidBody1,
+		bool dynamic0, bool dynamic1, const Vec3p& position0, const Vec3p& position1, double stepTime)
+	{
+		contact.CalcContactBasis();
+		contact.CalcLocalPoints(position0, position1);
+
+		const floatp normalInvMass = 
+			InverseMassAlong(rigidBody0, dynamic0, contact.localPoint0, contact.normal) +
+			InverseMassAlong(rigidBody1, dynamic1, contact.localPoint1, contact.normal);
+
+		contact.normalMass = normalInvMass > 0.0f ? 1.0f / normalInvMass : 0.0f;
 
-			outDeltaLinear1 = contact.normal * linearMovement1;
+		for (uSize i = 0; i < 2; i++)
+		{
+			const floatp tangentInvMass =
+				InverseMassAlong(rigidBody0, dynamic0, contact.localPoint0, contact.tangents[i]) +
+				InverseMassAlong(rigidBody1, dynamic1, contact.localPoint1, contact.tangents[i]);
+
+			contact.tangentMass[i] = tangentInvMass > 0.0f ? 1.0f / tangentInvMass : 0.0f;
+		}
+
+		/* Restitution and Baumgarte position correction both bias the target normal velocity */
+
+		const floatp normalVelocity = Dot(RelativeVelocity(contact, rigidBody0, rigidBody1), contact.normal);
+		const floatp restitution = Min(rigidBody0.restitution, rigidBody1.restitution);
+
+		floatp restitutionBias = 0.0f;
+
+		if (normalVelocity < -PHYSICS_RESTITUTION_VELOCITY)
+		{
+			restitutionBias = -restitution * normalVelocity;
+		}
+
+		const floatp penetrationBias = (PHYSICS_BAUMGARTE_FACTOR / stepTime) * 
+			Max(contact.depth - PHYSICS_PENETRATION_SLOP, (floatp)0.0f);
+
+		contact.velocityBias = Max(restitutionBias, penetrationBias);
+
+		if (contact.depth < 0.0f)
+		{
+			// Followed contact that has separated, allow the bodies to close the gap this step
+			contact.velocityBias = contact.depth / stepTime;
 		}
 	}
 
-	inline void CalculateVelocityDeltas(Physics::CollisionData& collisionData, Contact& contact,
-		Vec3p& outDeltaLinearVel0, Vec3p& outDeltaLinearVel1, Vec3p& outDeltaAngularVel0, Vec3p& outDeltaAngularVel1)
+	inline void WarmStartContact(const Contact& contact, RigidBody& rigidBody0, RigidBody& rigidBody1, bool dynamic0, bool dynamic1)
 	{
-		const Collider&  collider0	= collisionData.pRigidBody0->collider;
-		const Collider&  collider1	= collisionData.pRigidBody1->collider;
-		const RigidBody& rigidBody0	= collisionData.pRigidBody0->rigidBody;
-		const RigidBody& rigidBody1	= collisionData.pRigidBody1->rigidBody;
+		const Vec3p impulse = 
+			contact.normal * contact.normalImpulse + 
+			contact.tangents[0] * contact.tangentImpulse[0] +
+			contact.tangents[1] * contact.tangentImpulse[1];
 
-		/* Resolve Linear and Angular Velocities */
+		ApplyImpulse(rigidBody0, dynamic0, contact.localPoint0, impulse);
+		ApplyImpulse(rigidBody1, dynamic1, contact.localPoint1, -impulse);
+	}
 
-		Vec3p impulse = CalculateImpulse(contact, rigidBody0, rigidBody1);
+	// Returns the largest change in accumulated impulse
+	inline floatp SolveContact(Contact& contact, RigidBody& rigidBody0, RigidBody& rigidBody1, 
+		bool dynamic0, bool dynamic1, floatp friction)
+	{
+		floatp maxDelta = 0.0f;
 
-		if (!collider0.IsStatic())
+		/* Friction */
+
+		const floatp maxFriction = friction * contact.normalImpulse;
+
+		for (uSize i = 0; i < 2; i++)
 		{
-			const Vec3p linearVelocity0 = impulse * rigidBody0.invMass;
-			outDeltaLinearVel0 = linearVelocity0;
+			const Vec3p& tangent = contact.tangents[i];
+			const floatp tangentVelocity = Dot(RelativeVelocity(contact, rigidBody0, rigidBody1), tangent);
+
+			const floatp oldImpulse = contact.tangentImpulse[i];
+			contact.tangentImpulse[i] = Clamp(oldImpulse - contact.tangentMass[i] * tangentVelocity, -maxFriction, maxFriction);
+
+			const floatp deltaImpulse = contact.tangentImpulse[i] - oldImpulse;
+			const Vec3p impulse = tangent * deltaImpulse;
 
-			const Vec3p impulsiveTorque0 = Cross(contact.localPoint0, impulse);
-			const Vec3p angularVelocity0 = rigidBody0.invInertiaTensor * impulsiveTorque0;
-			outDeltaAngularVel0 = angularVelocity0;
+			ApplyImpulse(rigidBody0, dynamic0, contact.localPoint0, impulse);
+			ApplyImpulse(rigidBody1, dynamic1, contact.localPoint1, -impulse);
+
+			maxDelta = Max(maxDelta, Abs(deltaImpulse));
 		}
 
-		if (!collider1.IsStatic() && rigidBody1.invMass != 0.0f)
+		/* Normal */
+
+		const floatp normalVelocity = Dot(RelativeVelocity(contact, rigidBody0, rigidBody1), contact.normal);
+
+		const floatp oldImpulse = contact.normalImpulse;
+		contact.normalImpulse = Max(oldImpulse + contact.normalMass * (contact.velocityBias - normalVelocity), (floatp)0.0f);
+
+		const floatp deltaImpulse = contact.normalImpulse - oldImpulse;
+		const Vec3p impulse = contact.normal * deltaImpulse;
+
+		ApplyImpulse(rigidBody0, dynamic0, contact.localPoint0, impulse);
+		ApplyImpulse(rigidBody1, dynamic1, contact.localPoint1, -impulse);
+
+		return Max(maxDelta, Abs(deltaImpulse));
+	}
+
+	/* Joints */
+
+	inline Vec3p PointVelocity(const RigidBody& rigidBody, const Vec3p& localPoint)
+	{
+		return rigidBody.linearVelocity + Cross(rigidBody.angularVelocity, localPoint);
+	}
+
+	inline void ApplyJointImpulse(RigidBody& rigidBody, bool dynamic, const Vec3p& localPoint, const Vec3p& linear, const Vec3p& angular)
+	{
+		if (!dynamic)
 		{
-			const Vec3p linearVelocity1 = impulse * -rigidBody1.invMass; // Flip impulse for second body
-			outDeltaLinearVel1 = linearVelocity1;
+			return;
+		}
 
-			const Vec3p impulsiveTorque1 = Cross(impulse, contact.localPoint1); // @Note: flipped from body0
-			const Vec3p angularVelocity1 = rigidBody1.invInertiaTensor * impulsiveTorque1;
-			outDeltaAngularVel1 = angularVelocity1;
+		rigidBody.linearVelocity += linear * rigidBody.invMass;
+		rigidBody.angularVelocity += rigidBody.invInertiaTensor * (Cross(localPoint, linear) + angular);
+	}
+
+	/* Change in a body's anchor and angular velocity for an impulse on it */
+	inline void AddJointResponse(const RigidBody& rigidBody, bool dynamic, const Vec3p& localPoint,
+		const Vec3p& linear, const Vec3p& angular, Vec3p& outLinear, Vec3p& outAngular)
+	{
+		if (!dynamic)
+		{
+			return;
 		}
+
+		const Vec3p deltaAngular = rigidBody.invInertiaTensor * (Cross(localPoint, linear) + angular);
+
+		outLinear += linear * rigidBody.invMass + Cross(deltaAngular, localPoint);
+		outAngular += deltaAngular;
 	}
 
-	uSize FindNextDeepest(Collision& collision)
+	/* Gauss-Jordan with partial pivoting, false if the rows are dependent */
+	static bool InvertRows(floatp* pMatrix, uSize size, floatp* pOutInverse)
 	{
-		floatp maxDist = PHYSICS_SMALLEST_DISTANCE;
-		uSize maxIndex = collision.count;
+		for (uSize i = 0; i < size * size; i++)
+		{
+			pOutInverse[i] = (i / size == i % size) ? 1.0f : 0.0f;
+		}
 
-		for (uSize i = 0; i < collision.count; i++) // @TODO: speed up
+		for (uSize column = 0; column < size; column++)
 		{
-			Contact& contact = collision.contacts[i];
+			uSize pivot = column;
 
-			if (contact.depth > maxDist)
+			for (uSize row = column + 1; row < size; row++)
 			{
-				maxDist = contact.depth;
-				maxIndex = i;
+				if (Abs(pMatrix[row * size + column]) > Abs(pMatrix[pivot * size + column]))
+				{
+					pivot = row;
+				}
+			}
+
+			if (Abs(pMatrix[pivot * size + column]) < 1.0e-12)
+			{
+				return false;
+			}
+
+			for (uSize i = 0; i < size; i++)
+			{
+				Swap(pMatrix[column * size + i], pMatrix[pivot * size + i]);
+				Swap(pOutInverse[column * size + i], pOutInverse[pivot * size + i]);
+			}
+
+			const floatp invPivot = 1.0f / pMatrix[column * size + column];
+
+			for (uSize i = 0; i < size; i++)
+			{
+				pMatrix[column * size + i] *= invPivot;
+				pOutInverse[column * size + i] *= invPivot;
+			}
+
+			for (uSize row = 0; row < size; row++)
+			{
+				const floatp factor = pMatrix[row * size + column];
+
+				if (row == column || factor == 0.0f)
+				{
+					continue;
+				}
+
+				for (uSize i = 0; i < size; i++)
+				{
+					pMatrix[row * size + i] -= factor * pMatrix[column * size + i];
+					pOutInverse[row * size + i] -= factor * pOutInverse[column * size + i];
+				}
 			}
 		}
-		
-		return maxIndex;
+
+		return true;
+	}
+
+	/* Rows 0-2 hold the anchors together along the world axes, the rest lock rotation about joint.angularRows */
+	inline void GetJointRow(const Joint& joint, uSize row, Vec3p& outLinear, Vec3p& outAngular)
+	{
+		const Vec3p axes[3] = { Vec3p(1.0f, 0.0f, 0.0f), Vec3p(0.0f, 1.0f, 0.0f), Vec3p(0.0f, 0.0f, 1.0f) };
+
+		outLinear	= row < 3 ? axes[row] : Vec3p(0.0f, 0.0f, 0.0f);
+		outAngular	= row < 3 ? Vec3p(0.0f, 0.0f, 0.0f) : joint.angularRows[row - 3];
+	}
+
+	inline void PrepareJoint(Joint& joint, const RigidBody& rigidBody0, const RigidBody& rigidBody1,
+		bool dynamic0, bool dynamic1, const Transform& transform0, const Transform& transform1, double stepTime)
+	{
+		joint.CalcLocalPoints(transform0, transform1);
+
+		const Vec3p anchor0 = Vec3p(transform0.position) + joint.localPoint0;
+		const Vec3p anchor1 = Vec3p(transform1.position) + joint.localPoint1;
+		/*
+			Drift is fed back through the target velocity as with contacts, but softened
+			like a damped spring: warm started impulses that already include last substep's
+			correction would otherwise overshoot along stiff chains of joints.
+		*/
+
+		const floatp omega = (floatp)ToRadians(360.0f) * (floatp)PHYSICS_JOINT_HERTZ;
+		const floatp a1 = 2.0f * PHYSICS_JOINT_DAMPING_RATIO + stepTime * omega;
+		const floatp a2 = stepTime * omega * a1;
+		const floatp a3 = 1.0f / (1.0f + a2);
+		const floatp biasFactor = omega / a1;
+
+		joint.massScale		= a2 * a3;
+		joint.impulseScale	= a3;
+
+		if (joint.type == JOINT_DISTANCE)
+		{
+			const Vec3p offset = anchor0 - anchor1;
+			const floatp length = sqrt(Dot(offset, offset));
+
+			joint.axis = length > 1.0e-6 ? offset * (1.0f / length) : Vec3p(0.0f, 1.0f, 0.0f);
+
+			const floatp axisInvMass = 
+				InverseMassAlong(rigidBody0, dynamic0, joint.localPoint0, joint.axis) +
+				InverseMassAlong(rigidBody1, dynamic1, joint.localPoint1, joint.axis);
+
+			joint.axisMass = axisInvMass > 0.0f ? 1.0f / axisInvMass : 0.0f;
+
+			const floatp error = length - joint.distance;
+			joint.axisBias = -biasFactor * error;
+
+			if (joint.rope && error < 0.0f)
+			{
+				// Slack rope, the anchors may separate up to the full length this step
+				joint.axisBias		= -error / stepTime;
+				joint.massScale		= 1.0f;
+				joint.impulseScale	= 0.0f;
+			}
+
+			return;
+		}
+
+		const Vec3p linearBias = (anchor0 - anchor1) * -biasFactor;
+		Vec3p angularBias = Vec3p(0.0f, 0.0f, 0.0f);
+
+		joint.angularRowCount = 0;
+
+		if (joint.type == JOINT_FIXED)
+		{
+			// Rotation from where body 0 should be to where it is, as a small rotation vector
+			Quatp target = Quatp(transform1.rotation) * joint.relativeRotation;
+			target.x = -target.x;
+			target.y = -target.y;
+			target.z = -target.z;
+
+			const Quatp error = Quatp(transform0.rotation) * target;
+			const floatp scale = error.w < 0.0f ? -2.0f : 2.0f;
+
+			joint.angularRows[0] = Vec3p(1.0f, 0.0f, 0.0f);
+			joint.angularRows[1] = Vec3p(0.0f, 1.0f, 0.0f);
+			joint.angularRows[2] = Vec3p(0.0f, 0.0f, 1.0f);
+			joint.angularRowCount = 3;
+
+			angularBias = Vec3p(error.x, error.y, error.z) * (-scale * biasFactor);
+		}
+		else if (joint.type == JOINT_HINGE)
+		{
+			const Vec3p axis0 = Quatp(transform0.rotation) * joint.localAxis0;
+			joint.axis = Quatp(transform1.rotation) * joint.localAxis1;
+
+			const Vec3p side = Abs(joint.axis.x) > 0.57735f ? 
+				Vec3p(joint.axis.y, -joint.axis.x, 0.0f) : Vec3p(0.0f, joint.axis.z, -joint.axis.y);
+
+			joint.angularRows[0] = side * (1.0f / sqrt(Dot(side, side)));
+			joint.angularRows[1] = Cross(joint.axis, joint.angularRows[0]);
+			joint.angularRowCount = 2;
+
+			// Turning body 0 about axis0 x axis1 brings the hinge axes back in line
+			angularBias = Cross(axis0, joint.axis) * biasFactor;
+		}
+
+		/* Effective mass over all rows, one column per unit row impulse */
+
+		const uSize rowCount = 3 + joint.angularRowCount;
+		floatp invMass[PHYSICS_JOINT_MAX_ROWS * PHYSICS_JOINT_MAX_ROWS];
+
+		for (uSize column = 0; column < rowCount; column++)
+		{
+			Vec3p linear;
+			Vec3p angular;
+			GetJointRow(joint, column, linear, angular);
+
+			Vec3p responseLinear = Vec3p(0.0f, 0.0f, 0.0f);
+			Vec3p responseAngular = Vec3p(0.0f, 0.0f, 0.0f);
+			AddJointResponse(rigidBody0, dynamic0, joint.localPoint0, linear, angular, responseLinear, responseAngular);
+			AddJointResponse(rigidBody1, dynamic1, joint.localPoint1, linear, angular, responseLinear, responseAngular);
+
+			for (uSize row = 0; row < rowCount; row++)
+			{
+				GetJointRow(joint, row, linear, angular);
+				invMass[row * rowCount + column] = Dot(linear, responseLinear) + Dot(angular, responseAngular);
+			}
+		}
+
+		if (!InvertRows(invMass, rowCount, joint.rowMass))
+		{
+			for (uSize i = 0; i < rowCount * rowCount; i++)
+			{
+				joint.rowMass[i] = 0.0f;
+			}
+		}
+
+		for (uSize row = 0; row < rowCount; row++)
+		{
+			Vec3p linear;
+			Vec3p angular;
+			GetJointRow(joint, row, linear, angular);
+
+			joint.rowBias[row] = Dot(linear, linearBias) + Dot(angular, angularBias);
+		}
+	}
+
+	inline void WarmStartJoint(const Joint& joint, RigidBody& rigidBody0, RigidBody& rigidBody1, bool dynamic0, bool dynamic1)
+	{
+		const Vec3p linearImpulse = joint.type == JOINT_DISTANCE ? joint.axis * joint.axisImpulse : joint.linearImpulse;
+
+		ApplyJointImpulse(rigidBody0, dynamic0, joint.localPoint0, linearImpulse, joint.angularImpulse);
+		ApplyJointImpulse(rigidBody1, dynamic1, joint.localPoint1, -linearImpulse, -joint.angularImpulse);
 	}
 
-	uSize FindNextFastest(Collision& collision)
+	// Returns the largest change in accumulated impulse
+	inline floatp SolveJoint(Joint& joint, RigidBody& rigidBody0, RigidBody& rigidBody1, bool dynamic0, bool dynamic1)
 	{
-		floatp maxVel = PHYSICS_SMALLEST_VELOCITY;
-		uSize maxIndex = collision.count;
+		const Vec3p velocity = PointVelocity(rigidBody0, joint.localPoint0) - PointVelocity(rigidBody1, joint.localPoint1);
 
-		for (uSize i = 0; i < collision.count; i++) // @TODO: speed up
+		if (joint.type == JOINT_DISTANCE)
 		{
-			Contact& contact = collision.contacts[i];
+			const floatp oldImpulse = joint.axisImpulse;
+			joint.axisImpulse = oldImpulse + joint.massScale * joint.axisMass * (joint.axisBias - Dot(velocity, joint.axis)) - 
+				joint.impulseScale * oldImpulse;
 
-			if (contact.targetVelocity > maxVel)
+			if (joint.rope)
 			{
-				maxVel = contact.targetVelocity;
-				maxIndex = i;
+				joint.axisImpulse = Min(joint.axisImpulse, (floatp)0.0f); // Ropes only pull
 			}
+
+			const floatp deltaImpulse = joint.axisImpulse - oldImpulse;
+			const Vec3p impulse = joint.axis * deltaImpulse;
+
+			ApplyImpulse(rigidBody0, dynamic0, joint.localPoint0, impulse);
+			ApplyImpulse(rigidBody1, dynamic1, joint.localPoint1, -impulse);
+
+			return Abs(deltaImpulse);
 		}
 
-		return maxIndex;
+		const Vec3p angularVelocity = rigidBody0.angularVelocity - rigidBody1.angularVelocity;
+		const uSize rowCount = 3 + joint.angularRowCount;
+
+		floatp error[PHYSICS_JOINT_MAX_ROWS];
+		floatp accumulated[PHYSICS_JOINT_MAX_ROWS];
+
+		for (uSize row = 0; row < rowCount; row++)
+		{
+			Vec3p linear;
+			Vec3p angular;
+			GetJointRow(joint, row, linear, angular);
+
+			error[row] = joint.rowBias[row] - Dot(linear, velocity) - Dot(angular, angularVelocity);
+			accumulated[row] = Dot(linear, joint.linearImpulse) + Dot(angular, joint.angularImpulse);
+		}
+
+		Vec3p linearImpulse = Vec3p(0.0f, 0.0f, 0.0f);
+		Vec3p angularImpulse = Vec3p(0.0f, 0.0f, 0.0f);
+		floatp maxDelta = 0.0f;
+
+		for (uSize row = 0; row < rowCount; row++)
+		{
+			floatp impulse = -joint.impulseScale * accumulated[row];
+
+			for (uSize i = 0; i < rowCount; i++)
+			{
+				impulse += joint.massScale * joint.rowMass[row * rowCount + i] * error[i];
+			}
+
+			Vec3p linear;
+			Vec3p angular;
+			GetJointRow(joint, row, linear, angular);
+
+			linearImpulse += linear * impulse;
+			angularImpulse += angular * impulse;
+			maxDelta = Max(maxDelta, Abs(impulse));
+		}
+
+		joint.linearImpulse += linearImpulse;
+		joint.angularImpulse += angularImpulse;
+
+		ApplyJointImpulse(rigidBody0, dynamic0, joint.localPoint0, linearImpulse, angularImpulse);
+		ApplyJointImpulse(rigidBody1, dynamic1, joint.localPoint1, -linearImpulse, -angularImpulse);
+
+		return maxDelta;
 	}
 
 	void Physics::ResolveCollisions(EntityWorld& world, RigidBodyView& rigidBodies, double stepTime)
 	{
+		/* Prepare joints and contacts and apply last step's impulses */
+
+		for (JointData& jointData : mJoints)
+		{
+			Joint& joint = jointData.pJoint->joint;
+
+			PrepareJoint(joint, *jointData.pRigidBody0, *jointData.pRigidBody1, jointData.dynamic0, jointData.dynamic1,
+				*jointData.pTransform0, *jointData.pTransform1, stepTime);
+			WarmStartJoint(joint, *jointData.pRigidBody0, *jointData.pRigidBody1, jointData.dynamic0, jointData.dynamic1);
+		}
+
 		for (CollisionData& collisionData : mCollisions)
 		{
 			Collision& collision = collisionData.collision;
 
 			RigidBody& rigidBody0 = collisionData.pRigidBody0->rigidBody;
 			RigidBody& rigidBody1 = collisionData.pRigidBody1->rigidBody;
-			Transform& transform0 = *collisionData.pTransform0;
-			Transform& transform1 = *collisionData.pTransform1;
-
-			/* Calculate contact data */
+			const bool dynamic0 = IsDynamic(*collisionData.pRigidBody0);
+			const bool dynamic1 = IsDynamic(*collisionData.pRigidBody1);
 
-			for (uSize i = 0; i < collision.count; i++) // @TODO: speed up
+			for (uSize i = 0; i < collision.count; i++)
 			{
 				Contact& contact = collision.contacts[i];
 
-				contact.CalcContactBasis();
-				contact.CalcLocalPoints(transform0.position, transform1.position);
-				contact.CalcContactVelocity(rigidBody0.lastAcceleration, rigidBody1.lastAcceleration, 
-					rigidBody0.angularVelocity, rigidBody1.angularVelocity,
-					rigidBody0.linearVelocity, rigidBody1.linearVelocity, stepTime);
-				contact.CalcTargetVelocity(rigidBody0.lastAcceleration, rigidBody1.lastAcceleration, 
-					rigidBody0.restitution, rigidBody1.restitution, stepTime);
+				PrepareContact(contact, rigidBody0, rigidBody1, dynamic0, dynamic1, 
+					collisionData.pTransform0->position, collisionData.pTransform1->position, stepTime);
+				WarmStartContact(contact, rigidBody0, rigidBody1, dynamic0, dynamic1);
 			}
+		}
+
+		/* Sequential impulses (Gauss-Seidel over every joint and contact) */
+
+		mSolverIterations = 0;
 
-			/* Resolve penetrations */
+		while (mSolverIterations < PHYSICS_SOLVER_ITERATIONS)
+		{
+			floatp maxDelta = 0.0f;
+
+			for (JointData& jointData : mJoints)
+			{
+				const floatp delta = SolveJoint(jointData.pJoint->joint, 
+					*jointData.pRigidBody0, *jointData.pRigidBody1, jointData.dynamic0, jointData.dynamic1);
+
+				maxDelta = Max(maxDelta, delta);
+			}
 
-			uSize posIteration = 0;
-			while (posIteration++ < PHYSICS_MAX_RESOLVE_ITERATIONS)
+			for (CollisionData& collisionData : mCollisions)
 			{
-				const uSize nextIndex = FindNextDeepest(collision);
+				Collision& collision = collisionData.collision;
+
+				RigidBody& rigidBody0 = collisionData.pRigidBody0->rigidBody;
+				RigidBody& rigidBody1 = collisionData.pRigidBody1->rigidBody;
+				const bool dynamic0 = IsDynamic(*collisionData.pRigidBody0);
+				const bool dynamic1 = IsDynamic(*collisionData.pRigidBody1);
+				const floatp friction = sqrt(rigidBody0.friction * rigidBody1.friction);
 
-				if (nextIndex == collision.count)
+				for (uSize i = 0; i < collision.count; i++)
 				{
-					break;
+					const floatp delta = SolveContact(collision.contacts[i], 
+						rigidBody0, rigidBody1, dynamic0, dynamic1, friction);
+
+					maxDelta = Max(maxDelta, delta);
 				}
+			}
 
-				Contact& contact = collision.contacts[nextIndex];
+			mSolverIterations++;
 
-				/* Calculate deltas */
+			if (maxDelta < PHYSICS_SOLVER_TOLERANCE)
+			{
+				break; // Converged
+			}
+		}
 
-				Vec3p deltaAngular0, deltaAngular1;
-				Vec3p deltaLinear0, deltaLinear1;
+		mStats.solverIterations += mSolverIterations;
+		mStats.maxSolverIterations = Max(mStats.maxSolverIterations, mSolverIterations);
 
-				CalculatePenetrationDeltas(collisionData, contact, 
-					deltaLinear0, deltaLinear1, deltaAngular0, deltaAngular1);
+		/* Keep the solved impulses for warm starting the next step */
 
-				/* Apply deltas */
+		Swap(mPrevCollisions, mCollisions);
 
-				transform0.Move(Vec3f(deltaLinear0));
-				transform1.Move(Vec3f(deltaLinear1));
-				transform0.Rotate(Vec3f(deltaAngular0));
-				transform1.Rotate(Vec3f(deltaAngular1));
+		std::sort(mPrevCollisions.Data(), mPrevCollisions.Data() + mPrevCollisions.Size(),
+			[](const CollisionData& data0, const CollisionData& data1) { return data0.pairKey < data1.pairKey; });
+	}
 
-				transform0.rotation.Normalize();
-				transform1.rotation.Normalize();
+	static void HashBytes(uInt64& hash, const void* pData, uSize size)
+	{
+		const uInt8* pBytes = (const uInt8*)pData;
 
-				/* Update inertia tensors */
+		// FNV-1a
+		for (uSize i = 0; i < size; i++)
+		{
+			hash ^= pBytes[i];
+			hash *= 1099511628211ull;
+		}
+	}
 
-				rigidBody0.UpdateInertia(transform0);
-				rigidBody1.UpdateInertia(transform1);
+	/* Covers everything a body carries into the next step, in gathered order */
+	uInt64 Physics::CalcStateHash() const
+	{
+		uInt64 hash = 14695981039346656037ull;
 
-				/* Adjust remaining contacts */
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			const TransformComponent& transform = *mBodyTransforms[i];
+			const RigidBody& rigidBody = mBodyPhysics[i]->rigidBody;
 
-				for (uSize j = 0; j < collision.count; j++) // @TODO: speed up
-				{
-					Contact& nextContact = collision.contacts[j];
+			const float transformState[7] =
+			{
+				transform.position.x, transform.position.y, transform.position.z,
+				transform.rotation.x, transform.rotation.y, transform.rotation.z, transform.rotation.w
+			};
 
-					/* Adjust depths */
+			const floatp velocityState[6] =
+			{
+				rigidBody.linearVelocity.x, rigidBody.linearVelocity.y, rigidBody.linearVelocity.z,
+				rigidBody.angularVelocity.x, rigidBody.angularVelocity.y, rigidBody.angularVelocity.z
+			};
 
-					Vec3p deltaPos0 = deltaLinear0 + Cross(deltaAngular0, contact.localPoint0);
-					Vec3p deltaPos1 = deltaLinear1 + Cross(deltaAngular1, contact.localPoint1);
+			const uInt32 handle = (uInt32)mEntities[i].handle;
 
-					nextContact.depth -= Dot(deltaPos0, nextContact.normal);
-					nextContact.depth += Dot(deltaPos1, nextContact.normal);
-				}
+			HashBytes(hash, &handle, sizeof(handle));
+			HashBytes(hash, transformState, sizeof(transformState));
+			HashBytes(hash, velocityState, sizeof(velocityState));
+		}
+
+		/* Warm start impulses also steer the next step */
+
+		for (const CollisionData& data : mPrevCollisions)
+		{
+			HashBytes(hash, &data.pairKey, sizeof(data.pairKey));
+
+			for (uSize c = 0; c < data.collision.count; c++)
+			{
+				const Contact& contact = data.collision.contacts[c];
+
+				HashBytes(hash, &contact.normalImpulse, sizeof(contact.normalImpulse));
+				HashBytes(hash, contact.tangentImpulse, sizeof(contact.tangentImpulse));
 			}
+		}
 
-			/* Resolve velocities */
+		for (const JointData& data : mJoints)
+		{
+			const Joint& joint = data.pJoint->joint;
 
-			uSize velIteration = 0;
-			while (velIteration++ < PHYSICS_MAX_VELOCITY_ITERATIONS)
+			const floatp jointState[7] =
 			{
-				const uSize nextIndex = FindNextFastest(collision);
+				joint.linearImpulse.x, joint.linearImpulse.y, joint.linearImpulse.z,
+				joint.angularImpulse.x, joint.angularImpulse.y, joint.angularImpulse.z, joint.axisImpulse
+			};
 
-				if (nextIndex == collision.count)
-				{
-					break;
-				}
+			const uInt32 handle = (uInt32)data.entity.handle;
 
-				Contact& contact = collision.contacts[nextIndex];
+			HashBytes(hash, &handle, sizeof(handle));
+			HashBytes(hash, jointState, sizeof(jointState));
+		}
 
-				/* Calculate deltas */
+		return hash;
+	}
 
-				Vec3p deltaLinearVel0, deltaLinearVel1;
-				Vec3p deltaAngularVel0, deltaAngularVel1;
+	/* Narrowphase counters are per thread, the ones of this thread are cleared for the step */
+	void Physics::BeginStats()
+	{
+		mStats = {};
+		CollisionDetection::ThreadStats() = {};
+		GJK::ThreadEPAStats() = {};
+	}
 
-				CalculateVelocityDeltas(collisionData, contact, 
-					deltaLinearVel0, deltaLinearVel1, deltaAngularVel0, deltaAngularVel1);
+	void Physics::EndStats()
+	{
+		mStats.bodies = mEntities.Size();
+		mStats.joints = mJoints.Size();
 
-				/* Apply deltas */
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			mStats.sleepingBodies += mBodyPhysics[i]->rigidBody.asleep ? 1 : 0;
+		}
 
-				rigidBody0.AddLinearVelocity(deltaLinearVel0);
-				rigidBody1.AddLinearVelocity(deltaLinearVel1);
-				rigidBody0.AddAngularVelocity(deltaAngularVel0);
-				rigidBody1.AddAngularVelocity(deltaAngularVel1);
+		const NarrowphaseStats& narrowphaseStats = CollisionDetection::ThreadStats();
 
-				/* Adjust remaining contacts */
+		for (uSize type0 = 0; type0 < SHAPE_TYPE_COUNT; type0++)
+		{
+			for (uSize type1 = 0; type1 < SHAPE_TYPE_COUNT; type1++)
+			{
+				mStats.narrowphaseTests[type0][type1] = narrowphaseStats.tests[type0][type1];
+			}
+		}
 
-				for (uSize j = 0; j < collision.count; j++) // @TODO: speed up
-				{
-					Contact& nextContact = collision.contacts[j];
+		mStats.meshQueryOverflows = narrowphaseStats.meshQueryOverflows;
+
+		// Warned once, a body resting on dense geometry would otherwise repeat it every step
+		if (mStats.meshQueryOverflows > 0 && !mMeshOverflowWarned)
+		{
+			LogWarning("Physics: a mesh test found more than %d triangles, the rest were skipped and contacts may be missing.",
+				(int)PHYSICS_MESH_MAX_QUERY_TRIANGLES);
+			mMeshOverflowWarned = true;
+		}
+
+		const GJK::EPAStats& epaStats = GJK::ThreadEPAStats();
+
+		for (uSize i = 0; i < PHYSICS_EPA_STAT_BUCKETS; i++)
+		{
+			mStats.epaIterations[i] = epaStats.runs[i];
+		}
+
+		mStats.timings = mTimings;
+	}
 
-					/* Adjust velocities */
+	void Physics::LogStats() const
+	{
+		static const char* shapeNames[SHAPE_TYPE_COUNT] = { "sphere", "plane", "rect", "capsule", "hull", "mesh", "compound" };
 
-					Vec3p deltaVel0 = deltaLinearVel0 + Cross(deltaAngularVel0, contact.localPoint0);
-					Vec3p deltaVel1 = deltaLinearVel1 + Cross(deltaAngularVel1, contact.localPoint1);
-					Vec3p deltaContactVel0 = nextContact.invContactBasis.Transposed() * deltaVel0;
-					Vec3p deltaContactVel1 = nextContact.invContactBasis.Transposed() * deltaVel1;
+		const PhysicsTimings& timings = mStats.timings;
 
-					nextContact.contactVelocity += deltaContactVel0;
-					nextContact.contactVelocity -= deltaContactVel1;
+		LogInfo("Physics: %d bodies (%d asleep), %d joints, %d candidate pairs (%d reused), %d colliding pairs, %d contacts, max penetration %.4f (%.4f after solving)",
+			(int)mStats.bodies, (int)mStats.sleepingBodies, (int)mStats.joints, (int)mStats.candidatePairs, (int)mStats.reusedManifolds,
+			(int)mStats.collidingPairs, (int)mStats.contacts, (double)mStats.maxPenetration, (double)mStats.residualPenetration);
 
-					nextContact.CalcContactBasis();
-					nextContact.CalcLocalPoints(transform0.position, transform1.position);
-					nextContact.CalcContactVelocity(rigidBody0.lastAcceleration, rigidBody1.lastAcceleration,
-						rigidBody0.angularVelocity, rigidBody1.angularVelocity,
-						rigidBody0.linearVelocity, rigidBody1.linearVelocity, stepTime);
-					nextContact.CalcTargetVelocity(rigidBody0.lastAcceleration, rigidBody1.lastAcceleration, 
-						rigidBody0.restitution, rigidBody1.restitution, stepTime);
+		LogInfo("Physics: %d solver iterations (at most %d per substep), broad %.3f ms, narrow %.3f ms, solve %.3f ms, continuous %.3f ms, integrate %.3f ms, diagnostics %.3f ms",
+			(int)mStats.solverIterations, (int)mStats.maxSolverIterations, timings.broadphase * 1.0e-6, timings.narrowphase * 1.0e-6,
+			timings.solve * 1.0e-6, timings.continuous * 1.0e-6, timings.integrate * 1.0e-6, timings.diagnostics * 1.0e-6);
+
+		LogInfo("Physics: EPA iterations 1: %d, 2-3: %d, 4-7: %d, 8-15: %d, 16-31: %d, 32+: %d",
+			(int)mStats.epaIterations[0], (int)mStats.epaIterations[1], (int)mStats.epaIterations[2],
+			(int)mStats.epaIterations[3], (int)mStats.epaIterations[4], (int)mStats.epaIterations[5]);
+
+		if (mStats.meshQueryOverflows > 0)
+		{
+			LogInfo("Physics: %d mesh tests skipped triangles past %d", (int)mStats.meshQueryOverflows, (int)PHYSICS_MESH_MAX_QUERY_TRIANGLES);
+		}
+
+		for (uSize type0 = 0; type0 < SHAPE_TYPE_COUNT; type0++)
+		{
+			for (uSize type1 = 0; type1 < SHAPE_TYPE_COUNT; type1++)
+			{
+				if (mStats.narrowphaseTests[type0][type1] > 0)
+				{
+					LogInfo("Physics: %d %s-%s tests", (int)mStats.narrowphaseTests[type0][type1], shapeNames[type0], shapeNames[type1]);
 				}
 			}
 		}
@@ -477,16 +1371,68 @@ namespace Quartz
 	void Physics::Step(EntityWorld& world, double deltaTime)
 	{
 		RigidBodyView& rigidBodies = world.CreateView<RigidBodyComponent, TransformComponent>();
+		JointView& joints = world.CreateView<JointComponent>();
+
+		const double stepTime = deltaTime / (double)PHYSICS_STEP_ITERATIONS;
+
+		mTimings = {};
+		mTimer.Start();
+
+		BeginStats();
+
+		/* Drag factors only depend on the step length */
+
+		mLinearDrag		= pow(0.9, stepTime);
+		mAngularDrag	= pow(0.1, stepTime);
+
+		GatherBodies(world, rigidBodies);
+		GatherJoints(world, joints);
+		mTimings.integrate += mTimer.Mark();
+
+		mResidualPenetration = 0;
 
 		for (uSize i = 0; i < PHYSICS_STEP_ITERATIONS; i++)
 		{
-			double stepTime = deltaTime / (double)PHYSICS_STEP_ITERATIONS;
+
+			ApplyForces(world, rigidBodies, stepTime);
+			mTimings.integrate += mTimer.Mark();
+
+			FindCandidates(world, rigidBodies, stepTime);
+			mTimings.broadphase += mTimer.Mark();
 
 			FindCollisions(world, rigidBodies, stepTime);
+			mTimings.narrowphase += mTimer.Mark();
+
 			ResolveCollisions(world, rigidBodies, stepTime);
-			ApplyForces(world, rigidBodies, stepTime);
+			mTimings.solve += mTimer.Mark();
+
+			SweepContinuous(world, rigidBodies, stepTime);
+			mTimings.continuous += mTimer.Mark();
+
+			IntegrateVelocities(world, rigidBodies, stepTime);
+			mTimings.integrate += mTimer.Mark();
+
+			if (mLogStats || mMeasurePenetration)
+			{
+				MeasurePenetration();
+				mTimings.diagnostics += mTimer.Mark();
+			}
 		}
 
+		UpdateQueryBounds();
+		mTimings.broadphase += mTimer.Mark();
+
+		EndStats();
+
+		if (mLogStats)
+		{
+			LogStats();
+		}
+
+#if PHYSICS_DETERMINISTIC
+		mStateHash = CalcStateHash();
+#endif
+
 	}
 }
 
@@ -0,0 +1,705 @@
+#include "Physics.h"
+#include "Utility/Swap.h"
+
+#include <algorithm>
+#include <thread>
+#include <float.h>
+#include <math.h>
+
+namespace Quartz
+{
+	/* Sweep Bounds */
+
+	void SweepBounds::Clear()
+	{
+		mEntries.Clear();
+		mReach.Clear();
+	}
+
+	void SweepBounds::Add(const Vec3p& min, const Vec3p& max, uInt32 index)
+	{
+		mEntries.PushBack({ min, max, index });
+	}
+
+	void SweepBounds::Sort()
+	{
+		std::sort(mEntries.Data(), mEntries.Data() + mEntries.Size(),
+			[](const Entry& entry0, const Entry& entry1)
+			{
+				return entry0.min.x < entry1.min.x || (entry0.min.x == entry1.min.x && entry0.index < entry1.index);
+			});
+
+		mReach.Resize(mEntries.Size());
+
+		floatp reach = -FLT_MAX;
+
+		for (uSize i = 0; i < mEntries.Size(); i++)
+		{
+			reach = Max(reach, mEntries[i].max.x);
+			mReach[i] = reach;
+		}
+	}
+
+	/*
+		Static and moving bodies are kept apart, so large level geometry only
+		widens the reach of the few static entries instead of every body.
+	*/
+	void Physics::UpdateQueryBounds()
+	{
+		mQueryStatic.Clear();
+		mQueryDynamic.Clear();
+
+		for (uSize i = 0; i < mEntities.Size(); i++)
+		{
+			const RigidBodyComponent& physics = *mBodyPhysics[i];
+
+			Vec3p min;
+			Vec3p max;
+			CalcBounds(physics.collider, *mBodyTransforms[i], min, max);
+
+			if (physics.collider.IsStatic())
+			{
+				mQueryStatic.Add(min, max, (uInt32)i);
+			}
+			else
+			{
+				mQueryDynamic.Add(min, max, (uInt32)i);
+			}
+		}
+
+		mQueryStatic.Sort();
+		mQueryDynamic.Sort();
+	}
+
+	/* Ray Helpers */
+
+	static Vec3p InverseDirection(const Vec3p& direction)
+	{
+		return Vec3p(
+			direction.x != 0.0f ? 1.0f / direction.x : FLT_MAX,
+			direction.y != 0.0f ? 1.0f / direction.y : FLT_MAX,
+			direction.z != 0.0f ? 1.0f / direction.z : FLT_MAX);
+	}
+
+	static bool RayBounds(const Vec3p& origin, const Vec3p& invDirection, const Vec3p& min, const Vec3p& max, floatp maxDistance)
+	{
+		const floatp tx0 = (min.x - origin.x) * invDirection.x;
+		const floatp tx1 = (max.x - origin.x) * invDirection.x;
+		const floatp ty0 = (min.y - origin.y) * invDirection.y;
+		const floatp ty1 = (max.y - origin.y) * invDirection.y;
+		const floatp tz0 = (min.z - origin.z) * invDirection.z;
+		const floatp tz1 = (max.z - origin.z) * invDirection.z;
+
+		const floatp enter	= Max(Max(Min(tx0, tx1), Min(ty0, ty1)), Max(Min(tz0, tz1), (floatp)0.0f));
+		const floatp exit	= Min(Min(Max(tx0, tx1), Max(ty0, ty1)), Min(Max(tz0, tz1), maxDistance));
+
+		return enter <= exit;
+	}
+
+	/* Entry distance of a ray starting outside the sphere */
+	static bool RaySphere(const Vec3p& origin, const Vec3p& direction, const Vec3p& center, floatp radius, floatp& outDistance)
+	{
+		const Vec3p offset = origin - center;
+		const floatp b = Dot(offset, direction);
+		const floatp c = Dot(offset, offset) - radius * radius;
+		const floatp discriminant = b * b - c;
+
+		if (b > 0.0f || discriminant < 0.0f)
+		{
+			return false;
+		}
+
+		outDistance = Max(-b - sqrt(discriminant), (floatp)0.0f);
+
+		return true;
+	}
+
+	/* Ray in the unscaled local space of a shape transform, distances along it match world distances */
+	static void ToLocalRay(const ShapeTransform& transform, const Vec3p& origin, const Vec3p& direction,
+		Vec3p& outOrigin, Vec3p& outDirection)
+	{
+		const Vec3p rotated = transform.invRotation * direction;
+
+		outOrigin		= transform.ToLocalPoint(origin);
+		outDirection	= Vec3p(rotated.x / transform.scale.x, rotated.y / transform.scale.y, rotated.z / transform.scale.z);
+	}
+
+	/* Raycasts, the origin starting inside a solid shape hits at distance 0 */
+
+	bool Physics::RaycastSphere(const SphereCollider& sphere, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const Vec3p center = transform.position;
+		const floatp radius = sphere.GetSphere().radius * transform.scale.Maximum();
+
+		if ((origin - center).MagnitudeSquared() <= radius * radius)
+		{
+			outDistance = 0.0f;
+			outNormal = -direction;
+			return true;
+		}
+
+		if (!RaySphere(origin, direction, center, radius, outDistance) || outDistance > maxDistance)
+		{
+			return false;
+		}
+
+		outNormal = (origin + direction * outDistance - center).Normalized();
+
+		return true;
+	}
+
+	bool Physics::RaycastPlane(const PlaneCollider& plane, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const Vec3p normal = Quatp(transform.rotation) * plane.GetPlane().normal;
+		const floatp denominator = Dot(normal, direction);
+
+		if (Abs(denominator) < 1e-9f)
+		{
+			return false; // Parallel
+		}
+
+		outDistance = Dot(normal, Vec3p(transform.position) - origin) / denominator;
+
+		if (outDistance < 0.0f || outDistance > maxDistance)
+		{
+			return false;
+		}
+
+		// Planes are two sided, like their collisions
+		outNormal = denominator > 0.0f ? -normal : normal;
+
+		return true;
+	}
+
+	bool Physics::RaycastRect(const RectCollider& rect, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const ShapeTransform transform0(transform, rect.GetRect().bounds);
+
+		Vec3p localOrigin;
+		Vec3p localDirection;
+		ToLocalRay(transform0, origin, direction, localOrigin, localDirection);
+
+		const floatp origins[3]		= { localOrigin.x, localOrigin.y, localOrigin.z };
+		const floatp directions[3]	= { localDirection.x, localDirection.y, localDirection.z };
+
+		floatp enter		= 0.0f;
+		floatp exit			= maxDistance;
+		sSize enterAxis		= -1;
+		floatp enterSign	= 0.0f;
+
+		/* Slabs of the [-1, 1] cube */
+
+		for (uSize axis = 0; axis < 3; axis++)
+		{
+			if (Abs(directions[axis]) < 1e-12f)
+			{
+				if (origins[axis] < -1.0f || origins[axis] > 1.0f)
+				{
+					return false;
+				}
+
+				continue;
+			}
+
+			floatp t0 = (-1.0f - origins[axis]) / directions[axis];
+			floatp t1 = (1.0f - origins[axis]) / directions[axis];
+			floatp sign = -1.0f;
+
+			if (t0 > t1)
+			{
+				Swap(t0, t1);
+				sign = 1.0f;
+			}
+
+			if (t0 > enter)
+			{
+				enter		= t0;
+				enterAxis	= (sSize)axis;
+				enterSign	= sign;
+			}
+
+			exit = Min(exit, t1);
+
+			if (enter > exit)
+			{
+				return false;
+			}
+		}
+
+		outDistance = enter;
+
+		if (enterAxis < 0)
+		{
+			outNormal = -direction; // Started inside
+			return true;
+		}
+
+		const Vec3p localNormal(
+			enterAxis == 0 ? enterSign : 0.0f,
+			enterAxis == 1 ? enterSign : 0.0f,
+			enterAxis == 2 ? enterSign : 0.0f);
+
+		outNormal = transform0.ToWorldNormal(localNormal);
+
+		return true;
+	}
+
+	bool Physics::RaycastCapsule(const CapsuleCollider& capsule, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const Vec3p axis = Quatp(transform.rotation) * Vec3p(0.0f, capsule.GetCapsule().halfHeight * transform.scale.y, 0.0f);
+		const floatp radius = capsule.GetCapsule().radius * Max(transform.scale.x, transform.scale.z);
+		const Vec3p base = Vec3p(transform.position) - axis;
+		const Vec3p segment = axis * 2.0f;
+		const floatp segmentLength2 = Dot(segment, segment);
+
+		auto ClosestOnSegment = [&](const Vec3p& point)
+		{
+			const floatp t = segmentLength2 > 0.0f ? Dot(point - base, segment) / segmentLength2 : 0.0f;
+			return base + segment * Min(Max(t, (floatp)0.0f), (floatp)1.0f);
+		};
+
+		if ((origin - ClosestOnSegment(origin)).MagnitudeSquared() <= radius * radius)
+		{
+			outDistance = 0.0f;
+			outNormal = -direction;
+			return true;
+		}
+
+		floatp closest = FLT_MAX;
+
+		/* Cylinder body, the hit only counts between the end caps */
+
+		const Vec3p offset = origin - base;
+		const floatp segmentDirection	= Dot(segment, direction);
+		const floatp segmentOffset		= Dot(segment, offset);
+		const floatp a = segmentLength2 - segmentDirection * segmentDirection;
+
+		if (a > 1e-12f)
+		{
+			const floatp b = segmentLength2 * Dot(direction, offset) - segmentOffset * segmentDirection;
+			const floatp c = segmentLength2 * (Dot(offset, offset) - radius * radius) - segmentOffset * segmentOffset;
+			const floatp discriminant = b * b - a * c;
+
+			if (discriminant >= 0.0f)
+			{
+				const floatp t = (-b - sqrt(discriminant)) / a;
+				const floatp y = segmentOffset + t * segmentDirection;
+
+				if (t >= 0.0f && y > 0.0f && y < segmentLength2)
+				{
+					closest = t;
+				}
+			}
+		}
+
+		/* End caps */
+
+		if (closest == FLT_MAX)
+		{
+			floatp distance;
+
+			if (RaySphere(origin, direction, base, radius, distance))
+			{
+				closest = distance;
+			}
+
+			if (RaySphere(origin, direction, base + segment, radius, distance))
+			{
+				closest = Min(closest, distance);
+			}
+		}
+
+		if (closest > maxDistance)
+		{
+			return false;
+		}
+
+		const Vec3p point = origin + direction * closest;
+
+		outDistance = closest;
+		outNormal = (point - ClosestOnSegment(point)).Normalized();
+
+		return true;
+	}
+
+	bool Physics::RaycastHull(const HullCollider& hull, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const HullData& hullData = *hull.GetHull().pHullData;
+
+		if (!hullData.IsValid())
+		{
+			return false;
+		}
+
+		const ShapeTransform transform0(transform);
+
+		Vec3p localOrigin;
+		Vec3p localDirection;
+		ToLocalRay(transform0, origin, direction, localOrigin, localDirection);
+
+		floatp enter	= 0.0f;
+		floatp exit		= maxDistance;
+		const HullFace* pEnterFace = nullptr;
+
+		/* Clip the ray against every face plane */
+
+		for (const HullFace& face : hullData.GetFaces())
+		{
+			const floatp denominator	= Dot(face.normal, localDirection);
+			const floatp distance		= face.distance - Dot(face.normal, localOrigin);
+
+			if (Abs(denominator) < 1e-12f)
+			{
+				if (distance < 0.0f)
+				{
+					return false; // Parallel and outside
+				}
+
+				continue;
+			}
+
+			const floatp t = distance / denominator;
+
+			if (denominator < 0.0f)
+			{
+				if (t > enter)
+				{
+					enter = t;
+					pEnterFace = &face;
+				}
+			}
+			else
+			{
+				exit = Min(exit, t);
+			}
+
+			if (enter > exit)
+			{
+				return false;
+			}
+		}
+
+		outDistance = enter;
+		outNormal = pEnterFace ? transform0.ToWorldNormal(pEnterFace->normal) : -direction;
+
+		return true;
+	}
+
+	bool Physics::RaycastMesh(const MeshCollider& mesh, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const CollisionMesh& collisionMesh = *mesh.GetMesh().pMesh;
+		const ShapeTransform transform0(transform);
+
+		Vec3p localOrigin;
+		Vec3p localDirection;
+		ToLocalRay(transform0, origin, direction, localOrigin, localDirection);
+
+		uInt32 triangle;
+
+		if (!collisionMesh.Raycast(localOrigin, localDirection, maxDistance, outDistance, triangle))
+		{
+			return false;
+		}
+
+		Vec3f a, b, c;
+		collisionMesh.GetTriangle(triangle, a, b, c);
+
+		const Vec3p normal = transform0.ToWorldNormal(Cross(Vec3p(b) - Vec3p(a), Vec3p(c) - Vec3p(a)));
+
+		outNormal = Dot(normal, direction) > 0.0f ? -normal : normal;
+
+		return true;
+	}
+
+	bool Physics::RaycastCompound(const CompoundCollider& compound, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		const CompoundData& compoundData = *compound.GetCompound().pCompound;
+		const ShapeTransform transform0(transform);
+
+		// Children are bounded before the body's scale, which is the space ToLocalPoint maps into
+		const Vec3p localOrigin	= transform0.ToLocalPoint(origin);
+		const Vec3p localEnd	= transform0.ToLocalPoint(origin + direction * maxDistance);
+
+		const Vec3p localMin(Min(localOrigin.x, localEnd.x), Min(localOrigin.y, localEnd.y), Min(localOrigin.z, localEnd.z));
+		const Vec3p localMax(Max(localOrigin.x, localEnd.x), Max(localOrigin.y, localEnd.y), Max(localOrigin.z, localEnd.z));
+
+		uInt32 children[PHYSICS_COMPOUND_MAX_CHILDREN];
+		const uSize childCount = compoundData.QueryBounds(localMin, localMax, children, PHYSICS_COMPOUND_MAX_CHILDREN);
+
+		bool hit = false;
+		floatp closest = maxDistance;
+
+		for (uSize i = 0; i < childCount; i++)
+		{
+			const Transform childTransform = compoundData.GetChildTransform(children[i], transform);
+
+			floatp distance;
+			Vec3p normal;
+
+			if (RaycastCollider(compoundData.GetChild(children[i]).collider, childTransform, origin, direction, closest, distance, normal) &&
+				(!hit || distance < closest))
+			{
+				closest		= distance;
+				outDistance	= distance;
+				outNormal	= normal;
+				hit			= true;
+			}
+		}
+
+		return hit;
+	}
+
+	bool Physics::RaycastCollider(const Collider& collider, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+		floatp maxDistance, floatp& outDistance, Vec3p& outNormal)
+	{
+		using RaycastFunc = bool(*)(const Collider& collider, const Transform& transform, const Vec3p& origin, const Vec3p& direction,
+			floatp maxDistance, floatp& outDistance, Vec3p& outNormal);
+
+		static RaycastFunc functionTable[7]
+		{
+			(RaycastFunc) RaycastSphere,
+			(RaycastFunc) RaycastPlane,
+			(RaycastFunc) RaycastRect,
+			(RaycastFunc) RaycastCapsule,
+			(RaycastFunc) RaycastHull,
+			(RaycastFunc) RaycastMesh,
+			(RaycastFunc) RaycastCompound
+		};
+
+		return functionTable[(uSize)collider.GetShapeType()](collider, transform, origin, direction, maxDistance, outDistance, outNormal);
+	}
+
+	/* Scene Queries */
+
+	bool Physics::Raycast(const RaycastQuery& query, QueryHit& outHit) const
+	{
+		const Vec3p direction		= query.direction.Normalized();
+		const Vec3p invDirection	= InverseDirection(direction);
+		const Vec3p end				= query.origin + direction * query.maxDistance;
+
+		const Vec3p min(Min(query.origin.x, end.x), Min(query.origin.y, end.y), Min(query.origin.z, end.z));
+		const Vec3p max(Max(query.origin.x, end.x), Max(query.origin.y, end.y), Max(query.origin.z, end.z));
+
+		outHit.entity	= NullEntity;
+		outHit.hit		= false;
+
+		floatp closest = query.maxDistance;
+
+		QueryBounds(min, max, [&](const SweepBounds::Entry& entry)
+		{
+			const Entity entity = mEntities[entry.index];
+
+			if (entity.handle == query.ignore.handle || !RayBounds(query.origin, invDirection, entry.min, entry.max, closest))
+			{
+				return true;
+			}
+
+			floatp distance;
+			Vec3p normal;
+
+			if (RaycastCollider(mBodyPhysics[entry.index]->collider, *mBodyTransforms[entry.index],
+				query.origin, direction, closest, distance, normal) && (!outHit.hit || distance < closest))
+			{
+				closest = distance;
+
+				outHit.entity	= entity;
+				outHit.distance	= distance;
+				outHit.point	= query.origin + direction * distance;
+				outHit.normal	= normal;
+				outHit.hit		= true;
+			}
+
+			return true;
+		});
+
+		return outHit.hit;
+	}
+
+	/*
+		Shape casts reuse the conservative advancement of continuous collision, so the
+		reported distance is within 1/64th of the sample spacing past the true contact.
+		Casts longer than PHYSICS_CONTINUOUS_MAX_SAMPLES radii are sampled more coarsely.
+	*/
+	bool Physics::ShapeCast(const ShapeCastQuery& query, QueryHit& outHit) const
+	{
+		const Collider& collider	= *query.pCollider;
+		const Transform& transform	= query.transform;
+
+		const Vec3p direction	= query.direction.Normalized();
+		const Vec3p motion		= direction * query.maxDistance;
+		const floatp spacing	= CalcInnerRadius(collider, transform) * PHYSICS_CONTINUOUS_SPACING;
+
+		outHit.entity	= NullEntity;
+		outHit.hit		= false;
+
+		if (spacing <= 0.0f)
+		{
+			return false; // Planes and meshes have no volume to sweep
+		}
+
+		Vec3p min;
+		Vec3p max;
+		CalcBounds(collider, transform, min, max);
+
+		min += Vec3p(Min(motion.x, (floatp)0.0f), Min(motion.y, (floatp)0.0f), Min(motion.z, (floatp)0.0f));
+		max += Vec3p(Max(motion.x, (floatp)0.0f), Max(motion.y, (floatp)0.0f), Max(motion.z, (floatp)0.0f));
+
+		floatp closest = FLT_MAX;
+		uInt32 closestIndex = 0;
+
+		QueryBounds(min, max, [&](const SweepBounds::Entry& entry)
+		{
+			if (mEntities[entry.index].handle == query.ignore.handle)
+			{
+				return true;
+			}
+
+			floatp time;
+
+			if (TimeOfImpact(collider, transform, motion, mBodyPhysics[entry.index]->collider, *mBodyTransforms[entry.index], spacing, time) &&
+				time < closest)
+			{
+				closest			= time;
+				closestIndex	= entry.index;
+			}
+
+			return true;
+		});
+
+		if (closest == FLT_MAX)
+		{
+			return false;
+		}
+
+		/* Contact at the time of impact, the normal points from the hit body towards the cast shape */
+
+		Transform swept = transform;
+		swept.position = Vec3f(Vec3p(transform.position) + motion * closest);
+
+		Collision collision;
+
+		outHit.entity	= mEntities[closestIndex];
+		outHit.distance	= query.maxDistance * closest;
+		outHit.hit		= true;
+
+		if (collisionDetection.Collide(collider, swept, mBodyPhysics[closestIndex]->collider, *mBodyTransforms[closestIndex], collision) &&
+			collision.count > 0)
+		{
+			outHit.point	= collision.contacts[0].point;
+			outHit.normal	= collision.contacts[0].normal;
+		}
+		else
+		{
+			outHit.point	= swept.position;
+			outHit.normal	= -direction;
+		}
+
+		return true;
+	}
+
+	uSize Physics::Overlap(const OverlapQuery& query, Entity* pOutEntities, uSize maxEntities) const
+	{
+		Vec3p min;
+		Vec3p max;
+		CalcBounds(*query.pCollider, query.transform, min, max);
+
+		if (maxEntities == 0)
+		{
+			return 0;
+		}
+
+		uSize count = 0;
+
+		QueryBounds(min, max, [&](const SweepBounds::Entry& entry)
+		{
+			const Entity entity = mEntities[entry.index];
+
+			if (entity.handle == query.ignore.handle)
+			{
+				return true;
+			}
+
+			Collision collision;
+
+			if (collisionDetection.Collide(*query.pCollider, query.transform,
+				mBodyPhysics[entry.index]->collider, *mBodyTransforms[entry.index], collision))
+			{
+				pOutEntities[count++] = entity;
+			}
+
+			return count < maxEntities;
+		});
+
+		return count;
+	}
+
+	/* Batches */
+
+	/* Runs func(start, end) over even slices of count, the calling thread takes the first slice */
+	template<typename Func>
+	static void RunBatch(uSize count, uSize threadCount, Func&& func)
+	{
+		threadCount = Min(Min(Max(threadCount, (uSize)1), (uSize)PHYSICS_QUERY_MAX_THREADS),
+			Max(count / PHYSICS_QUERY_BATCH_SIZE, (uSize)1));
+
+		std::thread threads[PHYSICS_QUERY_MAX_THREADS];
+
+		for (uSize i = 1; i < threadCount; i++)
+		{
+			uSize start = (count / threadCount) * i;
+			uSize end	= (count / threadCount) * (i + 1);
+
+			if (i == threadCount - 1) end = count;
+
+			threads[i] = std::thread(func, start, end);
+		}
+
+		func((uSize)0, threadCount == 1 ? count : count / threadCount);
+
+		for (uSize i = 1; i < threadCount; i++)
+		{
+			threads[i].join();
+		}
+	}
+
+	void Physics::RaycastBatch(const RaycastQuery* pQueries, uSize count, QueryHit* pOutHits, uSize threadCount) const
+	{
+		RunBatch(count, threadCount, [&](uSize start, uSize end)
+		{
+			for (uSize i = start; i < end; i++)
+			{
+				Raycast(pQueries[i], pOutHits[i]);
+			}
+		});
+	}
+
+	void Physics::ShapeCastBatch(const ShapeCastQuery* pQueries, uSize count, QueryHit* pOutHits, uSize threadCount) const
+	{
+		RunBatch(count, threadCount, [&](uSize start, uSize end)
+		{
+			for (uSize i = start; i < end; i++)
+			{
+				ShapeCast(pQueries[i], pOutHits[i]);
+			}
+		});
+	}
+
+	void Physics::OverlapBatch(const OverlapQuery* pQueries, uSize count, Entity* pOutEntities, uSize maxEntities,
+		uSize* pOutCounts, uSize threadCount) const
+	{
+		RunBatch(count, threadCount, [&](uSize start, uSize end)
+		{
+			for (uSize i = start; i < end; i++)
+			{
+				pOutCounts[i] = Overlap(pQueries[i], pOutEntities + i * maxEntities, maxEntities);
+			}
+		});
+	}
+}
@@ -23,6 +23,7 @@
 #include "Physics.h"
 
 #include <vulkan/vulkan.h>
+#include <thread>
 
 #include "Input/Input.h"
 #include "Filesystem/File.h"
@@ -37,6 +38,10 @@
 #include "Resource/Loaders/MaterialHandler.h"
 #include "Resource/Binary/QModelParser.h"
 #include "Resource/Binary/QShaderParser.h"
+#include "Resource/Processing/MeshOptimizer.h"
+#include "Resource/Processing/MeshSimplifier.h"
+#include "Resource/Processing/MeshletBuilder.h"
+#include "Resource/Processing/VertexQuantizer.h"
 
 #include "Runtime/Timer.h"
 #include "Utility/RefCounter.h"
@@ -55,6 +60,7 @@ namespace Quartz
 		Entity			gEntity0;
 		Entity			gEntity1;
 		Physics			gPhysics;
+		CollisionMesh	gTestSceneMesh;
 
 		bool QUARTZ_ENGINE_API ModuleQuery(bool isEditor, Quartz::ModuleQueryInfo& moduleQuery)
 		{
@@ -294,13 +300,73 @@ namespace Quartz
 		RigidBody cameraRigidBody(0.0f, 1.0f, 1.0f, { 0.0f, 0.0f, 0.0f });
 		SphereCollider cameraCollider(0.5f, true);
 
-		void QuickConvertToQModel(const String& objFilePath, const String& qModelFilePath)
+		ModelHandler* pModelHandler = nullptr;
+
+		void QuickConvertToQModel(const String& objFilePath, const String& qModelFilePath,
+			VertexQuantizeFlags quantizeFlags = VERTEX_QUANTIZE_NONE, uInt32 lodCount = 0)
 		{
 			File* pQMFFile = Engine::GetFilesystem().CreateFile(qModelFilePath);
 			Model* pModel = Engine::GetAssetManager().GetOrLoadAsset<Model>(objFilePath);
+
+			if (!pModel)
+			{
+				LogError("Failed to convert [%s] to QModel: the model could not be loaded.", objFilePath.Str());
+				return;
+			}
+
+			LodChainSettings lodSettings;
+			lodSettings.lodCount		= lodCount;
+			lodSettings.reduction		= 0.5f;
+			lodSettings.maxError		= 0.01f;
+			lodSettings.minTriangles	= 64;
+
+			LodChainStats lodStats;
+			if (lodCount > 0 && GenerateModelLods(*pModel, lodSettings, pModelHandler->GetBufferPool(), &lodStats))
+			{
+				for (uSize level = 0; level < lodStats.levelCount; level++)
+				{
+					LogInfo("LOD %d of [%s]: %d triangles, max error %f", (int)level, objFilePath.Str(),
+						(int)lodStats.triangleCounts[level], lodStats.maxErrors[level]);
+				}
+			}
+
+			MeshOptimizeStats optimizeStats;
+			if (OptimizeModel(*pModel, &optimizeStats))
+			{
+				LogInfo("Optimized [%s]: ACMR %.3f -> %.3f, ATVR %.3f -> %.3f", objFilePath.Str(),
+					optimizeStats.before.acmr, optimizeStats.after.acmr, optimizeStats.before.atvr, optimizeStats.after.atvr);
+			}
+
+			MeshletStats meshletStats;
+			if (BuildModelMeshlets(*pModel, &meshletStats))
+			{
+				LogInfo("Meshlets [%s]: %d meshlets, %.1f vertices, %.1f triangles, reuse %.2f, cones %.2f at %.1f deg",
+					objFilePath.Str(), (int)meshletStats.meshletCount, meshletStats.averageVertices, meshletStats.averageTriangles,
+					meshletStats.vertexReuse, meshletStats.coneFraction, meshletStats.averageConeAngle);
+			}
+
+			VertexQuantizeStats quantizeStats;
+			if (quantizeFlags != VERTEX_QUANTIZE_NONE &&
+				QuantizeModel(*pModel, quantizeFlags, pModelHandler->GetBufferPool(), &quantizeStats))
+			{
+				LogInfo("Quantized [%s]: vertices %.2f MB -> %.2f MB", objFilePath.Str(),
+					quantizeStats.sizeBytesBefore / 1e6, quantizeStats.sizeBytesAfter / 1e6);
+
+				for (uSize i = 0; i < quantizeStats.meshErrors.Size(); i++)
+				{
+					const VertexQuantizeError& meshError = quantizeStats.meshErrors[i];
+					LogInfo("  Mesh [%s]: max error position %f, normal %f deg, uv %f",
+						i < pModel->meshes.Size() ? pModel->meshes[i].name.Str() : "", meshError.maxPositionError,
+						meshError.maxDirectionError, meshError.maxTexCoordError);
+				}
+			}
+
 			QModelParser qmfWriter(*pQMFFile);
 			qmfWriter.SetModel(*pModel);
 			qmfWriter.Write();
+
+			// The steps above rewrote the shared model in place, unload it so later loads read the source again
+			Engine::GetAssetManager().UnloadAsset(pModel);
 		}
 
 		void QuckConvertToQShader(const String& glslFilePath, const String& qShaderFilePath)
@@ -499,7 +565,7 @@ namespace Quartz
 
 			/////////////////////////////////
 
-			ModelHandler* pModelHandler = new ModelHandler; // TODO
+			pModelHandler = new ModelHandler; // TODO
 			Engine::GetAssetManager().RegisterAssetHandler("obj", pModelHandler);
 			Engine::GetAssetManager().RegisterAssetHandler("qmodel", pModelHandler);
 
@@ -540,6 +606,7 @@ namespace Quartz
 			//QuckConvertToQShader("Shaders/terrain.frag", "Shaders/terrain.qsfrag");
 
 			//QuckConvertToQShader("Shaders/basic_mesh.vert", "Shaders/basic_mesh.qsvert");
+			//QuckConvertToQShader("Shaders/basic_mesh_quantized.vert", "Shaders/basic_mesh_quantized.qsvert");
 			//QuckConvertToQShader("Shaders/basic_color.frag", "Shaders/basic_color.qsfrag");
 			//QuckConvertToQShader("Shaders/basic_texture.frag", "Shaders/basic_texture.qsfrag");
 
@@ -576,6 +643,8 @@ namespace Quartz
 			//QuickConvertToQModel("Assets/Models/sponza.obj", "Assets/Models/sponza.qmodel");
 			//QuickConvertToQModel("Assets/Models/testScene.obj", "Assets/Models/testScene.qmodel");
 			//QuickConvertToQModel("Assets/Models/gun.obj", "Assets/Models/gun.qmodel");
+			//QuickConvertToQModel("Assets/Models/dragon.obj", "Assets/Models/dragon_quantized.qmodel", VERTEX_QUANTIZE_ALL);
+			//QuickConvertToQModel("Assets/Models/dragon.obj", "Assets/Models/dragon_lod.qmodel", VERTEX_QUANTIZE_ALL, 4);
 
 			/////////////////////////////////
 
@@ -615,6 +684,7 @@ namespace Quartz
 			gfx.pSurface = gfx.pResourceManager->CreateSurface(gfx.pPrimaryDevice, gfx.vkInstance, *(VulkanApiSurface*)gpWindow->GetSurface());
 
 			gPhysics.Initialize();
+			gPhysics.SetThreadCount(std::thread::hardware_concurrency());
 
 			/////////////////////////////////
 
@@ -656,6 +726,16 @@ namespace Quartz
 			Entity entity2 = world.CreateEntity(transform2, MeshComponent("Assets/Models/gun.qmodel"), gunMaterial);
 			Entity entity3 = world.CreateEntity(transform3, MeshComponent("Assets/Models/testScene.qmodel"), testSceneMaterial);
 
+			Model* pTestSceneModel = Engine::GetAssetManager().GetOrLoadAsset<Model>("Assets/Models/testScene.qmodel");
+
+			if (pTestSceneModel && gTestSceneMesh.Build(*pTestSceneModel))
+			{
+				RigidBody testSceneRigidBody(0.0f, 1.0f, 1.0f, { 0.0f, 0.0f, 0.0f });
+				MeshCollider testSceneCollider(gTestSceneMesh);
+
+				world.AddComponent(entity3, RigidBodyComponent(testSceneRigidBody, testSceneCollider));
+			}
+
 			TransformComponent lightTransform0
 			(
 				{ 0.5f, 10.2f, 0.0f },
@@ -873,6 +953,7 @@ namespace Quartz
 					);
 
 					RigidBody projectileBody(0.1f, 0.6f, 1.0f);
+					projectileBody.SetContinuous(true);
 					//RectCollider projectileCollider(Bounds3f{ {-0.5f, -0.5f, -0.5f}, {0.5f, 0.5f, 0.5f} }, false);
 					SphereCollider projectileCollider(1.0f, false);
 					RigidBodyComponent projectilePhysics(projectileBody, projectileCollider);
@@ -0,0 +1,57 @@
+#version 450
+#extension GL_ARB_separate_shader_objects : enable
+
+// basic_mesh.vert for models written with VERTEX_QUANTIZE_ALL
+
+layout(location = 0) in vec4 inPosition;	// UNORM16_4, fraction of the model bounds
+layout(location = 1) in vec2 inNormal;		// SNORM16_2, octahedral
+layout(location = 2) in vec4 inTangent;		// SNORM16_4, octahedral xy, sign in z
+layout(location = 3) in vec2 inTexCoord;	// FLOAT16_2
+
+layout(location = 0) out vec3 outPosition;
+layout(location = 1) out vec3 outNormal;
+layout(location = 2) out vec4 outTangent;
+layout(location = 3) out vec2 outTexCoord;
+layout(location = 4) out mat3 outTBN;
+
+layout(std140, set = 0, binding = 1) uniform TransformUBO
+{
+	mat4 model;
+	mat4 view;
+	mat4 proj;
+	vec4 positionScale;
+	vec4 positionOffset;
+}
+transform;
+
+vec3 DecodeOctahedral(vec2 encoded)
+{
+	vec3 direction = vec3(encoded, 1.0 - abs(encoded.x) - abs(encoded.y));
+
+	if (direction.z < 0.0)
+	{
+		direction.xy = (1.0 - abs(direction.yx)) * vec2(direction.x >= 0.0 ? 1.0 : -1.0, direction.y >= 0.0 ? 1.0 : -1.0);
+	}
+
+	return normalize(direction);
+}
+
+void main()
+{
+	vec3 position	= inPosition.xyz * transform.positionScale.xyz + transform.positionOffset.xyz;
+	vec3 normal		= DecodeOctahedral(inNormal);
+	vec4 tangent	= vec4(DecodeOctahedral(inTangent.xy), inTangent.z < 0.0 ? -1.0 : 1.0);
+
+    vec3 T = normalize(vec3(transform.model * vec4(tangent.xyz, 0.0)));
+    vec3 B = normalize(vec3(transform.model * vec4(cross(normal, tangent.xyz) * tangent.w, 0.0)));
+ 	vec3 N = normalize(vec3(transform.model * vec4(normal, 0.0)));
+
+    outNormal = normal;
+	outTangent = tangent;
+	outTBN = mat3(T, B, N);
+    outTexCoord = inTexCoord;
+
+    outPosition = vec3(transform.model * vec4(position, 1.0));
+
+	gl_Position = (transform.proj * transform.view * transform.model) * vec4(position, 1.0);
+}
\ No newline at end of file